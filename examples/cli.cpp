@@ -7,18 +7,47 @@
  *   validate <plugin>  - Basic smoke test (load, process, destroy)
  *   info <plugin>      - Dump detailed plugin information
  *   bench <plugin>     - Benchmark processing performance
+ *   startup <plugin>   - Time each step from loading a plugin to its first block
+ *   batch <dir|list>   - Validate many plugins in parallel worker processes
+ *   scan <dir|list>    - Refresh the plugin scan cache, probing only changed files
+ *   chain <a,b,...>    - Bench or render a chain of plugins through a ProcessGraph
  */
 
 #include "clap-trap/clap-trap.h"
 #include <algorithm>
+#include <atomic>
+#include <barrier>
 #include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cerrno>
 #include <cmath>
+#include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace clap_trap;
 
 static constexpr uint32_t DEFAULT_SAMPLE_RATE = 48000;
@@ -35,19 +64,172 @@ static void printUsage(const char* prog) {
     fprintf(stderr, "  validate <plugin>   Basic smoke test (load, process, destroy)\n");
     fprintf(stderr, "  info <plugin>       Dump detailed plugin information\n");
     fprintf(stderr, "  bench <plugin>      Benchmark processing performance\n");
+    fprintf(stderr, "  startup <plugin>    Time each step from loading to the first block, cold and warm\n");
     fprintf(stderr, "  process <plugin>    Offline audio rendering\n");
     fprintf(stderr, "  state <plugin>      Save/load plugin state\n");
     fprintf(stderr, "  notes <plugin>      Test note/MIDI processing\n");
+    fprintf(stderr, "  realtime <plugin>   Process on a realtime-priority thread at the buffer period\n");
+    fprintf(stderr, "  batch <dir|list>    Validate every plugin in a directory or manifest in parallel\n");
+    fprintf(stderr, "  scan <dir|list>     Probe new and changed plugins into the scan cache, in parallel\n");
+    fprintf(stderr, "  chain <a,b,...>     Bench a plugin chain with per-node timing, or render through it with -o\n");
     fprintf(stderr, "\nOptions:\n");
     fprintf(stderr, "  --blocks N          Number of blocks to process (default: 10 for validate, 10000 for bench)\n");
     fprintf(stderr, "  --buffer-size N     Buffer size in samples (default: 256)\n");
-    fprintf(stderr, "  --sample-rate N     Sample rate in Hz (default: 48000)\n");
-    fprintf(stderr, "  -i, --input FILE    Input WAV/MIDI file (process/notes), or state file (state)\n");
+    fprintf(stderr, "  --sample-rate N     Sample rate in Hz (default: 48000); with -i, resample the input to it\n");
+    fprintf(stderr, "  -i, --input FILE    Input WAV/MIDI file (process/notes), or state file (state, startup)\n");
     fprintf(stderr, "  -o, --output FILE   Output WAV file (process), or state file to save (state)\n");
     fprintf(stderr, "  --float             Output 32-bit float WAV (default: 16-bit PCM)\n");
+    fprintf(stderr, "  --trim-latency      Drop the plugin's reported latency from the output (process)\n");
+    fprintf(stderr, "  --tail              Render the plugin's reported tail after the input (process)\n");
+    fprintf(stderr, "  --batch IN OUT      Render every WAV file in IN to OUT on -j threads (process)\n");
     fprintf(stderr, "  --roundtrip         Test state save/load round-trip (state command)\n");
     fprintf(stderr, "  --verbose           Show detailed event output (notes command)\n");
     fprintf(stderr, "  --param ID=VALUE    Set parameter before processing (can repeat)\n");
+    fprintf(stderr, "  --instances N       Plugin instances to run in parallel (bench command, or to measure with --memory)\n");
+    fprintf(stderr, "  --threads N         Worker threads for --instances (default: one per instance, up to core count)\n");
+    fprintf(stderr, "  --pin               Pin bench worker threads (realtime: audio and load threads) to cores\n");
+    fprintf(stderr, "  --contiguous-buffers  Bench with all channels in one 64-byte aligned slab\n");
+    fprintf(stderr, "  --huge-pages        Like --contiguous-buffers, backed by huge pages if available\n");
+    fprintf(stderr, "  --precision P       auto, 32 or 64 (default: auto; bench: 64 also measures the data64 path)\n");
+    fprintf(stderr, "  --capture-ring N    Capture output events through an N-entry lock-free ring (notes command)\n");
+    fprintf(stderr, "  -j, --jobs N        Worker processes for batch and scan, threads for process --batch (default: core count)\n");
+    fprintf(stderr, "  --timeout SEC       Kill a batch or scan worker after SEC seconds (default: 300, 0 = never)\n");
+    fprintf(stderr, "  --bench [N]         Also benchmark each plugin (batch); time N saves and loads (state, default 100)\n");
+    fprintf(stderr, "  --memory-limit MB   Address space limit per batch or scan worker\n");
+    fprintf(stderr, "  --cached            Answer info from the scan cache when the file is unchanged\n");
+    fprintf(stderr, "  --cache FILE        Scan cache file (default: per-user cache directory)\n");
+    fprintf(stderr, "  --hash              Compare content hashes instead of mtimes in the scan cache\n");
+    fprintf(stderr, "  --format FMT        Output format: text, json or csv (info, validate, bench, realtime, startup, batch, scan, chain)\n");
+    fprintf(stderr, "  --repetitions N     Repeat each bench run N times and pool the results (startup: runs, default 5)\n");
+    fprintf(stderr, "  --save-baseline FILE  Save bench results as a baseline for --compare\n");
+    fprintf(stderr, "  --compare FILE      Compare bench results against a baseline; fail on a slowdown\n");
+    fprintf(stderr, "  --threshold PCT     Slowdown that counts as a regression (default: 5%%)\n");
+    fprintf(stderr, "  --sweep ID[:N]      Bench at N values of a parameter (id, name or 'all'; repeat for a grid)\n");
+    fprintf(stderr, "  --automation-rate N Also bench with N parameter events per block per automated parameter\n");
+    fprintf(stderr, "  --automate ID[:SHAPE]  Parameter to automate, shape ramp, lfo or random (default: all, lfo)\n");
+    fprintf(stderr, "  --modulate          Send automation as CLAP_EVENT_PARAM_MOD instead of value events\n");
+    fprintf(stderr, "  --voices N,N,...    Also bench with N held notes each (instruments)\n");
+    fprintf(stderr, "  --pool-threads N,.. Also bench on a host thread pool with N workers each\n");
+    fprintf(stderr, "  --silence           Also bench silent input, skipping process() while the plugin sleeps\n");
+    fprintf(stderr, "  --constant-input    Also bench constant (DC) input flagged in constant_mask\n");
+    fprintf(stderr, "  --matrix            Bench every block size (16-4096) at every sample rate (44.1k-192k)\n");
+    fprintf(stderr, "  --matrix-sizes N,.. Block sizes for --matrix\n");
+    fprintf(stderr, "  --matrix-rates N,.. Sample rates for --matrix\n");
+    fprintf(stderr, "  --memory            Bench RSS/PSS and heap calls per lifecycle phase over --instances (default 8)\n");
+    fprintf(stderr, "  --counters          Count cycles, IPC, branch/cache misses and context switches per block (bench, validate)\n");
+    fprintf(stderr, "  --rt-check          Report allocations, locks and blocking calls inside process() (validate)\n");
+    fprintf(stderr, "  --load N            Run N cache-thrashing load threads alongside the audio thread (realtime)\n");
+    fprintf(stderr, "  --jitter US         Wake the audio thread up to US microseconds late at random (realtime)\n");
+}
+
+// Human-readable output, silenced when --format asks for JSON or CSV
+static bool textOutput = true;
+
+static void say(const char* fmt, ...) {
+    if (!textOutput) return;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+// Per-block process() timing with realtime deadline tracking
+struct BlockStats {
+    LatencyHistogram histogram;
+    uint64_t deadlineNs = 0;
+    uint64_t deadlineMisses = 0;
+    uint64_t longestMissRun = 0;
+    uint64_t currentMissRun = 0;
+
+    BlockStats(uint32_t bufferSize, uint32_t sampleRate)
+        : deadlineNs(static_cast<uint64_t>(bufferSize) * 1000000000ull / sampleRate) {}
+
+    void record(uint64_t ns) {
+        histogram.record(ns);
+        if (ns > deadlineNs) {
+            deadlineMisses++;
+            currentMissRun++;
+            longestMissRun = std::max(longestMissRun, currentMissRun);
+        } else {
+            currentMissRun = 0;
+        }
+    }
+
+    // Add the blocks of a separate run
+    void merge(const BlockStats& other) {
+        histogram.merge(other.histogram);
+        deadlineMisses += other.deadlineMisses;
+        longestMissRun = std::max(longestMissRun, other.longestMissRun);
+    }
+};
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point end) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+static void printBlockStats(const BlockStats& stats) {
+    const auto& h = stats.histogram;
+    say("    p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f µs\n",
+        h.valueAtPercentile(50.0) / 1000.0, h.valueAtPercentile(90.0) / 1000.0,
+        h.valueAtPercentile(99.0) / 1000.0, h.valueAtPercentile(99.9) / 1000.0,
+        h.max() / 1000.0);
+    say("    deadline %.1f µs: %llu missed, longest run %llu\n",
+        stats.deadlineNs / 1000.0,
+        static_cast<unsigned long long>(stats.deadlineMisses),
+        static_cast<unsigned long long>(stats.longestMissRun));
+}
+
+// Hardware counters averaged per block, as stored in reports
+static Json counterJson(const PerfCounters::Values& values, uint64_t blocks) {
+    Json out = Json::object();
+    if (blocks == 0) return out;
+    if (values.valid[PerfCounters::Cycles] && values.valid[PerfCounters::Instructions]) {
+        out.set("ipc", values.ipc());
+    }
+    for (int c = 0; c < PerfCounters::COUNTER_COUNT; ++c) {
+        if (!values.valid[c]) continue;
+        out.set(PerfCounters::name(static_cast<PerfCounters::Counter>(c)),
+                static_cast<double>(values.value[c]) / static_cast<double>(blocks));
+    }
+    return out;
+}
+
+static void printCounters(const char* indent, const PerfCounters::Values& values, uint64_t blocks) {
+    if (blocks == 0) return;
+    auto perBlock = [&](PerfCounters::Counter c) {
+        return static_cast<double>(values.value[c]) / static_cast<double>(blocks);
+    };
+
+    std::string line;
+    char part[64];
+    auto append = [&](PerfCounters::Counter c, const char* format) {
+        if (!values.valid[c]) return;
+        snprintf(part, sizeof(part), format, perBlock(c));
+        line += part;
+    };
+    append(PerfCounters::Cycles, "  %.0f cycles");
+    if (values.valid[PerfCounters::Cycles] && values.valid[PerfCounters::Instructions]) {
+        snprintf(part, sizeof(part), "  %.2f IPC", values.ipc());
+        line += part;
+    }
+    append(PerfCounters::BranchMisses, "  %.1f branch misses");
+    append(PerfCounters::L1DMisses, "  %.1f L1D misses");
+    append(PerfCounters::LlcMisses, "  %.1f LLC misses");
+    append(PerfCounters::ContextSwitches, "  %.3f context switches");
+    if (!line.empty()) say("%scounters%s per block\n", indent, line.c_str());
+}
+
+enum class OutputFormat { Text, Json, Csv };
+
+static TimingStats timingStats(std::string name, const BlockStats& stats, double realtime) {
+    TimingStats timing = TimingStats::fromHistogram(std::move(name), stats.histogram);
+    timing.realtime = realtime;
+    timing.deadlineNs = stats.deadlineNs;
+    timing.deadlineMisses = stats.deadlineMisses;
+    timing.longestMissRun = stats.longestMissRun;
+    return timing;
 }
 
 struct ParamSetting {
@@ -55,20 +237,95 @@ struct ParamSetting {
     double value;
 };
 
+// Held notes are spread over every key of each MIDI channel
+static constexpr uint32_t MAX_BENCH_VOICES = 16 * 128;
+
+// Largest host thread pool --pool-threads accepts
+static constexpr uint32_t MAX_POOL_THREADS = 256;
+
+// One --sweep argument
+struct SweepSpec {
+    std::string param;   // Parameter id or name, or "all"
+    uint32_t steps = 0;  // 0 = default
+};
+
+// One --automate argument
+struct AutomateSpec {
+    std::string param;  // Parameter id or name
+    AutomationShape shape = AutomationShape::Lfo;
+};
+
 struct Options {
     const char* command = nullptr;
     const char* pluginPath = nullptr;
     uint32_t blocks = 0;  // 0 = use default for command
     uint32_t bufferSize = DEFAULT_BLOCK_SIZE;
     uint32_t sampleRate = DEFAULT_SAMPLE_RATE;
+    bool sampleRateSet = false;  // --sample-rate given: WAV input is resampled to it
     const char* inputFile = nullptr;
     const char* outputFile = nullptr;
     bool outputFloat = false;
+    bool trimLatency = false;  // process: drop the reported latency from the output
+    bool renderTail = false;   // process: render the reported tail after the input
+    const char* batchInput = nullptr;   // process --batch: directory of WAV files to render
+    const char* batchOutput = nullptr;  // process --batch: directory the renders go to
     bool roundtrip = false;
     bool verbose = false;
     std::vector<ParamSetting> params;  // Parameter settings (--param id=value)
+    uint32_t instances = 1;
+    bool instancesSet = false;  // --instances given (--memory defaults to more than one)
+    uint32_t threads = 0;  // 0 = one per instance, capped at core count
+    bool pinThreads = false;
+    BufferLayout bufferLayout = BufferLayout::Separate;
+    SamplePrecision precision = SamplePrecision::Auto;
+    uint32_t captureRing = 0;  // 0 = capture output events inline
+    uint32_t jobs = 0;  // 0 = one batch worker per core
+    uint32_t timeoutSeconds = 300;
+    bool bench = false;  // batch: also bench each plugin; state: bench save and load
+    uint32_t benchIterations = 0;  // state --bench N (0 = default)
+    uint32_t memoryLimitMb = 0;  // 0 = no limit
+    bool cached = false;              // info: use the scan cache
+    const char* cacheFile = nullptr;  // nullptr = ScanCache::defaultPath()
+    bool hashFiles = false;           // Scan cache entries also check the content hash
+    OutputFormat format = OutputFormat::Text;
+    uint32_t repetitions = 0;  // 0 = 1, or 5 with --save-baseline/--compare
+    const char* saveBaseline = nullptr;
+    const char* compareFile = nullptr;
+    double threshold = 0.05;
+    std::vector<SweepSpec> sweeps;  // Parameter sweeps (--sweep id[:steps])
+    uint32_t automationRate = 0;  // Events per block per automated parameter (0 = off)
+    std::vector<AutomateSpec> automate;  // Empty = every automatable parameter
+    bool modulate = false;
+    std::vector<uint32_t> voices;  // Voice counts for the polyphony bench (--voices 1,8,32)
+    std::vector<uint32_t> poolThreads;  // Host thread pool sizes to bench (--pool-threads 1,2,4)
+    bool silence = false;        // Bench silent input flagged constant, honouring sleep (bench)
+    bool constantInput = false;  // Bench non-silent constant input flagged constant (bench)
+    bool matrix = false;
+    bool memory = false;  // Bench resident memory and heap calls instead of time
+    std::vector<uint32_t> matrixSizes;  // Empty = MATRIX_SIZES
+    std::vector<uint32_t> matrixRates;  // Empty = MATRIX_RATES
+    bool counters = false;  // Hardware counters around process() (bench, validate)
+    bool rtCheck = false;   // Realtime-safety hooks around process() (validate)
+    uint32_t loadThreads = 0;  // Background load threads (realtime)
+    uint32_t jitterUs = 0;     // Largest random wake-up delay (realtime)
 };
 
+// Parse a comma-separated list of counts in [minValue, maxValue]
+static bool parseCountList(const char* arg, uint32_t minValue, uint32_t maxValue, std::vector<uint32_t>& out) {
+    out.clear();
+    for (const char* p = arg; *p;) {
+        char* end = nullptr;
+        long value = strtol(p, &end, 10);
+        if (end == p || value < static_cast<long>(minValue) || value > static_cast<long>(maxValue) ||
+            (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        out.push_back(static_cast<uint32_t>(value));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
 static bool parseArgs(int argc, char* argv[], Options& opts) {
     if (argc < 3) return false;
 
@@ -82,16 +339,191 @@ static bool parseArgs(int argc, char* argv[], Options& opts) {
             opts.bufferSize = static_cast<uint32_t>(atoi(argv[++i]));
         } else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
             opts.sampleRate = static_cast<uint32_t>(atoi(argv[++i]));
+            opts.sampleRateSet = true;
         } else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--input") == 0) && i + 1 < argc) {
             opts.inputFile = argv[++i];
         } else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
             opts.outputFile = argv[++i];
         } else if (strcmp(argv[i], "--float") == 0) {
             opts.outputFloat = true;
+        } else if (strcmp(argv[i], "--trim-latency") == 0) {
+            opts.trimLatency = true;
+        } else if (strcmp(argv[i], "--tail") == 0) {
+            opts.renderTail = true;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 2 < argc) {
+            opts.batchInput = argv[++i];
+            opts.batchOutput = argv[++i];
         } else if (strcmp(argv[i], "--roundtrip") == 0) {
             opts.roundtrip = true;
         } else if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0) {
             opts.verbose = true;
+        } else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            opts.instances = std::max(1, atoi(argv[++i]));
+            opts.instancesSet = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            opts.pinThreads = true;
+        } else if (strcmp(argv[i], "--contiguous-buffers") == 0) {
+            if (opts.bufferLayout == BufferLayout::Separate) {
+                opts.bufferLayout = BufferLayout::Contiguous;
+            }
+        } else if (strcmp(argv[i], "--huge-pages") == 0) {
+            opts.bufferLayout = BufferLayout::ContiguousHugePages;
+        } else if (strcmp(argv[i], "--capture-ring") == 0 && i + 1 < argc) {
+            opts.captureRing = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            opts.jobs = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            opts.timeoutSeconds = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            opts.bench = true;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                opts.benchIterations = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+            }
+        } else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc) {
+            opts.memoryLimitMb = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--cached") == 0) {
+            opts.cached = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            opts.cacheFile = argv[++i];
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            opts.hashFiles = true;
+        } else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            opts.repetitions = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--save-baseline") == 0 && i + 1 < argc) {
+            opts.saveBaseline = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            opts.compareFile = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            // Percent, with or without a trailing '%'
+            const char* arg = argv[++i];
+            char* end = nullptr;
+            double percent = strtod(arg, &end);
+            if (end == arg || (*end != '\0' && strcmp(end, "%") != 0) || percent < 0.0) {
+                fprintf(stderr, "Invalid --threshold (expected a percentage, e.g. 5%%): %s\n", arg);
+                return false;
+            }
+            opts.threshold = percent / 100.0;
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            // Parse id[:steps]
+            const char* arg = argv[++i];
+            const char* colon = strrchr(arg, ':');
+            if (colon && strspn(colon + 1, "0123456789") != strlen(colon + 1)) {
+                colon = nullptr;  // Part of a parameter name
+            }
+            SweepSpec sweep;
+            sweep.param = colon ? std::string(arg, colon) : std::string(arg);
+            if (colon) {
+                int steps = atoi(colon + 1);
+                if (steps < 2) {
+                    fprintf(stderr, "Invalid --sweep steps (expected ID[:N] with N >= 2): %s\n", arg);
+                    return false;
+                }
+                sweep.steps = static_cast<uint32_t>(steps);
+            }
+            if (sweep.param.empty()) {
+                fprintf(stderr, "Invalid --sweep (expected ID[:N]): %s\n", arg);
+                return false;
+            }
+            opts.sweeps.push_back(sweep);
+        } else if (strcmp(argv[i], "--automation-rate") == 0 && i + 1 < argc) {
+            opts.automationRate = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--automate") == 0 && i + 1 < argc) {
+            // Parse id[:shape]
+            const char* arg = argv[++i];
+            AutomateSpec spec;
+            spec.param = arg;
+            const char* colon = strrchr(arg, ':');
+            if (colon) {
+                const char* shape = colon + 1;
+                bool known = true;
+                if (strcmp(shape, "ramp") == 0) {
+                    spec.shape = AutomationShape::Ramp;
+                } else if (strcmp(shape, "lfo") == 0) {
+                    spec.shape = AutomationShape::Lfo;
+                } else if (strcmp(shape, "random") == 0) {
+                    spec.shape = AutomationShape::Random;
+                } else {
+                    known = false;  // Part of a parameter name
+                }
+                if (known) spec.param.assign(arg, colon);
+            }
+            if (spec.param.empty()) {
+                fprintf(stderr, "Invalid --automate (expected ID[:ramp|lfo|random]): %s\n", arg);
+                return false;
+            }
+            opts.automate.push_back(spec);
+        } else if (strcmp(argv[i], "--modulate") == 0) {
+            opts.modulate = true;
+        } else if (strcmp(argv[i], "--voices") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (!parseCountList(arg, 1, MAX_BENCH_VOICES, opts.voices)) {
+                fprintf(stderr, "Invalid --voices (expected counts from 1 to %u, e.g. 1,8,32): %s\n",
+                        MAX_BENCH_VOICES, arg);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--pool-threads") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (!parseCountList(arg, 1, MAX_POOL_THREADS, opts.poolThreads)) {
+                fprintf(stderr, "Invalid --pool-threads (expected worker counts from 1 to %u, e.g. 1,2,4): %s\n",
+                        MAX_POOL_THREADS, arg);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--silence") == 0) {
+            opts.silence = true;
+        } else if (strcmp(argv[i], "--constant-input") == 0) {
+            opts.constantInput = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            opts.counters = true;
+        } else if (strcmp(argv[i], "--rt-check") == 0) {
+            opts.rtCheck = true;
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            opts.loadThreads = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            opts.jitterUs = static_cast<uint32_t>(std::max(0, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--matrix") == 0) {
+            opts.matrix = true;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            opts.memory = true;
+        } else if (strcmp(argv[i], "--matrix-sizes") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (!parseCountList(arg, 1, 1 << 20, opts.matrixSizes)) {
+                fprintf(stderr, "Invalid --matrix-sizes (expected block sizes, e.g. 64,256,1024): %s\n", arg);
+                return false;
+            }
+            opts.matrix = true;
+        } else if (strcmp(argv[i], "--matrix-rates") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (!parseCountList(arg, 1000, 1536000, opts.matrixRates)) {
+                fprintf(stderr, "Invalid --matrix-rates (expected sample rates, e.g. 44100,96000): %s\n", arg);
+                return false;
+            }
+            opts.matrix = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (strcmp(arg, "text") == 0) {
+                opts.format = OutputFormat::Text;
+            } else if (strcmp(arg, "json") == 0) {
+                opts.format = OutputFormat::Json;
+            } else if (strcmp(arg, "csv") == 0) {
+                opts.format = OutputFormat::Csv;
+            } else {
+                fprintf(stderr, "Invalid --format (expected text, json or csv): %s\n", arg);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            if (strcmp(arg, "auto") == 0) {
+                opts.precision = SamplePrecision::Auto;
+            } else if (strcmp(arg, "32") == 0) {
+                opts.precision = SamplePrecision::Float32;
+            } else if (strcmp(arg, "64") == 0) {
+                opts.precision = SamplePrecision::Float64;
+            } else {
+                fprintf(stderr, "Invalid --precision (expected auto, 32 or 64): %s\n", arg);
+                return false;
+            }
         } else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc) {
             // Parse id=value
             const char* arg = argv[++i];
@@ -112,167 +544,555 @@ static bool parseArgs(int argc, char* argv[], Options& opts) {
     return true;
 }
 
+static const char* layoutName(BufferLayout layout) {
+    switch (layout) {
+        case BufferLayout::Separate:            return "separate";
+        case BufferLayout::Contiguous:          return "contiguous";
+        case BufferLayout::ContiguousHugePages: return "huge-pages";
+    }
+    return "separate";
+}
+
+// Empty report for a command, recording the host configuration
+static Report makeReport(const Options& opts) {
+    Report report;
+    report.command = opts.command;
+    report.pluginPath = opts.pluginPath;
+    report.host.sampleRate = opts.sampleRate;
+    report.host.bufferSize = opts.bufferSize;
+    report.host.blocks = opts.blocks;
+    report.host.precision = opts.precision == SamplePrecision::Float64   ? "64"
+                            : opts.precision == SamplePrecision::Float32 ? "32"
+                                                                         : "auto";
+    report.host.bufferLayout = layoutName(opts.bufferLayout);
+    report.host.instances = opts.instances;
+    report.host.threads = opts.threads;
+    return report;
+}
+
+static void writeReport(const Options& opts, const Report& report) {
+    Json json = toJson(report);
+    std::string out = opts.format == OutputFormat::Csv ? toCsv(json) : json.dump() + "\n";
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+}
+
 //-----------------------------------------------------------------------------
 // Commands
 //-----------------------------------------------------------------------------
 
-static int cmdInfo(const Options& opts) {
+// Report entry for a plugin, filled in from its descriptor
+static PluginResult& pluginResult(Report& report, const clap_plugin_descriptor_t* desc) {
+    PluginResult& result = report.plugin(desc->id);
+    result.name = desc->name ? desc->name : "";
+    result.vendor = desc->vendor ? desc->vendor : "";
+    result.version = desc->version ? desc->version : "";
+    return result;
+}
+
+static Json audioPortJson(const clap_audio_port_info_t& info, bool input) {
+    return Json::object()
+        .set("direction", input ? "in" : "out")
+        .set("id", info.id)
+        .set("name", info.name)
+        .set("channels", info.channel_count)
+        .set("supports64", (info.flags & CLAP_AUDIO_PORT_SUPPORTS_64BITS) != 0)
+        .set("prefers64", (info.flags & CLAP_AUDIO_PORT_PREFERS_64BITS) != 0);
+}
+
+static const char* portPrecision(const Json& port) {
+    const Json* prefers = port.get("prefers64");
+    const Json* supports = port.get("supports64");
+    if (prefers && prefers->asBool()) return "  64-bit (preferred)";
+    if (supports && supports->asBool()) return "  64-bit";
+    return "";
+}
+
+static const char* detailText(const PluginResult& result, const char* key) {
+    const Json* value = result.details.get(key);
+    return value && value->isString() && !value->asString().empty() ? value->asString().c_str() : "(none)";
+}
+
+// Query descriptor, ports, parameters and extensions into result.details.
+// Nothing is printed, so the same data can come from the scan cache.
+static void probePluginInfo(const clap_plugin_factory_t* factory, const clap_plugin_descriptor_t* desc,
+                            TestHost& host, PluginResult& result) {
+    result.details.set("url", desc->url ? desc->url : "")
+                  .set("manualUrl", desc->manual_url ? desc->manual_url : "")
+                  .set("supportUrl", desc->support_url ? desc->support_url : "")
+                  .set("description", desc->description ? desc->description : "");
+
+    Json features = Json::array();
+    for (int f = 0; desc->features && desc->features[f]; ++f) features.push(desc->features[f]);
+    result.details.set("features", std::move(features));
+
+    // Create instance to query extensions
+    const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
+    if (!plugin || !plugin->init(plugin)) {
+        result.check("init", false, "Could not create instance to query extensions");
+        if (plugin) plugin->destroy(plugin);
+        return;
+    }
+    result.check("init", true);
+
+    // Audio ports
+    const auto* audioPorts = static_cast<const clap_plugin_audio_ports_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
+    if (audioPorts) {
+        Json ports = Json::array();
+        for (bool input : {true, false}) {
+            uint32_t portCount = audioPorts->count(plugin, input);
+            for (uint32_t p = 0; p < portCount; ++p) {
+                clap_audio_port_info_t info{};
+                if (audioPorts->get(plugin, p, input, &info)) ports.push(audioPortJson(info, input));
+            }
+        }
+        result.details.set("audioPorts", std::move(ports));
+    }
+
+    // Note ports
+    const auto* notePorts = static_cast<const clap_plugin_note_ports_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_NOTE_PORTS));
+    if (notePorts) {
+        Json ports = Json::array();
+        for (bool input : {true, false}) {
+            uint32_t portCount = notePorts->count(plugin, input);
+            for (uint32_t p = 0; p < portCount; ++p) {
+                clap_note_port_info_t info{};
+                if (notePorts->get(plugin, p, input, &info)) {
+                    ports.push(Json::object()
+                                   .set("direction", input ? "in" : "out")
+                                   .set("id", info.id)
+                                   .set("name", info.name));
+                }
+            }
+        }
+        if (ports.size() > 0) result.details.set("notePorts", std::move(ports));
+    }
+
+    // Parameters
+    const auto* params = static_cast<const clap_plugin_params_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_PARAMS));
+    if (params) {
+        uint32_t paramCount = params->count(plugin);
+        Json paramList = Json::array();
+        for (uint32_t p = 0; p < paramCount; ++p) {
+            clap_param_info_t info{};
+            if (params->get_info(plugin, p, &info)) {
+                double value = 0;
+                params->get_value(plugin, info.id, &value);
+                paramList.push(Json::object()
+                                   .set("id", info.id)
+                                   .set("name", info.name)
+                                   .set("module", info.module)
+                                   .set("min", info.min_value)
+                                   .set("max", info.max_value)
+                                   .set("default", info.default_value)
+                                   .set("value", value));
+            }
+        }
+        result.details.set("params", std::move(paramList));
+    }
+
+    // Extensions supported
+    const char* extensions[] = {
+        CLAP_EXT_PARAMS, CLAP_EXT_AUDIO_PORTS, CLAP_EXT_NOTE_PORTS,
+        CLAP_EXT_LATENCY, CLAP_EXT_STATE, CLAP_EXT_TAIL,
+        CLAP_EXT_RENDER, CLAP_EXT_GUI, nullptr
+    };
+    Json supported = Json::array();
+    for (int e = 0; extensions[e]; ++e) {
+        if (plugin->get_extension(plugin, extensions[e])) supported.push(extensions[e]);
+    }
+    result.details.set("extensions", std::move(supported));
+
+    plugin->destroy(plugin);
+}
+
+static void printPluginInfo(uint32_t index, const PluginResult& result) {
+    say("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+    say("Plugin %u: %s\n", index, result.name.c_str());
+    say("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+    say("  ID:          %s\n", result.id.c_str());
+    say("  Vendor:      %s\n", result.vendor.c_str());
+    say("  Version:     %s\n", result.version.c_str());
+    say("  URL:         %s\n", detailText(result, "url"));
+    say("  Manual URL:  %s\n", detailText(result, "manualUrl"));
+    say("  Support URL: %s\n", detailText(result, "supportUrl"));
+    say("  Description: %s\n", detailText(result, "description"));
+
+    const Json* features = result.details.get("features");
+    if (features && features->size() > 0) {
+        say("  Features:    ");
+        for (size_t f = 0; f < features->items().size(); ++f) {
+            say("%s%s", f > 0 ? ", " : "", features->items()[f].asString().c_str());
+        }
+        say("\n");
+    }
+
+    if (!result.passed()) {
+        say("  (Could not create instance to query extensions)\n\n");
+        return;
+    }
+
+    auto text = [](const Json& object, const char* key) {
+        const Json* value = object.get(key);
+        return value ? value->asString().c_str() : "";
+    };
+    auto number = [](const Json& object, const char* key) {
+        const Json* value = object.get(key);
+        return value ? value->asNumber() : 0.0;
+    };
+    auto isInput = [&](const Json& port) { return strcmp(text(port, "direction"), "in") == 0; };
+
+    if (const Json* ports = result.details.get("audioPorts")) {
+        say("\n  Audio Ports:\n");
+        for (bool input : {true, false}) {
+            uint32_t p = 0;
+            for (const auto& port : ports->items()) {
+                if (isInput(port) != input) continue;
+                say(input ? "    [IN %u]  %-20s %u ch%s\n" : "    [OUT %u] %-20s %u ch%s\n", p++,
+                    text(port, "name"), static_cast<uint32_t>(number(port, "channels")), portPrecision(port));
+            }
+        }
+    }
+
+    if (const Json* ports = result.details.get("notePorts")) {
+        say("\n  Note Ports:\n");
+        for (bool input : {true, false}) {
+            uint32_t p = 0;
+            for (const auto& port : ports->items()) {
+                if (isInput(port) != input) continue;
+                say(input ? "    [IN %u]  %-20s\n" : "    [OUT %u] %-20s\n", p++, text(port, "name"));
+            }
+        }
+    }
+
+    if (const Json* params = result.details.get("params")) {
+        say("\n  Parameters: %zu\n", params->size());
+        uint32_t p = 0;
+        for (const auto& param : params->items()) {
+            say("    [%u] %-30s id=%-8u range=[%.2f, %.2f] default=%.2f current=%.2f\n",
+                p++, text(param, "name"), static_cast<uint32_t>(number(param, "id")), number(param, "min"),
+                number(param, "max"), number(param, "default"), number(param, "value"));
+        }
+    }
+
+    say("\n  Extensions:\n");
+    if (const Json* extensions = result.details.get("extensions")) {
+        for (const auto& extension : extensions->items()) say("    ✓ %s\n", extension.asString().c_str());
+    }
+    say("\n");
+}
+
+// Load the file and probe every plugin in it, in this process
+static int probePluginFile(const Options& opts, Report& report) {
     auto loader = PluginLoader::load(opts.pluginPath);
     if (!loader->entry()) {
         fprintf(stderr, "ERROR: %s\n", loader->getError().c_str());
+        report.check("load", false, loader->getError());
         return 1;
     }
+    report.check("load", true);
 
     const auto* factory = loader->factory();
     if (!factory) {
         fprintf(stderr, "ERROR: No plugin factory\n");
+        report.check("factory", false);
         return 1;
     }
-
-    uint32_t count = factory->get_plugin_count(factory);
-    printf("Plugin file: %s\n", opts.pluginPath);
-    printf("Plugins: %u\n\n", count);
+    report.check("factory", true);
 
     TestHost host;
-
+    uint32_t count = factory->get_plugin_count(factory);
     for (uint32_t i = 0; i < count; ++i) {
         const auto* desc = factory->get_plugin_descriptor(factory, i);
-        if (!desc) continue;
+        if (desc) probePluginInfo(factory, desc, host, pluginResult(report, desc));
+    }
+    return 0;
+}
 
-        printf("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
-        printf("Plugin %u: %s\n", i, desc->name);
-        printf("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
-        printf("  ID:          %s\n", desc->id);
-        printf("  Vendor:      %s\n", desc->vendor);
-        printf("  Version:     %s\n", desc->version);
-        printf("  URL:         %s\n", desc->url ? desc->url : "(none)");
-        printf("  Manual URL:  %s\n", desc->manual_url ? desc->manual_url : "(none)");
-        printf("  Support URL: %s\n", desc->support_url ? desc->support_url : "(none)");
-        printf("  Description: %s\n", desc->description ? desc->description : "(none)");
-
-        // Features
-        if (desc->features && desc->features[0]) {
-            printf("  Features:    ");
-            for (int f = 0; desc->features[f]; ++f) {
-                printf("%s%s", f > 0 ? ", " : "", desc->features[f]);
-            }
-            printf("\n");
+// Cache entry for a probed file from its JSON report. A file whose load or
+// factory check failed is cached as failed, with that check's detail.
+static ScanEntry scanEntry(const std::string& path, const FileSignature& signature, const Json& report) {
+    ScanEntry entry;
+    entry.path = path;
+    entry.signature = signature;
+    entry.ok = true;
+    if (const Json* checks = report.get("checks")) {
+        for (const auto& check : checks->items()) {
+            const Json* passed = check.get("passed");
+            if (passed && passed->asBool()) continue;
+            const Json* name = check.get("name");
+            const Json* detail = check.get("detail");
+            entry.ok = false;
+            entry.error = detail ? detail->asString() : (name ? name->asString() : "check") + " failed";
+            break;
         }
+    }
+    if (const Json* plugins = report.get("plugins")) entry.plugins = *plugins;
+    return entry;
+}
 
-        // Create instance to query extensions
-        const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
-        if (!plugin || !plugin->init(plugin)) {
-            printf("  (Could not create instance to query extensions)\n\n");
-            if (plugin) plugin->destroy(plugin);
-            continue;
-        }
+static std::string scanCachePath(const Options& opts) {
+    return opts.cacheFile ? opts.cacheFile : ScanCache::defaultPath();
+}
 
-        // Audio ports
-        const auto* audioPorts = static_cast<const clap_plugin_audio_ports_t*>(
-            plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
-        if (audioPorts) {
-            uint32_t inputCount = audioPorts->count(plugin, true);
-            uint32_t outputCount = audioPorts->count(plugin, false);
+static int cmdInfo(const Options& opts, Report& report) {
+    std::unique_ptr<ScanCache> cache;
+    FileSignature signature;
+    const ScanEntry* cached = nullptr;
+    if (opts.cached) {
+        cache = ScanCache::open(scanCachePath(opts));
+        if (cache->hasError()) fprintf(stderr, "WARNING: %s\n", cache->getError().c_str());
+        signature = fileSignature(opts.pluginPath, opts.hashFiles);
+        cached = cache->lookup(opts.pluginPath, signature);
+        if (cached && !cached->ok) cached = nullptr;  // Last scan failed; try again here
+    }
 
-            printf("\n  Audio Ports:\n");
-            for (uint32_t p = 0; p < inputCount; ++p) {
-                clap_audio_port_info_t info{};
-                if (audioPorts->get(plugin, p, true, &info)) {
-                    printf("    [IN %u]  %-20s %u ch\n", p, info.name, info.channel_count);
-                }
-            }
-            for (uint32_t p = 0; p < outputCount; ++p) {
-                clap_audio_port_info_t info{};
-                if (audioPorts->get(plugin, p, false, &info)) {
-                    printf("    [OUT %u] %-20s %u ch\n", p, info.name, info.channel_count);
-                }
-            }
+    int rc = 0;
+    if (cached) {
+        report.check("load", true);
+        report.check("factory", true);
+        for (const auto& plugin : cached->plugins.items()) {
+            PluginResult result;
+            if (PluginResult::fromJson(plugin, result)) report.plugins.push_back(std::move(result));
         }
+        report.details.set("cached", true);
+    } else {
+        rc = probePluginFile(opts, report);
+        if (cache && signature.exists) {
+            cache->put(scanEntry(opts.pluginPath, signature, toJson(report)));
+            if (!cache->save()) fprintf(stderr, "WARNING: %s\n", cache->getError().c_str());
+        }
+        if (opts.cached) report.details.set("cached", false);
+    }
+    if (rc != 0) return rc;
 
-        // Note ports
-        const auto* notePorts = static_cast<const clap_plugin_note_ports_t*>(
-            plugin->get_extension(plugin, CLAP_EXT_NOTE_PORTS));
-        if (notePorts) {
-            uint32_t inputCount = notePorts->count(plugin, true);
-            uint32_t outputCount = notePorts->count(plugin, false);
+    say("Plugin file: %s%s\n", opts.pluginPath, cached ? " (cached)" : "");
+    say("Plugins: %zu\n\n", report.plugins.size());
+    for (size_t i = 0; i < report.plugins.size(); ++i) {
+        printPluginInfo(static_cast<uint32_t>(i), report.plugins[i]);
+    }
+    return 0;
+}
 
-            if (inputCount > 0 || outputCount > 0) {
-                printf("\n  Note Ports:\n");
-                for (uint32_t p = 0; p < inputCount; ++p) {
-                    clap_note_port_info_t info{};
-                    if (notePorts->get(plugin, p, true, &info)) {
-                        printf("    [IN %u]  %-20s\n", p, info.name);
-                    }
-                }
-                for (uint32_t p = 0; p < outputCount; ++p) {
-                    clap_note_port_info_t info{};
-                    if (notePorts->get(plugin, p, false, &info)) {
-                        printf("    [OUT %u] %-20s\n", p, info.name);
-                    }
-                }
-            }
+// Print the violations recorded since the last take, grouped by call site,
+// and record the "rt-safety" check; returns false if there were any
+static bool reportRtViolations(bool is64, PluginResult& result, Json& details) {
+    const char* checkName = is64 ? "rt-safety64" : "rt-safety";
+    std::vector<RtViolation> violations = takeRtViolations();
+    uint64_t dropped = droppedRtViolations();
+    if (violations.empty() && dropped == 0) {
+        say("  ✓ realtime safe: no allocations, locks or blocking calls in process()%s\n",
+            is64 ? " (64-bit)" : "");
+        result.check(checkName, true);
+        return true;
+    }
+
+    struct Site {
+        const RtViolation* first;
+        uint64_t count;
+        uint64_t maxSize;
+    };
+    std::vector<Site> sites;
+    for (const auto& violation : violations) {
+        auto site = std::find_if(sites.begin(), sites.end(), [&](const Site& s) {
+            return s.first->function == violation.function && s.first->frameCount == violation.frameCount &&
+                   std::equal(violation.frames, violation.frames + violation.frameCount, s.first->frames);
+        });
+        if (site == sites.end()) {
+            sites.push_back({&violation, 1, violation.size});
+        } else {
+            site->count++;
+            site->maxSize = std::max(site->maxSize, violation.size);
         }
+    }
 
-        // Parameters
-        const auto* params = static_cast<const clap_plugin_params_t*>(
-            plugin->get_extension(plugin, CLAP_EXT_PARAMS));
-        if (params) {
-            uint32_t paramCount = params->count(plugin);
-            printf("\n  Parameters: %u\n", paramCount);
+    char error[128];
+    snprintf(error, sizeof(error), "%llu realtime violation(s) at %zu call site(s) in process()%s",
+             static_cast<unsigned long long>(violations.size() + dropped), sites.size(), is64 ? " (64-bit)" : "");
+    fprintf(stderr, "  ✗ %s\n", error);
+
+    Json list = Json::array();
+    for (const auto& site : sites) {
+        const RtViolation& violation = *site.first;
+        if (violation.kind == RtViolationKind::Allocation && site.maxSize > 0) {
+            fprintf(stderr, "      %s %s(%llu bytes) x%llu\n", rtViolationKindName(violation.kind), violation.function,
+                    static_cast<unsigned long long>(site.maxSize), static_cast<unsigned long long>(site.count));
+        } else {
+            fprintf(stderr, "      %s %s() x%llu\n", rtViolationKindName(violation.kind), violation.function,
+                    static_cast<unsigned long long>(site.count));
+        }
+        Json stack = Json::array();
+        for (const auto& frame : symbolizeRtStack(violation)) {
+            fprintf(stderr, "          %s\n", frame.c_str());
+            stack.push(frame);
+        }
+        Json entry = Json::object();
+        entry.set("kind", rtViolationKindName(violation.kind))
+            .set("function", violation.function)
+            .set("count", site.count)
+            .set("bytes", site.maxSize)
+            .set("stack", std::move(stack));
+        list.push(std::move(entry));
+    }
+    if (dropped > 0) {
+        fprintf(stderr, "      (%llu more not recorded)\n", static_cast<unsigned long long>(dropped));
+    }
+    fprintf(stderr, "      (module offsets resolve with addr2line -f -C -e MODULE OFFSET)\n");
 
-            for (uint32_t p = 0; p < paramCount; ++p) {
-                clap_param_info_t info{};
-                if (params->get_info(plugin, p, &info)) {
-                    double value = 0;
-                    params->get_value(plugin, info.id, &value);
+    Json rt = Json::object();
+    rt.set("violations", std::move(list)).set("dropped", dropped);
+    details.set("rtSafety", std::move(rt));
+    result.check(checkName, false, error);
+    return false;
+}
 
-                    printf("    [%u] %-30s id=%-8u range=[%.2f, %.2f] default=%.2f current=%.2f\n",
-                           p, info.name, info.id, info.min_value, info.max_value,
-                           info.default_value, value);
-                }
-            }
+// Print what the plugin asked of the host extensions during validation:
+// log messages at warning level and up, params rescans, latency and tail
+// changes. Recorded in the "hostRequests" details; nothing here fails validation.
+static void reportHostRequests(TestHost& host, PluginResult& result) {
+    Json log = Json::array();
+    for (const auto& message : host.takeLogMessages()) {
+        if (message.severity >= CLAP_LOG_WARNING) {
+            say("  ! plugin log (%s): %s\n", logSeverityName(message.severity), message.text.c_str());
         }
+        Json entry = Json::object();
+        entry.set("severity", logSeverityName(message.severity)).set("text", message.text);
+        log.push(std::move(entry));
+    }
+    if (host.paramsRescanFlags() != 0) say("  ! params rescan requested (flags 0x%x)\n", host.paramsRescanFlags());
+    if (host.latencyChanged()) say("  ! latency changed\n");
+    if (host.tailChanged()) say("  ! tail changed\n");
+
+    Json requests = Json::object();
+    requests.set("log", std::move(log))
+        .set("paramsRescanFlags", host.paramsRescanFlags())
+        .set("latencyChanged", host.latencyChanged())
+        .set("tailChanged", host.tailChanged())
+        .set("restartRequested", host.restartRequested());
+    result.details.set("hostRequests", std::move(requests));
+    host.resetRequests();
+}
 
-        // Extensions supported
-        printf("\n  Extensions:\n");
-        const char* extensions[] = {
-            CLAP_EXT_PARAMS, CLAP_EXT_AUDIO_PORTS, CLAP_EXT_NOTE_PORTS,
-            CLAP_EXT_LATENCY, CLAP_EXT_STATE, CLAP_EXT_TAIL,
-            CLAP_EXT_RENDER, CLAP_EXT_GUI, nullptr
-        };
-        for (int e = 0; extensions[e]; ++e) {
-            if (plugin->get_extension(plugin, extensions[e])) {
-                printf("    ✓ %s\n", extensions[e]);
-            }
-        }
+// Run `blocks` process() calls and check every output block
+template<typename Buffers>
+static bool validateProcess(const clap_plugin_t* plugin, const Options& opts, uint32_t blocks,
+                            PluginResult& result) {
+    constexpr bool is64 = std::is_same_v<typename Buffers::Sample, double>;
+    const char* checkName = is64 ? "process64" : "process";
+    TestHost::AudioThreadScope audio;
+    Buffers buffers(opts.bufferSize);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
 
-        plugin->destroy(plugin);
-        printf("\n");
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.steady_time = 0;
+    process.frames_count = opts.bufferSize;
+    process.transport = nullptr;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = inEvents.get();
+    process.out_events = outEvents.get();
+
+    std::unique_ptr<PerfCounters> counters;
+    if (opts.counters) {
+        counters = std::make_unique<PerfCounters>();
+        if (counters->available()) {
+            counters->start();
+        } else {
+            counters.reset();
+        }
+    }
+    PerfCounters::Values counted;
+    if (opts.rtCheck) takeRtViolations();  // Only this run's calls
+
+    uint64_t denormals = 0;
+    float peak = 0.0f;
+    for (uint32_t b = 0; b < blocks; ++b) {
+        clap_process_status status;
+        {
+            std::optional<PerfCounters::Scope> scope;
+            if (counters) scope.emplace(*counters, counted);
+            std::optional<RtRegion> region;
+            if (opts.rtCheck) region.emplace();
+            status = plugin->process(plugin, &process);
+        }
+        if (status == CLAP_PROCESS_ERROR) {
+            char error[96];
+            snprintf(error, sizeof(error), "process() returned error at block %u%s", b, is64 ? " (64-bit)" : "");
+            fprintf(stderr, "  ✗ %s\n", error);
+            result.check(checkName, false, error);
+            return false;
+        }
+        BufferStats stats = buffers.analyzeOutput();
+        if (!stats.isValid()) {
+            char error[128];
+            snprintf(error, sizeof(error), "Invalid output at block %u%s (%llu NaN, %llu Inf)", b,
+                     is64 ? " (64-bit)" : "",
+                     static_cast<unsigned long long>(stats.nanCount),
+                     static_cast<unsigned long long>(stats.infCount));
+            fprintf(stderr, "  ✗ %s\n", error);
+            result.check(checkName, false, error);
+            return false;
+        }
+        denormals += stats.denormalCount;
+        peak = std::max(peak, stats.peak);
+        process.steady_time += opts.bufferSize;
     }
 
-    return 0;
+    say("  ✓ process() x%u blocks%s (peak %.3f)\n", blocks, is64 ? ", 64-bit" : "", peak);
+    if (denormals > 0) {
+        say("  ! %llu denormal output samples\n", static_cast<unsigned long long>(denormals));
+    }
+    if (counters) printCounters("    ", counted, blocks);
+    else if (opts.counters) say("    counters unavailable\n");
+    result.check(checkName, true);
+    Json details = Json::object();
+    details.set("blocks", blocks).set("peak", peak).set("denormals", denormals);
+    Json counterDetails = counterJson(counted, blocks);
+    if (!counterDetails.members().empty()) details.set("counters", std::move(counterDetails));
+    bool rtSafe = !opts.rtCheck || reportRtViolations(is64, result, details);
+    result.details.set(checkName, std::move(details));
+    return rtSafe;
 }
 
-static int cmdValidate(const Options& opts) {
+static int cmdValidate(const Options& opts, Report& report) {
     uint32_t blocks = opts.blocks > 0 ? opts.blocks : 10;
+    report.host.blocks = blocks;
+
+    if (opts.rtCheck && !rtCheckEnable()) {
+        fprintf(stderr, "ERROR: --rt-check needs Linux with glibc\n");
+        return 1;
+    }
 
     auto loader = PluginLoader::load(opts.pluginPath);
     if (!loader->entry()) {
         fprintf(stderr, "ERROR: %s\n", loader->getError().c_str());
+        report.check("load", false, loader->getError());
         return 1;
     }
-    printf("✓ Plugin loaded\n");
+    say("✓ Plugin loaded\n");
+    report.check("load", true);
 
     const auto* factory = loader->factory();
     if (!factory) {
         fprintf(stderr, "ERROR: No plugin factory\n");
+        report.check("factory", false);
         return 1;
     }
-    printf("✓ Got plugin factory\n");
+    say("✓ Got plugin factory\n");
+    report.check("factory", true);
 
     uint32_t count = factory->get_plugin_count(factory);
-    printf("✓ Found %u plugin(s)\n", count);
+    say("✓ Found %u plugin(s)\n", count);
 
+    report.check("plugins", count > 0, std::to_string(count) + " plugin(s)");
     if (count == 0) {
         fprintf(stderr, "ERROR: No plugins in factory\n");
         return 1;
@@ -285,202 +1105,2648 @@ static int cmdValidate(const Options& opts) {
         const auto* desc = factory->get_plugin_descriptor(factory, i);
         if (!desc) {
             fprintf(stderr, "✗ Null descriptor for plugin %u\n", i);
+            report.check("descriptor " + std::to_string(i), false, "Null descriptor");
             failures++;
             continue;
         }
 
-        printf("\n── %s ──\n", desc->name);
+        say("\n── %s ──\n", desc->name);
+        PluginResult& result = pluginResult(report, desc);
 
         const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
+        result.check("create_plugin", plugin != nullptr);
         if (!plugin) {
             fprintf(stderr, "  ✗ create_plugin() failed\n");
             failures++;
             continue;
         }
-        printf("  ✓ create_plugin()\n");
+        say("  ✓ create_plugin()\n");
 
-        if (!plugin->init(plugin)) {
+        bool initOk = plugin->init(plugin);
+        result.check("init", initOk);
+        if (!initOk) {
             fprintf(stderr, "  ✗ init() failed\n");
             plugin->destroy(plugin);
             failures++;
             continue;
         }
-        printf("  ✓ init()\n");
-
-        if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
+        say("  ✓ init()\n");
+        host.setPlugin(plugin);
+        host.pumpMainThread();
+
+        bool activateOk = plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize);
+        host.setPluginActive(activateOk);
+        result.check("activate", activateOk);
+        if (!activateOk) {
             fprintf(stderr, "  ✗ activate() failed\n");
             plugin->destroy(plugin);
+            host.setPlugin(nullptr);
             failures++;
             continue;
         }
-        printf("  ✓ activate(%u Hz, %u samples)\n", opts.sampleRate, opts.bufferSize);
+        say("  ✓ activate(%u Hz, %u samples)\n", opts.sampleRate, opts.bufferSize);
 
-        if (!plugin->start_processing(plugin)) {
+        bool startOk = plugin->start_processing(plugin);
+        result.check("start_processing", startOk);
+        if (!startOk) {
             fprintf(stderr, "  ✗ start_processing() failed\n");
             plugin->deactivate(plugin);
+            host.setPluginActive(false);
             plugin->destroy(plugin);
+            host.setPlugin(nullptr);
             failures++;
             continue;
         }
-        printf("  ✓ start_processing()\n");
-
-        // Process blocks
-        StereoAudioBuffers buffers(opts.bufferSize);
-        buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
-
-        EmptyInputEvents inEvents;
-        DiscardOutputEvents outEvents;
-
-        clap_process_t process{};
-        process.steady_time = 0;
-        process.frames_count = opts.bufferSize;
-        process.transport = nullptr;
-        process.audio_inputs = buffers.inputBuffer();
-        process.audio_outputs = buffers.outputBuffer();
-        process.audio_inputs_count = 1;
-        process.audio_outputs_count = 1;
-        process.in_events = inEvents.get();
-        process.out_events = outEvents.get();
-
-        bool processOk = true;
-        for (uint32_t b = 0; b < blocks; ++b) {
-            clap_process_status status = plugin->process(plugin, &process);
-            if (status == CLAP_PROCESS_ERROR) {
-                fprintf(stderr, "  ✗ process() returned error at block %u\n", b);
-                processOk = false;
-                break;
-            }
-            if (!buffers.outputIsValid()) {
-                fprintf(stderr, "  ✗ Invalid output (NaN/Inf) at block %u\n", b);
-                processOk = false;
-                break;
-            }
-            process.steady_time += opts.bufferSize;
+        say("  ✓ start_processing()\n");
+
+        // Process blocks in the negotiated precision, then in the other one
+        // if the ports support both
+        PrecisionSupport support = queryPrecisionSupport(plugin);
+        SamplePrecision precision = negotiatePrecision(support, opts.precision);
+        bool processOk = precision == SamplePrecision::Float64
+                         ? validateProcess<StereoAudioBuffers64>(plugin, opts, blocks, result)
+                         : validateProcess<StereoAudioBuffers>(plugin, opts, blocks, result);
+        if (processOk && support.supports64) {
+            processOk = precision == SamplePrecision::Float64
+                        ? validateProcess<StereoAudioBuffers>(plugin, opts, blocks, result)
+                        : validateProcess<StereoAudioBuffers64>(plugin, opts, blocks, result);
         }
-
-        if (processOk) {
-            printf("  ✓ process() x%u blocks\n", blocks);
-        } else {
+        if (!processOk) {
             failures++;
         }
 
         plugin->stop_processing(plugin);
-        printf("  ✓ stop_processing()\n");
+        say("  ✓ stop_processing()\n");
 
         plugin->deactivate(plugin);
-        printf("  ✓ deactivate()\n");
+        host.setPluginActive(false);
+        say("  ✓ deactivate()\n");
+        host.pumpMainThread();
+        reportHostRequests(host, result);
 
         plugin->destroy(plugin);
-        printf("  ✓ destroy()\n");
+        host.setPlugin(nullptr);
+        say("  ✓ destroy()\n");
     }
 
-    printf("\n");
+    say("\n");
     if (failures == 0) {
-        printf("All %u plugin(s) validated successfully.\n", count);
+        say("All %u plugin(s) validated successfully.\n", count);
         return 0;
     } else {
-        printf("FAILED: %d plugin(s) had errors.\n", failures);
+        say("FAILED: %d plugin(s) had errors.\n", failures);
         return 1;
     }
 }
 
-static int cmdBench(const Options& opts) {
-    uint32_t blocks = opts.blocks > 0 ? opts.blocks : 10000;
+// One bench worker thread: its own host, buffers and event lists
+struct BenchWorker {
+    struct Instance {
+        const clap_plugin_t* plugin = nullptr;
+        std::unique_ptr<StereoAudioBuffers> buffers;
+        clap_process_t process{};
+        bool processing = false;  // start_processing() succeeded
+    };
 
-    auto loader = PluginLoader::load(opts.pluginPath);
-    if (!loader->entry()) {
-        fprintf(stderr, "ERROR: %s\n", loader->getError().c_str());
-        return 1;
+    TestHost host;
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+    std::vector<Instance> instances;
+    BlockStats stats;
+    uint32_t core = 0;
+    bool pinned = false;
+    bool started = true;
+    uint64_t wallNs = 0;
+
+    BenchWorker(uint32_t bufferSize, uint32_t sampleRate) : stats(bufferSize, sampleRate) {}
+};
+
+// Run `instanceCount` instances of one plugin spread over `threadCount` threads.
+// Returns false if any instance failed to set up.
+static bool runParallelBench(const Options& opts, const clap_plugin_factory_t* factory,
+                             const clap_plugin_descriptor_t* desc, uint32_t instanceCount,
+                             uint32_t threadCount, uint32_t blocks,
+                             std::vector<std::unique_ptr<BenchWorker>>& workers,
+                             uint64_t& wallNs) {
+    workers.clear();
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        auto worker = std::make_unique<BenchWorker>(opts.bufferSize, opts.sampleRate);
+        worker->core = t % hardwareThreadCount();
+        workers.push_back(std::move(worker));
+    }
+
+    // Instances are created and activated on the main thread, as a host would
+    bool ok = true;
+    for (uint32_t n = 0; n < instanceCount && ok; ++n) {
+        auto& worker = *workers[n % threadCount];
+        const clap_plugin_t* plugin = factory->create_plugin(factory, worker.host.clapHost(), desc->id);
+        if (!plugin || !plugin->init(plugin)) {
+            if (plugin) plugin->destroy(plugin);
+            ok = false;
+            break;
+        }
+        if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
+            plugin->destroy(plugin);
+            ok = false;
+            break;
+        }
+
+        BenchWorker::Instance inst;
+        inst.plugin = plugin;
+        inst.buffers = std::make_unique<StereoAudioBuffers>(opts.bufferSize, opts.bufferLayout);
+        inst.buffers->fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+        inst.process.steady_time = 0;
+        inst.process.frames_count = opts.bufferSize;
+        inst.process.transport = nullptr;
+        inst.process.audio_inputs = inst.buffers->inputBuffer();
+        inst.process.audio_outputs = inst.buffers->outputBuffer();
+        inst.process.audio_inputs_count = 1;
+        inst.process.audio_outputs_count = 1;
+        inst.process.in_events = worker.inEvents.get();
+        inst.process.out_events = worker.outEvents.get();
+        worker.instances.push_back(std::move(inst));
+    }
+
+    if (ok) {
+        // Workers warm up, then all start timing together once the main thread joins the barrier
+        std::barrier startLine(static_cast<std::ptrdiff_t>(threadCount + 1));
+        std::vector<std::thread> threads;
+
+        for (auto& w : workers) {
+            BenchWorker* worker = w.get();
+            threads.emplace_back([&opts, &startLine, worker, blocks]() {
+                TestHost::AudioThreadScope audio;
+                if (opts.pinThreads) {
+                    worker->pinned = pinCurrentThreadToCore(worker->core);
+                }
+                for (auto& inst : worker->instances) {
+                    inst.processing = inst.plugin->start_processing(inst.plugin);
+                    if (!inst.processing) worker->started = false;
+                }
+                for (uint32_t b = 0; b < 100 && worker->started; ++b) {
+                    for (auto& inst : worker->instances) {
+                        inst.plugin->process(inst.plugin, &inst.process);
+                        inst.process.steady_time += opts.bufferSize;
+                    }
+                }
+
+                startLine.arrive_and_wait();
+
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t b = 0; b < blocks && worker->started; ++b) {
+                    for (auto& inst : worker->instances) {
+                        auto blockStart = std::chrono::steady_clock::now();
+                        inst.plugin->process(inst.plugin, &inst.process);
+                        worker->stats.record(elapsedNs(blockStart, std::chrono::steady_clock::now()));
+                        inst.process.steady_time += opts.bufferSize;
+                    }
+                }
+                worker->wallNs = elapsedNs(start, std::chrono::steady_clock::now());
+
+                for (auto& inst : worker->instances) {
+                    if (inst.processing) inst.plugin->stop_processing(inst.plugin);
+                }
+            });
+        }
+
+        startLine.arrive_and_wait();
+        auto start = std::chrono::steady_clock::now();
+        for (auto& t : threads) t.join();
+        wallNs = elapsedNs(start, std::chrono::steady_clock::now());
+
+        for (const auto& w : workers) {
+            if (!w->started) ok = false;
+        }
+    }
+
+    for (auto& w : workers) {
+        for (auto& inst : w->instances) {
+            inst.plugin->deactivate(inst.plugin);
+            inst.plugin->destroy(inst.plugin);
+        }
+        w->instances.clear();
+    }
+    return ok;
+}
+
+static void benchParallel(const Options& opts, const clap_plugin_factory_t* factory,
+                          const clap_plugin_descriptor_t* desc, uint32_t blocks,
+                          PluginResult& result) {
+    uint32_t instanceCount = opts.instances;
+    uint32_t threadCount = opts.threads > 0 ? opts.threads
+                                            : std::min(instanceCount, hardwareThreadCount());
+    threadCount = std::min(threadCount, instanceCount);
+
+    // Reference: one instance on one thread, i.e. no contention at all
+    std::vector<std::unique_ptr<BenchWorker>> workers;
+    uint64_t referenceNs = 0;
+    if (!runParallelBench(opts, factory, desc, 1, 1, blocks, workers, referenceNs)) {
+        fprintf(stderr, "%-40s (failed to set up instance)\n", desc->name);
+        result.check("setup", false, "Failed to set up instance");
+        return;
+    }
+    double referenceUsPerBlock = workers[0]->stats.histogram.mean() / 1000.0;
+    double referenceBlocksPerSec = blocks / (referenceNs / 1e9);
+
+    uint64_t wallNs = 0;
+    if (!runParallelBench(opts, factory, desc, instanceCount, threadCount, blocks, workers, wallNs)) {
+        fprintf(stderr, "%-40s (failed to set up %u instances)\n", desc->name, instanceCount);
+        result.check("setup", false, "Failed to set up " + std::to_string(instanceCount) + " instances");
+        return;
+    }
+    result.check("setup", true);
+
+    double wallSeconds = wallNs / 1e9;
+    double instanceBlocks = static_cast<double>(instanceCount) * blocks;
+    double audioSeconds = instanceBlocks * opts.bufferSize / opts.sampleRate;
+    double realtime = audioSeconds / wallSeconds;
+    double speedup = (instanceBlocks / wallSeconds) / referenceBlocksPerSec;
+    double idealSpeedup = threadCount;
+
+    say("%-40s %u instances on %u threads\n", desc->name, instanceCount, threadCount);
+    say("    total    %8.1fx realtime  (%.1fx per instance)\n", realtime, realtime / instanceCount);
+
+    BlockStats combined(opts.bufferSize, opts.sampleRate);
+    Json threadResults = Json::array();
+    for (size_t t = 0; t < workers.size(); ++t) {
+        const auto& w = *workers[t];
+        combined.histogram.merge(w.stats.histogram);
+        combined.deadlineMisses += w.stats.deadlineMisses;
+        combined.longestMissRun = std::max(combined.longestMissRun, w.stats.longestMissRun);
+
+        char core[32] = "";
+        if (opts.pinThreads) {
+            snprintf(core, sizeof(core), w.pinned ? " (core %u)" : " (core %u, pin failed)", w.core);
+        }
+        uint32_t perThread = instanceCount / threadCount + (t < instanceCount % threadCount ? 1 : 0);
+        double threadRealtime = (static_cast<double>(perThread) * blocks * opts.bufferSize / opts.sampleRate) /
+                                (w.wallNs / 1e9);
+        say("    thread %zu%s: %u inst  %8.1fx realtime  %6.1f µs/block  p99 %.1f  max %.1f µs\n",
+            t, core, perThread, threadRealtime, w.stats.histogram.mean() / 1000.0,
+            w.stats.histogram.valueAtPercentile(99.0) / 1000.0, w.stats.histogram.max() / 1000.0);
+        threadResults.push(Json::object()
+                               .set("core", w.core)
+                               .set("pinned", w.pinned)
+                               .set("instances", perThread)
+                               .set("realtime", threadRealtime)
+                               .set("meanNs", w.stats.histogram.mean())
+                               .set("p99Ns", w.stats.histogram.valueAtPercentile(99.0))
+                               .set("maxNs", w.stats.histogram.max()));
+    }
+
+    say("    scaling  %.2fx over one thread (%.0f%% of ideal %.0fx), "
+        "%.1f µs/block alone vs %.1f µs/block under load\n",
+        speedup, 100.0 * speedup / idealSpeedup, idealSpeedup,
+        referenceUsPerBlock, combined.histogram.mean() / 1000.0);
+    printBlockStats(combined);
+
+    result.timings.push_back(timingStats("parallel", combined, realtime));
+    result.details.set("parallel", Json::object()
+                                       .set("instances", instanceCount)
+                                       .set("threads", threadCount)
+                                       .set("speedup", speedup)
+                                       .set("referenceMeanNs", referenceUsPerBlock * 1000.0)
+                                       .set("threadStats", std::move(threadResults)));
+}
+
+// Optional extras for runSingleBench()
+struct BenchHooks {
+    const clap_input_events_t* setup = nullptr;  // Sent with the first warm-up block (--param)
+    AutomationGenerator* automation = nullptr;   // Fresh parameter events for every block
+    const PerfCounters* counters = nullptr;      // Running counters, read around every timed block
+};
+
+// Warm up, then time `blocks` process() calls; returns the wall time.
+// Generating automation events is left out of the returned time. With
+// hooks.counters, the timed process() calls are counted into `counted`.
+template<typename Buffers>
+static uint64_t runSingleBench(const Options& opts, const clap_plugin_t* plugin, uint32_t blocks,
+                               BlockStats& stats, const BenchHooks& hooks = {},
+                               PerfCounters::Values* counted = nullptr) {
+    TestHost::AudioThreadScope audio;
+    Buffers buffers(opts.bufferSize, opts.bufferLayout);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+    const clap_input_events_t* setup = hooks.setup;
+    AutomationGenerator* automation = hooks.automation;
+
+    std::unique_ptr<SimpleInputEvents> automated;
+    if (automation) {
+        uint32_t setupCount = setup ? setup->size(setup) : 0;
+        uint32_t maxEvents = automation->eventsForBlock(opts.bufferSize) + setupCount;
+        automated = std::make_unique<SimpleInputEvents>(
+            std::max<size_t>(SimpleInputEvents::DEFAULT_CAPACITY_BYTES, maxEvents * 2 * sizeof(clap_event_param_mod_t)),
+            std::max(SimpleInputEvents::DEFAULT_MAX_EVENTS, maxEvents));
+    }
+
+    clap_process_t process{};
+    process.steady_time = 0;
+    process.frames_count = opts.bufferSize;
+    process.transport = nullptr;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = setup ? setup : inEvents.get();
+    process.out_events = outEvents.get();
+
+    auto nextAutomation = [&](bool first) {
+        automated->clear();
+        if (first && setup) {
+            for (uint32_t e = 0; e < setup->size(setup); ++e) automated->add(setup->get(setup, e));
+        }
+        automation->fillBlock(*automated, opts.bufferSize);
+        process.in_events = automated->get();
+    };
+
+    // Warm up
+    for (uint32_t b = 0; b < 100; ++b) {
+        if (automation) nextAutomation(b == 0);
+        plugin->process(plugin, &process);
+        process.in_events = inEvents.get();
+        process.steady_time += opts.bufferSize;
+    }
+
+    // Benchmark, timing every block individually
+    PerfCounters::Values unused;
+    uint64_t generateNs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t b = 0; b < blocks; ++b) {
+        if (automation) {
+            auto generateStart = std::chrono::steady_clock::now();
+            nextAutomation(false);
+            generateNs += elapsedNs(generateStart, std::chrono::steady_clock::now());
+        }
+        std::optional<PerfCounters::Scope> scope;
+        if (hooks.counters) scope.emplace(*hooks.counters, counted ? *counted : unused);
+        auto blockStart = std::chrono::steady_clock::now();
+        plugin->process(plugin, &process);
+        stats.record(elapsedNs(blockStart, std::chrono::steady_clock::now()));
+        process.steady_time += opts.bufferSize;
+    }
+    return elapsedNs(start, std::chrono::steady_clock::now()) - generateNs;
+}
+
+// Median change (relative) beyond which a noisy first run is dropped
+static constexpr double NOISY_RUN_TOLERANCE = 0.05;
+
+// Repeated runs of one benchmark, pooled
+struct RepeatedBench {
+    BlockStats stats;
+    uint64_t wallNs = 0;
+    uint32_t runs = 0;  // Runs kept
+    std::vector<uint64_t> runMedians;
+    bool droppedFirstRun = false;
+    double firstRunDeviation = 0.0;
+    PerfCounters::Values counters;  // Kept runs only
+
+    RepeatedBench(uint32_t bufferSize, uint32_t sampleRate) : stats(bufferSize, sampleRate) {}
+};
+
+// Run the benchmark `repetitions` times; a first run that is an outlier
+// against the others is left out of the pooled result
+template<typename Buffers>
+static void runRepeatedBench(const Options& opts, const clap_plugin_t* plugin, uint32_t blocks,
+                             uint32_t repetitions, RepeatedBench& out, const BenchHooks& hooks = {}) {
+    std::vector<BlockStats> runs;
+    std::vector<uint64_t> wallNs;
+    std::vector<uint64_t> medians;
+    std::vector<PerfCounters::Values> counted(repetitions);
+    for (uint32_t r = 0; r < repetitions; ++r) {
+        runs.emplace_back(opts.bufferSize, opts.sampleRate);
+        wallNs.push_back(runSingleBench<Buffers>(opts, plugin, blocks, runs.back(), hooks, &counted[r]));
+        medians.push_back(runs.back().histogram.valueAtPercentile(50.0));
+    }
+
+    size_t first = 0;
+    if (isNoisyFirstRun(medians, NOISY_RUN_TOLERANCE, &out.firstRunDeviation)) {
+        out.droppedFirstRun = true;
+        first = 1;
+    }
+    for (size_t r = first; r < runs.size(); ++r) {
+        out.stats.merge(runs[r]);
+        out.wallNs += wallNs[r];
+        out.runMedians.push_back(medians[r]);
+        out.counters.add(counted[r]);
+        out.runs++;
+    }
+}
+
+static TimingStats timingStats(std::string name, const RepeatedBench& bench, double realtime) {
+    TimingStats timing = timingStats(std::move(name), bench.stats, realtime);
+    if (bench.runMedians.size() > 1) timing.runMediansNs = bench.runMedians;
+    Json counters = counterJson(bench.counters, bench.stats.histogram.count());
+    if (!counters.members().empty()) timing.counters = std::move(counters);
+    return timing;
+}
+
+static void printRepeatedBench(const RepeatedBench& bench) {
+    if (bench.droppedFirstRun) {
+        say("    dropped noisy first run (%+.1f%% vs the others)\n", 100.0 * bench.firstRunDeviation);
+    }
+    printBlockStats(bench.stats);
+    printCounters("    ", bench.counters, bench.stats.histogram.count());
+}
+
+static const Json* findBaselinePlugin(const Json& baseline, const std::string& id) {
+    const Json* plugins = baseline.get("plugins");
+    if (!plugins) return nullptr;
+    for (const auto& plugin : plugins->items()) {
+        const Json* pluginId = plugin.get("id");
+        if (pluginId && pluginId->asString() == id) return &plugin;
+    }
+    return nullptr;
+}
+
+// Compare every timing in the report against the baseline file. Returns
+// false on a significant slowdown or an unreadable baseline.
+static bool compareWithBaseline(const Options& opts, Report& report) {
+    std::ifstream file(opts.compareFile, std::ios::binary);
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string error = file ? "" : "Cannot open file";
+    Json baseline = error.empty() ? Json::parse(text, &error) : Json();
+    if (!error.empty()) {
+        fprintf(stderr, "ERROR: Cannot read baseline %s: %s\n", opts.compareFile, error.c_str());
+        report.check("baseline", false, error);
+        return false;
+    }
+    report.check("baseline", true);
+
+    if (const Json* host = baseline.get("host")) {
+        uint32_t rate = static_cast<uint32_t>(host->get("sampleRate") ? host->get("sampleRate")->asNumber() : 0);
+        uint32_t size = static_cast<uint32_t>(host->get("bufferSize") ? host->get("bufferSize")->asNumber() : 0);
+        if (rate != opts.sampleRate || size != opts.bufferSize) {
+            fprintf(stderr, "WARNING: Baseline was recorded at %u Hz / %u samples\n", rate, size);
+        }
+    }
+
+    say("\nCompared with %s (threshold %.1f%%):\n", opts.compareFile, 100.0 * opts.threshold);
+    bool ok = true;
+    for (auto& result : report.plugins) {
+        const Json* basePlugin = findBaselinePlugin(baseline, result.id);
+        if (!basePlugin) {
+            say("  %-30s not in baseline\n", result.name.c_str());
+            continue;
+        }
+
+        Json comparisons = Json::array();
+        for (const auto& timing : result.timings) {
+            TimingStats base;
+            bool found = false;
+            if (const Json* baseTimings = basePlugin->get("timings")) {
+                for (const auto& t : baseTimings->items()) {
+                    if (TimingStats::fromJson(t, base) && base.name == timing.name) {
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            if (!found) {
+                say("  %-30s %-8s not in baseline\n", result.name.c_str(), timing.name.c_str());
+                continue;
+            }
+
+            TimingComparison cmp = compareTimings(base, timing, opts.threshold);
+            const char* verdict = cmp.regressed ? "REGRESSED" : cmp.improved ? "faster" : "ok";
+            char interval[64] = "CI n/a";
+            if (cmp.hasInterval) {
+                snprintf(interval, sizeof(interval), "95%% CI [%+.1f%%, %+.1f%%]",
+                         100.0 * cmp.changeLow, 100.0 * cmp.changeHigh);
+            }
+            say("  %-30s %-8s median %.2f -> %.2f µs  %+6.1f%%  %s  p=%.3g  %s\n",
+                result.name.c_str(), timing.name.c_str(), cmp.baselineMedianNs / 1000.0,
+                cmp.currentMedianNs / 1000.0, 100.0 * cmp.change, interval, cmp.pValue, verdict);
+
+            char detail[96];
+            snprintf(detail, sizeof(detail), "%+.1f%% median, p=%.3g", 100.0 * cmp.change, cmp.pValue);
+            result.check("regression." + timing.name, !cmp.regressed, detail);
+
+            Json entry = Json::object();
+            entry.set("name", timing.name)
+                 .set("baselineMedianNs", cmp.baselineMedianNs)
+                 .set("currentMedianNs", cmp.currentMedianNs)
+                 .set("change", cmp.change)
+                 .set("pValue", cmp.pValue)
+                 .set("regressed", cmp.regressed)
+                 .set("improved", cmp.improved);
+            if (cmp.hasInterval) entry.set("changeLow", cmp.changeLow).set("changeHigh", cmp.changeHigh);
+            comparisons.push(std::move(entry));
+            if (cmp.regressed) ok = false;
+        }
+        result.details.set("comparison", std::move(comparisons));
+    }
+    return ok;
+}
+
+//-----------------------------------------------------------------------------
+// Parameter sweeps
+//-----------------------------------------------------------------------------
+
+static constexpr uint32_t DEFAULT_SWEEP_STEPS = 5;
+static constexpr uint32_t DEFAULT_SWEEP_BLOCKS = 2000;
+static constexpr uint32_t MAX_STEPPED_SWEEP_VALUES = 32;  // Stepped params below this get every value
+static constexpr size_t MAX_SWEEP_POINTS = 10000;
+static constexpr double SWEEP_CLIFF_RATIO = 2.0;  // Points this much slower than the cheapest are marked
+
+// One swept parameter and the values it takes
+struct SweepAxis {
+    clap_param_info_t info;
+    std::vector<double> values;
+};
+
+static std::vector<double> sweepValues(const clap_param_info_t& info, uint32_t steps) {
+    double range = info.max_value - info.min_value;
+    std::vector<double> values;
+    if (info.flags & CLAP_PARAM_IS_STEPPED) {
+        auto count = static_cast<uint64_t>(std::llround(range)) + 1;
+        if (steps == 0 && count <= MAX_STEPPED_SWEEP_VALUES) steps = static_cast<uint32_t>(count);
+        if (steps == 0) steps = DEFAULT_SWEEP_STEPS;
+        if (steps < 2) return {info.min_value};  // One value, or no range to spread over
+        for (uint32_t k = 0; k < steps; ++k) {
+            double value = std::round(info.min_value + range * k / (steps - 1));
+            if (values.empty() || value != values.back()) values.push_back(value);
+        }
+        return values;
+    }
+
+    if (steps == 0) steps = DEFAULT_SWEEP_STEPS;
+    if (steps < 2) return {info.min_value};
+    for (uint32_t k = 0; k < steps; ++k) {
+        values.push_back(info.min_value + range * k / (steps - 1));
+    }
+    return values;
+}
+
+// Find a parameter by decimal id or by name
+static bool findParamInfo(const clap_plugin_t* plugin, const clap_plugin_params_t* params,
+                           const std::string& key, clap_param_info_t& out) {
+    char* end = nullptr;
+    unsigned long id = strtoul(key.c_str(), &end, 10);
+    bool numeric = end != key.c_str() && *end == '\0';
+
+    uint32_t count = params->count(plugin);
+    for (uint32_t i = 0; i < count; ++i) {
+        clap_param_info_t info{};
+        if (!params->get_info(plugin, i, &info)) continue;
+        if ((numeric && info.id == id) || key == info.name) {
+            out = info;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Resolve --sweep arguments into groups of axes. Explicit parameters form
+// one grid; "all" sweeps every automatable parameter on its own.
+static bool buildSweeps(const Options& opts, const clap_plugin_t* plugin, const clap_plugin_params_t* params,
+                        std::vector<std::vector<SweepAxis>>& groups, std::string& error) {
+    bool all = std::any_of(opts.sweeps.begin(), opts.sweeps.end(),
+                           [](const SweepSpec& s) { return s.param == "all"; });
+    if (all) {
+        if (opts.sweeps.size() > 1) {
+            error = "--sweep all cannot be combined with other --sweep options";
+            return false;
+        }
+        uint32_t count = params->count(plugin);
+        for (uint32_t i = 0; i < count; ++i) {
+            clap_param_info_t info{};
+            if (!params->get_info(plugin, i, &info)) continue;
+            if (!(info.flags & CLAP_PARAM_IS_AUTOMATABLE) || (info.flags & CLAP_PARAM_IS_READONLY)) continue;
+            groups.push_back({{info, sweepValues(info, opts.sweeps[0].steps)}});
+        }
+        if (groups.empty()) error = "no automatable parameters";
+        return !groups.empty();
+    }
+
+    std::vector<SweepAxis> grid;
+    size_t points = 1;
+    for (const auto& spec : opts.sweeps) {
+        SweepAxis axis;
+        if (!findParamInfo(plugin, params, spec.param, axis.info)) {
+            error = "no parameter '" + spec.param + "'";
+            return false;
+        }
+        axis.values = sweepValues(axis.info, spec.steps);
+        points *= axis.values.size();
+        grid.push_back(std::move(axis));
+    }
+    if (points > MAX_SWEEP_POINTS) {
+        error = std::to_string(points) + " sweep points (limit " + std::to_string(MAX_SWEEP_POINTS) + ")";
+        return false;
+    }
+    groups.push_back(std::move(grid));
+    return true;
+}
+
+static std::string sweepValueText(const clap_plugin_t* plugin, const clap_plugin_params_t* params,
+                                  clap_id id, double value) {
+    char text[64];
+    if (!params->value_to_text || !params->value_to_text(plugin, id, value, text, sizeof(text))) {
+        snprintf(text, sizeof(text), "%.4g", value);
+    }
+    return text;
+}
+
+// Bench one activated instance at every point of each sweep group;
+// false if the sweep could not be set up
+static bool benchSweep(const Options& opts, const clap_plugin_t* plugin, PluginResult& result) {
+    const auto* params = static_cast<const clap_plugin_params_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_PARAMS));
+    if (!params) {
+        say("    sweep    plugin has no parameters\n");
+        result.check("sweep", false, "no params extension");
+        return false;
+    }
+
+    std::vector<std::vector<SweepAxis>> groups;
+    std::string error;
+    if (!buildSweeps(opts, plugin, params, groups, error)) {
+        fprintf(stderr, "ERROR: %s: %s\n", result.name.c_str(), error.c_str());
+        result.check("sweep", false, error);
+        return false;
+    }
+
+    // Swept parameters not in the current group go back to where they started
+    std::vector<std::pair<clap_id, double>> initial;
+    for (const auto& group : groups) {
+        for (const auto& axis : group) {
+            double value = axis.info.default_value;
+            params->get_value(plugin, axis.info.id, &value);
+            initial.emplace_back(axis.info.id, value);
+        }
+    }
+
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : DEFAULT_SWEEP_BLOCKS;
+    SimpleInputEvents setup;
+    Json sweeps = Json::array();
+
+    for (const auto& group : groups) {
+        size_t pointCount = 1;
+        for (const auto& axis : group) pointCount *= axis.values.size();
+
+        say("    sweep    %zu point(s) x %u blocks\n", pointCount, blocks);
+        say("    ");
+        for (const auto& axis : group) say(" %-14.14s", axis.info.name);
+        say(" %10s %10s %7s\n", "µs/block", "p99 µs", "vs min");
+
+        struct Point {
+            std::vector<double> values;
+            TimingStats timing;
+        };
+        std::vector<Point> points;
+        points.reserve(pointCount);
+
+        std::vector<size_t> index(group.size(), 0);
+        for (size_t n = 0; n < pointCount; ++n) {
+            Point point;
+            setup.clear();
+            for (const auto& [id, value] : initial) setup.addParamValue(0, id, value);
+            for (const auto& p : opts.params) setup.addParamValue(0, p.id, p.value);
+            for (size_t a = 0; a < group.size(); ++a) {
+                double value = group[a].values[index[a]];
+                setup.addParamValue(0, group[a].info.id, value);
+                point.values.push_back(value);
+            }
+
+            BlockStats stats(opts.bufferSize, opts.sampleRate);
+            uint64_t wallNs = runSingleBench<StereoAudioBuffers>(opts, plugin, blocks, stats,
+                                                                 BenchHooks{setup.get()});
+            double realtime = static_cast<double>(blocks) * opts.bufferSize / opts.sampleRate / (wallNs / 1e9);
+            point.timing = timingStats("sweep", stats, realtime);
+            points.push_back(std::move(point));
+
+            // Last axis varies fastest
+            for (size_t a = group.size(); a-- > 0;) {
+                if (++index[a] < group[a].values.size()) break;
+                index[a] = 0;
+            }
+        }
+
+        double cheapest = 0.0;
+        size_t slowest = 0;
+        for (size_t n = 0; n < points.size(); ++n) {
+            double mean = points[n].timing.meanNs;
+            if (n == 0 || mean < cheapest) cheapest = mean;
+            if (mean > points[slowest].timing.meanNs) slowest = n;
+        }
+
+        Json axes = Json::array();
+        for (const auto& axis : group) {
+            Json a = Json::object();
+            a.set("id", axis.info.id)
+             .set("name", axis.info.name)
+             .set("min", axis.info.min_value)
+             .set("max", axis.info.max_value)
+             .set("stepped", (axis.info.flags & CLAP_PARAM_IS_STEPPED) != 0);
+            axes.push(std::move(a));
+        }
+
+        Json pointList = Json::array();
+        for (const auto& point : points) {
+            double relative = cheapest > 0.0 ? point.timing.meanNs / cheapest : 1.0;
+            say("    ");
+            for (size_t a = 0; a < group.size(); ++a) {
+                say(" %-14.14s", sweepValueText(plugin, params, group[a].info.id, point.values[a]).c_str());
+            }
+            say(" %9.1f %9.1f %6.1fx%s\n", point.timing.meanNs / 1000.0, point.timing.p99Ns / 1000.0,
+                relative, relative >= SWEEP_CLIFF_RATIO ? "  <-" : "");
+
+            Json values = Json::array();
+            for (double v : point.values) values.push(v);
+            Json p = Json::object();
+            p.set("values", std::move(values))
+             .set("meanNs", point.timing.meanNs)
+             .set("p50Ns", point.timing.p50Ns)
+             .set("p99Ns", point.timing.p99Ns)
+             .set("maxNs", point.timing.maxNs)
+             .set("deadlineMisses", point.timing.deadlineMisses)
+             .set("relative", relative);
+            pointList.push(std::move(p));
+        }
+
+        if (points.size() > 1 && cheapest > 0.0) {
+            std::string where;
+            for (size_t a = 0; a < group.size(); ++a) {
+                if (a > 0) where += ", ";
+                where += std::string(group[a].info.name) + " = " +
+                         sweepValueText(plugin, params, group[a].info.id, points[slowest].values[a]);
+            }
+            say("     slowest at %s: %.1fx the cheapest point\n",
+                where.c_str(), points[slowest].timing.meanNs / cheapest);
+        }
+
+        Json sweep = Json::object();
+        sweep.set("blocksPerPoint", blocks)
+             .set("params", std::move(axes))
+             .set("points", std::move(pointList));
+        sweeps.push(std::move(sweep));
+    }
+
+    result.check("sweep", true);
+    result.details.set("sweeps", std::move(sweeps));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Automation stress
+//-----------------------------------------------------------------------------
+
+static const char* shapeName(AutomationShape shape) {
+    switch (shape) {
+        case AutomationShape::Ramp:   return "ramp";
+        case AutomationShape::Lfo:    return "lfo";
+        case AutomationShape::Random: return "random";
+    }
+    return "?";
+}
+
+static AutomationLane automationLane(const clap_param_info_t& info, AutomationShape shape, bool modulate) {
+    AutomationLane lane;
+    lane.paramId = info.id;
+    lane.minValue = info.min_value;
+    lane.maxValue = info.max_value;
+    lane.stepped = (info.flags & CLAP_PARAM_IS_STEPPED) != 0;
+    lane.modulation = modulate;
+    lane.shape = shape;
+    return lane;
+}
+
+// Resolve --automate arguments into lanes. Without any, every automatable
+// parameter (or every modulatable one with --modulate) gets an LFO.
+static bool buildAutomationLanes(const Options& opts, const clap_plugin_t* plugin,
+                                 const clap_plugin_params_t* params,
+                                 std::vector<AutomationLane>& lanes, std::string& error) {
+    clap_param_info_flags required = opts.modulate ? CLAP_PARAM_IS_MODULATABLE : CLAP_PARAM_IS_AUTOMATABLE;
+
+    if (opts.automate.empty()) {
+        uint32_t count = params->count(plugin);
+        for (uint32_t i = 0; i < count; ++i) {
+            clap_param_info_t info{};
+            if (!params->get_info(plugin, i, &info)) continue;
+            if (!(info.flags & required) || (info.flags & CLAP_PARAM_IS_READONLY)) continue;
+            lanes.push_back(automationLane(info, AutomationShape::Lfo, opts.modulate));
+        }
+        if (lanes.empty()) {
+            error = opts.modulate ? "no modulatable parameters" : "no automatable parameters";
+        }
+        return !lanes.empty();
+    }
+
+    for (const auto& spec : opts.automate) {
+        clap_param_info_t info{};
+        if (!findParamInfo(plugin, params, spec.param, info)) {
+            error = "no parameter '" + spec.param + "'";
+            return false;
+        }
+        if (!(info.flags & required)) {
+            error = std::string("parameter '") + info.name + "' is not " +
+                    (opts.modulate ? "modulatable" : "automatable");
+            return false;
+        }
+        lanes.push_back(automationLane(info, spec.shape, opts.modulate));
+    }
+    return true;
+}
+
+// Bench again with dense automation and report the cost against the static run
+static bool benchAutomation(const Options& opts, const clap_plugin_t* plugin, uint32_t blocks,
+                            uint32_t repetitions, BenchHooks hooks,
+                            const RepeatedBench& staticBench, PluginResult& result) {
+    const auto* params = static_cast<const clap_plugin_params_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_PARAMS));
+    std::vector<AutomationLane> lanes;
+    std::string error = "plugin has no parameters";
+    if (!params || !buildAutomationLanes(opts, plugin, params, lanes, error)) {
+        fprintf(stderr, "ERROR: %s: %s\n", result.name.c_str(), error.c_str());
+        result.check("automation", false, error);
+        return false;
+    }
+
+    AutomationGenerator automation(lanes, opts.sampleRate, opts.automationRate);
+    RepeatedBench bench(opts.bufferSize, opts.sampleRate);
+    hooks.automation = &automation;
+    runRepeatedBench<StereoAudioBuffers>(opts, plugin, blocks, repetitions, bench, hooks);
+    double audioSeconds = static_cast<double>(blocks) * bench.runs * opts.bufferSize / opts.sampleRate;
+    double realtime = audioSeconds / (bench.wallNs / 1e9);
+    double usPerBlock = bench.stats.histogram.mean() / 1000.0;
+    double staticUs = staticBench.stats.histogram.mean() / 1000.0;
+    double penalty = staticUs > 0.0 ? usPerBlock / staticUs - 1.0 : 0.0;
+    uint32_t perLane = std::min(opts.automationRate, opts.bufferSize);
+    const char* kind = opts.modulate ? "mod" : "value";
+
+    say("    automated %7.1fx realtime  %6.1f µs/block  (%+.1f%% vs static; %zu param(s) x %u %s events/block)\n",
+        realtime, usPerBlock, 100.0 * penalty, lanes.size(), perLane, kind);
+    printRepeatedBench(bench);
+    result.timings.push_back(timingStats("automation", bench, realtime));
+
+    Json laneList = Json::array();
+    for (const auto& lane : lanes) {
+        Json l = Json::object();
+        l.set("id", lane.paramId).set("shape", shapeName(lane.shape));
+        laneList.push(std::move(l));
+    }
+    Json details = Json::object();
+    details.set("eventsPerBlock", perLane)
+           .set("events", kind)
+           .set("params", std::move(laneList))
+           .set("staticMeanNs", staticBench.stats.histogram.mean())
+           .set("automatedMeanNs", bench.stats.histogram.mean())
+           .set("penalty", penalty);
+    result.details.set("automation", std::move(details));
+    result.check("automation", true);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Polyphony scaling
+//-----------------------------------------------------------------------------
+
+static constexpr uint32_t DEFAULT_VOICE_BLOCKS = 2000;
+static constexpr uint32_t VOICE_BURSTS = 5;          // Note-on bursts timed per voice count
+static constexpr uint32_t VOICE_SETTLE_BLOCKS = 20;  // Blocks after a choke and after a burst
+
+// Note input dialect the polyphony bench uses, or 0 if there is no note input
+static uint32_t voiceDialect(const clap_plugin_t* plugin) {
+    const auto* notePorts = static_cast<const clap_plugin_note_ports_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_NOTE_PORTS));
+    clap_note_port_info_t info{};
+    if (!notePorts || notePorts->count(plugin, true) == 0 || !notePorts->get(plugin, 0, true, &info)) {
+        return 0;
+    }
+    if (info.supported_dialects & CLAP_NOTE_DIALECT_CLAP) return CLAP_NOTE_DIALECT_CLAP;
+    if (info.supported_dialects & CLAP_NOTE_DIALECT_MIDI) return CLAP_NOTE_DIALECT_MIDI;
+    return 0;
+}
+
+// Add note-ons (or note-offs and chokes) for voices [0, count) at time 0
+static void addVoiceEvents(SimpleInputEvents& events, uint32_t dialect, uint32_t count, bool on) {
+    for (uint32_t v = 0; v < count; ++v) {
+        auto channel = static_cast<int16_t>(v / 128);
+        auto key = static_cast<int16_t>(v % 128);
+        auto noteId = static_cast<int32_t>(v);
+        if (dialect == CLAP_NOTE_DIALECT_MIDI) {
+            uint8_t status = static_cast<uint8_t>((on ? 0x90 : 0x80) | channel);
+            events.addMidi(0, 0, status, static_cast<uint8_t>(key), on ? 100 : 0);
+        } else if (on) {
+            events.addNoteOn(0, 0, channel, key, noteId, 0.8);
+        } else {
+            events.addNoteOff(0, 0, channel, key, noteId, 0.0);
+            events.addNoteChoke(0, 0, channel, key, noteId);
+        }
+    }
+}
+
+// Bench held chords of each --voices count: the note-on burst block and
+// the steady state while the notes are held
+static void benchVoices(const Options& opts, const clap_plugin_t* plugin, double idleMeanNs,
+                        PluginResult& result) {
+    uint32_t dialect = voiceDialect(plugin);
+    if (dialect == 0) {
+        say("    voices   no CLAP or MIDI note input, skipped\n");
+        result.details.set("voices", "no note input");
+        return;
+    }
+
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : DEFAULT_VOICE_BLOCKS;
+    uint32_t maxVoices = *std::max_element(opts.voices.begin(), opts.voices.end());
+
+    TestHost::AudioThreadScope audio;
+    StereoAudioBuffers buffers(opts.bufferSize, opts.bufferLayout);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+    EmptyInputEvents noEvents;
+    SimpleInputEvents events(SimpleInputEvents::DEFAULT_CAPACITY_BYTES,
+                             std::max(SimpleInputEvents::DEFAULT_MAX_EVENTS, 2 * maxVoices));
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.frames_count = opts.bufferSize;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.out_events = outEvents.get();
+
+    auto runBlock = [&](const clap_input_events_t* in) {
+        process.in_events = in;
+        auto blockStart = std::chrono::steady_clock::now();
+        plugin->process(plugin, &process);
+        uint64_t ns = elapsedNs(blockStart, std::chrono::steady_clock::now());
+        process.steady_time += opts.bufferSize;
+        return ns;
+    };
+    auto release = [&](uint32_t count) {
+        events.clear();
+        addVoiceEvents(events, dialect, count, false);
+        runBlock(events.get());
+        for (uint32_t b = 0; b < VOICE_SETTLE_BLOCKS; ++b) runBlock(noEvents.get());
+    };
+
+    say("    %6s %10s %11s %13s %10s %7s\n",
+        "voices", "µs/block", "µs/voice", "note-on µs", "p99 µs", "missed");
+
+    Json levels = Json::array();
+    for (uint32_t count : opts.voices) {
+        // Time the note-on block a few times, releasing the chord in between
+        LatencyHistogram bursts;
+        for (uint32_t r = 0; r < VOICE_BURSTS; ++r) {
+            if (r > 0) release(count);
+            events.clear();
+            addVoiceEvents(events, dialect, count, true);
+            bursts.record(runBlock(events.get()));
+        }
+        for (uint32_t b = 0; b < VOICE_SETTLE_BLOCKS; ++b) runBlock(noEvents.get());
+
+        // Steady state with the chord held
+        BlockStats stats(opts.bufferSize, opts.sampleRate);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t b = 0; b < blocks; ++b) stats.record(runBlock(noEvents.get()));
+        uint64_t wallNs = elapsedNs(start, std::chrono::steady_clock::now());
+        release(count);
+
+        double realtime = static_cast<double>(blocks) * opts.bufferSize / opts.sampleRate / (wallNs / 1e9);
+        TimingStats timing = timingStats("voices." + std::to_string(count), stats, realtime);
+        double perVoiceNs = (timing.meanNs - idleMeanNs) / count;
+        uint64_t burstNs = bursts.valueAtPercentile(50.0);
+
+        say("    %6u %9.1f %10.2f %12.1f %9.1f %7llu\n", count, timing.meanNs / 1000.0,
+            perVoiceNs / 1000.0, burstNs / 1000.0, timing.p99Ns / 1000.0,
+            static_cast<unsigned long long>(timing.deadlineMisses));
+
+        Json level = Json::object();
+        level.set("voices", count)
+             .set("meanNs", timing.meanNs)
+             .set("perVoiceNs", perVoiceNs)
+             .set("noteOnBlockNs", burstNs)
+             .set("noteOnBlockMaxNs", bursts.max())
+             .set("p99Ns", timing.p99Ns);
+        levels.push(std::move(level));
+        result.timings.push_back(std::move(timing));
+    }
+
+    Json details = Json::object();
+    details.set("dialect", dialect == CLAP_NOTE_DIALECT_MIDI ? "midi" : "clap")
+           .set("blocksPerLevel", blocks)
+           .set("idleMeanNs", idleMeanNs)
+           .set("levels", std::move(levels));
+    result.details.set("voices", std::move(details));
+}
+
+//-----------------------------------------------------------------------------
+// Silent and constant input
+//-----------------------------------------------------------------------------
+
+static constexpr uint32_t DEFAULT_IDLE_BLOCKS = 2000;
+static constexpr float CONSTANT_INPUT_LEVEL = 0.25f;
+static constexpr float QUIET_PEAK = 1e-6f;  // -120 dB; quieter output counts as silence
+
+enum class IdleInput { Silence, Constant };
+
+static const char* processStatusName(clap_process_status status) {
+    switch (status) {
+        case CLAP_PROCESS_ERROR:                 return "error";
+        case CLAP_PROCESS_CONTINUE:              return "continue";
+        case CLAP_PROCESS_CONTINUE_IF_NOT_QUIET: return "continueIfNotQuiet";
+        case CLAP_PROCESS_TAIL:                  return "tail";
+        case CLAP_PROCESS_SLEEP:                 return "sleep";
+        default:                                 return "unknown";
+    }
+}
+
+// Bench input flagged constant in constant_mask. With silence, process() is
+// skipped once the plugin may sleep, as a host would: after SLEEP, or after
+// CONTINUE_IF_NOT_QUIET or TAIL with quiet output. Constant non-silent input
+// never lets the plugin sleep. The idle cost counts skipped blocks as free.
+static void benchIdle(const Options& opts, const clap_plugin_t* plugin, IdleInput input, double activeMeanNs,
+                      PluginResult& result) {
+    bool silence = input == IdleInput::Silence;
+    const char* name = silence ? "silence" : "constant";
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : DEFAULT_IDLE_BLOCKS;
+
+    TestHost::AudioThreadScope audio;
+    StereoAudioBuffers buffers(opts.bufferSize, opts.bufferLayout);
+    buffers.fillInputWithConstant(silence ? 0.0f : CONSTANT_INPUT_LEVEL);
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.frames_count = opts.bufferSize;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = inEvents.get();
+    process.out_events = outEvents.get();
+
+    // The plugin has just processed a sine; its tail decays during the run
+    BlockStats stats(opts.bufferSize, opts.sampleRate);
+    uint64_t statusCounts[CLAP_PROCESS_SLEEP + 1] = {};
+    uint64_t processedNs = 0;
+    uint64_t constantOutput = 0;
+    uint32_t processed = 0;
+    int64_t sleptAt = -1;
+    bool failed = false;
+    for (uint32_t b = 0; b < blocks && sleptAt < 0; ++b) {
+        buffers.outputBuffer()->constant_mask = 0;
+        auto blockStart = std::chrono::steady_clock::now();
+        clap_process_status status = plugin->process(plugin, &process);
+        uint64_t ns = elapsedNs(blockStart, std::chrono::steady_clock::now());
+        stats.record(ns);
+        processedNs += ns;
+        processed++;
+        process.steady_time += opts.bufferSize;
+        if (status < 0 || status > CLAP_PROCESS_SLEEP) {
+            failed = true;
+            break;
+        }
+        statusCounts[status]++;
+        if (status == CLAP_PROCESS_ERROR) {
+            failed = true;
+            break;
+        }
+        if (buffers.outputBuffer()->constant_mask != 0) constantOutput++;
+        if (!silence) continue;
+
+        bool quiet = status == CLAP_PROCESS_SLEEP ||
+                     ((status == CLAP_PROCESS_CONTINUE_IF_NOT_QUIET || status == CLAP_PROCESS_TAIL) &&
+                      buffers.analyzeOutput().peak < QUIET_PEAK);
+        if (quiet) sleptAt = b;
+    }
+
+    uint32_t skipped = failed ? 0 : blocks - processed;
+    double idleNs = static_cast<double>(processedNs) / blocks;
+    double blockNs = 1e9 * opts.bufferSize / opts.sampleRate;
+    double share = activeMeanNs > 0 ? 100.0 * idleNs / activeMeanNs : 0.0;
+
+    if (failed) {
+        say("    %-8s process() failed at block %u\n", name, processed - 1);
+    } else if (sleptAt >= 0) {
+        say("    %-8s %8.3f µs/block  (%.1f%% of a sine block, %.3f%% of a core)  asleep after %lld block(s), "
+            "%u/%u skipped\n", name, idleNs / 1000.0, share, 100.0 * idleNs / blockNs,
+            static_cast<long long>(sleptAt + 1), skipped, blocks);
+    } else {
+        say("    %-8s %8.3f µs/block  (%.1f%% of a sine block, %.3f%% of a core)  %s\n", name, idleNs / 1000.0,
+            share, 100.0 * idleNs / blockNs, silence ? "never slept" : "processed every block");
+    }
+
+    std::string statusText;
+    Json statuses = Json::object();
+    for (int st = CLAP_PROCESS_CONTINUE; st <= CLAP_PROCESS_SLEEP; ++st) {
+        if (statusCounts[st] == 0) continue;
+        statuses.set(processStatusName(st), statusCounts[st]);
+        statusText += std::string(statusText.empty() ? "" : ", ") + processStatusName(st) + " " +
+                      std::to_string(statusCounts[st]);
+    }
+    if (!statusText.empty()) {
+        say("             returned %s; constant output in %llu block(s)\n", statusText.c_str(),
+            static_cast<unsigned long long>(constantOutput));
+    }
+
+    double audioSeconds = static_cast<double>(blocks) * opts.bufferSize / opts.sampleRate;
+    double realtime = processedNs > 0 ? audioSeconds / (processedNs / 1e9) : 0.0;
+    result.timings.push_back(timingStats(name, stats, realtime));
+
+    Json details = Json::object();
+    details.set("blocks", blocks)
+           .set("processed", processed)
+           .set("skipped", skipped)
+           .set("asleepAfter", sleptAt >= 0 ? Json(sleptAt + 1) : Json())
+           .set("idleNsPerBlock", idleNs)
+           .set("activeMeanNs", activeMeanNs)
+           .set("statuses", std::move(statuses))
+           .set("constantOutputBlocks", constantOutput)
+           .set("failed", failed);
+    result.details.set(name, std::move(details));
+}
+
+//-----------------------------------------------------------------------------
+// Host thread pool
+//-----------------------------------------------------------------------------
+
+// Tasks shorter than this on average hardly pay for waking the pool
+static constexpr double FINE_GRAINED_TASK_NS = 5000.0;
+
+// Bench a fresh instance on a host offering a thread pool of each
+// --pool-threads size, against the pool-less run (`referenceNs` per block)
+static void benchThreadPool(const Options& opts, const clap_plugin_factory_t* factory,
+                            const clap_plugin_descriptor_t* desc, uint32_t blocks, uint32_t repetitions,
+                            const clap_input_events_t* setup, double referenceNs, PluginResult& result) {
+    Json levels = Json::array();
+    double bestSpeedup = 0.0;
+    double taskNsSum = 0.0;
+    uint64_t taskCount = 0;
+    for (uint32_t workers : opts.poolThreads) {
+        // Plugins look up host extensions in init(), so every size gets a new instance
+        TestHost host;
+        host.enableThreadPool(workers, opts.pinThreads);
+        const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
+        if (!plugin || !plugin->init(plugin)) {
+            if (plugin) plugin->destroy(plugin);
+            say("    %12u  create_plugin() or init() failed\n", workers);
+            continue;
+        }
+        host.setPlugin(plugin);
+        if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
+            plugin->destroy(plugin);
+            say("    %12u  activate() failed\n", workers);
+            continue;
+        }
+        if (!plugin->start_processing(plugin)) {
+            plugin->deactivate(plugin);
+            plugin->destroy(plugin);
+            say("    %12u  start_processing() failed\n", workers);
+            continue;
+        }
+
+        BenchHooks hooks;
+        hooks.setup = setup;
+        RepeatedBench bench(opts.bufferSize, opts.sampleRate);
+        runRepeatedBench<StereoAudioBuffers>(opts, plugin, blocks, repetitions, bench, hooks);
+        ThreadPool::Stats stats = host.threadPool()->stats();
+
+        plugin->stop_processing(plugin);
+        plugin->deactivate(plugin);
+        plugin->destroy(plugin);
+
+        if (stats.runs == 0 && stats.rejected == 0) {
+            say("    thread pool  not used: the plugin never called request_exec()\n");
+            result.details.set("threadPool", Json::object().set("used", false));
+            return;
+        }
+
+        double audioSeconds = static_cast<double>(blocks) * bench.runs * opts.bufferSize / opts.sampleRate;
+        TimingStats timing = timingStats("pool." + std::to_string(workers), bench, audioSeconds / (bench.wallNs / 1e9));
+        double speedup = timing.meanNs > 0.0 ? referenceNs / timing.meanNs : 0.0;
+        double tasksPerExec = stats.runs > 0 ? static_cast<double>(stats.tasks) / stats.runs : 0.0;
+        double meanTaskNs = stats.tasks > 0 ? static_cast<double>(stats.taskNs) / stats.tasks : 0.0;
+        double stolen = stats.tasks > 0 ? static_cast<double>(stats.stolen) / stats.tasks : 0.0;
+        bestSpeedup = std::max(bestSpeedup, speedup);
+        taskNsSum += static_cast<double>(stats.taskNs);
+        taskCount += stats.tasks;
+
+        if (levels.size() == 0) {
+            say("    %12s %10s %9s %11s %9s %7s\n", "pool workers", "µs/block", "speedup", "tasks/exec", "µs/task", "stolen");
+            say("    %12s %9.1f %8.2fx\n", "none", referenceNs / 1000.0, 1.0);
+        }
+        say("    %12u %9.1f %8.2fx %11.1f %9.2f %6.0f%%\n", workers, timing.meanNs / 1000.0, speedup,
+            tasksPerExec, meanTaskNs / 1000.0, 100.0 * stolen);
+
+        Json level = Json::object();
+        level.set("workers", workers)
+             .set("meanNs", timing.meanNs)
+             .set("speedup", speedup)
+             .set("execs", stats.runs)
+             .set("rejected", stats.rejected)
+             .set("tasksPerExec", tasksPerExec)
+             .set("meanTaskNs", meanTaskNs)
+             .set("stolenFraction", stolen);
+        levels.push(std::move(level));
+        result.timings.push_back(std::move(timing));
+    }
+
+    double meanTaskNs = taskCount > 0 ? taskNsSum / taskCount : 0.0;
+    bool fineGrained = taskCount > 0 && meanTaskNs < FINE_GRAINED_TASK_NS;
+    if (fineGrained) {
+        say("    ! tasks average %.2f µs, too fine-grained for the pool to pay off\n", meanTaskNs / 1000.0);
+    }
+    if (levels.size() > 0 && bestSpeedup < 1.0) {
+        say("    ! slower with a thread pool than without at every size\n");
+    }
+
+    Json details = Json::object();
+    details.set("used", true)
+           .set("referenceMeanNs", referenceNs)
+           .set("meanTaskNs", meanTaskNs)
+           .set("fineGrained", fineGrained)
+           .set("levels", std::move(levels));
+    result.details.set("threadPool", std::move(details));
+}
+
+//-----------------------------------------------------------------------------
+// Block size / sample rate matrix
+//-----------------------------------------------------------------------------
+
+static const std::vector<uint32_t> MATRIX_SIZES = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+static const std::vector<uint32_t> MATRIX_RATES = {44100, 48000, 88200, 96000, 176400, 192000};
+static constexpr double MATRIX_SECONDS = 1.0;  // Audio per point and mode unless --blocks
+static constexpr uint32_t MATRIX_MIN_BLOCKS = 100;
+
+struct MatrixRun {
+    bool activated = false;
+    double nsPerSample = 0.0;
+    uint64_t p99Ns = 0;  // Per block
+    PerfCounters::Values counters;
+    uint64_t samples = 0;
+};
+
+struct MatrixPoint {
+    uint32_t sampleRate;
+    uint32_t blockSize;
+    MatrixRun fixed;     // frames_count == max_frames
+    MatrixRun variable;  // frames_count random in [1, max_frames]
+};
+
+// Activate at (rate, minFrames, size), then time `blocks` blocks; `setup`
+// events go with the first warm-up block
+static MatrixRun runMatrix(const Options& opts, const clap_plugin_t* plugin, uint32_t sampleRate,
+                           uint32_t size, bool variable, uint32_t blocks,
+                           const clap_input_events_t* setup, PerfCounters* counters) {
+    MatrixRun run;
+    if (!plugin->activate(plugin, sampleRate, variable ? 1 : size, size)) return run;
+    if (!plugin->start_processing(plugin)) {
+        plugin->deactivate(plugin);
+        return run;
+    }
+    run.activated = true;
+    std::optional<TestHost::AudioThreadScope> audio;
+    audio.emplace();
+
+    StereoAudioBuffers buffers(size, opts.bufferLayout);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(sampleRate));
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = inEvents.get();
+    process.out_events = outEvents.get();
+
+    // Same frame sequence for every point with the same size
+    std::mt19937 rng(size);
+    std::uniform_int_distribution<uint32_t> frames(1, size);
+    auto nextFrames = [&] { return variable ? frames(rng) : size; };
+
+    process.in_events = setup;
+    for (uint32_t b = 0; b < std::min(blocks, MATRIX_MIN_BLOCKS); ++b) {
+        process.frames_count = nextFrames();
+        plugin->process(plugin, &process);
+        process.in_events = inEvents.get();
+        process.steady_time += process.frames_count;
+    }
+
+    LatencyHistogram histogram;
+    uint64_t totalNs = 0;
+    if (counters) counters->start();
+    for (uint32_t b = 0; b < blocks; ++b) {
+        process.frames_count = nextFrames();
+        auto blockStart = std::chrono::steady_clock::now();
+        plugin->process(plugin, &process);
+        uint64_t ns = elapsedNs(blockStart, std::chrono::steady_clock::now());
+        histogram.record(ns);
+        totalNs += ns;
+        run.samples += process.frames_count;
+        process.steady_time += process.frames_count;
+    }
+    if (counters) {
+        counters->stop();
+        run.counters = counters->read();
+    }
+
+    plugin->stop_processing(plugin);
+    audio.reset();
+    plugin->deactivate(plugin);
+
+    run.nsPerSample = static_cast<double>(totalNs) / static_cast<double>(run.samples);
+    run.p99Ns = histogram.valueAtPercentile(99.0);
+    return run;
+}
+
+static void printMatrixTable(const char* title, const std::vector<uint32_t>& sizes,
+                             const std::vector<uint32_t>& rates, const std::vector<MatrixPoint>& points,
+                             MatrixRun MatrixPoint::*mode) {
+    say("\n    µs/sample, %s\n", title);
+    say("    %8s", "rate");
+    for (uint32_t size : sizes) say(" %8u", size);
+    say("\n");
+    for (size_t r = 0; r < rates.size(); ++r) {
+        say("    %8u", rates[r]);
+        for (size_t c = 0; c < sizes.size(); ++c) {
+            const MatrixRun& run = points[r * sizes.size() + c].*mode;
+            if (run.activated) {
+                say(" %8.4f", run.nsPerSample / 1000.0);
+            } else {
+                say(" %8s", "-");
+            }
+        }
+        say("\n");
+    }
+}
+
+static Json matrixRunJson(const MatrixRun& run) {
+    Json out = Json::object();
+    out.set("activated", run.activated);
+    if (!run.activated) return out;
+    out.set("nsPerSample", run.nsPerSample).set("p99Ns", run.p99Ns).set("samples", run.samples);
+    Json counters = Json::object();
+    for (int c = 0; c < PerfCounters::COUNTER_COUNT; ++c) {
+        if (run.counters.valid[c]) {
+            counters.set(PerfCounters::name(static_cast<PerfCounters::Counter>(c)), run.counters.value[c]);
+        }
+    }
+    if (!counters.members().empty()) out.set("counters", std::move(counters));
+    return out;
+}
+
+// Bench an initialized (inactive) plugin at every block size and sample rate
+static void benchMatrix(const Options& opts, const clap_plugin_t* plugin, PluginResult& result) {
+    const auto& sizes = opts.matrixSizes.empty() ? MATRIX_SIZES : opts.matrixSizes;
+    const auto& rates = opts.matrixRates.empty() ? MATRIX_RATES : opts.matrixRates;
+
+    PerfCounters counters;
+    PerfCounters* counting = counters.has(PerfCounters::Cycles) ? &counters : nullptr;
+
+    SimpleInputEvents setup;
+    for (const auto& p : opts.params) setup.addParamValue(0, p.id, p.value);
+
+    std::vector<MatrixPoint> points;
+    for (uint32_t rate : rates) {
+        for (uint32_t size : sizes) {
+            uint32_t blocks = opts.blocks > 0 ? opts.blocks
+                            : std::max(MATRIX_MIN_BLOCKS, static_cast<uint32_t>(rate * MATRIX_SECONDS / size));
+            MatrixPoint point{rate, size, {}, {}};
+            point.fixed = runMatrix(opts, plugin, rate, size, false, blocks, setup.get(), counting);
+            point.variable = runMatrix(opts, plugin, rate, size, true, blocks, setup.get(), counting);
+            points.push_back(point);
+        }
+    }
+
+    printMatrixTable("fixed frames_count", sizes, rates, points, &MatrixPoint::fixed);
+    printMatrixTable("variable frames_count (1 to block size)", sizes, rates, points, &MatrixPoint::variable);
+
+    if (counting) {
+        say("\n    counters, fixed frames_count, per sample:\n");
+        say("    %8s %6s %9s %9s %6s %9s %10s %10s\n",
+            "rate", "size", "cycles", "instr", "IPC", "br miss", "L1D miss", "LLC miss");
+        for (const auto& point : points) {
+            const MatrixRun& run = point.fixed;
+            if (!run.activated) continue;
+            auto perSample = [&](PerfCounters::Counter c) {
+                return run.counters.valid[c] ? static_cast<double>(run.counters.value[c]) / run.samples : -1.0;
+            };
+            say("    %8u %6u %9.1f %9.1f %6.2f %9.3f %10.3f %10.3f\n", point.sampleRate, point.blockSize,
+                perSample(PerfCounters::Cycles), perSample(PerfCounters::Instructions), run.counters.ipc(),
+                perSample(PerfCounters::BranchMisses), perSample(PerfCounters::L1DMisses),
+                perSample(PerfCounters::LlcMisses));
+        }
+    } else {
+        say("\n    counters unavailable: %s\n", counters.getError().c_str());
+    }
+
+    Json sizeList = Json::array();
+    for (uint32_t size : sizes) sizeList.push(size);
+    Json rateList = Json::array();
+    for (uint32_t rate : rates) rateList.push(rate);
+    Json pointList = Json::array();
+    for (const auto& point : points) {
+        Json p = Json::object();
+        p.set("sampleRate", point.sampleRate)
+         .set("blockSize", point.blockSize)
+         .set("fixed", matrixRunJson(point.fixed))
+         .set("variable", matrixRunJson(point.variable));
+        pointList.push(std::move(p));
+    }
+    Json matrix = Json::object();
+    matrix.set("blockSizes", std::move(sizeList))
+          .set("sampleRates", std::move(rateList))
+          .set("points", std::move(pointList));
+    if (!counting) matrix.set("countersError", counters.getError());
+    result.details.set("matrix", std::move(matrix));
+}
+
+//-----------------------------------------------------------------------------
+// Memory footprint
+//-----------------------------------------------------------------------------
+
+static constexpr uint32_t DEFAULT_MEMORY_INSTANCES = 8;
+static constexpr uint32_t DEFAULT_MEMORY_BLOCKS = 2000;
+static constexpr uint32_t MEMORY_WARMUP_BLOCKS = 100;  // Same warm-up as the timed bench
+
+static uint32_t memoryInstanceCount(const Options& opts) {
+    return opts.instancesSet ? opts.instances : DEFAULT_MEMORY_INSTANCES;
+}
+
+struct MemoryPhase {
+    std::string name;
+    ResourceUsage usage;  // Change over the phase
+    HeapCounts heap;      // Heap calls made on this thread during it
+};
+
+struct MemoryInstance {
+    const clap_plugin_t* plugin = nullptr;
+    bool initialized = false;
+    bool activated = false;
+    bool processing = false;
+};
+
+// Run `step`, recording the resident memory it adds and (unless it counts
+// for itself into the phase) the heap calls it makes
+template<typename Step>
+static MemoryPhase& measureMemoryPhase(std::vector<MemoryPhase>& phases, std::string name, bool countHeap,
+                                       Step&& step) {
+    MemoryPhase& phase = phases.emplace_back();
+    phase.name = std::move(name);
+    ResourceUsage before = ResourceUsage::current(true);
+    if (countHeap) {
+        HeapCountScope scope(phase.heap);
+        step(phase);
+    } else {
+        step(phase);
+    }
+    phase.usage = ResourceUsage::current(true) - before;
+    return phase;
+}
+
+static void benchMemory(const Options& opts, const clap_plugin_factory_t* factory,
+                        const clap_plugin_descriptor_t* desc, TestHost& host, PluginResult& result) {
+    uint32_t instanceCount = memoryInstanceCount(opts);
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : DEFAULT_MEMORY_BLOCKS;
+    bool countHeap = rtCheckEnable();
+
+    // Everything the host needs is allocated up front, outside the counted phases
+    StereoAudioBuffers buffers(opts.bufferSize, opts.bufferLayout);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+    clap_process_t process{};
+    process.frames_count = opts.bufferSize;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = inEvents.get();
+    process.out_events = outEvents.get();
+
+    std::vector<MemoryInstance> instances(instanceCount);
+    std::vector<MemoryPhase> phases;
+    phases.reserve(8);
+    std::string failure;
+
+    auto create = [&](MemoryInstance& instance) {
+        instance.plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
+        if (!instance.plugin) failure = "create_plugin() failed";
+    };
+    auto init = [&](MemoryInstance& instance) {
+        instance.initialized = instance.plugin->init(instance.plugin);
+        if (!instance.initialized) failure = "init() failed";
+    };
+    auto activate = [&](MemoryInstance& instance) {
+        instance.activated = instance.plugin->activate(instance.plugin, opts.sampleRate, opts.bufferSize,
+                                                       opts.bufferSize);
+        if (!instance.activated) {
+            failure = "activate() failed";
+            return;
+        }
+        TestHost::AudioThreadScope audio;
+        instance.processing = instance.plugin->start_processing(instance.plugin);
+        if (!instance.processing) failure = "start_processing() failed";
+    };
+    auto warmUp = [&](MemoryInstance& instance) {
+        TestHost::AudioThreadScope audio;
+        process.steady_time = 0;
+        for (uint32_t b = 0; b < MEMORY_WARMUP_BLOCKS; ++b) {
+            instance.plugin->process(instance.plugin, &process);
+            process.steady_time += opts.bufferSize;
+        }
+    };
+
+    // The first instance, phase by phase
+    MemoryInstance& first = instances[0];
+    measureMemoryPhase(phases, "create", countHeap, [&](MemoryPhase&) { create(first); });
+    if (failure.empty()) measureMemoryPhase(phases, "init", countHeap, [&](MemoryPhase&) { init(first); });
+    if (failure.empty()) measureMemoryPhase(phases, "activate", countHeap, [&](MemoryPhase&) { activate(first); });
+    if (failure.empty()) measureMemoryPhase(phases, "warm-up", countHeap, [&](MemoryPhase&) { warmUp(first); });
+    size_t firstPhases = phases.size();
+
+    // Steady state, counted block by block
+    uint64_t allocatingBlocks = 0;
+    if (failure.empty()) {
+        measureMemoryPhase(phases, "steady", false, [&](MemoryPhase& phase) {
+            TestHost::AudioThreadScope audio;
+            for (uint32_t b = 0; b < blocks; ++b) {
+                HeapCounts block;
+                {
+                    HeapCountScope scope(block);
+                    first.plugin->process(first.plugin, &process);
+                }
+                process.steady_time += opts.bufferSize;
+                if (block.allocations > 0 || block.frees > 0) allocatingBlocks++;
+                phase.heap += block;
+            }
+        });
+    }
+
+    // The rest, all the way to warmed up
+    if (failure.empty() && instanceCount > 1) {
+        measureMemoryPhase(phases, "+" + std::to_string(instanceCount - 1) + " instances", countHeap,
+                           [&](MemoryPhase&) {
+            for (uint32_t i = 1; i < instanceCount && failure.empty(); ++i) {
+                create(instances[i]);
+                if (failure.empty()) init(instances[i]);
+                if (failure.empty()) activate(instances[i]);
+                if (failure.empty()) warmUp(instances[i]);
+            }
+        });
+    }
+
+    measureMemoryPhase(phases, "destroy", countHeap, [&](MemoryPhase&) {
+        for (auto& instance : instances) {
+            if (!instance.plugin) continue;
+            if (instance.processing) {
+                TestHost::AudioThreadScope audio;
+                instance.plugin->stop_processing(instance.plugin);
+            }
+            if (instance.activated) instance.plugin->deactivate(instance.plugin);
+            instance.plugin->destroy(instance.plugin);
+        }
+    });
+
+    say("%s  (%u instance(s), %u steady-state blocks)\n", desc->name, instanceCount, blocks);
+    if (!failure.empty()) {
+        fprintf(stderr, "  ✗ %s: %s\n", desc->name, failure.c_str());
+        result.check("setup", false, failure);
+        return;
+    }
+    result.check("setup", true);
+
+    auto kib = [](int64_t bytes) { return static_cast<double>(bytes) / 1024.0; };
+    say("  %-14s %10s %10s %8s %9s %9s %10s\n", "phase", "RSS KiB", "PSS KiB", "faults", "allocs", "frees",
+        "heap KiB");
+    ResourceUsage firstUsage;
+    HeapCounts firstHeap;
+    HeapCounts total;
+    Json phaseList = Json::array();
+    for (size_t p = 0; p < phases.size(); ++p) {
+        const MemoryPhase& phase = phases[p];
+        uint64_t faults = phase.usage.minorFaults + phase.usage.majorFaults;
+        if (countHeap) {
+            say("  %-14s %+10.1f %+10.1f %8llu %9llu %9llu %+10.1f\n", phase.name.c_str(),
+                kib(phase.usage.residentBytes), kib(phase.usage.proportionalBytes),
+                static_cast<unsigned long long>(faults), static_cast<unsigned long long>(phase.heap.allocations),
+                static_cast<unsigned long long>(phase.heap.frees), kib(phase.heap.netBytes()));
+        } else {
+            say("  %-14s %+10.1f %+10.1f %8llu\n", phase.name.c_str(), kib(phase.usage.residentBytes),
+                kib(phase.usage.proportionalBytes), static_cast<unsigned long long>(faults));
+        }
+        if (p < firstPhases) {
+            firstUsage.residentBytes += phase.usage.residentBytes;
+            firstUsage.proportionalBytes += phase.usage.proportionalBytes;
+            firstHeap += phase.heap;
+        }
+        total += phase.heap;
+
+        Json entry = Json::object();
+        entry.set("name", phase.name)
+             .set("residentBytes", phase.usage.residentBytes)
+             .set("proportionalBytes", phase.usage.proportionalBytes)
+             .set("faults", faults);
+        if (countHeap) {
+            entry.set("allocations", phase.heap.allocations)
+                 .set("frees", phase.heap.frees)
+                 .set("allocatedBytes", phase.heap.allocatedBytes)
+                 .set("heapBytes", phase.heap.netBytes());
+        }
+        phaseList.push(std::move(entry));
+    }
+
+    // Later instances share what the first one set up, so they are the per-instance cost
+    const MemoryPhase* more = instanceCount > 1 ? &phases[phases.size() - 2] : nullptr;
+    uint32_t moreCount = instanceCount - 1;
+    int64_t perResident = more ? more->usage.residentBytes / moreCount : firstUsage.residentBytes;
+    int64_t perProportional = more ? more->usage.proportionalBytes / moreCount : firstUsage.proportionalBytes;
+    int64_t perHeap = more ? more->heap.netBytes() / moreCount : firstHeap.netBytes();
+    say("\n  Per instance: %.1f KiB resident (%.1f KiB PSS)", kib(perResident), kib(perProportional));
+    if (countHeap) say(", %.1f KiB heap", kib(perHeap));
+    say("; the first took %.1f KiB resident\n", kib(firstUsage.residentBytes));
+
+    Json memory = Json::object();
+    memory.set("instances", instanceCount)
+          .set("blocks", blocks)
+          .set("phases", std::move(phaseList))
+          .set("firstInstanceBytes", firstUsage.residentBytes)
+          .set("perInstanceBytes", perResident)
+          .set("perInstanceProportionalBytes", perProportional);
+
+    if (!countHeap) {
+        say("  Heap calls are not counted on this platform\n\n");
+        result.details.set("memory", std::move(memory));
+        return;
+    }
+
+    const HeapCounts& steady = phases[firstPhases].heap;
+    double callsPerBlock = static_cast<double>(steady.allocations + steady.frees) / blocks;
+    double bytesPerBlock = static_cast<double>(steady.allocatedBytes) / blocks;
+    if (allocatingBlocks == 0) {
+        say("  Steady state: no heap calls in %u blocks\n", blocks);
+    } else {
+        say("  Steady state: ✗ heap calls in %llu of %u blocks%s, %.1f calls and %.0f bytes per block\n",
+            static_cast<unsigned long long>(allocatingBlocks), blocks, allocatingBlocks == blocks ? " (every block)" : "",
+            callsPerBlock, bytesPerBlock);
+    }
+    say("  Heap left after destroy: %.1f KiB\n\n", kib(total.netBytes()));
+
+    char detail[128];
+    snprintf(detail, sizeof(detail), "heap calls in %llu of %u blocks",
+             static_cast<unsigned long long>(allocatingBlocks), blocks);
+    result.check("steady-heap", allocatingBlocks == 0, allocatingBlocks == 0 ? "" : detail);
+    memory.set("perInstanceHeapBytes", perHeap)
+          .set("allocatingBlocks", allocatingBlocks)
+          .set("heapCallsPerBlock", callsPerBlock)
+          .set("heapBytesPerBlock", bytesPerBlock)
+          .set("leakedBytes", total.netBytes());
+    result.details.set("memory", std::move(memory));
+}
+
+static int cmdBench(const Options& opts, Report& report) {
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : 10000;
+    report.host.blocks = opts.sweeps.empty() ? blocks : opts.blocks > 0 ? opts.blocks : DEFAULT_SWEEP_BLOCKS;
+    if (opts.memory) report.host.blocks = opts.blocks > 0 ? opts.blocks : DEFAULT_MEMORY_BLOCKS;
+    bool gating = opts.saveBaseline || opts.compareFile;
+    if (opts.automationRate == 0 && (!opts.automate.empty() || opts.modulate)) {
+        fprintf(stderr, "ERROR: --automate and --modulate need --automation-rate\n");
+        return 1;
+    }
+    if (!opts.sweeps.empty() && (gating || opts.instances > 1 || opts.threads > 1)) {
+        fprintf(stderr, "ERROR: --sweep cannot be combined with --instances, --threads, --save-baseline or --compare\n");
+        return 1;
+    }
+    if (!opts.poolThreads.empty() && (opts.instances > 1 || opts.threads > 1 || !opts.sweeps.empty())) {
+        fprintf(stderr, "ERROR: --pool-threads cannot be combined with --instances, --threads or --sweep\n");
+        return 1;
+    }
+    if ((opts.silence || opts.constantInput) &&
+        (opts.instances > 1 || opts.threads > 1 || !opts.sweeps.empty())) {
+        fprintf(stderr, "ERROR: --silence and --constant-input cannot be combined with --instances, --threads or --sweep\n");
+        return 1;
+    }
+    if (opts.matrix && (gating || opts.instances > 1 || opts.threads > 1 || !opts.sweeps.empty() ||
+                        opts.automationRate > 0 || !opts.voices.empty() || !opts.poolThreads.empty() ||
+                        opts.silence || opts.constantInput)) {
+        fprintf(stderr, "ERROR: --matrix is a bench of its own and cannot be combined with other bench modes\n");
+        return 1;
+    }
+    if (opts.memory && (gating || opts.threads > 1 || !opts.sweeps.empty() || opts.automationRate > 0 ||
+                        !opts.voices.empty() || !opts.poolThreads.empty() || opts.silence ||
+                        opts.constantInput || opts.matrix || opts.counters)) {
+        fprintf(stderr, "ERROR: --memory is a bench of its own and only takes --instances and --blocks\n");
+        return 1;
+    }
+    if (opts.memory) report.host.instances = memoryInstanceCount(opts);
+    uint32_t repetitions = opts.repetitions > 0 ? opts.repetitions : gating ? 5 : 1;
+
+    auto loader = PluginLoader::load(opts.pluginPath);
+    if (!loader->entry()) {
+        fprintf(stderr, "ERROR: %s\n", loader->getError().c_str());
+        report.check("load", false, loader->getError());
+        return 1;
+    }
+    report.check("load", true);
+
+    const auto* factory = loader->factory();
+    if (!factory) {
+        fprintf(stderr, "ERROR: No plugin factory\n");
+        report.check("factory", false);
+        return 1;
+    }
+    report.check("factory", true);
+
+    uint32_t count = factory->get_plugin_count(factory);
+    report.check("plugins", count > 0, std::to_string(count) + " plugin(s)");
+    if (count == 0) {
+        fprintf(stderr, "ERROR: No plugins in factory\n");
+        return 1;
+    }
+
+    if (opts.bufferLayout != BufferLayout::Separate) {
+        StereoAudioBuffers probe(opts.bufferSize, opts.bufferLayout);
+        const char* pages = probe.hugePageBacked() ? "huge pages"
+                          : opts.bufferLayout == BufferLayout::ContiguousHugePages ? "huge pages unavailable, normal pages"
+                          : "normal pages";
+        say("Buffers: contiguous, %zu-sample stride, %s\n",
+            paddedChannelStride(opts.bufferSize), pages);
+    }
+
+    TestHost host;
+    bool optionError = false;  // A --sweep or --automate argument did not resolve
+
+    // Counted around each timed process() call of the single-instance runs
+    std::unique_ptr<PerfCounters> counters;
+    if (opts.counters) {
+        counters = std::make_unique<PerfCounters>();
+        if (!counters->has(PerfCounters::Cycles)) {
+            fprintf(stderr, "WARNING: Hardware counters unavailable: %s\n", counters->getError().c_str());
+        }
+        if (counters->available()) {
+            counters->start();
+        } else {
+            counters.reset();
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto* desc = factory->get_plugin_descriptor(factory, i);
+        if (!desc) continue;
+        PluginResult& result = pluginResult(report, desc);
+
+        if (opts.memory) {
+            benchMemory(opts, factory, desc, host, result);
+            continue;
+        }
+
+        if (opts.instances > 1 || opts.threads > 1) {
+            benchParallel(opts, factory, desc, blocks, result);
+            continue;
+        }
+
+        const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
+        if (!plugin || !plugin->init(plugin)) {
+            if (plugin) plugin->destroy(plugin);
+            result.check("setup", false, "create_plugin() or init() failed");
+            continue;
+        }
+
+        if (opts.matrix) {
+            result.check("setup", true);
+            say("%s\n", desc->name);
+            benchMatrix(opts, plugin, result);
+            plugin->destroy(plugin);
+            continue;
+        }
+
+        if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
+            plugin->destroy(plugin);
+            result.check("setup", false, "activate() failed");
+            continue;
+        }
+
+        if (!plugin->start_processing(plugin)) {
+            plugin->deactivate(plugin);
+            plugin->destroy(plugin);
+            result.check("setup", false, "start_processing() failed");
+            continue;
+        }
+        result.check("setup", true);
+
+        if (!opts.sweeps.empty()) {
+            say("%s\n", desc->name);
+            if (!benchSweep(opts, plugin, result)) optionError = true;
+            plugin->stop_processing(plugin);
+            plugin->deactivate(plugin);
+            plugin->destroy(plugin);
+            continue;
+        }
+
+        // --param settings go with the first block of every run
+        SimpleInputEvents setup;
+        for (const auto& p : opts.params) setup.addParamValue(0, p.id, p.value);
+        BenchHooks hooks;
+        hooks.setup = setup.get();
+        hooks.counters = counters.get();
+
+        RepeatedBench bench(opts.bufferSize, opts.sampleRate);
+        runRepeatedBench<StereoAudioBuffers>(opts, plugin, blocks, repetitions, bench, hooks);
+        double audioSeconds = static_cast<double>(blocks) * bench.runs * opts.bufferSize / opts.sampleRate;
+        double realtime = audioSeconds / (bench.wallNs / 1e9);
+        double usPerBlock = bench.stats.histogram.mean() / 1000.0;
+
+        if (repetitions > 1) {
+            say("%-40s %8.1fx realtime  %6.1f µs/block  (%u blocks x %u runs)\n",
+                desc->name, realtime, usPerBlock, blocks, bench.runs);
+        } else {
+            say("%-40s %8.1fx realtime  %6.1f µs/block  (%u blocks)\n",
+                desc->name, realtime, usPerBlock, blocks);
+        }
+        printRepeatedBench(bench);
+        result.timings.push_back(timingStats("float32", bench, realtime));
+
+        if (opts.automationRate > 0 &&
+            !benchAutomation(opts, plugin, blocks, repetitions, hooks, bench, result)) {
+            optionError = true;
+        }
+
+        if (!opts.voices.empty()) {
+            benchVoices(opts, plugin, bench.stats.histogram.mean(), result);
+        }
+
+        if (opts.silence) benchIdle(opts, plugin, IdleInput::Silence, bench.stats.histogram.mean(), result);
+        if (opts.constantInput) benchIdle(opts, plugin, IdleInput::Constant, bench.stats.histogram.mean(), result);
+
+        if (!opts.poolThreads.empty()) {
+            benchThreadPool(opts, factory, desc, blocks, repetitions, setup.get(),
+                            bench.stats.histogram.mean(), result);
+        }
+
+        if (opts.precision == SamplePrecision::Float64) {
+            if (!queryPrecisionSupport(plugin).supports64) {
+                say("    64-bit   not supported by the plugin's audio ports\n");
+                result.details.set("float64", "unsupported");
+            } else {
+                RepeatedBench bench64(opts.bufferSize, opts.sampleRate);
+                runRepeatedBench<StereoAudioBuffers64>(opts, plugin, blocks, repetitions, bench64, hooks);
+                double audioSeconds64 = static_cast<double>(blocks) * bench64.runs * opts.bufferSize / opts.sampleRate;
+                double realtime64 = audioSeconds64 / (bench64.wallNs / 1e9);
+                double usPerBlock64 = bench64.stats.histogram.mean() / 1000.0;
+                say("    64-bit   %8.1fx realtime  %6.1f µs/block  (%+.1f%% vs 32-bit)\n",
+                    realtime64, usPerBlock64, 100.0 * (usPerBlock64 - usPerBlock) / usPerBlock);
+                printRepeatedBench(bench64);
+                result.timings.push_back(timingStats("float64", bench64, realtime64));
+            }
+        }
+
+        plugin->stop_processing(plugin);
+        plugin->deactivate(plugin);
+        plugin->destroy(plugin);
+    }
+
+    if (opts.saveBaseline) {
+        std::ofstream file(opts.saveBaseline, std::ios::binary);
+        file << toJson(report).dump() << "\n";
+        if (!file) {
+            fprintf(stderr, "ERROR: Cannot write baseline %s\n", opts.saveBaseline);
+            return 1;
+        }
+        say("\nSaved baseline to %s\n", opts.saveBaseline);
+    }
+
+    if (opts.compareFile && !compareWithBaseline(opts, report)) {
+        return 1;
+    }
+    return optionError ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Realtime
+//-----------------------------------------------------------------------------
+
+// Audio time the realtime command runs for unless --blocks is given
+static constexpr double DEFAULT_REALTIME_SECONDS = 5.0;
+
+// Each load thread streams through this much memory, more than most LLCs
+static constexpr size_t LOAD_BUFFER_BYTES = 64u << 20;
+
+struct RealtimeRun {
+    BlockStats process;         // process() time against the period
+    LatencyHistogram wakeup;    // How late the thread woke after its target
+    uint64_t overruns = 0;      // Callbacks that finished after the next period began
+    uint64_t skippedPeriods = 0;
+    uint64_t worstNs = 0;       // Longest period start to process() return
+    bool prioritized = false;
+    bool started = false;       // start_processing() succeeded; nothing was timed otherwise
+    std::string policy;         // Scheduling policy set, or why it was refused
+
+    RealtimeRun(uint32_t bufferSize, uint32_t sampleRate) : process(bufferSize, sampleRate) {}
+};
+
+// Busy thread for --load: read-modify-write over a buffer larger than the caches
+static void runLoadThread(const std::atomic<bool>& stop, uint32_t index) {
+    std::vector<uint64_t> buffer(LOAD_BUFFER_BYTES / sizeof(uint64_t), index);
+    uint64_t x = index + 1;
+    while (!stop.load(std::memory_order_relaxed)) {
+        // One word per cache line, so every access misses
+        for (size_t i = 0; i < buffer.size(); i += 8) {
+            buffer[i] = buffer[i] * 6364136223846793005ull + x;
+            x ^= buffer[i] >> 17;
+        }
+    }
+    static std::atomic<uint64_t> sink;
+    sink.store(x, std::memory_order_relaxed);
+}
+
+// The audio thread: wakes at every period boundary (plus --jitter), calls
+// process() and checks it returned before the next boundary. A callback that
+// runs past whole periods skips them, as a driver would.
+static void runRealtimeThread(const Options& opts, const clap_plugin_t* plugin, uint32_t blocks,
+                              const clap_input_events_t* setup, RealtimeRun& run) {
+    uint64_t periodNs = run.process.deadlineNs;
+    if (opts.pinThreads) pinCurrentThreadToCore(0);
+    run.prioritized = setCurrentThreadRealtime(periodNs, run.policy);
+    TestHost::AudioThreadScope audio;
+
+    StereoAudioBuffers buffers(opts.bufferSize);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.steady_time = 0;
+    process.frames_count = opts.bufferSize;
+    process.transport = nullptr;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = setup;
+    process.out_events = outEvents.get();
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> jitter(0, opts.jitterUs * 1000);
+    auto period = std::chrono::nanoseconds(periodNs);
+
+    run.started = plugin->start_processing(plugin);
+    if (!run.started) return;
+    auto boundary = std::chrono::steady_clock::now() + period;
+    for (uint32_t b = 0; b < blocks; ++b) {
+        auto target = boundary;
+        if (opts.jitterUs > 0) target += std::chrono::nanoseconds(jitter(rng));
+        sleepUntil(target);
+
+        auto woke = std::chrono::steady_clock::now();
+        plugin->process(plugin, &process);
+        auto done = std::chrono::steady_clock::now();
+        process.in_events = inEvents.get();
+        process.steady_time += opts.bufferSize;
+
+        run.wakeup.record(woke > target ? elapsedNs(target, woke) : 0);
+        run.process.record(elapsedNs(woke, done));
+        run.worstNs = std::max(run.worstNs, elapsedNs(boundary, done));
+
+        boundary += period;
+        if (done > boundary) {
+            run.overruns++;
+            while (boundary < done) {
+                boundary += period;
+                run.skippedPeriods++;
+            }
+        }
+    }
+    plugin->stop_processing(plugin);
+}
+
+static int cmdRealtime(const Options& opts, Report& report) {
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks
+                    : static_cast<uint32_t>(std::ceil(DEFAULT_REALTIME_SECONDS * opts.sampleRate / opts.bufferSize));
+    report.host.blocks = blocks;
+
+    auto loader = PluginLoader::load(opts.pluginPath);
+    if (!loader->entry()) {
+        fprintf(stderr, "ERROR: %s\n", loader->getError().c_str());
+        report.check("load", false, loader->getError());
+        return 1;
     }
+    report.check("load", true);
 
     const auto* factory = loader->factory();
     if (!factory) {
         fprintf(stderr, "ERROR: No plugin factory\n");
+        report.check("factory", false);
         return 1;
     }
+    report.check("factory", true);
 
     uint32_t count = factory->get_plugin_count(factory);
+    report.check("plugins", count > 0, std::to_string(count) + " plugin(s)");
     if (count == 0) {
         fprintf(stderr, "ERROR: No plugins in factory\n");
         return 1;
     }
 
-    TestHost host;
+    // Load threads keep off the audio thread's core when it is pinned
+    std::atomic<bool> stopLoad{false};
+    std::vector<std::thread> loadThreads;
+    uint32_t cores = hardwareThreadCount();
+    for (uint32_t t = 0; t < opts.loadThreads; ++t) {
+        loadThreads.emplace_back([&stopLoad, t, cores, pin = opts.pinThreads] {
+            if (pin) pinCurrentThreadToCore(cores > 1 ? 1 + t % (cores - 1) : 0);
+            runLoadThread(stopLoad, t);
+        });
+    }
 
+    TestHost host;
+    bool allInTime = true;
     for (uint32_t i = 0; i < count; ++i) {
         const auto* desc = factory->get_plugin_descriptor(factory, i);
         if (!desc) continue;
+        PluginResult& result = pluginResult(report, desc);
 
         const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
         if (!plugin || !plugin->init(plugin)) {
             if (plugin) plugin->destroy(plugin);
+            result.check("setup", false, "create_plugin() or init() failed");
+            allInTime = false;
             continue;
         }
-
         if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
             plugin->destroy(plugin);
+            result.check("setup", false, "activate() failed");
+            allInTime = false;
             continue;
         }
+        result.check("setup", true);
 
-        if (!plugin->start_processing(plugin)) {
-            plugin->deactivate(plugin);
-            plugin->destroy(plugin);
+        SimpleInputEvents setup;
+        for (const auto& p : opts.params) setup.addParamValue(0, p.id, p.value);
+
+        RealtimeRun run(opts.bufferSize, opts.sampleRate);
+        std::thread audio([&] { runRealtimeThread(opts, plugin, blocks, setup.get(), run); });
+        audio.join();
+
+        plugin->deactivate(plugin);
+        plugin->destroy(plugin);
+
+        if (!run.started) {
+            say("%s\n    start_processing() failed\n", desc->name);
+            result.check("setup", false, "start_processing() failed");
+            allInTime = false;
             continue;
         }
 
-        StereoAudioBuffers buffers(opts.bufferSize);
-        buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+        double periodUs = run.process.deadlineNs / 1000.0;
+        say("%s\n", desc->name);
+        say("    audio thread  %s\n", run.prioritized ? run.policy.c_str()
+                                                      : ("normal priority (" + run.policy + ")").c_str());
+        say("    period %.1f µs, %u callbacks", periodUs, blocks);
+        if (opts.loadThreads > 0) say(", %u load thread(s)", opts.loadThreads);
+        if (opts.jitterUs > 0) say(", jitter up to %u µs", opts.jitterUs);
+        say("\n");
+        printBlockStats(run.process);
+        say("    wake-up late p50 %.1f  p99 %.1f  max %.1f µs\n",
+            run.wakeup.valueAtPercentile(50.0) / 1000.0, run.wakeup.valueAtPercentile(99.0) / 1000.0,
+            run.wakeup.max() / 1000.0);
+        say("    %llu overrun(s), %llu period(s) skipped, worst callback ended at %.0f%% of the period\n",
+            static_cast<unsigned long long>(run.overruns), static_cast<unsigned long long>(run.skippedPeriods),
+            100.0 * run.worstNs / run.process.deadlineNs);
+
+        double processSeconds = run.process.histogram.mean() * run.process.histogram.count() / 1e9;
+        double audioSeconds = static_cast<double>(blocks) * opts.bufferSize / opts.sampleRate;
+        result.timings.push_back(timingStats("realtime", run.process,
+                                             processSeconds > 0.0 ? audioSeconds / processSeconds : 0.0));
+        result.timings.push_back(TimingStats::fromHistogram("wakeup", run.wakeup));
+        result.details.set("realtime", Json::object()
+                                           .set("prioritized", run.prioritized)
+                                           .set("policy", run.policy)
+                                           .set("periodNs", run.process.deadlineNs)
+                                           .set("loadThreads", opts.loadThreads)
+                                           .set("jitterUs", opts.jitterUs)
+                                           .set("overruns", run.overruns)
+                                           .set("skippedPeriods", run.skippedPeriods)
+                                           .set("worstNs", run.worstNs));
+
+        char detail[96];
+        snprintf(detail, sizeof(detail), "%llu overrun(s) in %u callbacks",
+                 static_cast<unsigned long long>(run.overruns), blocks);
+        result.check("deadlines", run.overruns == 0, detail);
+        if (run.overruns > 0) allInTime = false;
+    }
 
-        EmptyInputEvents inEvents;
-        DiscardOutputEvents outEvents;
+    stopLoad.store(true, std::memory_order_relaxed);
+    for (auto& t : loadThreads) t.join();
+    return allInTime ? 0 : 1;
+}
 
-        clap_process_t process{};
-        process.steady_time = 0;
-        process.frames_count = opts.bufferSize;
-        process.transport = nullptr;
-        process.audio_inputs = buffers.inputBuffer();
-        process.audio_outputs = buffers.outputBuffer();
-        process.audio_inputs_count = 1;
-        process.audio_outputs_count = 1;
-        process.in_events = inEvents.get();
-        process.out_events = outEvents.get();
+// Longest tail --tail renders; an infinite one (UINT32_MAX) is cut to this
+static constexpr uint32_t MAX_TAIL_SECONDS = 30;
 
-        // Warm up
-        for (uint32_t b = 0; b < 100; ++b) {
-            plugin->process(plugin, &process);
-            process.steady_time += opts.bufferSize;
+// Open a WAV input for streaming. With an explicit --sample-rate that differs
+// from the file, the reader converts as it goes, so the read-ahead thread
+// does the resampling and the file is never held whole.
+static std::unique_ptr<WavReader> openInput(const Options& opts, const std::string& path) {
+    auto reader = WavReader::open(path);
+    if (!reader->hasError() && opts.sampleRateSet) reader->resampleTo(opts.sampleRate);
+    return reader;
+}
+
+static void printInput(const char* path, const WavReader& reader) {
+    printf("Input: %s (%u Hz, %u ch, %llu frames", path, reader.sampleRate(), reader.channels(),
+           static_cast<unsigned long long>(reader.frameCount()));
+    if (reader.fileSampleRate() != reader.sampleRate()) {
+        printf(", resampled from %u Hz", reader.fileSampleRate());
+    }
+    printf(")\n");
+}
+
+// One plugin instance rendering files offline. The thread that creates it
+// is the instance's main thread: it creates, activates and destroys it. The
+// render itself runs on that thread too (processing marked as audio with an
+// AudioThreadScope, block by block) or, in process --batch, on a worker
+// while the main thread keeps pumping the host.
+struct Renderer {
+    TestHost host;
+    bool pumpWhileRendering = true;  // False when the main thread pumps from elsewhere
+    const clap_plugin_t* plugin = nullptr;
+    uint32_t sampleRate = 0;  // Rate it is activated at (0 = inactive)
+    uint32_t outputChannels = 2;
+    uint32_t latency = 0;
+    uint32_t tail = 0;
+    bool tailCapped = false;
+    bool rendered = false;   // A file went through since activation; reset() before the next
+    uint64_t steadyTime = 0;
+    uint64_t processNs = 0;  // Time inside process(), over every file
+
+    Renderer() = default;
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    ~Renderer() {
+        if (!plugin) return;
+        if (sampleRate > 0) plugin->deactivate(plugin);
+        plugin->destroy(plugin);
+    }
+};
+
+static bool createRenderer(const clap_plugin_factory_t* factory, const clap_plugin_descriptor_t* desc,
+                           Renderer& renderer) {
+    const clap_plugin_t* plugin = factory->create_plugin(factory, renderer.host.clapHost(), desc->id);
+    if (!plugin || !plugin->init(plugin)) {
+        if (plugin) plugin->destroy(plugin);
+        return false;
+    }
+    renderer.plugin = plugin;
+    renderer.host.setPlugin(plugin);
+    renderer.host.pumpMainThread();
+    return true;
+}
+
+// Activate at `sampleRate`, reactivating only if the rate changed, and pick
+// up the latency, tail and output channel count a host would compensate for
+static bool activateRenderer(const Options& opts, Renderer& renderer, uint32_t sampleRate) {
+    const clap_plugin_t* plugin = renderer.plugin;
+    if (renderer.sampleRate == sampleRate) return true;
+    if (renderer.sampleRate > 0) {
+        plugin->deactivate(plugin);
+        renderer.host.setPluginActive(false);
+        renderer.sampleRate = 0;
+    }
+    if (!plugin->activate(plugin, sampleRate, opts.bufferSize, opts.bufferSize)) return false;
+    renderer.host.setPluginActive(true);
+    renderer.sampleRate = sampleRate;
+    renderer.rendered = false;
+
+    renderer.latency = 0;
+    if (const auto* ext = static_cast<const clap_plugin_latency_t*>(plugin->get_extension(plugin, CLAP_EXT_LATENCY))) {
+        renderer.latency = ext->get(plugin);
+    }
+    renderer.tail = 0;
+    renderer.tailCapped = false;
+    if (const auto* ext = static_cast<const clap_plugin_tail_t*>(plugin->get_extension(plugin, CLAP_EXT_TAIL))) {
+        renderer.tail = ext->get(plugin);
+        uint64_t maxTail = static_cast<uint64_t>(MAX_TAIL_SECONDS) * sampleRate;
+        if (renderer.tail > maxTail) {
+            renderer.tail = static_cast<uint32_t>(maxTail);
+            renderer.tailCapped = true;
         }
+    }
+
+    renderer.outputChannels = 2;  // Default stereo
+    const auto* audioPorts = static_cast<const clap_plugin_audio_ports_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
+    if (audioPorts && audioPorts->count(plugin, false) > 0) {
+        clap_audio_port_info_t info{};
+        if (audioPorts->get(plugin, 0, false, &info)) renderer.outputChannels = info.channel_count;
+    }
+    return true;
+}
+
+// Render `outputFrames` frames of `input` (silence if null) plus latency and
+// tail as requested, into `output`. Returns false if processing could not
+// start; a write error stops the render and shows up in output.close().
+static bool renderFile(const Options& opts, Renderer& renderer, WavReadAhead* input, uint64_t outputFrames,
+                       WavWriteBehind& output) {
+    const clap_plugin_t* plugin = renderer.plugin;
+    uint32_t inputChannels = input ? input->channels() : 2;
+    uint64_t inputFrames = input ? input->frameCount() : 0;
+    uint32_t outputChannels = renderer.outputChannels;
+
+    uint64_t skipFrames = opts.trimLatency ? renderer.latency : 0;
+    uint64_t renderFrames = outputFrames + skipFrames + (opts.renderTail ? renderer.tail : 0);
+
+    {
+        TestHost::AudioThreadScope audio;
+        if (!plugin->start_processing(plugin)) return false;
+        // Each file starts from a clean state, as if rendered on its own
+        if (renderer.rendered) plugin->reset(plugin);
+    }
+    renderer.rendered = true;
 
-        // Benchmark
-        auto start = std::chrono::high_resolution_clock::now();
+    // Allocate one block of interleaved file I/O and per-channel CLAP buffers
+    std::vector<float> inputBlock(static_cast<size_t>(opts.bufferSize) * inputChannels);
+    std::vector<float> outputBlock(static_cast<size_t>(opts.bufferSize) * outputChannels);
 
-        for (uint32_t b = 0; b < blocks; ++b) {
+    std::vector<float*> inChannelPtrs(inputChannels);
+    std::vector<float*> outChannelPtrs(outputChannels);
+    std::vector<std::vector<float>> inChannels(inputChannels);
+    std::vector<std::vector<float>> outChannels(outputChannels);
+
+    for (uint32_t c = 0; c < inputChannels; ++c) {
+        inChannels[c].resize(opts.bufferSize);
+        inChannelPtrs[c] = inChannels[c].data();
+    }
+    for (uint32_t c = 0; c < outputChannels; ++c) {
+        outChannels[c].resize(opts.bufferSize);
+        outChannelPtrs[c] = outChannels[c].data();
+    }
+
+    clap_audio_buffer_t inBuf{};
+    inBuf.data32 = inChannelPtrs.data();
+    inBuf.channel_count = inputChannels;
+    inBuf.latency = 0;
+    inBuf.constant_mask = 0;
+
+    clap_audio_buffer_t outBuf{};
+    outBuf.data32 = outChannelPtrs.data();
+    outBuf.channel_count = outputChannels;
+    outBuf.latency = 0;
+    outBuf.constant_mask = 0;
+
+    EmptyInputEvents inEvents;
+    DiscardOutputEvents outEvents;
+
+    clap_process_t process{};
+    process.frames_count = opts.bufferSize;
+    process.transport = nullptr;
+    process.audio_inputs = &inBuf;
+    process.audio_outputs = &outBuf;
+    process.audio_inputs_count = 1;
+    process.audio_outputs_count = 1;
+    process.in_events = inEvents.get();
+    process.out_events = outEvents.get();
+
+    // Process; past the end of the input (latency and tail) the input is silent
+    uint64_t framesProcessed = 0;
+    bool writeOk = true;
+
+    while (framesProcessed < renderFrames && writeOk) {
+        uint32_t framesToProcess = static_cast<uint32_t>(
+            std::min<uint64_t>(opts.bufferSize, renderFrames - framesProcessed));
+        process.frames_count = framesToProcess;
+        process.steady_time = static_cast<int64_t>(renderer.steadyTime);
+
+        // Fill input buffers
+        if (input && framesProcessed < inputFrames) {
+            uint32_t framesRead = input->read(inputBlock.data(), framesToProcess);
+            for (uint32_t f = 0; f < framesToProcess; ++f) {
+                for (uint32_t c = 0; c < inputChannels; ++c) {
+                    if (f < framesRead) {
+                        inChannels[c][f] = inputBlock[f * inputChannels + c];
+                    } else {
+                        inChannels[c][f] = 0.0f;
+                    }
+                }
+            }
+        } else {
+            // No input: silence
+            for (uint32_t c = 0; c < inputChannels; ++c) {
+                std::fill(inChannels[c].begin(), inChannels[c].end(), 0.0f);
+            }
+        }
+
+        // Clear output buffers
+        for (uint32_t c = 0; c < outputChannels; ++c) {
+            std::fill(outChannels[c].begin(), outChannels[c].end(), 0.0f);
+        }
+
+        {
+            TestHost::AudioThreadScope audio;
+            auto start = std::chrono::steady_clock::now();
             plugin->process(plugin, &process);
-            process.steady_time += opts.bufferSize;
+            renderer.processNs += elapsedNs(start, std::chrono::steady_clock::now());
         }
 
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        // Write output (interleaved), leaving out the first `skipFrames`
+        uint32_t skip = static_cast<uint32_t>(
+            std::min<uint64_t>(framesToProcess, skipFrames - std::min(skipFrames, framesProcessed)));
+        for (uint32_t f = skip; f < framesToProcess; ++f) {
+            for (uint32_t c = 0; c < outputChannels; ++c) {
+                outputBlock[(f - skip) * outputChannels + c] = outChannels[c][f];
+            }
+        }
+        if (skip < framesToProcess) writeOk = output.write(outputBlock.data(), framesToProcess - skip);
 
-        double totalSeconds = duration.count() / 1000000.0;
-        double samplesProcessed = static_cast<double>(blocks) * opts.bufferSize;
-        double audioSeconds = samplesProcessed / opts.sampleRate;
-        double realtime = audioSeconds / totalSeconds;
-        double usPerBlock = static_cast<double>(duration.count()) / blocks;
+        framesProcessed += framesToProcess;
+        renderer.steadyTime += framesToProcess;
 
-        printf("%-40s %8.1fx realtime  %6.1f µs/block  (%u blocks)\n",
-               desc->name, realtime, usPerBlock, blocks);
+        // Main-thread callbacks the plugin asked for, between blocks as a host's event loop would
+        if (renderer.pumpWhileRendering) renderer.host.pumpMainThread();
+    }
 
-        plugin->stop_processing(plugin);
-        plugin->deactivate(plugin);
-        plugin->destroy(plugin);
+    TestHost::AudioThreadScope audio;
+    plugin->stop_processing(plugin);
+    return true;
+}
+
+// process --batch: every WAV file in a directory, one plugin instance per worker thread
+struct RenderJob {
+    std::string input;
+    std::string output;
+    bool ok = false;
+    std::string error;
+    double audioSeconds = 0.0;  // Output length
+    double seconds = 0.0;       // Wall time, I/O included
+};
+
+// How often the main thread services the instances' hosts while workers render
+static constexpr auto RENDER_PUMP_INTERVAL = std::chrono::milliseconds(5);
+
+// One instance and the worker that renders with it. The main thread opens
+// the files and activates the instance, hands the job over, and takes it
+// back once `finished`; the worker only starts, processes and stops.
+struct RenderSlot {
+    Renderer renderer;
+    std::thread worker;
+    RenderJob* job = nullptr;  // Handed to the worker; nullptr while idle
+    std::unique_ptr<WavReadAhead> input;
+    std::unique_ptr<WavWriteBehind> output;
+    std::chrono::steady_clock::time_point start;
+    bool finished = false;
+};
+
+struct RenderBatch {
+    const Options& opts;
+    const clap_plugin_factory_t* factory;
+    const clap_plugin_descriptor_t* desc;
+    std::vector<RenderJob> jobs;
+    std::vector<std::unique_ptr<RenderSlot>> slots;
+
+    std::mutex mutex;  // Guards the slots' job, finished and `stopping`
+    std::condition_variable changed;
+    bool stopping = false;
+
+    size_t done = 0;
+    uint32_t failedInstances = 0;
+
+    RenderBatch(const Options& o, const clap_plugin_factory_t* f, const clap_plugin_descriptor_t* d)
+        : opts(o), factory(f), desc(d) {}
+};
+
+static bool isWavPath(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".wav";
+}
+
+// Every WAV file directly inside the input directory, sorted, each with the
+// same file name in the (created if needed) output directory
+static bool collectRenderJobs(const Options& opts, std::vector<RenderJob>& jobs) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    if (!fs::is_directory(opts.batchInput, ec)) {
+        fprintf(stderr, "ERROR: Not a directory: %s\n", opts.batchInput);
+        return false;
+    }
+    fs::create_directories(opts.batchOutput, ec);
+    if (ec) {
+        fprintf(stderr, "ERROR: Cannot create %s: %s\n", opts.batchOutput, ec.message().c_str());
+        return false;
+    }
+    if (fs::equivalent(opts.batchInput, opts.batchOutput, ec)) {
+        fprintf(stderr, "ERROR: --batch output directory must differ from the input directory\n");
+        return false;
     }
 
-    return 0;
+    std::vector<fs::path> inputs;
+    for (auto it = fs::directory_iterator(opts.batchInput, ec); !ec && it != fs::directory_iterator();
+         it.increment(ec)) {
+        if (it->is_regular_file(ec) && isWavPath(it->path())) inputs.push_back(it->path());
+    }
+    if (ec) {
+        fprintf(stderr, "ERROR: Cannot scan %s: %s\n", opts.batchInput, ec.message().c_str());
+        return false;
+    }
+    std::sort(inputs.begin(), inputs.end());
+
+    for (const auto& path : inputs) {
+        RenderJob job;
+        job.input = path.string();
+        job.output = (fs::path(opts.batchOutput) / path.filename()).string();
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+// Main thread: open the job's files and activate the slot's instance at the
+// input's rate. False (with job.error set) if the job cannot be rendered.
+static bool prepareRenderJob(const Options& opts, RenderSlot& slot, RenderJob& job) {
+    Renderer& renderer = slot.renderer;
+    auto reader = openInput(opts, job.input);
+    if (reader->hasError()) {
+        job.error = reader->getError();
+        return false;
+    }
+    slot.input = std::make_unique<WavReadAhead>(std::move(reader));
+    uint32_t sampleRate = slot.input->sampleRate();
+
+    if (!activateRenderer(opts, renderer, sampleRate)) {
+        job.error = "Failed to activate plugin at " + std::to_string(sampleRate) + " Hz";
+        return false;
+    }
+
+    WavFormat format = opts.outputFloat ? WavFormat::Float32 : WavFormat::Int16;
+    auto writer = WavWriter::open(job.output, sampleRate, renderer.outputChannels, format);
+    if (writer->hasError()) {
+        job.error = writer->getError();
+        return false;
+    }
+    slot.output = std::make_unique<WavWriteBehind>(std::move(writer), renderer.outputChannels);
+    return true;
+}
+
+// Worker: render the job it was handed
+static void renderJob(const Options& opts, RenderSlot& slot, RenderJob& job) {
+    WavReadAhead& input = *slot.input;
+    WavWriteBehind& output = *slot.output;
+    if (!renderFile(opts, slot.renderer, &input, input.frameCount(), output)) {
+        job.error = "Failed to start processing";
+        return;
+    }
+    bool written = output.close();
+    if (input.hasError()) {
+        job.error = "Failed to read input file: " + input.getError();
+        return;
+    }
+    if (!written) {
+        job.error = "Failed to write output file: " + output.getError();
+        return;
+    }
+    job.audioSeconds = static_cast<double>(output.framesQueued()) / input.sampleRate();
+    job.ok = true;
+}
+
+static void runRenderWorker(RenderBatch& batch, RenderSlot& slot) {
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    while (true) {
+        batch.changed.wait(lock, [&] { return batch.stopping || (slot.job && !slot.finished); });
+        if (batch.stopping) return;
+        RenderJob& job = *slot.job;
+        lock.unlock();
+        renderJob(batch.opts, slot, job);
+        lock.lock();
+        slot.finished = true;
+        batch.changed.notify_all();
+    }
+}
+
+static void printRenderProgress(RenderBatch& batch, const RenderJob& job) {
+    const size_t total = batch.jobs.size();
+    ++batch.done;
+    int width = static_cast<int>(std::to_string(total).size());
+    std::string name = std::filesystem::path(job.input).filename().string();
+    if (job.ok) {
+        printf("[%*zu/%zu] %7.2fs  %s (%.1f s of audio, %.1fx realtime)\n", width, batch.done, total,
+               job.seconds, name.c_str(), job.audioSeconds,
+               job.seconds > 0 ? job.audioSeconds / job.seconds : 0.0);
+    } else {
+        printf("[%*zu/%zu] FAILED   %s: %s\n", width, batch.done, total, name.c_str(), job.error.c_str());
+    }
+}
+
+// Main thread: hand jobs to idle slots and pump every host until all jobs are done
+static void runRenderJobs(RenderBatch& batch) {
+    size_t next = 0;
+    size_t busy = 0;
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    while (true) {
+        for (auto& slot : batch.slots) {
+            if (slot->finished) {
+                RenderJob& job = *slot->job;
+                job.seconds = elapsedNs(slot->start, std::chrono::steady_clock::now()) / 1e9;
+                slot->job = nullptr;
+                slot->finished = false;
+                slot->input.reset();
+                slot->output.reset();
+                busy--;
+                printRenderProgress(batch, job);
+            }
+            while (!slot->job && next < batch.jobs.size()) {
+                RenderJob& job = batch.jobs[next++];
+                slot->start = std::chrono::steady_clock::now();
+                lock.unlock();
+                bool prepared = prepareRenderJob(batch.opts, *slot, job);
+                lock.lock();
+                if (!prepared) {
+                    slot->input.reset();
+                    slot->output.reset();
+                    job.seconds = elapsedNs(slot->start, std::chrono::steady_clock::now()) / 1e9;
+                    printRenderProgress(batch, job);
+                    continue;
+                }
+                slot->job = &job;
+                busy++;
+                batch.changed.notify_all();
+            }
+        }
+        if (busy == 0) break;
+
+        batch.changed.wait_for(lock, RENDER_PUMP_INTERVAL);
+        lock.unlock();
+        for (auto& slot : batch.slots) slot->renderer.host.pumpMainThread();
+        lock.lock();
+    }
+    batch.stopping = true;
+    batch.changed.notify_all();
+}
+
+static int processBatch(const Options& opts, const clap_plugin_factory_t* factory,
+                        const clap_plugin_descriptor_t* desc) {
+    RenderBatch batch(opts, factory, desc);
+    if (!collectRenderJobs(opts, batch.jobs)) return 1;
+    if (batch.jobs.empty()) {
+        fprintf(stderr, "ERROR: No WAV files in %s\n", opts.batchInput);
+        return 1;
+    }
+
+    uint32_t threads = opts.jobs > 0 ? opts.jobs : hardwareThreadCount();
+    threads = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(threads, batch.jobs.size())));
+    printf("Plugin: %s\n", desc->name);
+    printf("Batch: %zu file(s) from %s to %s, %u thread(s)\n\n", batch.jobs.size(), opts.batchInput,
+           opts.batchOutput, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    // Every instance is created here, so this is the main thread of all of them
+    for (uint32_t t = 0; t < threads; ++t) {
+        auto slot = std::make_unique<RenderSlot>();
+        slot->renderer.host.setLogEcho(true);
+        slot->renderer.pumpWhileRendering = false;
+        if (!createRenderer(factory, desc, slot->renderer)) {
+            batch.failedInstances++;
+            continue;
+        }
+        batch.slots.push_back(std::move(slot));
+    }
+    for (auto& slot : batch.slots) {
+        slot->worker = std::thread([&batch, target = slot.get()] { runRenderWorker(batch, *target); });
+    }
+    runRenderJobs(batch);
+    uint64_t processNs = 0;
+    for (auto& slot : batch.slots) {
+        slot->worker.join();
+        processNs += slot->renderer.processNs;
+    }
+    double wallSeconds = elapsedNs(start, std::chrono::steady_clock::now()) / 1e9;
+
+    size_t passed = 0;
+    double audioSeconds = 0.0;
+    for (auto& job : batch.jobs) {
+        if (!job.ok && job.error.empty()) job.error = "Not rendered: no plugin instance could be created";
+        if (job.ok) {
+            passed++;
+            audioSeconds += job.audioSeconds;
+        }
+    }
+
+    printf("\nRendered %zu of %zu file(s), %.1f s of audio in %.2f s\n", passed, batch.jobs.size(), audioSeconds,
+           wallSeconds);
+    if (batch.failedInstances > 0) {
+        printf("  %u of %u instance(s) failed to create/init\n", batch.failedInstances, threads);
+    }
+    printf("  Realtime factor %.1fx overall, %.1fx per thread\n",
+           wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0,
+           wallSeconds > 0 ? audioSeconds / wallSeconds / threads : 0.0);
+    double processSeconds = processNs / 1e9;
+    printf("  %.2f s inside process(), %.0f%% of thread time\n", processSeconds,
+           wallSeconds > 0 ? 100.0 * processSeconds / (wallSeconds * threads) : 0.0);
+    return passed == batch.jobs.size() ? 0 : 1;
 }
 
 static int cmdProcess(const Options& opts) {
-    if (!opts.outputFile) {
+    if (opts.batchInput && (opts.inputFile || opts.outputFile)) {
+        fprintf(stderr, "ERROR: --batch takes input and output directories instead of -i and -o\n");
+        return 1;
+    }
+    if (!opts.batchInput && !opts.outputFile) {
         fprintf(stderr, "ERROR: --output (-o) is required for process command\n");
         return 1;
     }
@@ -503,218 +3769,303 @@ static int cmdProcess(const Options& opts) {
         return 1;
     }
 
-    // Load input audio if provided
-    std::unique_ptr<WavFile> inputWav;
-    uint32_t inputChannels = 2;
-    uint32_t inputFrames = 0;
+    // Use first plugin
+    const auto* desc = factory->get_plugin_descriptor(factory, 0);
+    if (!desc) {
+        fprintf(stderr, "ERROR: Null plugin descriptor\n");
+        return 1;
+    }
+
+    if (opts.batchInput) return processBatch(opts, factory, desc);
+
+    // Open input audio if provided (streamed and read ahead, never loaded whole)
+    std::unique_ptr<WavReadAhead> input;
     uint32_t sampleRate = opts.sampleRate;
 
     if (opts.inputFile) {
-        inputWav = WavFile::load(opts.inputFile);
-        if (inputWav->hasError()) {
-            fprintf(stderr, "ERROR: %s\n", inputWav->getError().c_str());
+        auto reader = openInput(opts, opts.inputFile);
+        if (reader->hasError()) {
+            fprintf(stderr, "ERROR: %s\n", reader->getError().c_str());
             return 1;
         }
-        inputChannels = inputWav->channels();
-        inputFrames = inputWav->frameCount();
-        sampleRate = inputWav->sampleRate();
-        printf("Input: %s (%u Hz, %u ch, %u frames)\n",
-               opts.inputFile, sampleRate, inputChannels, inputFrames);
+        printInput(opts.inputFile, *reader);
+        input = std::make_unique<WavReadAhead>(std::move(reader));
+        sampleRate = input->sampleRate();
     }
 
     // Determine output length
-    uint32_t outputFrames;
-    if (inputWav) {
-        outputFrames = inputFrames;
+    uint64_t outputFrames;
+    if (input) {
+        outputFrames = input->frameCount();
     } else {
         // No input: generate specified number of blocks (or default to 1 second)
         uint32_t blocks = opts.blocks > 0 ? opts.blocks : (sampleRate / opts.bufferSize);
-        outputFrames = blocks * opts.bufferSize;
+        outputFrames = static_cast<uint64_t>(blocks) * opts.bufferSize;
     }
 
-    TestHost host;
-
-    // Use first plugin
-    const auto* desc = factory->get_plugin_descriptor(factory, 0);
-    if (!desc) {
-        fprintf(stderr, "ERROR: Null plugin descriptor\n");
-        return 1;
-    }
     printf("Plugin: %s\n", desc->name);
 
-    const clap_plugin_t* plugin = factory->create_plugin(factory, host.clapHost(), desc->id);
-    if (!plugin || !plugin->init(plugin)) {
+    Renderer renderer;
+    renderer.host.setLogEcho(true);
+    if (!createRenderer(factory, desc, renderer)) {
         fprintf(stderr, "ERROR: Failed to create/init plugin\n");
-        if (plugin) plugin->destroy(plugin);
         return 1;
     }
-
-    if (!plugin->activate(plugin, sampleRate, opts.bufferSize, opts.bufferSize)) {
+    if (!activateRenderer(opts, renderer, sampleRate)) {
         fprintf(stderr, "ERROR: Failed to activate plugin\n");
-        plugin->destroy(plugin);
         return 1;
     }
+    if (renderer.latency > 0 || renderer.tail > 0) {
+        printf("Latency: %u frames, tail: %u frames%s\n", renderer.latency, renderer.tail,
+               renderer.tailCapped ? " (infinite, capped)" : "");
+    }
 
-    if (!plugin->start_processing(plugin)) {
-        fprintf(stderr, "ERROR: Failed to start processing\n");
-        plugin->deactivate(plugin);
-        plugin->destroy(plugin);
+    WavFormat wavFmt = opts.outputFloat ? WavFormat::Float32 : WavFormat::Int16;
+    auto writer = WavWriter::open(opts.outputFile, sampleRate, renderer.outputChannels, wavFmt);
+    if (writer->hasError()) {
+        fprintf(stderr, "ERROR: %s\n", writer->getError().c_str());
         return 1;
     }
+    WavWriteBehind output(std::move(writer), renderer.outputChannels);
 
-    // Query audio ports to get output channel count
-    uint32_t outputChannels = 2; // default stereo
-    const auto* audioPorts = static_cast<const clap_plugin_audio_ports_t*>(
-        plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
-    if (audioPorts) {
-        uint32_t outCount = audioPorts->count(plugin, false);
-        if (outCount > 0) {
-            clap_audio_port_info_t info{};
-            if (audioPorts->get(plugin, 0, false, &info)) {
-                outputChannels = info.channel_count;
-            }
-        }
+    if (!renderFile(opts, renderer, input.get(), outputFrames, output)) {
+        fprintf(stderr, "ERROR: Failed to start processing\n");
+        return 1;
+    }
+    bool written = output.close();
+    if (input && input->hasError()) {
+        fprintf(stderr, "ERROR: Failed to read input file: %s\n", input->getError().c_str());
+        return 1;
+    }
+    if (!written) {
+        fprintf(stderr, "ERROR: Failed to write output file: %s\n", output.getError().c_str());
+        return 1;
     }
 
-    // Allocate buffers
-    std::vector<float> inputBuffer(opts.bufferSize * inputChannels);
-    std::vector<float> outputBuffer(opts.bufferSize * outputChannels);
-    std::vector<float> outputSamples;
-    outputSamples.reserve(outputFrames * outputChannels);
+    printf("Output: %s (%u Hz, %u ch, %llu frames, %s)\n",
+           opts.outputFile, sampleRate, renderer.outputChannels,
+           static_cast<unsigned long long>(output.framesQueued()),
+           opts.outputFloat ? "float32" : "int16");
 
-    // Set up CLAP audio buffers
-    std::vector<float*> inChannelPtrs(inputChannels);
-    std::vector<float*> outChannelPtrs(outputChannels);
-    std::vector<std::vector<float>> inChannels(inputChannels);
-    std::vector<std::vector<float>> outChannels(outputChannels);
+    return 0;
+}
 
-    for (uint32_t c = 0; c < inputChannels; ++c) {
-        inChannels[c].resize(opts.bufferSize);
-        inChannelPtrs[c] = inChannels[c].data();
+// Stream for state save/load
+// Byte buffer behind the state streams. rewind() keeps the allocation, so
+// a stream reused for every save stops allocating once it has held the
+// largest state.
+struct StateStream {
+    std::vector<uint8_t> data;
+    size_t readPos = 0;
+    clap_ostream_t ostream{this, write};
+    clap_istream_t istream{this, read};
+
+    StateStream() = default;
+    StateStream(const StateStream&) = delete;
+    StateStream& operator=(const StateStream&) = delete;
+
+    /// Start a new save, keeping the capacity
+    void rewind() {
+        data.clear();
+        readPos = 0;
     }
-    for (uint32_t c = 0; c < outputChannels; ++c) {
-        outChannels[c].resize(opts.bufferSize);
-        outChannelPtrs[c] = outChannels[c].data();
+
+    static int64_t write(const clap_ostream_t* stream, const void* buffer, uint64_t size) {
+        auto* s = static_cast<StateStream*>(stream->ctx);
+        const auto* bytes = static_cast<const uint8_t*>(buffer);
+        s->data.insert(s->data.end(), bytes, bytes + size);
+        return static_cast<int64_t>(size);
     }
 
-    clap_audio_buffer_t inBuf{};
-    inBuf.data32 = inChannelPtrs.data();
-    inBuf.channel_count = inputChannels;
-    inBuf.latency = 0;
-    inBuf.constant_mask = 0;
+    static int64_t read(const clap_istream_t* stream, void* buffer, uint64_t size) {
+        auto* s = static_cast<StateStream*>(stream->ctx);
+        size_t available = s->data.size() - s->readPos;
+        size_t toRead = std::min(static_cast<size_t>(size), available);
+        if (toRead > 0) {
+            std::memcpy(buffer, s->data.data() + s->readPos, toRead);
+            s->readPos += toRead;
+        }
+        return static_cast<int64_t>(toRead);
+    }
+};
 
-    clap_audio_buffer_t outBuf{};
-    outBuf.data32 = outChannelPtrs.data();
-    outBuf.channel_count = outputChannels;
-    outBuf.latency = 0;
-    outBuf.constant_mask = 0;
+static constexpr uint32_t DEFAULT_STATE_BENCH_ITERATIONS = 100;
+static constexpr double STATE_CONCURRENT_SECONDS = 1.0;  // Per phase of the save-while-processing test
+// Deadline misses while saving, beyond the audio-alone rate, that are still
+// scheduling noise: the larger of a fixed count and a share of the blocks
+static constexpr double STATE_NOISE_MISSES = 3.0;
+static constexpr double STATE_NOISE_MISS_FRACTION = 0.02;
+
+// Time each call into `histogram`; false as soon as one fails
+template<typename Call>
+static bool timeStateCalls(uint32_t iterations, LatencyHistogram& histogram, Call&& call) {
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = call();
+        histogram.record(elapsedNs(start, std::chrono::steady_clock::now()));
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static void printStateTimes(const char* indent, const char* name, const LatencyHistogram& h, size_t bytes) {
+    double mbPerSecond = h.mean() > 0 ? static_cast<double>(bytes) / h.mean() * 1e9 / 1e6 : 0.0;
+    printf("%s%-6s %10.1f MB/s  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f µs\n", indent, name, mbPerSecond,
+           h.valueAtPercentile(50.0) / 1000.0, h.valueAtPercentile(90.0) / 1000.0,
+           h.valueAtPercentile(99.0) / 1000.0, h.max() / 1000.0);
+}
+
+// Processes one block per buffer period, like a real host, until `stop`.
+// Returns false at once if start_processing() is refused.
+static bool runStateAudioThread(const Options& opts, const clap_plugin_t* plugin, const std::atomic<bool>& stop,
+                                BlockStats& stats) {
+    std::string policy;
+    setCurrentThreadRealtime(stats.deadlineNs, policy);  // Best effort; keeps the saving thread from preempting us
+    TestHost::AudioThreadScope audio;
 
+    StereoAudioBuffers buffers(opts.bufferSize);
+    buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
     EmptyInputEvents inEvents;
     DiscardOutputEvents outEvents;
 
     clap_process_t process{};
-    process.steady_time = 0;
     process.frames_count = opts.bufferSize;
-    process.transport = nullptr;
-    process.audio_inputs = &inBuf;
-    process.audio_outputs = &outBuf;
+    process.audio_inputs = buffers.inputBuffer();
+    process.audio_outputs = buffers.outputBuffer();
     process.audio_inputs_count = 1;
     process.audio_outputs_count = 1;
     process.in_events = inEvents.get();
     process.out_events = outEvents.get();
 
-    // Process
-    uint32_t framesProcessed = 0;
-    uint32_t inputPos = 0;
-
-    while (framesProcessed < outputFrames) {
-        uint32_t framesToProcess = std::min(opts.bufferSize, outputFrames - framesProcessed);
-        process.frames_count = framesToProcess;
+    if (!plugin->start_processing(plugin)) return false;
+    auto period = std::chrono::nanoseconds(stats.deadlineNs);
+    auto boundary = std::chrono::steady_clock::now();
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        plugin->process(plugin, &process);
+        auto done = std::chrono::steady_clock::now();
+        stats.record(elapsedNs(start, done));
+        process.steady_time += opts.bufferSize;
+        boundary += period;
+        if (boundary < done) boundary = done;  // Overran; don't try to catch up
+        sleepUntil(boundary);
+    }
+    plugin->stop_processing(plugin);
+    return true;
+}
 
-        // Fill input buffers
-        if (inputWav) {
-            const auto& samples = inputWav->samples();
-            for (uint32_t f = 0; f < framesToProcess; ++f) {
-                for (uint32_t c = 0; c < inputChannels; ++c) {
-                    if (inputPos + f < inputFrames) {
-                        inChannels[c][f] = samples[(inputPos + f) * inputChannels + c];
-                    } else {
-                        inChannels[c][f] = 0.0f;
-                    }
-                }
-            }
-        } else {
-            // No input: silence
-            for (uint32_t c = 0; c < inputChannels; ++c) {
-                std::fill(inChannels[c].begin(), inChannels[c].end(), 0.0f);
-            }
-        }
+static void printStateAudio(const char* label, const BlockStats& stats) {
+    const auto& h = stats.histogram;
+    printf("    %-13s p99 %8.1f  max %8.1f µs, %llu of %llu blocks over the deadline\n", label,
+           h.valueAtPercentile(99.0) / 1000.0, h.max() / 1000.0,
+           static_cast<unsigned long long>(stats.deadlineMisses), static_cast<unsigned long long>(h.count()));
+}
 
-        // Clear output buffers
-        for (uint32_t c = 0; c < outputChannels; ++c) {
-            std::fill(outChannels[c].begin(), outChannels[c].end(), 0.0f);
-        }
+// state --bench: save and load throughput, then saving on the main thread
+// while the audio thread processes. Returns 1 if saving held up the audio.
+static int benchState(const Options& opts, const clap_plugin_t* plugin, const clap_plugin_state_t* state) {
+    uint32_t iterations = opts.benchIterations > 0 ? opts.benchIterations : DEFAULT_STATE_BENCH_ITERATIONS;
 
-        plugin->process(plugin, &process);
+    // One stream for every call: after the first save it holds the largest
+    // state, so the timings leave out the host's own allocations
+    StateStream stream;
+    if (!state->save(plugin, &stream.ostream)) {
+        fprintf(stderr, "ERROR: Failed to save state\n");
+        return 1;
+    }
+    size_t bytes = stream.data.size();
+    printf("State bench: %zu bytes, %u iterations\n", bytes, iterations);
+
+    LatencyHistogram saves;
+    bool saved = timeStateCalls(iterations, saves, [&] {
+        stream.rewind();
+        return state->save(plugin, &stream.ostream);
+    });
+    if (!saved) {
+        fprintf(stderr, "ERROR: Failed to save state\n");
+        return 1;
+    }
+    printStateTimes("  ", "save", saves, bytes);
+
+    LatencyHistogram loads;
+    if (!timeStateCalls(iterations, loads, [&] {
+            stream.readPos = 0;
+            return state->load(plugin, &stream.istream);
+        })) {
+        fprintf(stderr, "ERROR: Failed to load state\n");
+        return 1;
+    }
+    printStateTimes("  ", "load", loads, bytes);
 
-        // Collect output (interleaved)
-        for (uint32_t f = 0; f < framesToProcess; ++f) {
-            for (uint32_t c = 0; c < outputChannels; ++c) {
-                outputSamples.push_back(outChannels[c][f]);
+    // Save while processing: a plugin that takes a lock its process() also
+    // needs shows up as audio blocks running past the deadline
+    if (!plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize)) {
+        fprintf(stderr, "ERROR: activate() failed\n");
+        return 1;
+    }
+    BlockStats alone(opts.bufferSize, opts.sampleRate);
+    BlockStats saving(opts.bufferSize, opts.sampleRate);
+    LatencyHistogram concurrentSaves;
+    bool concurrentOk = true;
+    std::atomic<bool> processing{true};
+    auto phase = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(STATE_CONCURRENT_SECONDS));
+    for (BlockStats* stats : {&alone, &saving}) {
+        std::atomic<bool> stop{false};
+        std::thread audio([&] {
+            if (!runStateAudioThread(opts, plugin, stop, *stats)) processing.store(false);
+        });
+        auto end = std::chrono::steady_clock::now() + phase;
+        if (stats == &alone) {
+            sleepUntil(end);
+        } else {
+            // At least `iterations` saves, spread over the whole phase
+            while (concurrentOk && processing.load() &&
+                   (concurrentSaves.count() < iterations || std::chrono::steady_clock::now() < end)) {
+                concurrentOk = timeStateCalls(1, concurrentSaves, [&] {
+                    stream.rewind();
+                    return state->save(plugin, &stream.ostream);
+                });
+                std::this_thread::yield();
             }
         }
-
-        framesProcessed += framesToProcess;
-        inputPos += framesToProcess;
-        process.steady_time += framesToProcess;
+        stop.store(true);
+        audio.join();
+        if (!processing.load()) break;
     }
-
-    plugin->stop_processing(plugin);
     plugin->deactivate(plugin);
-    plugin->destroy(plugin);
-
-    // Write output
-    WavFormat wavFmt = opts.outputFloat ? WavFormat::Float32 : WavFormat::Int16;
-    if (!WavFile::save(opts.outputFile, outputSamples, sampleRate, outputChannels, wavFmt)) {
-        fprintf(stderr, "ERROR: Failed to write output file\n");
+    if (!processing.load()) {
+        fprintf(stderr, "ERROR: start_processing() failed\n");
+        return 1;
+    }
+    if (!concurrentOk) {
+        fprintf(stderr, "ERROR: Failed to save state while processing\n");
         return 1;
     }
 
-    printf("Output: %s (%u Hz, %u ch, %u frames, %s)\n",
-           opts.outputFile, sampleRate, outputChannels,
-           static_cast<uint32_t>(outputSamples.size() / outputChannels),
-           opts.outputFloat ? "float32" : "int16");
-
-    return 0;
-}
-
-// Stream for state save/load
-struct StateStream {
-    std::vector<uint8_t> data;
-    size_t readPos = 0;
-};
-
-static int64_t stateWrite(const clap_ostream_t* stream, const void* buffer, uint64_t size) {
-    auto* s = static_cast<StateStream*>(stream->ctx);
-    const auto* bytes = static_cast<const uint8_t*>(buffer);
-    s->data.insert(s->data.end(), bytes, bytes + size);
-    return static_cast<int64_t>(size);
-}
-
-static int64_t stateRead(const clap_istream_t* stream, void* buffer, uint64_t size) {
-    auto* s = static_cast<StateStream*>(stream->ctx);
-    size_t available = s->data.size() - s->readPos;
-    size_t toRead = std::min(static_cast<size_t>(size), available);
-    if (toRead > 0) {
-        std::memcpy(buffer, s->data.data() + s->readPos, toRead);
-        s->readPos += toRead;
+    printf("\n  Saving while processing (%.0f µs deadline):\n", alone.deadlineNs / 1000.0);
+    printStateAudio("audio alone", alone);
+    printStateAudio("while saving", saving);
+    printStateTimes("    ", "save", concurrentSaves, bytes);
+
+    // Count misses beyond what the phase without saves had, scaled to its
+    // block count; a few more than that is the scheduler, not the plugin
+    double expectedMisses = alone.histogram.count() > 0
+        ? static_cast<double>(alone.deadlineMisses) * saving.histogram.count() / alone.histogram.count()
+        : 0.0;
+    double noise = std::max(STATE_NOISE_MISSES, STATE_NOISE_MISS_FRACTION * saving.histogram.count());
+    if (static_cast<double>(saving.deadlineMisses) > expectedMisses + noise) {
+        printf("  ✗ Saving blocks the audio thread: %llu deadline miss(es) while saving, max block %.1f µs\n",
+               static_cast<unsigned long long>(saving.deadlineMisses), saving.histogram.max() / 1000.0);
+        return 1;
     }
-    return static_cast<int64_t>(toRead);
+    printf("  ✓ Saving does not hold up the audio thread\n");
+    return 0;
 }
 
 static int cmdState(const Options& opts) {
-    if (!opts.outputFile && !opts.inputFile && !opts.roundtrip) {
-        fprintf(stderr, "ERROR: state command requires -o (save), -i (load), or --roundtrip\n");
+    if (!opts.outputFile && !opts.inputFile && !opts.roundtrip && !opts.bench) {
+        fprintf(stderr, "ERROR: state command requires -o (save), -i (load), --roundtrip or --bench\n");
         return 1;
     }
 
@@ -767,17 +4118,13 @@ static int cmdState(const Options& opts) {
         printf("Testing state round-trip...\n");
 
         // Save original state
-        StateStream saveStream;
-        clap_ostream_t ostream{};
-        ostream.ctx = &saveStream;
-        ostream.write = stateWrite;
-
-        if (!state->save(plugin, &ostream)) {
+        StateStream stream;
+        if (!state->save(plugin, &stream.ostream)) {
             fprintf(stderr, "  ERROR: Failed to save state\n");
             plugin->destroy(plugin);
             return 1;
         }
-        printf("  Saved state: %zu bytes\n", saveStream.data.size());
+        printf("  Saved state: %zu bytes\n", stream.data.size());
 
         // Get current parameter values
         const auto* params = static_cast<const clap_plugin_params_t*>(
@@ -798,13 +4145,7 @@ static int cmdState(const Options& opts) {
         }
 
         // Restore state
-        StateStream loadStream;
-        loadStream.data = saveStream.data;
-        clap_istream_t istream{};
-        istream.ctx = &loadStream;
-        istream.read = stateRead;
-
-        if (!state->load(plugin, &istream)) {
+        if (!state->load(plugin, &stream.istream)) {
             fprintf(stderr, "  ERROR: Failed to load state\n");
             plugin->destroy(plugin);
             return 1;
@@ -834,11 +4175,7 @@ static int cmdState(const Options& opts) {
     else if (opts.outputFile) {
         // Save state to file
         StateStream stream;
-        clap_ostream_t ostream{};
-        ostream.ctx = &stream;
-        ostream.write = stateWrite;
-
-        if (!state->save(plugin, &ostream)) {
+        if (!state->save(plugin, &stream.ostream)) {
             fprintf(stderr, "ERROR: Failed to save state\n");
             plugin->destroy(plugin);
             return 1;
@@ -869,20 +4206,395 @@ static int cmdState(const Options& opts) {
         stream.data.resize(size);
         file.read(reinterpret_cast<char*>(stream.data.data()), size);
 
-        clap_istream_t istream{};
-        istream.ctx = &stream;
-        istream.read = stateRead;
-
-        if (!state->load(plugin, &istream)) {
+        if (!state->load(plugin, &stream.istream)) {
             fprintf(stderr, "ERROR: Failed to load state\n");
             plugin->destroy(plugin);
             return 1;
         }
-        printf("Loaded state: %s (%zu bytes)\n", opts.inputFile, size);
+        printf("Loaded state: %s (%zu bytes)\n", opts.inputFile, size);
+    }
+
+    if (opts.bench && result == 0) result = benchState(opts, plugin, state);
+
+    plugin->destroy(plugin);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Startup
+//-----------------------------------------------------------------------------
+
+// Cold and warm runs each unless --repetitions
+static constexpr uint32_t DEFAULT_STARTUP_RUNS = 5;
+
+enum StartupPhaseId { Open, EntryInit, Create, Init, StateLoad, Activate, FirstProcess, STARTUP_PHASE_COUNT };
+
+static const char* const STARTUP_PHASE_NAMES[STARTUP_PHASE_COUNT] = {
+    "open", "entryInit", "create", "init", "stateLoad", "activate", "firstProcess"};
+static const char* const STARTUP_PHASE_LABELS[STARTUP_PHASE_COUNT] = {
+    "dlopen", "entry->init", "create_plugin", "plugin init", "state load", "activate", "first process"};
+
+struct StartupPhase {
+    bool ran = false;
+    uint64_t ns = 0;
+    ResourceUsage cost;
+};
+
+// One load-to-first-block run. Plain data, so a forked run can send it
+// back through a pipe as is.
+struct StartupRun {
+    StartupPhase phases[STARTUP_PHASE_COUNT];
+    bool ok = false;
+    uint32_t pluginCount = 0;
+    char error[160] = {};
+    char id[256] = {};
+    char name[256] = {};
+    char vendor[256] = {};
+    char version[64] = {};
+};
+
+static void copyField(char* out, size_t size, const char* text) {
+    snprintf(out, size, "%s", text ? text : "");
+}
+
+// Load the file and bring plugin `index` up to its first process() call,
+// timing each step and the page faults and RSS it caused. Without a state
+// file (-i) the state the instance has just saved is loaded back; saving
+// is not timed. Tearing down is not timed either.
+static void runStartup(const Options& opts, uint32_t index, const std::vector<uint8_t>* stateFile,
+                       StartupRun& run) {
+    run = StartupRun{};
+    auto timed = [&](StartupPhaseId id, auto&& step) {
+        ResourceUsage before = ResourceUsage::current();
+        auto start = std::chrono::steady_clock::now();
+        bool ok = step();
+        run.phases[id].ns = elapsedNs(start, std::chrono::steady_clock::now());
+        run.phases[id].cost = ResourceUsage::current() - before;
+        run.phases[id].ran = true;
+        return ok;
+    };
+    auto fail = [&](const char* what) {
+        copyField(run.error, sizeof(run.error), what);
+    };
+
+    TestHost host;
+    std::unique_ptr<PluginLoader> loader;
+    if (!timed(Open, [&] { loader = PluginLoader::open(opts.pluginPath); return loader->entry() != nullptr; })) {
+        return fail(loader->getError().c_str());
+    }
+    if (!timed(EntryInit, [&] { return loader->initEntry(); })) return fail(loader->getError().c_str());
+
+    const auto* factory = loader->factory();
+    if (!factory) return fail("No plugin factory");
+    run.pluginCount = factory->get_plugin_count(factory);
+    const auto* desc = index < run.pluginCount ? factory->get_plugin_descriptor(factory, index) : nullptr;
+    if (!desc) return fail("Null plugin descriptor");
+    copyField(run.id, sizeof(run.id), desc->id);
+    copyField(run.name, sizeof(run.name), desc->name);
+    copyField(run.vendor, sizeof(run.vendor), desc->vendor);
+    copyField(run.version, sizeof(run.version), desc->version);
+
+    const clap_plugin_t* plugin = nullptr;
+    if (!timed(Create, [&] { plugin = factory->create_plugin(factory, host.clapHost(), desc->id); return plugin != nullptr; })) {
+        return fail("create_plugin() failed");
+    }
+    if (!timed(Init, [&] { return plugin->init(plugin); })) {
+        plugin->destroy(plugin);
+        return fail("init() failed");
+    }
+    host.setPlugin(plugin);
+
+    bool ok = true;
+    const auto* state = static_cast<const clap_plugin_state_t*>(plugin->get_extension(plugin, CLAP_EXT_STATE));
+    if (state) {
+        StateStream stream;
+        if (stateFile) {
+            stream.data = *stateFile;
+        } else {
+            ok = state->save(plugin, &stream.ostream);
+            if (!ok) fail("state save failed");
+        }
+        if (ok && !timed(StateLoad, [&] { return state->load(plugin, &stream.istream); })) {
+            ok = false;
+            fail("state load failed");
+        }
+    }
+
+    bool activated = ok && timed(Activate, [&] {
+        return plugin->activate(plugin, opts.sampleRate, opts.bufferSize, opts.bufferSize);
+    });
+    if (ok && !activated) {
+        ok = false;
+        fail("activate() failed");
+    }
+
+    if (activated) {
+        StereoAudioBuffers buffers(opts.bufferSize);
+        buffers.fillInputWithSine(440.0f, static_cast<float>(opts.sampleRate));
+        EmptyInputEvents inEvents;
+        DiscardOutputEvents outEvents;
+        clap_process_t process{};
+        process.frames_count = opts.bufferSize;
+        process.audio_inputs = buffers.inputBuffer();
+        process.audio_outputs = buffers.outputBuffer();
+        process.audio_inputs_count = 1;
+        process.audio_outputs_count = 1;
+        process.in_events = inEvents.get();
+        process.out_events = outEvents.get();
+
+        TestHost::AudioThreadScope audio;
+        bool started = false;
+        if (!timed(FirstProcess, [&] {
+                started = plugin->start_processing(plugin);
+                return started && plugin->process(plugin, &process) != CLAP_PROCESS_ERROR;
+            })) {
+            ok = false;
+            fail(started ? "first process() failed" : "start_processing() failed");
+        }
+        if (started) plugin->stop_processing(plugin);
+    }
+
+    if (activated) plugin->deactivate(plugin);
+    plugin->destroy(plugin);
+    host.setPlugin(nullptr);
+    run.ok = ok;
+}
+
+#ifndef _WIN32
+// Do `runs` runs in a forked child and collect them; `warmUp` runs one more
+// first and drops it. With warmUp unset every run gets its own child, so the
+// library is loaded into a process that has never seen it.
+static bool forkStartupRuns(const Options& opts, uint32_t index, const std::vector<uint8_t>* stateFile,
+                            uint32_t runs, bool warmUp, std::vector<StartupRun>& out) {
+    uint32_t children = warmUp ? 1 : runs;
+    uint32_t perChild = warmUp ? runs : 1;
+    for (uint32_t c = 0; c < children; ++c) {
+        int fds[2];
+        if (pipe(fds) != 0) return false;
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            StartupRun run;
+            if (warmUp) runStartup(opts, index, stateFile, run);
+            for (uint32_t r = 0; r < perChild; ++r) {
+                runStartup(opts, index, stateFile, run);
+                const char* bytes = reinterpret_cast<const char*>(&run);
+                for (size_t done = 0; done < sizeof(run);) {
+                    ssize_t n = write(fds[1], bytes + done, sizeof(run) - done);
+                    if (n <= 0) _exit(1);
+                    done += static_cast<size_t>(n);
+                }
+            }
+            _exit(0);
+        }
+
+        close(fds[1]);
+        StartupRun run;
+        size_t have = 0;
+        ssize_t n;
+        while ((n = read(fds[0], reinterpret_cast<char*>(&run) + have, sizeof(run) - have)) > 0) {
+            have += static_cast<size_t>(n);
+            if (have == sizeof(run)) {
+                out.push_back(run);
+                have = 0;
+            }
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (out.size() < (c + 1) * perChild) {
+            // Crashed or exited part way: report it as a failed run
+            StartupRun crashed;
+            if (WIFSIGNALED(status)) {
+                snprintf(crashed.error, sizeof(crashed.error), "crashed (%s)", strsignal(WTERMSIG(status)));
+            } else {
+                snprintf(crashed.error, sizeof(crashed.error), "run exited early");
+            }
+            out.push_back(crashed);
+            return true;
+        }
+    }
+    return true;
+}
+#endif
+
+struct StartupSummary {
+    bool ran[STARTUP_PHASE_COUNT] = {};
+    uint64_t medianNs[STARTUP_PHASE_COUNT] = {};
+    uint64_t minNs[STARTUP_PHASE_COUNT] = {};
+    uint64_t minorFaults[STARTUP_PHASE_COUNT] = {};  // Medians over the runs
+    uint64_t majorFaults[STARTUP_PHASE_COUNT] = {};
+    int64_t residentBytes[STARTUP_PHASE_COUNT] = {};
+    LatencyHistogram total;
+};
+
+template<typename T>
+static T medianOf(std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static StartupSummary summarizeStartup(const std::vector<StartupRun>& runs) {
+    StartupSummary summary;
+    for (uint32_t p = 0; p < STARTUP_PHASE_COUNT; ++p) {
+        std::vector<uint64_t> ns, minor, major;
+        std::vector<int64_t> resident;
+        for (const auto& run : runs) {
+            const StartupPhase& phase = run.phases[p];
+            if (!phase.ran) continue;
+            ns.push_back(phase.ns);
+            minor.push_back(phase.cost.minorFaults);
+            major.push_back(phase.cost.majorFaults);
+            resident.push_back(phase.cost.residentBytes);
+        }
+        if (ns.empty()) continue;
+        summary.ran[p] = true;
+        summary.medianNs[p] = medianOf(ns);
+        summary.minNs[p] = *std::min_element(ns.begin(), ns.end());
+        summary.minorFaults[p] = medianOf(minor);
+        summary.majorFaults[p] = medianOf(major);
+        summary.residentBytes[p] = medianOf(resident);
+    }
+    for (const auto& run : runs) {
+        uint64_t ns = 0;
+        for (const auto& phase : run.phases) ns += phase.ns;
+        summary.total.record(ns);
+    }
+    return summary;
+}
+
+static Json startupJson(const StartupSummary& summary, size_t runs) {
+    Json phases = Json::object();
+    for (uint32_t p = 0; p < STARTUP_PHASE_COUNT; ++p) {
+        if (!summary.ran[p]) continue;
+        Json phase = Json::object();
+        phase.set("medianNs", summary.medianNs[p])
+             .set("minNs", summary.minNs[p])
+             .set("minorFaults", summary.minorFaults[p])
+             .set("majorFaults", summary.majorFaults[p])
+             .set("residentBytes", summary.residentBytes[p]);
+        phases.set(STARTUP_PHASE_NAMES[p], std::move(phase));
+    }
+    Json json = Json::object();
+    json.set("runs", runs).set("phases", std::move(phases));
+    return json;
+}
+
+static int cmdStartup(const Options& opts, Report& report) {
+    uint32_t runs = opts.repetitions > 0 ? opts.repetitions : DEFAULT_STARTUP_RUNS;
+
+    std::vector<uint8_t> stateData;
+    if (opts.inputFile) {
+        std::ifstream file(opts.inputFile, std::ios::binary);
+        if (!file) {
+            fprintf(stderr, "ERROR: Could not open file: %s\n", opts.inputFile);
+            return 1;
+        }
+        stateData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const std::vector<uint8_t>* stateFile = opts.inputFile ? &stateData : nullptr;
+
+    // Runs happen in child processes, so this one never loads the plugin itself
+    // and a plugin that crashes while loading is reported instead of taking us down
+    auto collect = [&](uint32_t index, bool warm, std::vector<StartupRun>& out) {
+#ifndef _WIN32
+        return forkStartupRuns(opts, index, stateFile, runs, warm, out);
+#else
+        // No fork: everything runs in this process, so only the very first run is cold
+        static bool loaded = false;
+        if (!warm && loaded) return true;
+        for (uint32_t r = 0; r < (warm ? runs : 1); ++r) {
+            StartupRun run;
+            runStartup(opts, index, stateFile, run);
+            out.push_back(run);
+            loaded = true;
+        }
+        return true;
+#endif
+    };
+
+    int failures = 0;
+    uint32_t pluginCount = 1;
+    for (uint32_t i = 0; i < pluginCount; ++i) {
+        std::vector<StartupRun> cold, warm;
+        if (!collect(i, false, cold) || !collect(i, true, warm)) {
+            fprintf(stderr, "ERROR: Could not start a run: %s\n", strerror(errno));
+            return 1;
+        }
+        const StartupRun* first = !cold.empty() ? &cold.front() : !warm.empty() ? &warm.front() : nullptr;
+        if (!first || first->id[0] == '\0') {
+            // Failed before the plugin was known: loading the file itself is broken
+            const char* error = first ? first->error : "no runs";
+            fprintf(stderr, "ERROR: %s\n", error);
+            report.check("load", false, error);
+            return 1;
+        }
+        if (i == 0) {
+            report.check("load", true);
+            pluginCount = first->pluginCount;
+        }
+
+        clap_plugin_descriptor_t desc{};
+        desc.id = first->id;
+        desc.name = first->name;
+        desc.vendor = first->vendor;
+        desc.version = first->version;
+        PluginResult& result = pluginResult(report, &desc);
+
+        const char* error = nullptr;
+        for (const auto* set : {&cold, &warm}) {
+            for (const auto& run : *set) {
+                if (!run.ok && !error) error = run.error;
+            }
+        }
+        result.check("startup", error == nullptr, error ? error : "");
+        if (error) {
+            fprintf(stderr, "  ✗ %s: %s\n", first->name, error);
+            failures++;
+        }
+
+        StartupSummary coldSummary = summarizeStartup(cold);
+        StartupSummary warmSummary = summarizeStartup(warm);
+        say("%s  (%zu cold run(s) in fresh processes, %zu warm)\n", first->name, cold.size(), warm.size());
+        say("  %-14s %9s %8s %9s %9s %8s %9s\n", "phase", "cold ms", "faults", "RSS KiB", "warm ms", "faults", "RSS KiB");
+        uint64_t coldTotal = 0, warmTotal = 0;
+        for (uint32_t p = 0; p < STARTUP_PHASE_COUNT; ++p) {
+            if (!coldSummary.ran[p] && !warmSummary.ran[p]) continue;
+            auto columns = [&](const StartupSummary& s, char* out, size_t size) {
+                if (!s.ran[p]) {
+                    snprintf(out, size, "%9s %8s %9s", "-", "-", "-");
+                    return;
+                }
+                snprintf(out, size, "%9.3f %8llu %9lld", s.medianNs[p] / 1e6,
+                         static_cast<unsigned long long>(s.minorFaults[p] + s.majorFaults[p]),
+                         static_cast<long long>(s.residentBytes[p] / 1024));
+            };
+            char coldText[64], warmText[64];
+            columns(coldSummary, coldText, sizeof(coldText));
+            columns(warmSummary, warmText, sizeof(warmText));
+            say("  %-14s %s %s\n", STARTUP_PHASE_LABELS[p], coldText, warmText);
+            coldTotal += coldSummary.medianNs[p];
+            warmTotal += warmSummary.medianNs[p];
+        }
+        say("  %-14s %9.3f %8s %9s %9.3f\n\n", "total", coldTotal / 1e6, "", "", warmTotal / 1e6);
+
+        if (!cold.empty()) result.timings.push_back(TimingStats::fromHistogram("startup.cold", coldSummary.total));
+        if (!warm.empty()) result.timings.push_back(TimingStats::fromHistogram("startup.warm", warmSummary.total));
+        Json details = Json::object();
+        details.set("cold", startupJson(coldSummary, cold.size()))
+               .set("warm", startupJson(warmSummary, warm.size()))
+               .set("stateFile", opts.inputFile ? Json(opts.inputFile) : Json());
+        result.details.set("startup", std::move(details));
     }
 
-    plugin->destroy(plugin);
-    return result;
+    return failures == 0 ? 0 : 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -891,7 +4603,7 @@ static int cmdState(const Options& opts) {
 
 static const char* noteName(int key) {
     static const char* names[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
-    static char buf[8];
+    thread_local char buf[16];  // Also called from the --capture-ring consumer
     int octave = (key / 12) - 1;
     snprintf(buf, sizeof(buf), "%s%d", names[key % 12], octave);
     return buf;
@@ -1005,11 +4717,115 @@ static int cmdNotes(const Options& opts) {
     // Collect output events for MIDI file
     std::vector<MidiEvent> outputMidiEvents;
 
+    // Count, print and collect one output event
+    auto handleOutputEvent = [&](const CapturedEvent& event, uint64_t sampleTime) {
+        double eventTime = sampleTime / static_cast<double>(sampleRate);
+
+        if (event.isNoteOn()) {
+            outputNoteOns++;
+
+            if (opts.verbose) {
+                printf("%-8.3f %-8s %-6s %-5d %-8.2f (output)\n",
+                       eventTime, "note-on", noteName(event.key),
+                       event.channel, event.velocity);
+            }
+
+            // Track velocity changes
+            totalVelocityDiff += event.velocity;
+            velocityCount++;
+
+            // Store for MIDI output
+            MidiEvent midiEvent{};
+            midiEvent.secondTime = eventTime;
+            midiEvent.type = MidiEvent::NoteOn;
+            midiEvent.channel = static_cast<uint8_t>(event.channel);
+            midiEvent.data1 = static_cast<uint8_t>(event.key);
+            midiEvent.data2 = static_cast<uint8_t>(std::clamp(event.velocity * 127.0, 0.0, 127.0));
+            outputMidiEvents.push_back(midiEvent);
+        } else if (event.isNoteOff()) {
+            outputNoteOffs++;
+
+            if (opts.verbose) {
+                printf("%-8.3f %-8s %-6s %-5d %-8s (output)\n",
+                       eventTime, "note-off", noteName(event.key),
+                       event.channel, "");
+            }
+
+            // Store for MIDI output
+            MidiEvent midiEvent{};
+            midiEvent.secondTime = eventTime;
+            midiEvent.type = MidiEvent::NoteOff;
+            midiEvent.channel = static_cast<uint8_t>(event.channel);
+            midiEvent.data1 = static_cast<uint8_t>(event.key);
+            midiEvent.data2 = 64;  // Default release velocity
+            outputMidiEvents.push_back(midiEvent);
+        } else if (event.isNoteExpression()) {
+            outputExpressions++;
+
+            if (opts.verbose) {
+                printf("%-8.3f %-8s %-6s %-5d %-8.2f %s\n",
+                       eventTime, "expr", noteName(event.key),
+                       event.channel, event.expressionValue,
+                       expressionName(event.expressionId));
+            }
+
+            // Convert tuning expression to pitch bend
+            if (event.expressionId == CLAP_NOTE_EXPRESSION_TUNING) {
+                MidiEvent midiEvent{};
+                midiEvent.secondTime = eventTime;
+                midiEvent.type = MidiEvent::PitchBend;
+                midiEvent.channel = static_cast<uint8_t>(event.channel);
+                // Tuning is in semitones, pitch bend range is typically ±2 semitones
+                // Center = 8192, range 0-16383
+                double semitones = event.expressionValue;
+                int pitchBend = static_cast<int>(8192 + (semitones / 2.0) * 8192);
+                pitchBend = std::clamp(pitchBend, 0, 16383);
+                midiEvent.data1 = static_cast<uint8_t>(pitchBend & 0x7F);        // LSB
+                midiEvent.data2 = static_cast<uint8_t>((pitchBend >> 7) & 0x7F); // MSB
+                outputMidiEvents.push_back(midiEvent);
+            }
+        }
+    };
+
+    // With --capture-ring, output events go through a lock-free ring and are
+    // handled on a consumer thread, so process() never waits on the capture
+    std::unique_ptr<RingCaptureOutputEvents> ringEvents;
+    std::atomic<bool> producing{true};
+    std::thread consumer;
+    if (opts.captureRing > 0) {
+        ringEvents = std::make_unique<RingCaptureOutputEvents>(opts.captureRing);
+        process.out_events = ringEvents->get();
+        // An empty ring backs off from a short sleep up to half a block
+        // period, so the consumer does not compete with the audio thread
+        const auto maxBackoff = std::chrono::nanoseconds(500000000ull * opts.bufferSize / sampleRate);
+        consumer = std::thread([&, maxBackoff] {
+            RingCaptureOutputEvents::Entry entry;
+            auto backoff = std::chrono::nanoseconds(50000);
+            for (;;) {
+                if (ringEvents->pop(entry)) {
+                    handleOutputEvent(entry.event, entry.sampleTime);
+                    backoff = std::chrono::nanoseconds(50000);
+                } else if (!producing.load(std::memory_order_acquire)) {
+                    while (ringEvents->pop(entry)) {
+                        handleOutputEvent(entry.event, entry.sampleTime);
+                    }
+                    break;
+                } else {
+                    std::this_thread::sleep_for(backoff);
+                    backoff = std::min(backoff * 2, std::max(maxBackoff, std::chrono::nanoseconds(50000)));
+                }
+            }
+        });
+    }
+
     // Process in time order
     double totalDuration = midi->durationSeconds() + 1.0;  // Add 1s for note-offs
     uint64_t totalSamples = static_cast<uint64_t>(totalDuration * sampleRate);
     uint64_t currentSample = 0;
-    size_t nextEventIdx = 0;
+    size_t blockIndex = 0;
+
+    // Bin every note event into its block up front
+    MidiSchedule schedule(noteEvents, sampleRate, opts.bufferSize);
 
     // Apply parameter settings in first buffer
     bool paramsApplied = false;
@@ -1021,8 +4837,6 @@ static int cmdNotes(const Options& opts) {
     }
 
     while (currentSample < totalSamples) {
-        uint64_t bufferEnd = currentSample + opts.bufferSize;
-
         // Add events for this buffer
         inEvents.clear();
 
@@ -1033,16 +4847,9 @@ static int cmdNotes(const Options& opts) {
             }
             paramsApplied = true;
         }
-        while (nextEventIdx < noteEvents.size()) {
-            const auto& event = noteEvents[nextEventIdx];
-            uint64_t eventSample = static_cast<uint64_t>(event.secondTime * sampleRate);
-
-            if (eventSample >= bufferEnd) break;
-
-            uint32_t offset = 0;
-            if (eventSample > currentSample) {
-                offset = static_cast<uint32_t>(eventSample - currentSample);
-            }
+        for (const auto& scheduled : schedule.block(blockIndex)) {
+            const auto& event = scheduled.midi;
+            uint32_t offset = scheduled.offset;
 
             if (event.isNoteOn()) {
                 inEvents.addNoteOn(offset, 0, event.channel, event.data1,
@@ -1065,88 +4872,33 @@ static int cmdNotes(const Options& opts) {
                            event.channel, "");
                 }
             }
-
-            nextEventIdx++;
         }
 
         // Process
-        outEvents.clear();
+        if (ringEvents) {
+            ringEvents->beginBlock(currentSample);
+        } else {
+            outEvents.clear();
+        }
         plugin->process(plugin, &process);
 
-        // Collect output events
-        for (const auto& event : outEvents.events()) {
-            double eventTime = (currentSample + event.time) / static_cast<double>(sampleRate);
-
-            if (event.isNoteOn()) {
-                outputNoteOns++;
-
-                if (opts.verbose) {
-                    printf("%-8.3f %-8s %-6s %-5d %-8.2f (output)\n",
-                           eventTime, "note-on", noteName(event.key),
-                           event.channel, event.velocity);
-                }
-
-                // Track velocity changes
-                totalVelocityDiff += event.velocity;
-                velocityCount++;
-
-                // Store for MIDI output
-                MidiEvent midiEvent{};
-                midiEvent.secondTime = eventTime;
-                midiEvent.type = MidiEvent::NoteOn;
-                midiEvent.channel = static_cast<uint8_t>(event.channel);
-                midiEvent.data1 = static_cast<uint8_t>(event.key);
-                midiEvent.data2 = static_cast<uint8_t>(std::clamp(event.velocity * 127.0, 0.0, 127.0));
-                outputMidiEvents.push_back(midiEvent);
-            } else if (event.isNoteOff()) {
-                outputNoteOffs++;
-
-                if (opts.verbose) {
-                    printf("%-8.3f %-8s %-6s %-5d %-8s (output)\n",
-                           eventTime, "note-off", noteName(event.key),
-                           event.channel, "");
-                }
-
-                // Store for MIDI output
-                MidiEvent midiEvent{};
-                midiEvent.secondTime = eventTime;
-                midiEvent.type = MidiEvent::NoteOff;
-                midiEvent.channel = static_cast<uint8_t>(event.channel);
-                midiEvent.data1 = static_cast<uint8_t>(event.key);
-                midiEvent.data2 = 64;  // Default release velocity
-                outputMidiEvents.push_back(midiEvent);
-            } else if (event.isNoteExpression()) {
-                outputExpressions++;
-
-                if (opts.verbose) {
-                    printf("%-8.3f %-8s %-6s %-5d %-8.2f %s\n",
-                           eventTime, "expr", noteName(event.key),
-                           event.channel, event.expressionValue,
-                           expressionName(event.expressionId));
-                }
-
-                // Convert tuning expression to pitch bend
-                if (event.expressionId == CLAP_NOTE_EXPRESSION_TUNING) {
-                    MidiEvent midiEvent{};
-                    midiEvent.secondTime = eventTime;
-                    midiEvent.type = MidiEvent::PitchBend;
-                    midiEvent.channel = static_cast<uint8_t>(event.channel);
-                    // Tuning is in semitones, pitch bend range is typically ±2 semitones
-                    // Center = 8192, range 0-16383
-                    double semitones = event.expressionValue;
-                    int pitchBend = static_cast<int>(8192 + (semitones / 2.0) * 8192);
-                    pitchBend = std::clamp(pitchBend, 0, 16383);
-                    midiEvent.data1 = static_cast<uint8_t>(pitchBend & 0x7F);        // LSB
-                    midiEvent.data2 = static_cast<uint8_t>((pitchBend >> 7) & 0x7F); // MSB
-                    outputMidiEvents.push_back(midiEvent);
-                }
+        // Collect output events (the consumer thread does this in ring mode)
+        if (!ringEvents) {
+            for (const auto& event : outEvents.events()) {
+                handleOutputEvent(event, currentSample + event.time);
             }
         }
 
         currentSample += opts.bufferSize;
+        blockIndex++;
         process.steady_time = static_cast<int64_t>(currentSample);
     }
 
+    if (consumer.joinable()) {
+        producing.store(false, std::memory_order_release);
+        consumer.join();
+    }
+
     plugin->stop_processing(plugin);
     plugin->deactivate(plugin);
     plugin->destroy(plugin);
@@ -1157,6 +4909,14 @@ static int cmdNotes(const Options& opts) {
     printf("  Input:  %zu note-on, %zu note-off\n", inputNoteOns, inputNoteOffs);
     printf("  Output: %zu note-on, %zu note-off, %zu expressions\n",
            outputNoteOns, outputNoteOffs, outputExpressions);
+    if (ringEvents && ringEvents->overflowCount() > 0) {
+        printf("  ⚠ %llu output events lost (capture ring of %zu overflowed)\n",
+               static_cast<unsigned long long>(ringEvents->overflowCount()), ringEvents->capacity());
+    }
+    if (inEvents.droppedCount() > 0) {
+        printf("  ⚠ %llu input events dropped (event list full)\n",
+               static_cast<unsigned long long>(inEvents.droppedCount()));
+    }
 
     if (velocityCount > 0) {
         printf("  Note events processed: %zu\n", velocityCount);
@@ -1186,6 +4946,764 @@ static int cmdNotes(const Options& opts) {
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+// Chain command - several plugins through a ProcessGraph, benched or rendered
+//-----------------------------------------------------------------------------
+
+static constexpr uint32_t CHAIN_WARMUP_BLOCKS = 100;  // Same warm-up as the single-plugin bench
+
+// The comma-separated plugin list, loaded and activated with one block size
+static std::unique_ptr<ProcessGraph> loadChain(const Options& opts, uint32_t sampleRate, Report& report) {
+    std::vector<std::string> paths;
+    for (const char* p = opts.pluginPath; *p;) {
+        const char* comma = strchr(p, ',');
+        size_t length = comma ? static_cast<size_t>(comma - p) : strlen(p);
+        if (length > 0) paths.emplace_back(p, length);
+        p += comma ? length + 1 : length;
+    }
+
+    auto graph = ProcessGraph::load(paths);
+    report.check("load", !graph->hasError(), graph->getError());
+    if (graph->hasError()) {
+        fprintf(stderr, "ERROR: %s\n", graph->getError().c_str());
+        return nullptr;
+    }
+
+    bool hugePages = opts.bufferLayout == BufferLayout::ContiguousHugePages;
+    bool active = graph->activate(sampleRate, opts.bufferSize, hugePages);
+    report.check("activate", active, active ? std::string() : graph->getError());
+    if (!active) {
+        fprintf(stderr, "ERROR: %s\n", graph->getError().c_str());
+        return nullptr;
+    }
+    return graph;
+}
+
+static void printChain(const ProcessGraph& graph) {
+    std::string names;
+    for (size_t i = 0; i < graph.nodeCount(); ++i) {
+        if (i > 0) names += " -> ";
+        names += graph.node(i).descriptor->name;
+    }
+    say("Chain: %s (%zu nodes, %u -> %u ch, latency %u frames)\n", names.c_str(), graph.nodeCount(),
+        graph.inputChannels(), graph.outputChannels(), graph.latency());
+}
+
+static int benchChain(const Options& opts, ProcessGraph& graph, Report& report) {
+    uint32_t blocks = opts.blocks > 0 ? opts.blocks : 10000;
+    report.host.blocks = blocks;
+
+    // The host writes the input every block; after the first node it is the other nodes' scratch space
+    constexpr float PI = 3.14159265358979323846f;
+    std::vector<float> sine(opts.bufferSize);
+    for (uint32_t f = 0; f < opts.bufferSize; ++f) {
+        sine[f] = 0.5f * std::sin(2.0f * PI * 440.0f * static_cast<float>(f) / static_cast<float>(opts.sampleRate));
+    }
+    auto fillInput = [&] {
+        for (uint32_t c = 0; c < graph.inputChannels(); ++c) {
+            memcpy(graph.input(c), sine.data(), sine.size() * sizeof(float));
+        }
+    };
+
+    BlockStats stats(opts.bufferSize, opts.sampleRate);
+    uint64_t wallNs = 0;
+    {
+        TestHost::AudioThreadScope audio;
+        bool started = graph.startProcessing();
+        report.check("start", started, started ? std::string() : graph.getError());
+        if (!started) {
+            fprintf(stderr, "ERROR: %s\n", graph.getError().c_str());
+            return 1;
+        }
+        for (uint32_t b = 0; b < CHAIN_WARMUP_BLOCKS; ++b) {
+            fillInput();
+            graph.process(opts.bufferSize);
+        }
+        graph.resetStats();
+
+        for (uint32_t b = 0; b < blocks; ++b) {
+            fillInput();
+            auto start = std::chrono::steady_clock::now();
+            graph.process(opts.bufferSize);
+            uint64_t ns = elapsedNs(start, std::chrono::steady_clock::now());
+            stats.record(ns);
+            wallNs += ns;
+        }
+        graph.stopProcessing();
+    }
+
+    double audioSeconds = static_cast<double>(blocks) * opts.bufferSize / opts.sampleRate;
+    double realtime = wallNs > 0 ? audioSeconds / (wallNs / 1e9) : 0.0;
+    double chainMeanNs = stats.histogram.mean();
+    say("%-40s %8.1fx realtime  %6.1f µs/block  (%u blocks)\n", "Whole chain", realtime, chainMeanNs / 1000.0,
+        blocks);
+    printBlockStats(stats);
+
+    // Per node: time inside its process(), and its share of the chain
+    double nodesNs = 0.0;
+    for (size_t i = 0; i < graph.nodeCount(); ++i) {
+        const auto& node = graph.node(i);
+        const auto& h = node.histogram;
+        nodesNs += h.mean();
+        say("  %zu. %-35s %6.1f µs/block  %5.1f%%  p99 %.1f  max %.1f µs\n", i + 1, node.descriptor->name,
+            h.mean() / 1000.0, chainMeanNs > 0 ? 100.0 * h.mean() / chainMeanNs : 0.0,
+            h.valueAtPercentile(99.0) / 1000.0, h.max() / 1000.0);
+
+        PluginResult& result = report.plugin(std::to_string(i + 1) + ":" + node.descriptor->id);
+        result.name = node.descriptor->name ? node.descriptor->name : "";
+        result.vendor = node.descriptor->vendor ? node.descriptor->vendor : "";
+        result.version = node.descriptor->version ? node.descriptor->version : "";
+        TimingStats timing = TimingStats::fromHistogram("float32", h);
+        timing.realtime = h.mean() > 0 ? static_cast<double>(opts.bufferSize) / opts.sampleRate / (h.mean() / 1e9) : 0.0;
+        result.timings.push_back(std::move(timing));
+        result.details.set("path", node.path)
+                      .set("inputChannels", node.inputChannels)
+                      .set("outputChannels", node.outputChannels)
+                      .set("latency", node.latency)
+                      .set("share", chainMeanNs > 0 ? h.mean() / chainMeanNs : 0.0);
+    }
+    double overheadNs = std::max(0.0, chainMeanNs - nodesNs);
+    say("  Between nodes %.2f µs/block (%.1f%%)\n", overheadNs / 1000.0,
+        chainMeanNs > 0 ? 100.0 * overheadNs / chainMeanNs : 0.0);
+
+    report.details.set("chain", toJson(timingStats("chain", stats, realtime)))
+                  .set("overheadNs", overheadNs)
+                  .set("latency", graph.latency());
+    return 0;
+}
+
+// Like process: -i (or silence) through the whole chain into -o
+static int renderChain(const Options& opts, Report& report) {
+    std::unique_ptr<WavReadAhead> input;
+    uint32_t sampleRate = opts.sampleRate;
+    if (opts.inputFile) {
+        auto reader = openInput(opts, opts.inputFile);
+        if (reader->hasError()) {
+            fprintf(stderr, "ERROR: %s\n", reader->getError().c_str());
+            return 1;
+        }
+        printInput(opts.inputFile, *reader);
+        input = std::make_unique<WavReadAhead>(std::move(reader));
+        sampleRate = input->sampleRate();
+    }
+
+    auto graph = loadChain(opts, sampleRate, report);
+    if (!graph) return 1;
+    printChain(*graph);
+
+    uint64_t outputFrames;
+    if (input) {
+        outputFrames = input->frameCount();
+    } else {
+        uint32_t blocks = opts.blocks > 0 ? opts.blocks : (sampleRate / opts.bufferSize);
+        outputFrames = static_cast<uint64_t>(blocks) * opts.bufferSize;
+    }
+    uint64_t tail = std::min<uint64_t>(graph->tail(), static_cast<uint64_t>(MAX_TAIL_SECONDS) * sampleRate);
+    uint64_t skipFrames = opts.trimLatency ? graph->latency() : 0;
+    uint64_t renderFrames = outputFrames + skipFrames + (opts.renderTail ? tail : 0);
+
+    uint32_t outputChannels = graph->outputChannels();
+    WavFormat wavFmt = opts.outputFloat ? WavFormat::Float32 : WavFormat::Int16;
+    auto writer = WavWriter::open(opts.outputFile, sampleRate, outputChannels, wavFmt);
+    if (writer->hasError()) {
+        fprintf(stderr, "ERROR: %s\n", writer->getError().c_str());
+        return 1;
+    }
+    WavWriteBehind output(std::move(writer), outputChannels);
+
+    {
+        TestHost::AudioThreadScope audio;
+        if (!graph->startProcessing()) {
+            fprintf(stderr, "ERROR: %s\n", graph->getError().c_str());
+            return 1;
+        }
+    }
+
+    uint32_t fileChannels = input ? input->channels() : 0;
+    std::vector<float> inputBlock(static_cast<size_t>(opts.bufferSize) * std::max(1u, fileChannels));
+    std::vector<float> outputBlock(static_cast<size_t>(opts.bufferSize) * outputChannels);
+
+    // Past the end of the input (latency and tail) the input is silent
+    uint64_t framesProcessed = 0;
+    bool writeOk = true;
+    while (framesProcessed < renderFrames && writeOk) {
+        uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(opts.bufferSize, renderFrames - framesProcessed));
+        uint32_t framesRead = 0;
+        if (input && framesProcessed < outputFrames) framesRead = input->read(inputBlock.data(), frames);
+        for (uint32_t c = 0; c < graph->inputChannels(); ++c) {
+            float* channel = graph->input(c);
+            for (uint32_t f = 0; f < frames; ++f) {
+                channel[f] = c < fileChannels && f < framesRead ? inputBlock[f * fileChannels + c] : 0.0f;
+            }
+        }
+
+        {
+            TestHost::AudioThreadScope audio;
+            graph->process(frames);
+        }
+
+        uint32_t skip = static_cast<uint32_t>(
+            std::min<uint64_t>(frames, skipFrames - std::min(skipFrames, framesProcessed)));
+        for (uint32_t c = 0; c < outputChannels; ++c) {
+            const float* channel = graph->output(c);
+            for (uint32_t f = skip; f < frames; ++f) outputBlock[(f - skip) * outputChannels + c] = channel[f];
+        }
+        if (skip < frames) writeOk = output.write(outputBlock.data(), frames - skip);
+        framesProcessed += frames;
+
+        // Main-thread callbacks the plugins asked for, between blocks
+        graph->pumpMainThread();
+    }
+
+    {
+        TestHost::AudioThreadScope audio;
+        graph->stopProcessing();
+    }
+    bool written = output.close();
+    if (input && input->hasError()) {
+        fprintf(stderr, "ERROR: Failed to read input file: %s\n", input->getError().c_str());
+        return 1;
+    }
+    if (!written) {
+        fprintf(stderr, "ERROR: Failed to write output file: %s\n", output.getError().c_str());
+        return 1;
+    }
+
+    printf("Output: %s (%u Hz, %u ch, %llu frames, %s)\n", opts.outputFile, sampleRate, outputChannels,
+           static_cast<unsigned long long>(output.framesQueued()), opts.outputFloat ? "float32" : "int16");
+    for (size_t i = 0; i < graph->nodeCount(); ++i) {
+        const auto& node = graph->node(i);
+        printf("  %zu. %-35s %6.1f µs/block\n", i + 1, node.descriptor->name, node.histogram.mean() / 1000.0);
+    }
+    return 0;
+}
+
+static int cmdChain(const Options& opts, Report& report) {
+    if (opts.outputFile) {
+        if (!textOutput) {
+            fprintf(stderr, "ERROR: --format is not supported when chain renders to a file\n");
+            return 1;
+        }
+        return renderChain(opts, report);
+    }
+    if (opts.inputFile) {
+        fprintf(stderr, "ERROR: chain needs --output (-o) to render an input file\n");
+        return 1;
+    }
+
+    auto graph = loadChain(opts, opts.sampleRate, report);
+    if (!graph) return 1;
+    printChain(*graph);
+    if (opts.bufferLayout != BufferLayout::Separate) {
+        say("Buffers: %s\n", graph->hugePageBacked() ? "huge pages" : "normal pages");
+    }
+    return benchChain(opts, *graph, report);
+}
+
+//-----------------------------------------------------------------------------
+// Batch command - validate (and bench) many plugins in worker processes
+//-----------------------------------------------------------------------------
+
+static bool isPluginPath(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".clap" || ext == ".wclap" || ext == ".wasm";
+}
+
+// A directory is searched recursively for plugins; any other file is a
+// manifest with one plugin path per line ('#' starts a comment)
+static bool collectBatchPlugins(const char* source, std::vector<std::string>& plugins) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    if (fs::is_directory(source, ec)) {
+        auto options = fs::directory_options::skip_permission_denied;
+        for (auto it = fs::recursive_directory_iterator(source, options, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (!isPluginPath(it->path())) continue;
+            plugins.push_back(it->path().string());
+            // macOS bundles are directories; don't look inside them
+            if (it->is_directory(ec)) it.disable_recursion_pending();
+        }
+    } else {
+        std::ifstream manifest(source);
+        if (!manifest) {
+            fprintf(stderr, "ERROR: Cannot open plugin directory or manifest: %s\n", source);
+            return false;
+        }
+        fs::path base = fs::path(source).parent_path();
+        std::string line;
+        while (std::getline(manifest, line)) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos) continue;
+            size_t last = line.find_last_not_of(" \t\r");
+            fs::path path = line.substr(first, last - first + 1);
+            plugins.push_back((path.is_relative() ? base / path : path).string());
+        }
+    }
+
+    if (ec) {
+        fprintf(stderr, "ERROR: Cannot scan %s: %s\n", source, ec.message().c_str());
+        return false;
+    }
+    std::sort(plugins.begin(), plugins.end());
+    return true;
+}
+
+#ifndef _WIN32
+
+enum class JobStatus { Passed, Failed, Crashed, TimedOut };
+
+struct BatchJob {
+    std::string path;
+    pid_t pid = -1;
+    int outFd = -1;
+    std::string output;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0.0;
+    JobStatus status = JobStatus::Passed;
+    int detail = 0;  // Exit code or signal number
+};
+
+static constexpr size_t MAX_JOB_OUTPUT = 1 << 20;
+
+// Forked worker: gets the plugin path and the write end of its pipe
+using BatchWorker = void (*)(const Options& opts, const std::string& path, int outFd);
+
+// Setup shared by every worker: its own process group, no core dumps and
+// the --memory-limit address space limit
+static void prepareWorkerProcess(const Options& opts) {
+    setpgid(0, 0);  // Lets the parent kill anything the plugin spawns
+
+    struct rlimit noCore = {0, 0};
+    setrlimit(RLIMIT_CORE, &noCore);
+    if (opts.memoryLimitMb > 0) {
+        rlim_t bytes = static_cast<rlim_t>(opts.memoryLimitMb) * 1024 * 1024;
+        struct rlimit memory = {bytes, bytes};
+        setrlimit(RLIMIT_AS, &memory);
+    }
+}
+
+// Runs in the forked worker: the normal validate/bench commands, with
+// stdout and stderr going to the parent through a pipe. With --format the
+// worker writes a JSON report instead, and stderr stays on the terminal.
+[[noreturn]] static void runBatchWorker(const Options& opts, const std::string& path, int outFd) {
+    dup2(outFd, STDOUT_FILENO);
+    if (opts.format == OutputFormat::Text) dup2(outFd, STDERR_FILENO);
+    close(outFd);
+    setvbuf(stdout, nullptr, _IOLBF, 0);  // Keep output up to a crash
+    prepareWorkerProcess(opts);
+
+    Options jobOpts = opts;
+    jobOpts.pluginPath = path.c_str();
+    jobOpts.format = opts.format == OutputFormat::Text ? OutputFormat::Text : OutputFormat::Json;
+
+    Report report = makeReport(jobOpts);
+    report.command = opts.bench ? "validate+bench" : "validate";
+    int rc = cmdValidate(jobOpts, report);
+    if (rc == 0 && opts.bench) {
+        say("\n");
+        rc = cmdBench(jobOpts, report);
+    }
+    if (jobOpts.format != OutputFormat::Text) writeReport(jobOpts, report);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(rc);
+}
+
+// Runs in the forked scan worker: probes the file like info and writes the
+// JSON report to the pipe. Whatever the plugin prints goes to /dev/null
+// (or stderr with --verbose), so it can't corrupt the report.
+[[noreturn]] static void runScanWorker(const Options& opts, const std::string& path, int outFd) {
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(opts.verbose ? STDERR_FILENO : devNull, STDOUT_FILENO);
+    if (!opts.verbose) dup2(devNull, STDERR_FILENO);
+    if (devNull >= 0) close(devNull);
+    prepareWorkerProcess(opts);
+
+    Options jobOpts = opts;
+    jobOpts.pluginPath = path.c_str();
+    jobOpts.cached = false;
+    textOutput = false;
+
+    Report report = makeReport(jobOpts);
+    report.command = "info";
+    int rc = probePluginFile(jobOpts, report);
+    std::string out = toJson(report).dump(-1);
+    for (size_t written = 0; written < out.size();) {
+        ssize_t n = write(outFd, out.data() + written, out.size() - written);
+        if (n <= 0) break;
+        written += static_cast<size_t>(n);
+    }
+    _exit(rc);
+}
+
+static bool startBatchJob(const Options& opts, BatchJob& job, BatchWorker worker) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        worker(opts, job.path, fds[1]);
+        _exit(127);  // Workers exit themselves
+    }
+
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    setpgid(pid, pid);  // Also set here so there is no race with the child
+    job.pid = pid;
+    job.outFd = fds[0];
+    job.start = std::chrono::steady_clock::now();
+    return true;
+}
+
+// Read whatever the worker has written so far (the pipe is non-blocking)
+static void drainJobOutput(BatchJob& job) {
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(job.outFd, buf, sizeof(buf))) > 0) {
+        if (job.output.size() < MAX_JOB_OUTPUT) job.output.append(buf, static_cast<size_t>(n));
+    }
+    if (n == 0) {
+        close(job.outFd);
+        job.outFd = -1;
+    }
+}
+
+static void finishBatchJob(BatchJob& job, int waitStatus) {
+    job.seconds = elapsedNs(job.start, std::chrono::steady_clock::now()) / 1e9;
+    job.pid = -1;
+    if (job.outFd >= 0) {
+        drainJobOutput(job);
+        if (job.outFd >= 0) close(job.outFd);
+        job.outFd = -1;
+    }
+    if (job.status == JobStatus::TimedOut) return;
+    if (WIFSIGNALED(waitStatus)) {
+        job.status = JobStatus::Crashed;
+        job.detail = WTERMSIG(waitStatus);
+    } else {
+        job.detail = WEXITSTATUS(waitStatus);
+        job.status = job.detail == 0 ? JobStatus::Passed : JobStatus::Failed;
+    }
+}
+
+static void printBatchResult(const Options& opts, const BatchJob& job, size_t done, size_t total) {
+    static const char* statusNames[] = {"PASS", "FAIL", "CRASH", "TIMEOUT"};
+    say("[%*zu/%zu] %-7s %7.2fs  %s\n", static_cast<int>(std::to_string(total).size()),
+        done, total, statusNames[static_cast<int>(job.status)], job.seconds, job.path.c_str());
+    if (job.status == JobStatus::Crashed) {
+        say("    Killed by signal %d (%s)\n", job.detail, strsignal(job.detail));
+    }
+
+    // Passing validate output is noise; bench output is the result
+    bool showOutput = opts.verbose || opts.bench || job.status != JobStatus::Passed;
+    if (!showOutput || job.output.empty()) return;
+    size_t pos = 0;
+    while (pos < job.output.size()) {
+        size_t end = job.output.find('\n', pos);
+        if (end == std::string::npos) end = job.output.size();
+        if (end > pos) {
+            say("    %.*s\n", static_cast<int>(end - pos), job.output.c_str() + pos);
+        } else {
+            say("\n");
+        }
+        pos = end + 1;
+    }
+}
+
+// Run every job on up to `workers` worker processes at once, calling
+// finished(job, done) as each one completes
+static void runBatchJobs(const Options& opts, std::vector<BatchJob>& jobs, size_t workers, BatchWorker worker,
+                         const std::function<void(BatchJob&, size_t)>& finished) {
+    std::vector<size_t> running;
+    size_t next = 0;
+    size_t done = 0;
+    auto timeout = std::chrono::seconds(opts.timeoutSeconds);
+
+    while (done < jobs.size()) {
+        // Keep every worker slot busy
+        while (running.size() < workers && next < jobs.size()) {
+            BatchJob& job = jobs[next];
+            if (startBatchJob(opts, job, worker)) {
+                running.push_back(next);
+            } else {
+                job.status = JobStatus::Failed;
+                job.detail = -1;
+                job.output = std::string("Could not start worker: ") + strerror(errno);
+                finished(job, ++done);
+            }
+            next++;
+        }
+        if (running.empty()) continue;
+
+        // Collect output until something exits or the poll interval ends
+        std::vector<pollfd> fds;
+        for (size_t idx : running) {
+            if (jobs[idx].outFd >= 0) fds.push_back({jobs[idx].outFd, POLLIN, 0});
+        }
+        poll(fds.data(), static_cast<nfds_t>(fds.size()), 100);
+        for (size_t idx : running) {
+            BatchJob& job = jobs[idx];
+            for (const auto& pfd : fds) {
+                if (pfd.fd == job.outFd && (pfd.revents & (POLLIN | POLLHUP))) {
+                    drainJobOutput(job);
+                }
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = running.begin(); it != running.end();) {
+            BatchJob& job = jobs[*it];
+            int waitStatus = 0;
+            pid_t result = waitpid(job.pid, &waitStatus, WNOHANG);
+            if (result == 0 && opts.timeoutSeconds > 0 && now - job.start > timeout) {
+                kill(-job.pid, SIGKILL);
+                job.status = JobStatus::TimedOut;
+                result = waitpid(job.pid, &waitStatus, 0);
+            }
+            if (result == 0) {
+                ++it;
+                continue;
+            }
+            kill(-job.pid, SIGKILL);  // Reap any stragglers the plugin left behind
+            finishBatchJob(job, waitStatus);
+            finished(job, ++done);
+            it = running.erase(it);
+        }
+    }
+}
+
+static size_t batchWorkerCount(const Options& opts, size_t jobCount) {
+    size_t workers = opts.jobs > 0 ? opts.jobs : std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(workers, jobCount));
+}
+
+static int cmdBatch(const Options& opts, Report& report) {
+    std::vector<std::string> plugins;
+    if (!collectBatchPlugins(opts.pluginPath, plugins)) return 1;
+    if (plugins.empty()) {
+        fprintf(stderr, "ERROR: No plugins found in %s\n", opts.pluginPath);
+        return 1;
+    }
+
+    size_t workers = batchWorkerCount(opts, plugins.size());
+    say("Batch: %zu plugin(s), %zu worker(s)", plugins.size(), workers);
+    if (opts.timeoutSeconds > 0) say(", %u s timeout", opts.timeoutSeconds);
+    say("\n\n");
+
+    std::vector<BatchJob> jobs(plugins.size());
+    for (size_t i = 0; i < plugins.size(); ++i) jobs[i].path = plugins[i];
+
+    auto batchStart = std::chrono::steady_clock::now();
+    runBatchJobs(opts, jobs, workers, runBatchWorker, [&](BatchJob& job, size_t done) {
+        printBatchResult(opts, job, done, jobs.size());
+    });
+
+    double wallSeconds = elapsedNs(batchStart, std::chrono::steady_clock::now()) / 1e9;
+    double jobSeconds = 0.0;
+    size_t counts[4] = {};
+    for (const auto& job : jobs) {
+        counts[static_cast<int>(job.status)]++;
+        jobSeconds += job.seconds;
+    }
+
+    say("\nSummary: %zu passed, %zu failed, %zu crashed, %zu timed out\n",
+        counts[0], counts[1], counts[2], counts[3]);
+    say("  Wall time %.2fs, %.2fs of plugin time (%.1fx parallel)\n",
+        wallSeconds, jobSeconds, wallSeconds > 0 ? jobSeconds / wallSeconds : 0.0);
+
+    static const char* statusNames[] = {"pass", "fail", "crash", "timeout"};
+    Json jobResults = Json::array();
+    for (const auto& job : jobs) {
+        Json entry = Json::object();
+        entry.set("name", job.path)
+             .set("status", statusNames[static_cast<int>(job.status)])
+             .set("seconds", job.seconds);
+        if (job.status == JobStatus::Crashed) entry.set("signal", job.detail);
+        if (job.status == JobStatus::Failed) entry.set("exitCode", job.detail);
+
+        // Workers that exited normally wrote a JSON report
+        std::string error;
+        Json jobReport = Json::parse(job.output, &error);
+        if (error.empty()) {
+            entry.set("report", std::move(jobReport));
+        } else if (!job.output.empty()) {
+            entry.set("output", job.output);
+        }
+        jobResults.push(std::move(entry));
+    }
+    report.check("jobs", counts[0] == jobs.size(),
+                 std::to_string(counts[0]) + " of " + std::to_string(jobs.size()) + " passed");
+    report.details.set("wallSeconds", wallSeconds)
+                  .set("jobSeconds", jobSeconds)
+                  .set("jobs", std::move(jobResults));
+
+    return counts[0] == jobs.size() ? 0 : 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// Scan command - refresh the scan cache from worker processes
+//-----------------------------------------------------------------------------
+
+// Cache entry for a finished scan worker; false if it should not be cached
+static bool scanJobEntry(const BatchJob& job, const FileSignature& signature, ScanEntry& entry) {
+    if (job.status == JobStatus::TimedOut) return false;  // Might work on a less busy machine
+    if (job.status == JobStatus::Crashed) {
+        entry = ScanEntry();
+        entry.path = job.path;
+        entry.signature = signature;
+        entry.error = "crashed (" + std::string(strsignal(job.detail)) + ")";
+        return true;
+    }
+    std::string error;
+    Json report = Json::parse(job.output, &error);
+    if (!error.empty()) return false;  // No report; the worker never got going
+    entry = scanEntry(job.path, signature, report);
+    return true;
+}
+
+static int cmdScan(const Options& opts, Report& report) {
+    std::vector<std::string> plugins;
+    if (!collectBatchPlugins(opts.pluginPath, plugins)) return 1;
+
+    std::string cachePath = scanCachePath(opts);
+    auto cache = ScanCache::open(cachePath);
+    if (cache->hasError()) fprintf(stderr, "WARNING: %s\n", cache->getError().c_str());
+
+    // Forget files that are gone, but only from this source: a directory's
+    // entries are the ones under it, a manifest's the files it lists
+    std::error_code ec;
+    std::string root = std::filesystem::is_directory(opts.pluginPath, ec)
+        ? ScanCache::normalize(opts.pluginPath) : std::string();
+    if (!root.empty() && root.back() != '/') root += '/';
+    std::set<std::string> listed;
+    for (const auto& plugin : plugins) listed.insert(ScanCache::normalize(plugin));
+    std::vector<std::string> removed;
+    for (const auto& [path, entry] : cache->entries()) {
+        bool inSource = root.empty() ? listed.count(path) > 0 : path.compare(0, root.size(), root) == 0;
+        if (inSource && !fileSignature(path).exists) removed.push_back(path);
+    }
+    for (const auto& path : removed) cache->remove(path);
+
+    // Only new and changed files are probed
+    std::vector<FileSignature> signatures(plugins.size());
+    std::vector<BatchJob> jobs;
+    std::vector<size_t> jobFiles;  // Index into plugins for each job
+    for (size_t i = 0; i < plugins.size(); ++i) {
+        signatures[i] = fileSignature(plugins[i], opts.hashFiles);
+        const ScanEntry* entry = cache->lookup(plugins[i], signatures[i]);
+        if (!entry) {
+            jobs.emplace_back().path = plugins[i];
+            jobFiles.push_back(i);
+        } else if (entry->signature.mtimeNs != signatures[i].mtimeNs) {
+            // Same contents by hash; remember the new time
+            ScanEntry updated = *entry;
+            updated.signature = signatures[i];
+            cache->put(std::move(updated));
+        }
+    }
+
+    size_t workers = batchWorkerCount(opts, jobs.size());
+    say("Scan: %zu plugin file(s), %zu unchanged, %zu to probe", plugins.size(), plugins.size() - jobs.size(),
+        jobs.size());
+    if (!jobs.empty()) say(" with %zu worker(s)", workers);
+    say("\nCache: %s\n\n", cachePath.c_str());
+
+    auto scanStart = std::chrono::steady_clock::now();
+    runBatchJobs(opts, jobs, workers, runScanWorker, [&](BatchJob& job, size_t done) {
+        ScanEntry entry;
+        const FileSignature& signature = signatures[jobFiles[static_cast<size_t>(&job - jobs.data())]];
+        bool cacheable = scanJobEntry(job, signature, entry);
+        if (cacheable) cache->put(entry);
+
+        const char* status = "OK";
+        if (job.status == JobStatus::TimedOut) {
+            status = "TIMEOUT";
+        } else if (job.status == JobStatus::Crashed) {
+            status = "CRASH";
+        } else if (!cacheable || !entry.ok) {
+            status = "FAIL";
+        }
+        say("[%*zu/%zu] %-7s %7.2fs  %s", static_cast<int>(std::to_string(jobs.size()).size()), done, jobs.size(),
+            status, job.seconds, job.path.c_str());
+        if (cacheable && entry.ok) say("  (%zu plugin(s))", entry.plugins.size());
+        say("\n");
+        if (cacheable && !entry.error.empty()) say("    %s\n", entry.error.c_str());
+    });
+    double wallSeconds = elapsedNs(scanStart, std::chrono::steady_clock::now()) / 1e9;
+
+    bool saved = cache->save();
+    if (!saved) fprintf(stderr, "ERROR: %s\n", cache->getError().c_str());
+
+    // Every file in the source, whether it was probed or already cached
+    size_t ok = 0;
+    size_t pluginCount = 0;
+    Json files = Json::array();
+    for (size_t i = 0; i < plugins.size(); ++i) {
+        const ScanEntry* entry = cache->lookup(plugins[i], signatures[i]);
+        bool probed = std::find(jobFiles.begin(), jobFiles.end(), i) != jobFiles.end();
+        Json file = Json::object();
+        file.set("name", plugins[i]).set("probed", probed);
+        if (!entry) {
+            file.set("ok", false).set("error", "not scanned (timed out or no report)");
+        } else {
+            file.set("ok", entry->ok);
+            if (!entry->error.empty()) file.set("error", entry->error);
+            file.set("plugins", entry->plugins);
+            if (entry->ok) {
+                ok++;
+                pluginCount += entry->plugins.size();
+            }
+        }
+        if (!probed && opts.verbose) {
+            say("  cached  %s%s\n", plugins[i].c_str(), entry && !entry->ok ? "  (failed)" : "");
+        }
+        files.push(std::move(file));
+    }
+
+    say("%sSummary: %zu of %zu file(s) scanned OK, %zu plugin(s); probed %zu in %.2fs",
+        jobs.empty() ? "" : "\n", ok, plugins.size(), pluginCount, jobs.size(), wallSeconds);
+    if (!removed.empty()) say("; removed %zu stale entr%s", removed.size(), removed.size() == 1 ? "y" : "ies");
+    say("\n");
+
+    report.check("cache", saved, saved ? "" : cache->getError());
+    report.check("files", ok == plugins.size(),
+                 std::to_string(ok) + " of " + std::to_string(plugins.size()) + " scanned OK");
+    report.details.set("cacheFile", cachePath)
+                  .set("probed", jobs.size())
+                  .set("removed", removed.size())
+                  .set("wallSeconds", wallSeconds)
+                  .set("files", std::move(files));
+    return report.passed() ? 0 : 1;
+}
+#else
+
+static int cmdBatch(const Options&, Report&) {
+    fprintf(stderr, "ERROR: batch is not supported on Windows yet\n");
+    return 1;
+}
+
+static int cmdScan(const Options&, Report&) {
+    fprintf(stderr, "ERROR: scan is not supported on Windows yet (info --cached works)\n");
+    return 1;
+}
+
+#endif
+
 //-----------------------------------------------------------------------------
 // Main
 //-----------------------------------------------------------------------------
@@ -1198,13 +5716,40 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Commands that fill in a Report can print it instead of text
+    textOutput = opts.format == OutputFormat::Text;
+    int (*reportCommand)(const Options&, Report&) = nullptr;
     if (strcmp(opts.command, "info") == 0) {
-        return cmdInfo(opts);
+        reportCommand = cmdInfo;
     } else if (strcmp(opts.command, "validate") == 0) {
-        return cmdValidate(opts);
+        reportCommand = cmdValidate;
     } else if (strcmp(opts.command, "bench") == 0) {
-        return cmdBench(opts);
-    } else if (strcmp(opts.command, "process") == 0) {
+        reportCommand = cmdBench;
+    } else if (strcmp(opts.command, "realtime") == 0) {
+        reportCommand = cmdRealtime;
+    } else if (strcmp(opts.command, "startup") == 0) {
+        reportCommand = cmdStartup;
+    } else if (strcmp(opts.command, "batch") == 0) {
+        reportCommand = cmdBatch;
+    } else if (strcmp(opts.command, "scan") == 0) {
+        reportCommand = cmdScan;
+    } else if (strcmp(opts.command, "chain") == 0) {
+        reportCommand = cmdChain;
+    }
+
+    if (reportCommand) {
+        Report report = makeReport(opts);
+        int result = reportCommand(opts, report);
+        if (!textOutput) writeReport(opts, report);
+        return result;
+    }
+
+    if (!textOutput) {
+        fprintf(stderr, "ERROR: --format is only supported by info, validate, bench, realtime, startup, batch, scan and chain\n");
+        return 1;
+    }
+
+    if (strcmp(opts.command, "process") == 0) {
         return cmdProcess(opts);
     } else if (strcmp(opts.command, "state") == 0) {
         return cmdState(opts);
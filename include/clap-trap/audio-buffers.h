@@ -8,19 +8,138 @@
 
 #include <clap/clap.h>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace clap_trap {
 
+/**
+ * How buffer classes allocate their channel storage.
+ */
+enum class BufferLayout {
+    Separate,            ///< One heap allocation per channel (default)
+    Contiguous,          ///< All channels in one 64-byte aligned slab with padded strides
+    ContiguousHugePages  ///< Contiguous, backed by huge pages where the OS allows it
+};
+
+/**
+ * A single zeroed, cache-line aligned allocation.
+ *
+ * With hugePages set, explicit huge pages are tried first (MAP_HUGETLB on
+ * Linux, large pages on Windows). If those are unavailable, Linux falls
+ * back to a 2 MB aligned block advised for transparent huge pages, and
+ * other platforms use normal pages.
+ */
+class AlignedSlab {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    AlignedSlab() = default;
+    ~AlignedSlab();
+
+    AlignedSlab(const AlignedSlab&) = delete;
+    AlignedSlab& operator=(const AlignedSlab&) = delete;
+
+    /// Release any previous allocation and allocate `bytes` zeroed bytes
+    bool allocate(size_t bytes, bool hugePages);
+
+    /// Free the allocation
+    void release();
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    /// True if the slab is backed by explicit huge pages
+    bool hugePageBacked() const { return kind_ == Kind::HugePages; }
+
+private:
+    enum class Kind { None, Heap, HugePages };
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    size_t mappedSize_ = 0;
+    Kind kind_ = Kind::None;
+};
+
+/**
+ * Samples between the starts of neighbouring channels in a contiguous slab.
+ *
+ * Rounded up to a whole number of cache lines, plus one extra line when the
+ * stride would be a multiple of 4 KB so channels do not alias in the cache.
+ */
+size_t paddedChannelStride(uint32_t blockSize, size_t sampleSize = sizeof(float));
+
+/**
+ * Summary of a set of audio channels, gathered in a single pass.
+ *
+ * NaN and Inf samples are counted but left out of peak, rms and dc, so one
+ * bad sample does not hide the level of the rest of the block.
+ */
+struct BufferStats {
+    float peak = 0.0f;          ///< Largest absolute non-NaN sample (Inf if any)
+    double rms = 0.0;           ///< RMS of the finite samples
+    double dc = 0.0;            ///< Mean of the finite samples
+    uint64_t nanCount = 0;
+    uint64_t infCount = 0;
+    uint64_t denormalCount = 0; ///< Non-zero samples below FLT_MIN (DBL_MIN for double)
+    uint64_t sampleCount = 0;
+    bool hasNonZero = false;    ///< Any sample != 0 (NaN counts as non-zero)
+
+    /// True when there are no NaN or Inf samples
+    bool isValid() const { return nanCount == 0 && infCount == 0; }
+};
+
+/**
+ * Analyze `frames` samples in each of `channelCount` channels.
+ *
+ * The float version uses AVX2, SSE2 or NEON when available (picked at
+ * runtime).
+ */
+BufferStats analyzeSamples(const float* const* channels, uint32_t channelCount, uint32_t frames);
+BufferStats analyzeSamples(const double* const* channels, uint32_t channelCount, uint32_t frames);
+
+/**
+ * Sample precision for process() buffers.
+ */
+enum class SamplePrecision {
+    Auto,     ///< Whatever the plugin prefers (data64 only if a port prefers it)
+    Float32,  ///< data32
+    Float64   ///< data64
+};
+
+/**
+ * What a plugin's audio ports say about 64-bit processing.
+ */
+struct PrecisionSupport {
+    bool supports64 = false;  ///< Every port has CLAP_AUDIO_PORT_SUPPORTS_64BITS
+    bool prefers64 = false;   ///< Some port has CLAP_AUDIO_PORT_PREFERS_64BITS
+};
+
+/// Read the audio port flags of an initialized plugin
+PrecisionSupport queryPrecisionSupport(const clap_plugin_t* plugin);
+
+/**
+ * Pick the precision to process with.
+ *
+ * 64-bit is used when every port supports it and it is either requested, or
+ * the request is Auto and a port prefers it. An explicit Float32 is always
+ * honoured; anything else falls back to 32-bit.
+ */
+SamplePrecision negotiatePrecision(const PrecisionSupport& support, SamplePrecision requested);
+
 /**
  * Manages stereo audio buffers for testing.
+ *
+ * T is float (data32) or double (data64).
  */
-class StereoAudioBuffers {
+template<typename T>
+class BasicStereoAudioBuffers {
 public:
+    using Sample = T;
     static constexpr uint32_t NUM_CHANNELS = 2;
 
-    explicit StereoAudioBuffers(uint32_t blockSize);
+    explicit BasicStereoAudioBuffers(uint32_t blockSize, BufferLayout layout = BufferLayout::Separate);
 
     /// Get CLAP input buffer
     clap_audio_buffer_t* inputBuffer() { return &inputBuffer_; }
@@ -28,41 +147,54 @@ public:
     /// Get CLAP output buffer
     clap_audio_buffer_t* outputBuffer() { return &outputBuffer_; }
 
-    /// Fill input with a sine wave
+    /// Fill input with a sine wave (clears the input constant_mask)
     void fillInputWithSine(float frequency, float sampleRate, float amplitude = 0.5f);
 
+    /// Fill every input channel with `value` and flag them all in constant_mask
+    void fillInputWithConstant(T value);
+
     /// Fill input with silence
     void clearInput();
 
     /// Clear output buffer
     void clearOutput();
 
+    /// Peak, RMS, DC and NaN/Inf/denormal counts of the output in one pass
+    BufferStats analyzeOutput() const;
+
     /// Check if output contains non-zero samples
-    bool outputHasNonZero() const;
+    bool outputHasNonZero() const { return analyzeOutput().hasNonZero; }
 
     /// Check if output contains valid (non-NaN, non-Inf) samples
-    bool outputIsValid() const;
+    bool outputIsValid() const { return analyzeOutput().isValid(); }
 
     /// Get peak amplitude of output
-    float outputPeakAmplitude() const;
+    float outputPeakAmplitude() const { return analyzeOutput().peak; }
 
     /// Get input data for a channel
-    float* inputData(uint32_t channel) { return inputData_[channel].data(); }
-    const float* inputData(uint32_t channel) const { return inputData_[channel].data(); }
+    T* inputData(uint32_t channel) { return inputPtrs_[channel]; }
+    const T* inputData(uint32_t channel) const { return inputPtrs_[channel]; }
 
     /// Get output data for a channel
-    float* outputData(uint32_t channel) { return outputData_[channel].data(); }
-    const float* outputData(uint32_t channel) const { return outputData_[channel].data(); }
+    T* outputData(uint32_t channel) { return outputPtrs_[channel]; }
+    const T* outputData(uint32_t channel) const { return outputPtrs_[channel]; }
 
     /// Get block size
     uint32_t blockSize() const { return blockSize_; }
 
+    /// How the channel storage was allocated
+    BufferLayout layout() const { return layout_; }
+
+    /// True if the contiguous slab ended up on explicit huge pages
+    bool hugePageBacked() const { return slab_.hugePageBacked(); }
+
 private:
     uint32_t blockSize_;
-    std::vector<float> inputData_[NUM_CHANNELS];
-    std::vector<float> outputData_[NUM_CHANNELS];
-    float* inputPtrs_[NUM_CHANNELS];
-    float* outputPtrs_[NUM_CHANNELS];
+    BufferLayout layout_;
+    std::vector<T> separateData_[NUM_CHANNELS * 2];
+    AlignedSlab slab_;
+    T* inputPtrs_[NUM_CHANNELS];
+    T* outputPtrs_[NUM_CHANNELS];
     clap_audio_buffer_t inputBuffer_;
     clap_audio_buffer_t outputBuffer_;
 };
@@ -70,35 +202,56 @@ private:
 /**
  * Manages multi-channel audio buffers for testing.
  */
-class AudioBuffers {
+template<typename T>
+class BasicAudioBuffers {
 public:
-    AudioBuffers(uint32_t blockSize, uint32_t inputChannels, uint32_t outputChannels);
+    using Sample = T;
+
+    BasicAudioBuffers(uint32_t blockSize, uint32_t inputChannels, uint32_t outputChannels,
+                      BufferLayout layout = BufferLayout::Separate);
 
     clap_audio_buffer_t* inputBuffer() { return &inputBuffer_; }
     clap_audio_buffer_t* outputBuffer() { return &outputBuffer_; }
 
+    void fillInputWithConstant(T value);
     void clearInput();
     void clearOutput();
-    bool outputHasNonZero() const;
-    bool outputIsValid() const;
+    BufferStats analyzeOutput() const;
+    bool outputHasNonZero() const { return analyzeOutput().hasNonZero; }
+    bool outputIsValid() const { return analyzeOutput().isValid(); }
+    float outputPeakAmplitude() const { return analyzeOutput().peak; }
 
-    float* inputData(uint32_t channel) { return inputData_[channel].data(); }
-    float* outputData(uint32_t channel) { return outputData_[channel].data(); }
+    T* inputData(uint32_t channel) { return inputPtrs_[channel]; }
+    T* outputData(uint32_t channel) { return outputPtrs_[channel]; }
 
     uint32_t blockSize() const { return blockSize_; }
     uint32_t inputChannels() const { return inputChannels_; }
     uint32_t outputChannels() const { return outputChannels_; }
+    BufferLayout layout() const { return layout_; }
+    bool hugePageBacked() const { return slab_.hugePageBacked(); }
 
 private:
     uint32_t blockSize_;
     uint32_t inputChannels_;
     uint32_t outputChannels_;
-    std::vector<std::vector<float>> inputData_;
-    std::vector<std::vector<float>> outputData_;
-    std::vector<float*> inputPtrs_;
-    std::vector<float*> outputPtrs_;
+    BufferLayout layout_;
+    std::vector<std::vector<T>> separateData_;
+    AlignedSlab slab_;
+    std::vector<T*> inputPtrs_;
+    std::vector<T*> outputPtrs_;
     clap_audio_buffer_t inputBuffer_;
     clap_audio_buffer_t outputBuffer_;
 };
 
+// Instantiated for float and double in audio-buffers.cpp
+extern template class BasicStereoAudioBuffers<float>;
+extern template class BasicStereoAudioBuffers<double>;
+extern template class BasicAudioBuffers<float>;
+extern template class BasicAudioBuffers<double>;
+
+using StereoAudioBuffers = BasicStereoAudioBuffers<float>;
+using StereoAudioBuffers64 = BasicStereoAudioBuffers<double>;
+using AudioBuffers = BasicAudioBuffers<float>;
+using AudioBuffers64 = BasicAudioBuffers<double>;
+
 } // namespace clap_trap
@@ -0,0 +1,69 @@
+/**
+ * clap-trap: Automation
+ *
+ * Dense parameter automation and modulation for stress-testing plugins.
+ */
+
+#pragma once
+
+#include "test-host.h"
+#include <clap/clap.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace clap_trap {
+
+enum class AutomationShape {
+    Ramp,    ///< Triangle from min to max and back, once per second
+    Lfo,     ///< Sine at 5 Hz across the full range
+    Random,  ///< Random walk, reflected at the range limits
+};
+
+/**
+ * One automated parameter.
+ */
+struct AutomationLane {
+    clap_id paramId = CLAP_INVALID_ID;
+    double minValue = 0.0;
+    double maxValue = 1.0;
+    bool stepped = false;       ///< Round values to whole numbers
+    bool modulation = false;    ///< Send CLAP_EVENT_PARAM_MOD instead of CLAP_EVENT_PARAM_VALUE
+    AutomationShape shape = AutomationShape::Lfo;
+};
+
+/**
+ * Generates parameter events for consecutive blocks.
+ *
+ * Every lane gets `eventsPerBlock` events per block, evenly spaced (at most
+ * one per sample). Value events carry a plain value within the range;
+ * modulation events carry an offset of up to half the range either way.
+ * The sequence is deterministic for a given seed.
+ */
+class AutomationGenerator {
+public:
+    AutomationGenerator(std::vector<AutomationLane> lanes, double sampleRate,
+                        uint32_t eventsPerBlock, uint64_t seed = 1);
+
+    /// Add the next block's events to `events`; returns the number added
+    uint32_t fillBlock(SimpleInputEvents& events, uint32_t frames);
+
+    /// Events a block of `frames` samples gets, over all lanes
+    uint32_t eventsForBlock(uint32_t frames) const;
+
+    const std::vector<AutomationLane>& lanes() const { return lanes_; }
+    uint32_t eventsPerBlock() const { return eventsPerBlock_; }
+
+private:
+    /// Shape position in [0, 1] for lane `index` at `sample`
+    double position(size_t index, uint64_t sample);
+
+    std::vector<AutomationLane> lanes_;
+    std::vector<double> walk_;  // Random walk positions
+    double sampleRate_;
+    uint32_t eventsPerBlock_;
+    uint64_t sampleTime_ = 0;
+    std::mt19937_64 rng_;
+};
+
+} // namespace clap_trap
@@ -0,0 +1,79 @@
+/**
+ * clap-trap: Benchmark Comparison
+ *
+ * Statistics for deciding whether a benchmark got slower than a baseline.
+ */
+
+#pragma once
+
+#include "report.h"
+#include <cstdint>
+#include <vector>
+
+namespace clap_trap {
+
+/**
+ * One-sided Mann-Whitney U test.
+ */
+struct RankTestResult {
+    double u = 0.0;       ///< U statistic of the current samples
+    double z = 0.0;       ///< Normal approximation, tie corrected
+    double pValue = 1.0;  ///< P(a shift this large if current is not slower)
+};
+
+/**
+ * Test whether `current` block times are stochastically larger than `baseline`.
+ *
+ * Works directly on histogram buckets: every bucket is one tie group, so
+ * values within a bucket's ~1.6% width count as equal.
+ */
+RankTestResult mannWhitneyU(const std::vector<HistogramBucket>& baseline,
+                            const std::vector<HistogramBucket>& current);
+
+/**
+ * Bootstrap confidence interval for median(current) / median(baseline) - 1.
+ *
+ * The inputs are per-run values (e.g. the median block time of each
+ * repetition), so run-to-run noise such as clock changes is included.
+ * Returns false if either side has fewer than two runs.
+ */
+bool bootstrapChangeInterval(const std::vector<uint64_t>& baseline, const std::vector<uint64_t>& current,
+                             double confidence, double& low, double& high,
+                             uint32_t resamples = 2000, uint64_t seed = 1);
+
+/**
+ * True if the first of several runs is an outlier compared to the rest.
+ *
+ * The first repetition often runs against cold caches or a CPU that is
+ * still raising its clock. It is dropped when its median is further from
+ * the median of the other runs than `tolerance` (relative) and three
+ * median absolute deviations of the others. Needs at least three runs.
+ */
+bool isNoisyFirstRun(const std::vector<uint64_t>& runMedians, double tolerance, double* deviation = nullptr);
+
+/**
+ * Outcome of comparing one timing against its baseline.
+ */
+struct TimingComparison {
+    double baselineMedianNs = 0.0;
+    double currentMedianNs = 0.0;
+    double change = 0.0;            ///< Relative change of the median (+0.05 = 5% slower)
+    bool hasInterval = false;
+    double changeLow = 0.0;         ///< 95% bootstrap interval of `change`
+    double changeHigh = 0.0;
+    double pValue = 1.0;            ///< Mann-Whitney, current slower than baseline
+    bool regressed = false;         ///< Significant slowdown beyond the threshold
+    bool improved = false;          ///< Significant speedup beyond the threshold
+};
+
+/**
+ * Compare a timing against its baseline.
+ *
+ * A regression needs all of: median change above `threshold`, a
+ * Mann-Whitney p-value below `alpha`, and (when both sides have several
+ * runs) a bootstrap interval that lies entirely above zero.
+ */
+TimingComparison compareTimings(const TimingStats& baseline, const TimingStats& current,
+                                double threshold, double alpha = 0.01);
+
+} // namespace clap_trap
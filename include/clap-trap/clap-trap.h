@@ -13,4 +13,19 @@
 #include "test-host.h"
 #include "audio-buffers.h"
 #include "wav-file.h"
+#include "resampler.h"
+#include "wav-pipeline.h"
 #include "midi-file.h"
+#include "latency-histogram.h"
+#include "threading.h"
+#include "spsc-ring.h"
+#include "json.h"
+#include "report.h"
+#include "bench-compare.h"
+#include "automation.h"
+#include "perf-counters.h"
+#include "rt-check.h"
+#include "thread-pool.h"
+#include "resource-usage.h"
+#include "scan-cache.h"
+#include "process-graph.h"
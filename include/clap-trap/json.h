@@ -0,0 +1,90 @@
+/**
+ * clap-trap: JSON
+ *
+ * Minimal JSON document type for machine-readable results.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clap_trap {
+
+/**
+ * A JSON value: null, bool, number, string, array or object.
+ *
+ * Objects keep their members in insertion order, so dumped reports have a
+ * stable layout that diffs cleanly. Numbers are stored as double; integral
+ * values are written without a fraction.
+ */
+class Json {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    using Member = std::pair<std::string, Json>;
+
+    Json() = default;
+    Json(std::nullptr_t) {}
+    Json(bool value) : type_(Type::Bool), bool_(value) {}
+    Json(const char* value) : type_(Type::String), string_(value ? value : "") {}
+    Json(std::string value) : type_(Type::String), string_(std::move(value)) {}
+
+    template<typename T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    Json(T value) : type_(Type::Number), number_(static_cast<double>(value)) {}
+
+    static Json array();
+    static Json object();
+
+    /// Parse a JSON document; returns null and sets `error` on failure
+    static Json parse(std::string_view text, std::string* error = nullptr);
+
+    Type type() const { return type_; }
+    bool isNull() const { return type_ == Type::Null; }
+    bool isBool() const { return type_ == Type::Bool; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isString() const { return type_ == Type::String; }
+    bool isArray() const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    bool asBool(bool fallback = false) const { return isBool() ? bool_ : fallback; }
+    double asNumber(double fallback = 0.0) const { return isNumber() ? number_ : fallback; }
+    const std::string& asString() const { return string_; }
+
+    /// Array elements (empty for other types)
+    const std::vector<Json>& items() const { return items_; }
+
+    /// Object members in insertion order (empty for other types)
+    const std::vector<Member>& members() const { return members_; }
+
+    /// Number of array elements or object members
+    size_t size() const { return isArray() ? items_.size() : members_.size(); }
+
+    /// Append to an array; returns the new element
+    Json& push(Json value);
+
+    /// Set an object member, replacing any existing one; returns *this
+    Json& set(std::string key, Json value);
+
+    /// Object member, or nullptr if missing (or not an object)
+    const Json* get(std::string_view key) const;
+    Json* get(std::string_view key);
+
+    /// Serialize; indent < 0 writes everything on one line
+    std::string dump(int indent = 2) const;
+
+private:
+    void dumpTo(std::string& out, int indent, int depth) const;
+
+    Type type_ = Type::Null;
+    bool bool_ = false;
+    double number_ = 0.0;
+    std::string string_;
+    std::vector<Json> items_;
+    std::vector<Member> members_;
+};
+
+} // namespace clap_trap
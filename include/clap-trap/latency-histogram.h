@@ -0,0 +1,86 @@
+/**
+ * clap-trap: Latency Histogram
+ *
+ * Fixed-allocation, log-bucketed (HDR-style) histogram for per-block timings.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace clap_trap {
+
+/**
+ * Log-bucketed histogram of unsigned values (typically nanoseconds).
+ *
+ * Values below SUB_BUCKET_COUNT are stored exactly. Above that, every power
+ * of two is split into SUB_BUCKET_COUNT linear sub-buckets, so the relative
+ * error of any reported value is at most 1 / SUB_BUCKET_COUNT (~1.6%).
+ *
+ * All storage is allocated by the constructor; record() never allocates and
+ * is cheap enough to call around every process() call.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 6;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram();
+
+    /// Record a single value
+    void record(uint64_t value) {
+        counts_[bucketIndex(value)]++;
+        total_++;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    /// Forget all recorded values (keeps the allocation)
+    void reset();
+
+    /// Add all values recorded in another histogram
+    void merge(const LatencyHistogram& other);
+
+    /// Number of recorded values
+    uint64_t count() const { return total_; }
+
+    /// Smallest/largest recorded value (0 when empty)
+    uint64_t min() const { return total_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+
+    /// Arithmetic mean of recorded values (exact, not bucketed)
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+
+    /// Value at the given percentile (0-100), clamped to the recorded range
+    uint64_t valueAtPercentile(double percentile) const;
+
+    /// Bucket that a value falls into
+    static uint32_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) return static_cast<uint32_t>(value);
+        uint32_t exponent = static_cast<uint32_t>(std::bit_width(value)) - 1;
+        uint32_t shift = exponent - SUB_BUCKET_BITS;
+        uint32_t group = shift + 1;
+        return group * SUB_BUCKET_COUNT +
+               static_cast<uint32_t>((value >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    /// Smallest and largest value that map to a bucket
+    static uint64_t bucketLowerBound(uint32_t index);
+    static uint64_t bucketUpperBound(uint32_t index);
+
+    /// Raw count stored in a bucket
+    uint64_t countAt(uint32_t index) const { return counts_[index]; }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
+
+} // namespace clap_trap
@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -104,4 +105,39 @@ private:
     std::vector<TempoChange> tempoMap_;
 };
 
+/**
+ * MIDI events binned into process blocks.
+ *
+ * Built once for a sample rate and block size: every event is converted to
+ * an absolute sample position and an offset within its block, and the
+ * events for block N are a contiguous slice returned by block(N).
+ */
+class MidiSchedule {
+public:
+    struct Event {
+        uint64_t sampleTime;  ///< Absolute sample position
+        uint32_t offset;      ///< Sample offset within its block
+        MidiEvent midi;
+    };
+
+    /// @param events Events with secondTime set (e.g. from MidiFile)
+    MidiSchedule(const std::vector<MidiEvent>& events, uint32_t sampleRate, uint32_t blockSize);
+
+    /// Events that fall into block `index` (empty past the last event)
+    std::span<const Event> block(size_t index) const;
+
+    /// Number of blocks up to and including the one with the last event
+    size_t blockCount() const { return blockStarts_.empty() ? 0 : blockStarts_.size() - 1; }
+
+    size_t eventCount() const { return events_.size(); }
+    uint32_t sampleRate() const { return sampleRate_; }
+    uint32_t blockSize() const { return blockSize_; }
+
+private:
+    uint32_t sampleRate_;
+    uint32_t blockSize_;
+    std::vector<Event> events_;
+    std::vector<uint32_t> blockStarts_;
+};
+
 } // namespace clap_trap
@@ -0,0 +1,116 @@
+/**
+ * clap-trap: Performance Counters
+ *
+ * Hardware event counters for the calling thread, cheap enough to read
+ * around a single process() call. Uses perf_event_open on Linux and the
+ * kperf framework (kpc, needs root) on macOS.
+ *
+ * @code
+ * PerfCounters counters;
+ * PerfCounters::Values total;
+ * counters.start();
+ * for (uint32_t b = 0; b < blocks; ++b) {
+ *     PerfCounters::Scope scope(counters, total);
+ *     plugin->process(plugin, &process);
+ * }
+ * counters.stop();
+ * double ipc = total.ipc();
+ * @endcode
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace clap_trap {
+
+class PerfCounters {
+public:
+    enum Counter {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,        ///< L1 data cache read misses
+        LlcMisses,        ///< Last-level cache misses
+        ContextSwitches,  ///< Software event, includes involuntary preemption
+        COUNTER_COUNT
+    };
+
+    struct Values {
+        uint64_t value[COUNTER_COUNT] = {};
+        bool valid[COUNTER_COUNT] = {};  ///< False if the counter is not available
+
+        /// Instructions per cycle; 0 unless both were counted
+        double ipc() const;
+
+        /// Add `other`'s counts; a counter becomes valid once anything valid is added
+        void add(const Values& other);
+
+        /// `end - begin`, valid where both are
+        static Values difference(const Values& end, const Values& begin);
+    };
+
+    /**
+     * Adds the counts of its own lifetime to a running total.
+     *
+     * The counters have to be started. Costs one read per end (a single
+     * syscall on Linux), so it can wrap every process() call.
+     */
+    class Scope {
+    public:
+        Scope(const PerfCounters& counters, Values& total)
+            : counters_(counters), total_(total), begin_(counters.read()) {}
+        ~Scope() { total_.add(Values::difference(counters_.read(), begin_)); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const PerfCounters& counters_;
+        Values& total_;
+        Values begin_;
+    };
+
+    /// Open the counters for the calling thread (user space only, except context switches)
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// True if at least one counter could be opened
+    bool available() const;
+
+    /// True if `counter` can be read
+    bool has(Counter counter) const;
+
+    /// Why counters are unavailable (e.g. perf_event_paranoid)
+    const std::string& getError() const { return error_; }
+
+    /// Reset and enable all counters
+    void start();
+
+    /// Disable all counters; read() keeps returning the final counts
+    void stop();
+
+    /// Counts since start(), scaled up if the kernel multiplexed the counters
+    Values read() const;
+
+    /// Short identifier, e.g. "branchMisses"
+    static const char* name(Counter counter);
+
+private:
+    int fds_[COUNTER_COUNT];  // Linux: perf event fds in the group, -1 if not open
+    int leader_ = -1;         // Linux: group leader fd
+    int slot_[COUNTER_COUNT]; // Linux: position in the group read, -1 if not open
+    bool kpc_ = false;        // macOS: kpc thread counting set up
+    bool running_ = false;
+    Values base_;             // macOS: counts at start()
+    Values final_;            // macOS: counts at stop()
+    std::string error_;
+
+    Values readRaw() const;
+};
+
+} // namespace clap_trap
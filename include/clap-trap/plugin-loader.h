@@ -43,20 +43,39 @@ public:
      *   - .clap → native loading via dlopen
      *   - .wclap, .wasm → WASM loading via wclap-bridge (if enabled)
      *
-     * Returns nullptr on failure - call getError() for details.
+     * Always returns a loader; on failure entry() is nullptr and getError()
+     * says why.
      */
     static std::unique_ptr<PluginLoader> create(const std::string& path);
 
     /**
      * Load a native CLAP plugin from the given path.
-     * Returns nullptr on failure - call getError() for details.
+     * Always returns a loader; on failure entry() is nullptr and getError()
+     * says why.
      */
     static std::unique_ptr<PluginLoader> load(const std::string& path);
 
+    /**
+     * First half of load(): open the library and find clap_entry, without
+     * calling clap_entry->init(). Finish with initEntry(). Lets a caller
+     * time the two steps apart.
+     * Always returns a loader. entry() is nullptr if the library could not
+     * be opened or has no usable clap_entry, with the reason in getError().
+     */
+    static std::unique_ptr<PluginLoader> open(const std::string& path);
+
+    /**
+     * Second half of load(): call clap_entry->init(). Returns true if the
+     * entry is initialized, including when it already was. If init() fails,
+     * entry() becomes nullptr and getError() is set.
+     */
+    bool initEntry();
+
 #if CLAP_TRAP_HAS_WASM
     /**
      * Load a WASM CLAP plugin (.wclap or .wasm) via wclap-bridge.
-     * Returns nullptr on failure - call getError() for details.
+     * Always returns a loader; on failure entry() is nullptr and getError()
+     * says why.
      */
     static std::unique_ptr<PluginLoader> loadWasm(const std::string& path);
 
@@ -0,0 +1,148 @@
+/**
+ * clap-trap: Process Graph
+ *
+ * A chain of plugins processed block by block as one unit, e.g.
+ * EQ -> compressor -> reverb. Audio moves between nodes through two
+ * ping-pong buffers in one aligned slab: node i writes the buffer node
+ * i + 1 reads, so no samples are copied between stages and the data a
+ * node produces is still in cache when the next one starts.
+ *
+ * @code
+ * auto graph = ProcessGraph::load({"eq.clap", "comp.clap", "verb.clap"});
+ * if (graph->hasError() || !graph->activate(48000, 256) || !graph->startProcessing()) {
+ *     fprintf(stderr, "%s\n", graph->getError().c_str());
+ * }
+ * while (...) {
+ *     fill graph->input(c) for c < graph->inputChannels()
+ *     graph->process(256);
+ *     use graph->output(c) for c < graph->outputChannels()
+ * }
+ * graph->stopProcessing();
+ * @endcode
+ */
+
+#pragma once
+
+#include "audio-buffers.h"
+#include "latency-histogram.h"
+#include "plugin-loader.h"
+#include "test-host.h"
+#include <clap/clap.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clap_trap {
+
+class ProcessGraph {
+public:
+    /// One plugin instance in the chain
+    struct Node {
+        std::string path;
+        const clap_plugin_descriptor_t* descriptor = nullptr;
+        const clap_plugin_t* plugin = nullptr;
+        std::unique_ptr<TestHost> host;  ///< Each instance has its own host
+        uint32_t inputChannels = 0;      ///< Channels of the first input port (0 if it has none)
+        uint32_t outputChannels = 2;     ///< Channels of the first output port
+        uint32_t latency = 0;            ///< Reported once activated
+        uint32_t tail = 0;
+        clap_process_status lastStatus = CLAP_PROCESS_CONTINUE;
+        LatencyHistogram histogram;      ///< process() time per block, in ns
+
+        clap_audio_buffer_t inputBuffer{};
+        clap_audio_buffer_t outputBuffer{};
+        clap_process_t process{};
+        EmptyInputEvents inEvents;
+        DiscardOutputEvents outEvents;
+    };
+
+    /**
+     * Load every file and create and init the first plugin of each, in order.
+     * A file listed more than once is loaded once and gets one instance per
+     * listing. The hosts belong to the calling thread, which is the main
+     * thread for every later call except process().
+     * @return ProcessGraph instance (check hasError() for success)
+     */
+    static std::unique_ptr<ProcessGraph> load(const std::vector<std::string>& paths);
+
+    /// Stops, deactivates and destroys every instance
+    ~ProcessGraph();
+
+    ProcessGraph(const ProcessGraph&) = delete;
+    ProcessGraph& operator=(const ProcessGraph&) = delete;
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    /**
+     * Activate every node at the same sample rate and block size, and lay
+     * out the ping-pong buffers for their port channel counts. Reactivates
+     * nodes that are already active.
+     * @return false if a node fails to activate (see getError())
+     */
+    bool activate(uint32_t sampleRate, uint32_t blockSize, bool hugePages = false);
+    void deactivate();
+
+    /**
+     * start_processing()/stop_processing() on every node. Call on the thread
+     * that calls process(), marked with a TestHost::AudioThreadScope.
+     */
+    bool startProcessing();
+    void stopProcessing();
+
+    /**
+     * Run every node once, in order, over `frames` frames (at most the block
+     * size), timing each node into its histogram. Channels a node reads but
+     * its predecessor did not write are silent.
+     */
+    void process(uint32_t frames);
+
+    /// Call clap_plugin->reset() on every node (audio thread, while processing)
+    void reset();
+
+    /// Run main-thread callbacks every node asked for
+    void pumpMainThread();
+
+    /// Input of the first node, blockSize() samples per channel
+    uint32_t inputChannels() const;
+    float* input(uint32_t channel) const;
+
+    /// Output of the last node, valid after process()
+    uint32_t outputChannels() const;
+    const float* output(uint32_t channel) const;
+
+    /// Sum of the nodes' latencies and tails
+    uint32_t latency() const;
+    uint32_t tail() const;
+
+    size_t nodeCount() const { return nodes_.size(); }
+    const Node& node(size_t index) const { return *nodes_[index]; }
+
+    uint32_t blockSize() const { return blockSize_; }
+    bool hugePageBacked() const { return slab_.hugePageBacked(); }
+
+    /// Forget the recorded per-node timings
+    void resetStats();
+
+private:
+    ProcessGraph() = default;
+
+    float* const* channels(uint32_t side) const { return channels_[side].data(); }
+
+    std::vector<std::unique_ptr<PluginLoader>> loaders_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::string error_;
+    uint32_t sampleRate_ = 0;  // 0 = inactive
+    uint32_t blockSize_ = 0;
+    bool processing_ = false;
+    uint64_t steadyTime_ = 0;
+
+    // Ping-pong channels: node i reads side i % 2 and writes side (i + 1) % 2
+    AlignedSlab slab_;
+    std::vector<float*> channels_[2];
+    uint32_t maxChannels_ = 0;
+    size_t stride_ = 0;
+};
+
+} // namespace clap_trap
@@ -0,0 +1,132 @@
+/**
+ * clap-trap: Results Report
+ *
+ * Structured results shared by the CLI commands, with JSON and CSV output.
+ */
+
+#pragma once
+
+#include "json.h"
+#include "latency-histogram.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clap_trap {
+
+/**
+ * Host settings a run used, recorded so results can be compared later.
+ */
+struct HostConfig {
+    uint32_t sampleRate = 0;
+    uint32_t bufferSize = 0;
+    uint32_t blocks = 0;
+    std::string precision;     ///< "auto", "32" or "64"
+    std::string bufferLayout;  ///< "separate", "contiguous" or "huge-pages"
+    uint32_t instances = 1;
+    uint32_t threads = 0;
+};
+
+/**
+ * Outcome of a single check (e.g. "init", "process").
+ */
+struct CheckResult {
+    std::string name;
+    bool passed = false;
+    std::string detail;
+};
+
+/**
+ * One bucket of a latency histogram.
+ */
+struct HistogramBucket {
+    uint64_t lowerNs = 0;
+    uint64_t upperNs = 0;
+    uint64_t count = 0;
+};
+
+/**
+ * Per-block timing of one benchmark run.
+ */
+struct TimingStats {
+    std::string name;  ///< e.g. "float32", "float64", "parallel"
+    uint64_t blocks = 0;
+    double realtime = 0.0;  ///< Audio time / wall time
+    double meanNs = 0.0;
+    uint64_t minNs = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p90Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+    uint64_t deadlineNs = 0;
+    uint64_t deadlineMisses = 0;
+    uint64_t longestMissRun = 0;
+    std::vector<HistogramBucket> histogram;  ///< Non-empty buckets only
+    std::vector<uint64_t> runMediansNs;      ///< Median of each run, when repeated
+    Json counters;                           ///< Hardware counters per block, plus "ipc" (null if not counted)
+
+    /// Percentiles and buckets of a recorded histogram
+    static TimingStats fromHistogram(std::string name, const LatencyHistogram& histogram);
+
+    /// Read back a timing written by toJson(); false if it is malformed
+    static bool fromJson(const Json& json, TimingStats& out);
+};
+
+/**
+ * Results for one plugin in a file.
+ */
+struct PluginResult {
+    std::string id;
+    std::string name;
+    std::string vendor;
+    std::string version;
+    std::vector<CheckResult> checks;
+    std::vector<TimingStats> timings;
+    Json details = Json::object();  ///< Command-specific data (ports, params, ...), under "details" in JSON
+
+    /// Record a check result, replacing an earlier one with the same name
+    void check(std::string checkName, bool passed, std::string detail = {});
+
+    /// True when every check passed
+    bool passed() const;
+
+    /// Read back a plugin written by toJson(); false if it is malformed
+    static bool fromJson(const Json& json, PluginResult& out);
+};
+
+/**
+ * Everything one command run produced.
+ */
+struct Report {
+    std::string command;
+    std::string pluginPath;
+    HostConfig host;
+    std::vector<CheckResult> checks;  ///< File-level checks (load, factory)
+    std::vector<PluginResult> plugins;
+    Json details = Json::object();
+
+    /// Record a file-level check result, replacing an earlier one with the same name
+    void check(std::string checkName, bool passed, std::string detail = {});
+
+    /// Result entry for a plugin id, added on first use
+    PluginResult& plugin(const std::string& id);
+
+    /// True when every file-level and per-plugin check passed
+    bool passed() const;
+};
+
+Json toJson(const TimingStats& timing);
+Json toJson(const PluginResult& plugin);
+Json toJson(const Report& report);
+
+/**
+ * Flatten a report into CSV rows of `plugin,metric,value`.
+ *
+ * Metrics are dotted paths into the JSON report ("timings.float32.p99Ns").
+ * Array entries with a "name" member are keyed by it, others by index.
+ * Report-level values have an empty plugin column.
+ */
+std::string toCsv(const Json& report);
+
+} // namespace clap_trap
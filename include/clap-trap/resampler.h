@@ -0,0 +1,83 @@
+/**
+ * clap-trap: Resampler
+ *
+ * Streaming sample-rate converter built on a polyphase bank of
+ * Kaiser-windowed sinc filters, one filter per phase of the exact rational
+ * ratio between the two rates. Each output sample costs one SIMD dot
+ * product per channel. The output is not delayed: output frame m sits at
+ * input time m * inputRate / outputRate.
+ *
+ * @code
+ * Resampler resampler(44100, 96000, 2);
+ * resampler.push(input, inputFrames);
+ * resampler.finish();  // At the end of the input
+ * uint32_t frames = resampler.pull(output, maxFrames);
+ * @endcode
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace clap_trap {
+
+class Resampler {
+public:
+    /// Filter taps per phase when converting up; converting down scales it by the ratio
+    static constexpr uint32_t DEFAULT_TAPS = 64;
+
+    /// Ratios needing more phases than this interpolate between neighbouring phases
+    static constexpr uint32_t MAX_PHASES = 1024;
+
+    /**
+     * @param inputRate Rate of the pushed frames in Hz
+     * @param outputRate Rate of the pulled frames in Hz
+     * @param channels Interleaved channels per frame
+     * @param taps Filter taps per phase at a 1:1 ratio, rounded up to a multiple of 8
+     */
+    Resampler(uint32_t inputRate, uint32_t outputRate, uint32_t channels, uint32_t taps = DEFAULT_TAPS);
+
+    /// Output frames `inputFrames` input frames convert to
+    uint64_t outputFramesFor(uint64_t inputFrames) const;
+
+    /// Append interleaved input frames
+    void push(const float* interleaved, uint32_t frames);
+
+    /// Mark the end of the input; the filter's look-ahead past it reads silence
+    void finish();
+
+    /**
+     * Convert as many frames as the pushed input allows
+     * @param interleaved Destination, at least frames * channels floats
+     * @param frames Maximum number of frames to produce
+     * @return Frames produced; 0 means push() more (or, after finish(), the
+     *         output has run past the end of the input)
+     */
+    uint32_t pull(float* interleaved, uint32_t frames);
+
+    uint32_t inputRate() const { return inputRate_; }
+    uint32_t outputRate() const { return outputRate_; }
+    uint32_t channels() const { return channels_; }
+    uint32_t taps() const { return taps_; }
+
+private:
+    uint32_t inputRate_;
+    uint32_t outputRate_;
+    uint32_t channels_;
+    uint64_t up_;    // Output rate / gcd: phases per input sample
+    uint64_t down_;  // Input rate / gcd: phase advance per output sample
+    uint32_t taps_;
+    uint32_t phases_;     // Rows in the table (up_ unless that exceeds MAX_PHASES)
+    bool interpolate_;    // Blend neighbouring rows instead of using exact phases
+    std::vector<float> coefficients_;  // (phases_ + 1) rows of taps_, row r at input offset r / phases_
+
+    // Per channel input history; element 0 is input frame bufferStart_
+    std::vector<std::vector<float>> history_;
+    int64_t bufferStart_;
+    int64_t position_ = 0;  // Input frame at or before the next output frame
+    uint64_t phase_ = 0;    // Its fraction, in units of 1 / up_
+    bool finished_ = false;
+};
+
+} // namespace clap_trap
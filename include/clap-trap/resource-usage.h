@@ -0,0 +1,38 @@
+/**
+ * clap-trap: Resource Usage
+ *
+ * Page fault counts and resident memory of the whole process, sampled
+ * before and after a step to see what it cost: mapping a library, running
+ * its static initializers, or allocating lazily on first use.
+ *
+ * @code
+ * ResourceUsage before = ResourceUsage::current();
+ * auto loader = PluginLoader::load(path);
+ * ResourceUsage cost = ResourceUsage::current() - before;
+ * @endcode
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace clap_trap {
+
+struct ResourceUsage {
+    uint64_t minorFaults = 0;    ///< Page faults served without I/O (all faults on Windows)
+    uint64_t majorFaults = 0;    ///< Page faults that had to read from disk
+    int64_t residentBytes = 0;   ///< Resident set size; a difference can be negative
+    int64_t proportionalBytes = 0;  ///< PSS: resident, with shared pages split between their processes (Linux)
+
+    /**
+     * Current values for this process; fields the platform can't report stay 0.
+     * PSS is only read with `proportional`, since the kernel has to walk every
+     * mapping to compute it.
+     */
+    static ResourceUsage current(bool proportional = false);
+
+    /// Change from `begin` to this
+    ResourceUsage operator-(const ResourceUsage& begin) const;
+};
+
+} // namespace clap_trap
@@ -0,0 +1,127 @@
+/**
+ * clap-trap: Realtime Safety Check
+ *
+ * Catches allocations, locks and blocking system calls made on the audio
+ * thread. The calling thread is marked for the lifetime of an RtRegion;
+ * any interposed call it makes while marked is recorded with its stack.
+ *
+ * The hooks live in the separate clap-trap-rtcheck CMake target. Linking it
+ * interposes malloc/free, pthread locks and a set of blocking libc calls for
+ * the whole program (Linux with glibc only), so the core library leaves it
+ * out; without it rtCheckSupported() is false and nothing is recorded.
+ * Outside a region the hooks only test a thread-local flag and forward the
+ * call.
+ *
+ * The same hooks can count heap calls instead of recording them: a
+ * HeapCountScope adds every allocation and free the calling thread makes
+ * to a HeapCounts, with the usable size of each block.
+ *
+ * @code
+ * rtCheckEnable();
+ * {
+ *     RtRegion region;
+ *     plugin->process(plugin, &process);
+ * }
+ * for (const auto& violation : takeRtViolations()) {
+ *     for (const auto& frame : symbolizeRtStack(violation)) puts(frame.c_str());
+ * }
+ * @endcode
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clap_trap {
+
+constexpr uint32_t RT_MAX_FRAMES = 16;
+
+enum class RtViolationKind {
+    Allocation,  ///< malloc, free and friends (operator new/delete go through these)
+    Lock,        ///< Blocking mutex, rwlock or semaphore acquisition
+    Syscall,     ///< File I/O, sleeping, mapping memory
+};
+
+/**
+ * One forbidden call, recorded without allocating.
+ */
+struct RtViolation {
+    RtViolationKind kind = RtViolationKind::Allocation;
+    const char* function = "";  ///< Interposed function, e.g. "malloc"
+    uint64_t size = 0;          ///< Bytes requested, for allocations
+    uint32_t frameCount = 0;
+    void* frames[RT_MAX_FRAMES] = {};  ///< Return addresses, the caller first
+};
+
+/// True if the hooks are compiled in on this platform
+bool rtCheckSupported();
+
+/**
+ * Resolve the forwarded functions and warm up stack capture.
+ *
+ * Both can allocate the first time, so this must run before the first
+ * region. Returns false if the check is not supported.
+ */
+bool rtCheckEnable();
+
+/**
+ * Marks the calling thread as realtime for its lifetime. Regions nest.
+ */
+class RtRegion {
+public:
+    RtRegion();
+    ~RtRegion();
+
+    RtRegion(const RtRegion&) = delete;
+    RtRegion& operator=(const RtRegion&) = delete;
+};
+
+/// Violations recorded since the last call, oldest first (not realtime safe)
+std::vector<RtViolation> takeRtViolations();
+
+/// Violations lost because the table was full, since the last take
+uint64_t droppedRtViolations();
+
+/// One line per frame, e.g. "toy.clap: Toy::process(clap_process const*) + 0x4f"
+std::vector<std::string> symbolizeRtStack(const RtViolation& violation);
+
+/// Short identifier, e.g. "allocation"
+const char* rtViolationKindName(RtViolationKind kind);
+
+/**
+ * Heap calls counted by a HeapCountScope. Sizes are what malloc_usable_size()
+ * reports, so freedBytes matches allocatedBytes once everything is freed.
+ */
+struct HeapCounts {
+    uint64_t allocations = 0;     ///< malloc, calloc, realloc and the aligned variants
+    uint64_t frees = 0;           ///< free, and the old block of a moving realloc
+    uint64_t allocatedBytes = 0;
+    uint64_t freedBytes = 0;
+
+    /// Heap growth: bytes allocated and not yet freed
+    int64_t netBytes() const { return static_cast<int64_t>(allocatedBytes) - static_cast<int64_t>(freedBytes); }
+
+    HeapCounts& operator+=(const HeapCounts& other);
+};
+
+/**
+ * Counts the calling thread's heap calls into `counts` for its lifetime.
+ *
+ * Needs rtCheckSupported(); elsewhere nothing is counted. Scopes nest, and
+ * only the innermost one counts. A HeapCounts belongs to a single thread.
+ */
+class HeapCountScope {
+public:
+    explicit HeapCountScope(HeapCounts& counts);
+    ~HeapCountScope();
+
+    HeapCountScope(const HeapCountScope&) = delete;
+    HeapCountScope& operator=(const HeapCountScope&) = delete;
+
+private:
+    HeapCounts* previous_;
+};
+
+} // namespace clap_trap
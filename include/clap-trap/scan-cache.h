@@ -0,0 +1,116 @@
+/**
+ * clap-trap: Scan Cache
+ *
+ * Plugin metadata (descriptors, features, ports, parameters) remembered per
+ * file, so a folder of plugins does not have to be loaded again just to
+ * list what is in it. An entry stays valid while the file's size and
+ * modification time are unchanged, and optionally its content hash.
+ *
+ * @code
+ * auto cache = ScanCache::open(ScanCache::defaultPath());
+ * FileSignature sig = fileSignature(path);
+ * if (const ScanEntry* entry = cache->lookup(path, sig)) {
+ *     use(entry->plugins);
+ * } else {
+ *     cache->put(probe(path, sig));
+ *     cache->save();
+ * }
+ * @endcode
+ */
+
+#pragma once
+
+#include "json.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace clap_trap {
+
+/**
+ * What identifies one version of a plugin file. For a bundle (a directory),
+ * sizes are summed and the newest modification time is used.
+ */
+struct FileSignature {
+    bool exists = false;
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;  ///< Modification time on the filesystem clock
+    uint64_t hash = 0;    ///< FNV-1a of the contents; 0 = not computed
+
+    /**
+     * True if `current` is the file this signature was taken from: the same
+     * size and content hash when `current` has a hash, else the same size
+     * and modification time.
+     */
+    bool matches(const FileSignature& current) const;
+};
+
+/// Size and modification time of `path`, plus the content hash if `withHash`
+FileSignature fileSignature(const std::string& path, bool withHash = false);
+
+/**
+ * Cached scan result for one file.
+ */
+struct ScanEntry {
+    std::string path;
+    FileSignature signature;
+    bool ok = false;                ///< The scan completed
+    std::string error;              ///< Why not, e.g. "crashed (Segmentation fault)"
+    Json plugins = Json::array();   ///< One object per plugin in the file
+};
+
+class ScanCache {
+public:
+    /// Format version written to the file; other versions are ignored on load
+    static constexpr int FORMAT_VERSION = 2;
+
+    /**
+     * Open the cache stored at `file`. A missing file gives an empty cache;
+     * an unreadable or corrupt one also starts empty but sets getError().
+     */
+    static std::unique_ptr<ScanCache> open(const std::string& file);
+
+    /// Per-user cache location, e.g. ~/.cache/clap-trap/scan-cache.json
+    static std::string defaultPath();
+
+    /**
+     * Key `path` is cached under: absolute, with symlinks and ".." resolved
+     * as far as the path exists, so "plugin.clap" and "/abs/plugin.clap"
+     * find the same entry whatever the working directory.
+     */
+    static std::string normalize(const std::string& path);
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    /// Entry for `path` if the file is still the one it was scanned from, else nullptr
+    const ScanEntry* lookup(const std::string& path, const FileSignature& current) const;
+
+    /// Entry for `path` whatever its signature, or nullptr
+    const ScanEntry* find(const std::string& path) const;
+
+    /// Add or replace the entry for entry.path (stored with the path normalized)
+    void put(ScanEntry entry);
+
+    /// Drop the entry for `path`; returns true if there was one
+    bool remove(const std::string& path);
+
+    const std::map<std::string, ScanEntry>& entries() const { return entries_; }
+
+    /**
+     * Write the cache back to its file, creating the directory if needed.
+     * Written to a temporary file first and renamed into place, so a reader
+     * never sees half a cache. Returns false and sets getError() on failure.
+     */
+    bool save();
+
+private:
+    ScanCache() = default;
+
+    std::string file_;
+    std::string error_;
+    std::map<std::string, ScanEntry> entries_;
+};
+
+} // namespace clap_trap
@@ -0,0 +1,86 @@
+/**
+ * clap-trap: SPSC Ring
+ *
+ * Bounded, wait-free single-producer/single-consumer queue.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace clap_trap {
+
+/**
+ * Fixed-capacity ring buffer for handing values from one thread to another.
+ *
+ * Exactly one thread may call tryPush() and exactly one (other) thread may
+ * call tryPop(). Both are wait-free and never allocate; storage is allocated
+ * by the constructor. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing holds trivially copyable values");
+
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(std::bit_ceil(capacity < 2 ? size_t(2) : capacity)),
+          mask_(capacity_ - 1),
+          slots_(std::make_unique<T[]>(capacity_)) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /// Producer: append a value; false if the ring is full
+    bool tryPush(const T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ == capacity_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ == capacity_) return false;
+        }
+        slots_[head & mask_] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer: take the oldest value; false if the ring is empty
+    bool tryPop(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cachedHead_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail == cachedHead_) return false;
+        }
+        value = slots_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Approximate number of queued values (exact when both sides are idle)
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    // Producer and consumer state live on separate cache lines. Each side
+    // keeps a cached copy of the other's index, so it only touches the
+    // shared line when the ring looks full (or empty).
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+};
+
+} // namespace clap_trap
@@ -6,19 +6,37 @@
 
 #pragma once
 
+#include "spsc-ring.h"
+#include "thread-pool.h"
 #include <clap/clap.h>
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace clap_trap {
 
+/**
+ * Message a plugin sent through clap_host_log.
+ */
+struct LogMessage {
+    clap_log_severity severity;
+    std::string text;
+};
+
+/// Lower-case name, e.g. "warning"
+const char* logSeverityName(clap_log_severity severity);
+
 /**
  * Minimal CLAP host implementation for testing.
  *
- * Provides the required clap_host_t interface with optional
- * callbacks for host requests.
+ * Provides the required clap_host_t interface and the params, latency,
+ * tail, log and thread-check extensions, recording what the plugin asks
+ * for. Plugins often take slower fallback paths when these are missing.
  */
 class TestHost {
 public:
@@ -38,21 +56,130 @@ public:
     /// Check if callback was requested
     bool callbackRequested() const { return callbackRequested_; }
 
+    /// CLAP_PARAM_RESCAN_* flags of every params rescan() so far (0 = none)
+    uint32_t paramsRescanFlags() const { return paramsRescanFlags_; }
+
+    /// Check if a parameter flush was requested and not yet serviced by pumpMainThread()
+    bool paramsFlushRequested() const { return paramsFlushRequested_; }
+
+    /// Check if the plugin reported a latency or tail change
+    bool latencyChanged() const { return latencyChanged_; }
+    bool tailChanged() const { return tailChanged_; }
+
     /// Reset all request flags
     void resetRequests();
 
+    /// Text kept of a message logged from an audio thread; longer ones are cut
+    static constexpr size_t AUDIO_LOG_TEXT_BYTES = 256;
+
+    /// Messages an audio thread can log between two pumpMainThread() calls
+    static constexpr size_t AUDIO_LOG_CAPACITY = 64;
+
+    /**
+     * Messages logged since the last call, oldest first. Messages from audio
+     * threads are queued without locking or I/O and only show up here once
+     * they are drained, on the main thread, by this or pumpMainThread().
+     */
+    std::vector<LogMessage> takeLogMessages();
+
+    /// Audio-thread messages lost because the queue was full or busy
+    uint64_t droppedLogMessages() const { return audioLogDropped_.load(std::memory_order_relaxed); }
+
+    /// Also print log messages to stderr (audio-thread ones when drained)
+    void setLogEcho(bool echo) { logEcho_ = echo; }
+
+    /**
+     * Tell the host whether the plugin is activated. An active plugin's
+     * parameters are flushed on the audio thread, by its next process(), so
+     * pumpMainThread() only calls params flush() while it is not.
+     */
+    void setPluginActive(bool active) { pluginActive_ = active; }
+
+    /**
+     * Run main-thread work the plugin asked for: drain messages logged on
+     * audio threads, call on_main_thread() after request_callback(), and
+     * service request_flush() with params flush() while the plugin is
+     * inactive (see setPluginActive()). Call it on the main thread between
+     * blocks; needs setPlugin().
+     *
+     * Returns true if a callback or flush ran.
+     */
+    bool pumpMainThread();
+
+    /**
+     * Marks the calling thread as an audio thread for clap_host_thread_check
+     * while it lives. The main thread is the one that created the host; when
+     * it processes audio itself, wrap the processing in one of these.
+     */
+    class AudioThreadScope {
+    public:
+        AudioThreadScope();
+        ~AudioThreadScope();
+
+        AudioThreadScope(const AudioThreadScope&) = delete;
+        AudioThreadScope& operator=(const AudioThreadScope&) = delete;
+
+    private:
+        bool previous_;
+    };
+
     /// Optional: set callback for extension requests
     using ExtensionCallback = std::function<const void*(const char* id)>;
     void setExtensionCallback(ExtensionCallback cb) { extensionCallback_ = std::move(cb); }
 
+    /**
+     * Offer CLAP_EXT_THREAD_POOL backed by a ThreadPool with `workers` threads.
+     *
+     * Plugins usually look up host extensions in init(), so enable it before
+     * creating the plugin, then bind the instance with setPlugin(). An
+     * extension callback still takes precedence for the ids it answers.
+     */
+    void enableThreadPool(uint32_t workers, bool pinWorkers = false);
+
+    /// Pool behind the thread-pool extension, or nullptr if not enabled
+    ThreadPool* threadPool() const { return threadPool_.get(); }
+
+    /// The plugin instance request_exec() and pumpMainThread() work on
+    void setPlugin(const clap_plugin_t* plugin);
+
 private:
     clap_host_t host_;
-    bool restartRequested_ = false;
-    bool processRequested_ = false;
-    bool callbackRequested_ = false;
+    std::atomic<bool> restartRequested_{false};
+    std::atomic<bool> processRequested_{false};
+    std::atomic<bool> callbackRequested_{false};
+    std::atomic<uint32_t> paramsRescanFlags_{0};
+    std::atomic<bool> paramsFlushRequested_{false};
+    std::atomic<bool> latencyChanged_{false};
+    std::atomic<bool> tailChanged_{false};
+    std::thread::id mainThread_;
+    std::mutex logMutex_;
+    std::vector<LogMessage> log_;
+    bool logEcho_ = false;
+    bool pluginActive_ = false;
+
+    // Audio threads log into this ring; a flag lets one of them in at a time
+    // without ever waiting, and the main thread drains it
+    struct AudioLogEntry {
+        clap_log_severity severity;
+        char text[AUDIO_LOG_TEXT_BYTES];
+    };
+    SpscRing<AudioLogEntry> audioLog_{AUDIO_LOG_CAPACITY};
+    std::atomic_flag audioLogBusy_ = ATOMIC_FLAG_INIT;
+    std::atomic<uint64_t> audioLogDropped_{0};
+    void drainAudioLog();
     ExtensionCallback extensionCallback_;
+    clap_host_params_t paramsExt_{};
+    clap_host_latency_t latencyExt_{};
+    clap_host_tail_t tailExt_{};
+    clap_host_log_t logExt_{};
+    clap_host_thread_check_t threadCheckExt_{};
+    std::unique_ptr<ThreadPool> threadPool_;
+    clap_host_thread_pool_t threadPoolExt_{};
+    const clap_plugin_t* plugin_ = nullptr;
+    const clap_plugin_thread_pool_t* pluginThreadPool_ = nullptr;
 
     static const void* hostGetExtension(const clap_host_t* host, const char* id);
+    static bool hostRequestExec(const clap_host_t* host, uint32_t numTasks);
     static void hostRequestRestart(const clap_host_t* host);
     static void hostRequestProcess(const clap_host_t* host);
     static void hostRequestCallback(const clap_host_t* host);
@@ -140,32 +267,139 @@ private:
 };
 
 /**
- * Simple input events list that holds a vector of events.
+ * Capturing output events through a lock-free ring.
+ *
+ * try_push() converts the event and hands it to a bounded SPSC ring, so the
+ * audio thread never allocates or waits; when the ring is full the event is
+ * rejected and counted in overflowCount(). A separate consumer thread drains
+ * the ring with pop().
+ */
+class RingCaptureOutputEvents {
+public:
+    /// A captured event with its absolute sample position
+    struct Entry {
+        uint64_t sampleTime;
+        CapturedEvent event;
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    explicit RingCaptureOutputEvents(size_t capacity = DEFAULT_CAPACITY);
+
+    const clap_output_events_t* get() const { return &events_; }
+
+    /// Producer: set the sample position of the block about to be processed
+    void beginBlock(uint64_t blockStart) { blockStart_ = blockStart; }
+
+    /// Consumer: take the oldest captured event; false if none are queued
+    bool pop(Entry& entry) { return ring_.tryPop(entry); }
+
+    /// Events accepted / rejected because the ring was full
+    uint64_t capturedCount() const { return captured_.load(std::memory_order_relaxed); }
+    uint64_t overflowCount() const { return overflows_.load(std::memory_order_relaxed); }
+
+    size_t capacity() const { return ring_.capacity(); }
+
+private:
+    clap_output_events_t events_;
+    SpscRing<Entry> ring_;
+    uint64_t blockStart_ = 0;
+    std::atomic<uint64_t> captured_{0};
+    std::atomic<uint64_t> overflows_{0};
+
+    static bool tryPush(const clap_output_events_t* list, const clap_event_header_t* event);
+};
+
+/**
+ * Input event list backed by a fixed-size arena.
+ *
+ * Storage is allocated once by the constructor. Adding events never
+ * allocates; when the arena or the event table is full, add calls return
+ * false and the event is counted in droppedCount(). clear() only resets two
+ * counters, so the list can be refilled every block on the audio thread.
+ *
+ * Events are kept sorted by time as they are added (events with equal time
+ * keep their insertion order), as CLAP requires for input events.
  */
 class SimpleInputEvents {
 public:
-    SimpleInputEvents();
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = 256 * 1024;
+    static constexpr uint32_t DEFAULT_MAX_EVENTS = 4096;
+
+    explicit SimpleInputEvents(size_t capacityBytes = DEFAULT_CAPACITY_BYTES,
+                               uint32_t maxEvents = DEFAULT_MAX_EVENTS);
+
+    SimpleInputEvents(const SimpleInputEvents&) = delete;
+    SimpleInputEvents& operator=(const SimpleInputEvents&) = delete;
 
     /// Add a note-on event
-    void addNoteOn(uint32_t time, int16_t port, int16_t channel,
+    bool addNoteOn(uint32_t time, int16_t port, int16_t channel,
                    int16_t key, int32_t noteId, double velocity);
 
     /// Add a note-off event
-    void addNoteOff(uint32_t time, int16_t port, int16_t channel,
+    bool addNoteOff(uint32_t time, int16_t port, int16_t channel,
                     int16_t key, int32_t noteId, double velocity);
 
-    /// Add a parameter value event
-    void addParamValue(uint32_t time, clap_id paramId, double value);
+    /// Add a note-choke event
+    bool addNoteChoke(uint32_t time, int16_t port, int16_t channel, int16_t key, int32_t noteId);
+
+    /// Add a note expression event
+    bool addNoteExpression(uint32_t time, clap_note_expression expressionId, int16_t port,
+                           int16_t channel, int16_t key, int32_t noteId, double value);
 
-    /// Clear all events
+    /// Add a parameter value event (global, or per-note when noteId/key are set)
+    bool addParamValue(uint32_t time, clap_id paramId, double value,
+                       int32_t noteId = -1, int16_t port = -1, int16_t channel = -1, int16_t key = -1);
+
+    /// Add a parameter modulation event
+    bool addParamMod(uint32_t time, clap_id paramId, double amount,
+                     int32_t noteId = -1, int16_t port = -1, int16_t channel = -1, int16_t key = -1);
+
+    /// Add a parameter gesture begin/end event
+    bool addParamGestureBegin(uint32_t time, clap_id paramId);
+    bool addParamGestureEnd(uint32_t time, clap_id paramId);
+
+    /// Add a transport event (the header is filled in from `time`)
+    bool addTransport(uint32_t time, const clap_event_transport_t& transport);
+
+    /// Add a MIDI 1.0 message
+    bool addMidi(uint32_t time, uint16_t port, uint8_t status, uint8_t data1, uint8_t data2);
+
+    /// Add a SysEx message; the bytes are copied into the arena
+    bool addMidiSysex(uint32_t time, uint16_t port, const uint8_t* data, uint32_t size);
+
+    /// Add a MIDI 2.0 UMP packet
+    bool addMidi2(uint32_t time, uint16_t port, const uint32_t data[4]);
+
+    /// Add a copy of any event (header->size bytes; pointers inside it are not followed)
+    bool add(const clap_event_header_t* event);
+
+    /// Remove all events (keeps the arena)
     void clear();
 
+    /// Number of events in the list
+    uint32_t count() const { return eventCount_; }
+
+    /// Events rejected because the arena or event table was full
+    uint64_t droppedCount() const { return dropped_; }
+
+    /// Arena size and bytes in use
+    size_t capacityBytes() const { return arena_.size(); }
+    size_t usedBytes() const { return used_; }
+
     const clap_input_events_t* get() const { return &events_; }
 
 private:
     clap_input_events_t events_;
-    std::vector<uint8_t> eventData_;
-    std::vector<size_t> eventOffsets_;  // Store offsets instead of pointers (buffer can reallocate!)
+    std::vector<uint8_t> arena_;
+    std::vector<uint32_t> order_;  // Arena offsets, sorted by event time
+    size_t used_ = 0;
+    uint32_t eventCount_ = 0;
+    uint64_t dropped_ = 0;
+
+    /// Reserve space for an event (plus `extra` payload bytes), fill in its
+    /// header and insert it in time order; nullptr if full
+    void* allocate(uint32_t time, uint16_t type, uint32_t size, size_t extra = 0);
 
     static uint32_t size(const clap_input_events_t* list);
     static const clap_event_header_t* getEvent(const clap_input_events_t* list, uint32_t index);
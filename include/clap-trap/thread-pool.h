@@ -0,0 +1,96 @@
+/**
+ * clap-trap: Thread Pool
+ *
+ * Work-stealing pool behind the host's clap_host_thread_pool extension.
+ * The thread that asks for work (the audio thread) takes part, so a pool
+ * with N workers runs tasks on up to N + 1 threads.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace clap_trap {
+
+class ThreadPool {
+public:
+    using Task = void (*)(void* context, uint32_t index);
+
+    /// Largest task count a single run() accepts
+    static constexpr uint32_t MAX_TASKS = (1u << 24) - 1;
+
+    struct Stats {
+        uint64_t runs = 0;      ///< Accepted run() calls
+        uint64_t rejected = 0;  ///< run() calls refused (nested, concurrent or too many tasks)
+        uint64_t tasks = 0;     ///< Tasks executed
+        uint64_t stolen = 0;    ///< Tasks taken from another thread's share
+        uint64_t taskNs = 0;    ///< Time spent inside tasks, summed over threads
+    };
+
+    /**
+     * Start `workers` threads. With `pin`, worker i is pinned to core
+     * (i + 1) modulo the core count, leaving core 0 to the caller.
+     */
+    explicit ThreadPool(uint32_t workers, bool pin = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Run task(context, i) for every i in [0, count) and wait for all of them.
+     *
+     * Each thread starts on its own contiguous share of the indices and steals
+     * from the far end of the others' once it runs out. Returns false without
+     * running anything if a run is already in progress (including from inside
+     * a task) or count exceeds MAX_TASKS.
+     */
+    bool run(uint32_t count, Task task, void* context);
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+    /// Totals since construction or the last resetStats() (call it between runs)
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Job {
+        Task task = nullptr;
+        void* context = nullptr;
+        std::atomic<uint32_t> remaining{0};
+    };
+
+    // One share of the current job: generation tag, first and end index
+    struct alignas(64) Share {
+        std::atomic<uint64_t> range{0};
+    };
+
+    // Per-thread counters, kept apart to avoid false sharing
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> taskNs{0};
+    };
+
+    void workerLoop(uint32_t index, bool pin);
+    void work(uint32_t self, uint32_t generation, Job& job);
+    bool take(uint32_t share, uint32_t generation, bool fromBack, uint32_t& index);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Share[]> shares_;         // One per participant; 0 is the caller
+    std::unique_ptr<Counters[]> counters_;
+    uint32_t participants_;
+    Job jobs_[2];                             // Double-buffered by generation
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<uint32_t> active_{0};         // Workers inside work()
+    std::atomic<bool> busy_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+} // namespace clap_trap
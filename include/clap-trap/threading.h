@@ -0,0 +1,39 @@
+/**
+ * clap-trap: Threading helpers
+ *
+ * Small platform wrappers used by the multi-threaded benchmarks.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace clap_trap {
+
+/// Number of hardware threads (at least 1)
+uint32_t hardwareThreadCount();
+
+/**
+ * Pin the calling thread to a single CPU core.
+ *
+ * On Linux and Windows this is a hard affinity; on macOS it is only an
+ * affinity hint. Returns false if the platform refused the request.
+ */
+bool pinCurrentThreadToCore(uint32_t core);
+
+/**
+ * Give the calling thread realtime scheduling for a periodic audio callback.
+ *
+ * Linux: SCHED_FIFO (needs CAP_SYS_NICE or an rtprio limit). macOS: the
+ * time-constraint policy for `periodNs`, half of it as computation budget.
+ * Windows: time-critical priority. `detail` describes the policy that was
+ * set, or why it was refused; the thread then keeps its normal priority.
+ */
+bool setCurrentThreadRealtime(uint64_t periodNs, std::string& detail);
+
+/// Sleep until an absolute time, on an absolute high-resolution timer where the platform has one
+void sleepUntil(std::chrono::steady_clock::time_point deadline);
+
+} // namespace clap_trap
@@ -5,12 +5,15 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace clap_trap {
 
+class Resampler;
+
 /**
  * WAV output format
  */
@@ -24,6 +27,9 @@ enum class WavFormat {
  *
  * Supports reading: 16-bit, 24-bit, 32-bit PCM and 32-bit float
  * Supports writing: 16-bit PCM and 32-bit float
+ *
+ * Holds the whole file in memory; use WavReader/WavWriter for long files,
+ * or MappedWavFile to read without a full copy.
  */
 class WavFile {
 public:
@@ -67,4 +73,210 @@ private:
     std::vector<float> samples_;
 };
 
+/**
+ * Memory-mapped WAV file
+ *
+ * Maps the file read-only (MAP_PRIVATE on POSIX, a file mapping on Windows)
+ * and converts samples straight from the mapped bytes with vectorized
+ * kernels. 32-bit float files can be read without any copy at all through
+ * floatData().
+ */
+class MappedWavFile {
+public:
+    /**
+     * Map a WAV file and parse its header
+     * @param path Path to WAV file
+     * @return MappedWavFile instance (check hasError() for success)
+     */
+    static std::unique_ptr<MappedWavFile> open(const std::string& path);
+
+    ~MappedWavFile();
+
+    MappedWavFile(const MappedWavFile&) = delete;
+    MappedWavFile& operator=(const MappedWavFile&) = delete;
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    uint32_t sampleRate() const { return sampleRate_; }
+    uint32_t channels() const { return channels_; }
+    uint64_t frameCount() const { return frameCount_; }
+    uint16_t bitsPerSample() const { return bitsPerSample_; }
+    bool isFloat() const { return audioFormat_ == 3; }
+
+    /**
+     * Zero-copy view of the samples
+     * @return Interleaved float samples inside the mapping, or nullptr unless
+     *         the file is 32-bit float with suitably aligned sample data
+     */
+    const float* floatData() const;
+
+    /**
+     * Convert frames to interleaved float [-1, 1]
+     * @param startFrame First frame to read
+     * @param interleaved Destination, at least frames * channels() floats
+     * @param frames Number of frames to read
+     * @return Number of frames actually read
+     */
+    uint64_t readInterleaved(uint64_t startFrame, float* interleaved, uint64_t frames) const;
+
+    /**
+     * Convert and deinterleave frames into one buffer per channel
+     * @param startFrame First frame to read
+     * @param channelData channels() destination pointers, each at least frames floats
+     * @param frames Number of frames to read
+     * @return Number of frames actually read
+     */
+    uint64_t readChannels(uint64_t startFrame, float* const* channelData, uint64_t frames) const;
+
+private:
+    MappedWavFile() = default;
+
+    std::string error_;
+    uint32_t sampleRate_ = 0;
+    uint32_t channels_ = 0;
+    uint16_t audioFormat_ = 0;
+    uint16_t bitsPerSample_ = 0;
+    uint16_t blockAlign_ = 0;
+    uint64_t frameCount_ = 0;
+
+    const uint8_t* base_ = nullptr;   // Start of the mapping
+    size_t mappedSize_ = 0;
+    const uint8_t* samples_ = nullptr; // Start of the data chunk payload
+#if defined(_WIN32)
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+/**
+ * Streaming WAV reader
+ *
+ * Parses the header on open, then converts samples chunk by chunk so memory
+ * use depends only on the chunk size, not on the length of the file.
+ * Supports the same formats as WavFile::load, and can convert the file to
+ * another sample rate as it streams (see resampleTo()).
+ */
+class WavReader {
+public:
+    /**
+     * Open a WAV file and parse its header
+     * @param path Path to WAV file
+     * @return WavReader instance (check hasError() for success)
+     */
+    static std::unique_ptr<WavReader> open(const std::string& path);
+
+    ~WavReader();
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    /// Rate, length and position of the frames read() returns
+    uint32_t sampleRate() const { return sampleRate_; }
+    uint32_t channels() const { return channels_; }
+    uint64_t frameCount() const { return frameCount_; }
+    uint64_t framesRemaining() const { return frameCount_ - framesRead_; }
+
+    /// Sample rate stored in the file
+    uint32_t fileSampleRate() const { return fileSampleRate_; }
+
+    /**
+     * Convert the file to another sample rate as it is read, through a
+     * streaming Resampler; sampleRate() and frameCount() then describe the
+     * converted stream. Does nothing if the rates already match.
+     * @return false if frames were already read or the reader has an error
+     */
+    bool resampleTo(uint32_t sampleRate);
+
+    /**
+     * Read the next frames as interleaved float [-1, 1]
+     * @param interleaved Destination, at least frames * channels() floats
+     * @param frames Maximum number of frames to read
+     * @return Number of frames actually read (0 at end of file, or after a
+     *         read error, which sets hasError())
+     */
+    uint32_t read(float* interleaved, uint32_t frames);
+
+private:
+    WavReader() = default;
+
+    uint32_t readFile(float* interleaved, uint32_t frames);
+
+    std::ifstream file_;
+    std::string error_;
+    uint32_t sampleRate_ = 0;
+    uint32_t channels_ = 0;
+    uint16_t audioFormat_ = 0;
+    uint16_t bitsPerSample_ = 0;
+    uint16_t blockAlign_ = 0;
+    uint64_t frameCount_ = 0;
+    uint64_t framesRead_ = 0;
+    std::vector<uint8_t> raw_;
+
+    // The file itself; differs from the above only while resampling
+    uint32_t fileSampleRate_ = 0;
+    uint64_t fileFrameCount_ = 0;
+    uint64_t fileFramesRead_ = 0;
+
+    std::unique_ptr<Resampler> resampler_;
+    std::vector<float> fileChunk_;  // File frames on their way into the resampler
+    bool fileEnded_ = false;
+};
+
+/**
+ * Streaming WAV writer
+ *
+ * Writes the header up front and appends samples as they arrive. The RIFF
+ * and data chunk sizes are patched in when the file is closed.
+ */
+class WavWriter {
+public:
+    /**
+     * Create a WAV file for writing
+     * @param path Output path
+     * @param sampleRate Sample rate in Hz
+     * @param channels Number of channels
+     * @param format Output format (Int16 or Float32)
+     * @return WavWriter instance (check hasError() for success)
+     */
+    static std::unique_ptr<WavWriter> open(const std::string& path, uint32_t sampleRate,
+                                           uint32_t channels, WavFormat format = WavFormat::Int16);
+
+    /// Closes the file if close() was not called explicitly
+    ~WavWriter();
+
+    bool hasError() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+    /**
+     * Append interleaved frames
+     * @param interleaved Source, frames * channels floats
+     * @param frames Number of frames
+     * @return true on success
+     */
+    bool write(const float* interleaved, uint32_t frames);
+
+    /**
+     * Patch the header sizes and close the file
+     * @return true if every write and the header update succeeded
+     */
+    bool close();
+
+    uint64_t framesWritten() const { return framesWritten_; }
+
+private:
+    WavWriter() = default;
+
+    std::ofstream file_;
+    std::string error_;
+    uint32_t channels_ = 0;
+    WavFormat format_ = WavFormat::Int16;
+    uint64_t framesWritten_ = 0;
+    bool closed_ = false;
+    std::vector<uint8_t> raw_;
+};
+
 } // namespace clap_trap
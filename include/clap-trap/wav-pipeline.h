@@ -0,0 +1,169 @@
+/**
+ * clap-trap: WAV Pipeline
+ *
+ * Read-ahead and write-behind wrappers around the streaming WAV classes.
+ * A background thread converts and writes file chunks while the caller
+ * processes, so disk time overlaps plugin time during offline renders.
+ *
+ * @code
+ * WavReadAhead input(WavReader::open("in.wav"));
+ * WavWriteBehind output(WavWriter::open("out.wav", rate, 2), 2);
+ * while (uint32_t frames = input.read(block.data(), 256)) {
+ *     ... process ...
+ *     output.write(block.data(), frames);
+ * }
+ * bool ok = output.close();
+ * @endcode
+ */
+
+#pragma once
+
+#include "wav-file.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clap_trap {
+
+/// Frames per chunk handed between the I/O thread and the caller
+constexpr uint32_t WAV_PIPELINE_CHUNK_FRAMES = 16384;
+
+/// Chunks in flight per direction
+constexpr uint32_t WAV_PIPELINE_DEPTH = 4;
+
+/**
+ * Reads a WavReader up to `depth` chunks ahead of the caller.
+ *
+ * The reader must have opened without error. read() is called from one
+ * thread; the destructor stops the background thread. A read error ends
+ * the stream early, like the end of the file, and sets hasError().
+ */
+class WavReadAhead {
+public:
+    explicit WavReadAhead(std::unique_ptr<WavReader> reader,
+                          uint32_t chunkFrames = WAV_PIPELINE_CHUNK_FRAMES,
+                          uint32_t depth = WAV_PIPELINE_DEPTH);
+    ~WavReadAhead();
+
+    WavReadAhead(const WavReadAhead&) = delete;
+    WavReadAhead& operator=(const WavReadAhead&) = delete;
+
+    uint32_t sampleRate() const { return sampleRate_; }
+    uint32_t channels() const { return channels_; }
+    uint64_t frameCount() const { return frameCount_; }
+
+    /**
+     * Read the next frames as interleaved float [-1, 1], waiting for the
+     * background thread if it has not got that far yet
+     * @param interleaved Destination, at least frames * channels() floats
+     * @param frames Maximum number of frames to read
+     * @return Number of frames actually read (0 at end of file)
+     */
+    uint32_t read(float* interleaved, uint32_t frames);
+
+    /// True once the background thread hit a read error; check it after the last read()
+    bool hasError() const { return failed_.load(std::memory_order_acquire); }
+
+    /// The reader's error, once hasError() is true
+    const std::string& getError() const { return error_; }
+
+private:
+    struct Chunk {
+        std::vector<float> samples;
+        uint32_t frames = 0;
+    };
+
+    void readLoop();
+
+    std::unique_ptr<WavReader> reader_;
+    uint32_t sampleRate_ = 0;
+    uint32_t channels_ = 0;
+    uint64_t frameCount_ = 0;
+    uint32_t chunkFrames_;
+    std::vector<Chunk> chunks_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    uint64_t filled_ = 0;    // Chunks the thread has read
+    uint64_t consumed_ = 0;  // Chunks the caller has finished with
+    bool stop_ = false;
+    std::string error_;                // Written before failed_ is set, never after
+    std::atomic<bool> failed_{false};
+
+    uint32_t position_ = 0;  // Caller: frames taken from the current chunk
+    bool ended_ = false;     // Caller: saw the end-of-file chunk
+    std::thread thread_;
+};
+
+/**
+ * Writes to a WavWriter up to `depth` chunks behind the caller.
+ *
+ * The writer must have opened without error. write() and close() are
+ * called from one thread. A write error is reported by the next write()
+ * after the thread noticed it, and always by close().
+ */
+class WavWriteBehind {
+public:
+    WavWriteBehind(std::unique_ptr<WavWriter> writer, uint32_t channels,
+                   uint32_t chunkFrames = WAV_PIPELINE_CHUNK_FRAMES,
+                   uint32_t depth = WAV_PIPELINE_DEPTH);
+
+    /// Closes the file if close() was not called explicitly
+    ~WavWriteBehind();
+
+    WavWriteBehind(const WavWriteBehind&) = delete;
+    WavWriteBehind& operator=(const WavWriteBehind&) = delete;
+
+    /**
+     * Queue interleaved frames, waiting if `depth` chunks are already queued
+     * @param interleaved Source, frames * channels floats
+     * @param frames Number of frames
+     * @return false once a write has failed
+     */
+    bool write(const float* interleaved, uint32_t frames);
+
+    /**
+     * Write what is queued, then patch the header and close the file
+     * @return true if every write and the header update succeeded
+     */
+    bool close();
+
+    /// Frames passed to write() so far
+    uint64_t framesQueued() const { return framesQueued_; }
+
+    /// The writer's error, once close() has returned
+    const std::string& getError() const { return writer_->getError(); }
+
+private:
+    struct Chunk {
+        std::vector<float> samples;
+        uint32_t frames = 0;
+    };
+
+    void submit();
+    void writeLoop();
+
+    std::unique_ptr<WavWriter> writer_;
+    uint32_t channels_;
+    uint32_t chunkFrames_;
+    std::vector<Chunk> chunks_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    uint64_t submitted_ = 0;  // Chunks the caller has filled
+    uint64_t written_ = 0;    // Chunks the thread has written
+    bool finish_ = false;
+    bool failed_ = false;
+
+    uint64_t framesQueued_ = 0;
+    bool closed_ = false;
+    bool ok_ = true;
+    std::thread thread_;
+};
+
+} // namespace clap_trap
@@ -3,148 +3,600 @@
  */
 
 #include "clap-trap/audio-buffers.h"
+#include "simd.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
 
 namespace clap_trap {
 
+//-----------------------------------------------------------------------------
+// Buffer analysis
+//-----------------------------------------------------------------------------
+
+namespace {
+
+// Running totals for analyzeSamples(). The kernels sum in float lanes, so
+// they are fed at most ANALYSIS_CHUNK samples at a time and flushed into
+// the double totals in between.
+struct AnalysisTotals {
+    float peak = 0.0f;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    uint64_t nanCount = 0;
+    uint64_t infCount = 0;
+    uint64_t denormalCount = 0;
+    bool hasNonZero = false;
+};
+
+constexpr uint32_t ANALYSIS_CHUNK = 1024;
+
+template<typename T>
+void analyzeScalar(const T* data, uint32_t count, AnalysisTotals& totals) {
+    constexpr T minNormal = std::numeric_limits<T>::min();
+    for (uint32_t i = 0; i < count; ++i) {
+        T sample = data[i];
+        T magnitude = std::fabs(sample);
+        if (sample != T(0)) totals.hasNonZero = true;
+        if (std::isnan(sample)) {
+            totals.nanCount++;
+            continue;
+        }
+        totals.peak = std::max(totals.peak, static_cast<float>(magnitude));
+        if (std::isinf(sample)) {
+            totals.infCount++;
+            continue;
+        }
+        if (magnitude < minNormal && sample != T(0)) totals.denormalCount++;
+        totals.sum += sample;
+        totals.sumSquares += static_cast<double>(sample) * sample;
+    }
+}
+
+#if defined(CLAP_TRAP_SIMD_X86)
+
+float horizontalSum(__m128 v) {
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+float horizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(v);
+}
+
+uint64_t horizontalCount(__m128i v) {
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+    return static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+uint32_t analyzeSse2(const float* data, uint32_t count, AnalysisTotals& totals) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 inf = _mm_set1_ps(INFINITY);
+    const __m128 minNormal = _mm_set1_ps(FLT_MIN);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 peak = zero, sum = zero, sumSquares = zero, nonZero = zero;
+    __m128i nans = _mm_setzero_si128(), infs = nans, denormals = nans;
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(data + i);
+        __m128 magnitude = _mm_and_ps(v, absMask);
+        __m128 isNan = _mm_cmpunord_ps(v, v);
+        __m128 isFinite = _mm_cmplt_ps(magnitude, inf);
+        __m128 isInf = _mm_cmpeq_ps(magnitude, inf);
+        __m128 notZero = _mm_cmpneq_ps(v, zero);
+        __m128 isDenormal = _mm_and_ps(_mm_cmplt_ps(magnitude, minNormal), notZero);
+
+        // maxps returns its second operand when the first is NaN
+        peak = _mm_max_ps(magnitude, peak);
+        nonZero = _mm_or_ps(nonZero, notZero);
+
+        __m128 finite = _mm_and_ps(v, isFinite);
+        sum = _mm_add_ps(sum, finite);
+        sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(finite, finite));
+
+        // Compare masks are -1 per true lane
+        nans = _mm_sub_epi32(nans, _mm_castps_si128(isNan));
+        infs = _mm_sub_epi32(infs, _mm_castps_si128(isInf));
+        denormals = _mm_sub_epi32(denormals, _mm_castps_si128(isDenormal));
+    }
+
+    totals.peak = std::max(totals.peak, horizontalMax(peak));
+    totals.sum += horizontalSum(sum);
+    totals.sumSquares += horizontalSum(sumSquares);
+    totals.nanCount += horizontalCount(nans);
+    totals.infCount += horizontalCount(infs);
+    totals.denormalCount += horizontalCount(denormals);
+    if (_mm_movemask_ps(nonZero)) totals.hasNonZero = true;
+    return i;
+}
+
+CLAP_TRAP_TARGET("avx2")
+uint32_t analyzeAvx2(const float* data, uint32_t count, AnalysisTotals& totals) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 minNormal = _mm256_set1_ps(FLT_MIN);
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 peak = zero, sum = zero, sumSquares = zero, nonZero = zero;
+    __m256i nans = _mm256_setzero_si256(), infs = nans, denormals = nans;
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(data + i);
+        __m256 magnitude = _mm256_and_ps(v, absMask);
+        __m256 isNan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        __m256 isFinite = _mm256_cmp_ps(magnitude, inf, _CMP_LT_OQ);
+        __m256 isInf = _mm256_cmp_ps(magnitude, inf, _CMP_EQ_OQ);
+        __m256 notZero = _mm256_cmp_ps(v, zero, _CMP_NEQ_UQ);
+        __m256 isDenormal = _mm256_and_ps(_mm256_cmp_ps(magnitude, minNormal, _CMP_LT_OQ), notZero);
+
+        peak = _mm256_max_ps(magnitude, peak);
+        nonZero = _mm256_or_ps(nonZero, notZero);
+
+        __m256 finite = _mm256_and_ps(v, isFinite);
+        sum = _mm256_add_ps(sum, finite);
+        sumSquares = _mm256_add_ps(sumSquares, _mm256_mul_ps(finite, finite));
+
+        nans = _mm256_sub_epi32(nans, _mm256_castps_si256(isNan));
+        infs = _mm256_sub_epi32(infs, _mm256_castps_si256(isInf));
+        denormals = _mm256_sub_epi32(denormals, _mm256_castps_si256(isDenormal));
+    }
+
+    // Fold to 128 bits and finish like the SSE2 kernel
+    __m128 peak128 = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+    __m128 sum128 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    __m128 sumSquares128 = _mm_add_ps(_mm256_castps256_ps128(sumSquares), _mm256_extractf128_ps(sumSquares, 1));
+    __m128i nans128 = _mm_add_epi32(_mm256_castsi256_si128(nans), _mm256_extracti128_si256(nans, 1));
+    __m128i infs128 = _mm_add_epi32(_mm256_castsi256_si128(infs), _mm256_extracti128_si256(infs, 1));
+    __m128i denormals128 = _mm_add_epi32(_mm256_castsi256_si128(denormals), _mm256_extracti128_si256(denormals, 1));
+
+    totals.peak = std::max(totals.peak, horizontalMax(peak128));
+    totals.sum += horizontalSum(sum128);
+    totals.sumSquares += horizontalSum(sumSquares128);
+    totals.nanCount += horizontalCount(nans128);
+    totals.infCount += horizontalCount(infs128);
+    totals.denormalCount += horizontalCount(denormals128);
+    if (_mm256_movemask_ps(nonZero)) totals.hasNonZero = true;
+    return i;
+}
+
+#elif defined(CLAP_TRAP_SIMD_NEON)
+
+uint32_t analyzeNeon(const float* data, uint32_t count, AnalysisTotals& totals) {
+    const float32x4_t inf = vdupq_n_f32(INFINITY);
+    const float32x4_t minNormal = vdupq_n_f32(FLT_MIN);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+
+    float32x4_t peak = zero, sum = zero, sumSquares = zero;
+    uint32x4_t nonZero = vdupq_n_u32(0), nans = nonZero, infs = nonZero, denormals = nonZero;
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(data + i);
+        float32x4_t magnitude = vabsq_f32(v);
+        uint32x4_t isNan = vmvnq_u32(vceqq_f32(v, v));
+        uint32x4_t isFinite = vcltq_f32(magnitude, inf);
+        uint32x4_t isInf = vceqq_f32(magnitude, inf);
+        uint32x4_t notZero = vmvnq_u32(vceqq_f32(v, zero));
+        uint32x4_t isDenormal = vandq_u32(vcltq_f32(magnitude, minNormal), notZero);
+
+        // vmaxnm ignores a NaN operand
+        peak = vmaxnmq_f32(peak, magnitude);
+        nonZero = vorrq_u32(nonZero, notZero);
+
+        float32x4_t finite = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), isFinite));
+        sum = vaddq_f32(sum, finite);
+        sumSquares = vfmaq_f32(sumSquares, finite, finite);
+
+        nans = vsubq_u32(nans, isNan);
+        infs = vsubq_u32(infs, isInf);
+        denormals = vsubq_u32(denormals, isDenormal);
+    }
+
+    totals.peak = std::max(totals.peak, vmaxvq_f32(peak));
+    totals.sum += vaddvq_f32(sum);
+    totals.sumSquares += vaddvq_f32(sumSquares);
+    totals.nanCount += vaddvq_u32(nans);
+    totals.infCount += vaddvq_u32(infs);
+    totals.denormalCount += vaddvq_u32(denormals);
+    if (vmaxvq_u32(nonZero)) totals.hasNonZero = true;
+    return i;
+}
+
+#endif
+
+void analyzeChannel(const float* data, uint32_t count, AnalysisTotals& totals) {
+#if defined(CLAP_TRAP_SIMD_X86)
+    static const auto kernel = simd::hasAvx2() ? analyzeAvx2 : analyzeSse2;
+#elif defined(CLAP_TRAP_SIMD_NEON)
+    constexpr auto kernel = analyzeNeon;
+#endif
+
+    for (uint32_t offset = 0; offset < count; offset += ANALYSIS_CHUNK) {
+        uint32_t chunk = std::min(ANALYSIS_CHUNK, count - offset);
+        uint32_t done = 0;
+#if defined(CLAP_TRAP_SIMD_X86) || defined(CLAP_TRAP_SIMD_NEON)
+        done = kernel(data + offset, chunk, totals);
+#endif
+        analyzeScalar(data + offset + done, chunk - done, totals);
+    }
+}
+
+} // anonymous namespace
+
+namespace {
+
+BufferStats finishStats(const AnalysisTotals& totals, uint64_t sampleCount) {
+    BufferStats stats;
+    stats.peak = totals.peak;
+    stats.nanCount = totals.nanCount;
+    stats.infCount = totals.infCount;
+    stats.denormalCount = totals.denormalCount;
+    stats.sampleCount = sampleCount;
+    stats.hasNonZero = totals.hasNonZero;
+
+    uint64_t finiteCount = stats.sampleCount - stats.nanCount - stats.infCount;
+    if (finiteCount > 0) {
+        stats.dc = totals.sum / static_cast<double>(finiteCount);
+        stats.rms = std::sqrt(totals.sumSquares / static_cast<double>(finiteCount));
+    }
+    return stats;
+}
+
+} // anonymous namespace
+
+BufferStats analyzeSamples(const float* const* channels, uint32_t channelCount, uint32_t frames) {
+    AnalysisTotals totals;
+    for (uint32_t ch = 0; ch < channelCount; ++ch) {
+        analyzeChannel(channels[ch], frames, totals);
+    }
+    return finishStats(totals, static_cast<uint64_t>(channelCount) * frames);
+}
+
+BufferStats analyzeSamples(const double* const* channels, uint32_t channelCount, uint32_t frames) {
+    // Double buffers only show up on the 64-bit path, which is not hot
+    // enough to warrant its own kernels
+    AnalysisTotals totals;
+    for (uint32_t ch = 0; ch < channelCount; ++ch) {
+        analyzeScalar(channels[ch], frames, totals);
+    }
+    return finishStats(totals, static_cast<uint64_t>(channelCount) * frames);
+}
+
+//-----------------------------------------------------------------------------
+// Sample precision
+//-----------------------------------------------------------------------------
+
+PrecisionSupport queryPrecisionSupport(const clap_plugin_t* plugin) {
+    PrecisionSupport support;
+    const auto* audioPorts = static_cast<const clap_plugin_audio_ports_t*>(
+        plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
+    if (!audioPorts) return support;
+
+    uint32_t portCount = 0;
+    bool allSupport = true;
+    for (bool isInput : {true, false}) {
+        uint32_t count = audioPorts->count(plugin, isInput);
+        for (uint32_t i = 0; i < count; ++i) {
+            clap_audio_port_info_t info{};
+            if (!audioPorts->get(plugin, i, isInput, &info)) continue;
+            portCount++;
+            if (!(info.flags & CLAP_AUDIO_PORT_SUPPORTS_64BITS)) allSupport = false;
+            if (info.flags & CLAP_AUDIO_PORT_PREFERS_64BITS) support.prefers64 = true;
+        }
+    }
+    support.supports64 = portCount > 0 && allSupport;
+    return support;
+}
+
+SamplePrecision negotiatePrecision(const PrecisionSupport& support, SamplePrecision requested) {
+    if (!support.supports64) return SamplePrecision::Float32;
+    if (requested == SamplePrecision::Float64) return SamplePrecision::Float64;
+    if (requested == SamplePrecision::Auto && support.prefers64) return SamplePrecision::Float64;
+    return SamplePrecision::Float32;
+}
+
+//-----------------------------------------------------------------------------
+// AlignedSlab
+//-----------------------------------------------------------------------------
+
+namespace {
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void* alignedAlloc(size_t bytes, size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, alignment, bytes) == 0 ? ptr : nullptr;
+#endif
+}
+
+void alignedFree(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Point `ptrs` at `count` channels of `blockSize` samples, either in their
+// own vectors or packed into `slab`
+template<typename T>
+void allocateChannels(BufferLayout layout, uint32_t blockSize, uint32_t count,
+                      std::vector<T>* separate, AlignedSlab& slab, T** ptrs) {
+    if (layout == BufferLayout::Separate) {
+        for (uint32_t ch = 0; ch < count; ++ch) {
+            separate[ch].assign(blockSize, T(0));
+            ptrs[ch] = separate[ch].data();
+        }
+        return;
+    }
+
+    size_t stride = paddedChannelStride(blockSize, sizeof(T));
+    size_t bytes = std::max<size_t>(stride * count, 1) * sizeof(T);
+    if (!slab.allocate(bytes, layout == BufferLayout::ContiguousHugePages)) {
+        throw std::bad_alloc();
+    }
+    T* base = static_cast<T*>(slab.data());
+    for (uint32_t ch = 0; ch < count; ++ch) {
+        ptrs[ch] = base + ch * stride;
+    }
+}
+
+// Hand the channel pointers to CLAP as data32 or data64
+void setChannelPointers(clap_audio_buffer_t& buffer, float** ptrs) {
+    buffer.data32 = ptrs;
+    buffer.data64 = nullptr;
+}
+
+void setChannelPointers(clap_audio_buffer_t& buffer, double** ptrs) {
+    buffer.data32 = nullptr;
+    buffer.data64 = ptrs;
+}
+
+// constant_mask with a bit for each of the first `channels` channels (it holds 64)
+uint64_t constantMask(uint32_t channels) {
+    return channels >= 64 ? ~0ull : (1ull << channels) - 1;
+}
+
+} // anonymous namespace
+
+size_t paddedChannelStride(uint32_t blockSize, size_t sampleSize) {
+    size_t lineSamples = AlignedSlab::ALIGNMENT / sampleSize;
+    size_t stride = roundUp(std::max<uint32_t>(blockSize, 1), lineSamples);
+    if ((stride * sampleSize) % 4096 == 0) {
+        stride += lineSamples;
+    }
+    return stride;
+}
+
+AlignedSlab::~AlignedSlab() {
+    release();
+}
+
+bool AlignedSlab::allocate(size_t bytes, bool hugePages) {
+    release();
+    size_t size = roundUp(bytes, ALIGNMENT);
+
+    if (hugePages) {
+#if defined(__linux__)
+        constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+        size_t mapped = roundUp(size, HUGE_PAGE_SIZE);
+        void* ptr = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            data_ = ptr;
+            size_ = size;
+            mappedSize_ = mapped;
+            kind_ = Kind::HugePages;
+            return true;
+        }
+
+        // No reserved huge pages: ask for transparent huge pages instead
+        ptr = alignedAlloc(mapped, HUGE_PAGE_SIZE);
+        if (ptr) {
+            madvise(ptr, mapped, MADV_HUGEPAGE);
+            std::memset(ptr, 0, mapped);
+            data_ = ptr;
+            size_ = size;
+            mappedSize_ = mapped;
+            kind_ = Kind::Heap;
+            return true;
+        }
+#elif defined(_WIN32)
+        // Only succeeds when the process holds SeLockMemoryPrivilege
+        size_t largePage = GetLargePageMinimum();
+        if (largePage > 0) {
+            size_t mapped = roundUp(size, largePage);
+            void* ptr = VirtualAlloc(nullptr, mapped, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                     PAGE_READWRITE);
+            if (ptr) {
+                data_ = ptr;
+                size_ = size;
+                mappedSize_ = mapped;
+                kind_ = Kind::HugePages;
+                return true;
+            }
+        }
+#endif
+    }
+
+    void* ptr = alignedAlloc(size, ALIGNMENT);
+    if (!ptr) return false;
+    std::memset(ptr, 0, size);
+    data_ = ptr;
+    size_ = size;
+    mappedSize_ = size;
+    kind_ = Kind::Heap;
+    return true;
+}
+
+void AlignedSlab::release() {
+    if (kind_ == Kind::HugePages) {
+#if defined(_WIN32)
+        VirtualFree(data_, 0, MEM_RELEASE);
+#else
+        munmap(data_, mappedSize_);
+#endif
+    } else if (kind_ == Kind::Heap) {
+        alignedFree(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mappedSize_ = 0;
+    kind_ = Kind::None;
+}
+
 //-----------------------------------------------------------------------------
 // StereoAudioBuffers
 //-----------------------------------------------------------------------------
 
-StereoAudioBuffers::StereoAudioBuffers(uint32_t blockSize) : blockSize_(blockSize) {
+template<typename T>
+BasicStereoAudioBuffers<T>::BasicStereoAudioBuffers(uint32_t blockSize, BufferLayout layout)
+    : blockSize_(blockSize), layout_(layout) {
+    // Inputs first, then outputs
+    T* ptrs[NUM_CHANNELS * 2];
+    allocateChannels(layout, blockSize, NUM_CHANNELS * 2, separateData_, slab_, ptrs);
     for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        inputData_[ch].resize(blockSize, 0.0f);
-        outputData_[ch].resize(blockSize, 0.0f);
-        inputPtrs_[ch] = inputData_[ch].data();
-        outputPtrs_[ch] = outputData_[ch].data();
+        inputPtrs_[ch] = ptrs[ch];
+        outputPtrs_[ch] = ptrs[NUM_CHANNELS + ch];
     }
 
-    inputBuffer_.data32 = inputPtrs_;
-    inputBuffer_.data64 = nullptr;
+    setChannelPointers(inputBuffer_, inputPtrs_);
     inputBuffer_.channel_count = NUM_CHANNELS;
     inputBuffer_.latency = 0;
     inputBuffer_.constant_mask = 0;
 
-    outputBuffer_.data32 = outputPtrs_;
-    outputBuffer_.data64 = nullptr;
+    setChannelPointers(outputBuffer_, outputPtrs_);
     outputBuffer_.channel_count = NUM_CHANNELS;
     outputBuffer_.latency = 0;
     outputBuffer_.constant_mask = 0;
 }
 
-void StereoAudioBuffers::fillInputWithSine(float frequency, float sampleRate, float amplitude) {
+template<typename T>
+void BasicStereoAudioBuffers<T>::fillInputWithSine(float frequency, float sampleRate, float amplitude) {
     constexpr float PI = 3.14159265358979323846f;
     for (uint32_t i = 0; i < blockSize_; ++i) {
         float sample = amplitude * std::sin(2.0f * PI * frequency * static_cast<float>(i) / sampleRate);
         for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-            inputData_[ch][i] = sample;
+            inputPtrs_[ch][i] = sample;
         }
     }
+    inputBuffer_.constant_mask = 0;
 }
 
-void StereoAudioBuffers::clearInput() {
+template<typename T>
+void BasicStereoAudioBuffers<T>::fillInputWithConstant(T value) {
     for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        std::fill(inputData_[ch].begin(), inputData_[ch].end(), 0.0f);
+        std::fill_n(inputPtrs_[ch], blockSize_, value);
     }
+    inputBuffer_.constant_mask = constantMask(NUM_CHANNELS);
 }
 
-void StereoAudioBuffers::clearOutput() {
+template<typename T>
+void BasicStereoAudioBuffers<T>::clearInput() {
     for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        std::fill(outputData_[ch].begin(), outputData_[ch].end(), 0.0f);
+        std::fill_n(inputPtrs_[ch], blockSize_, T(0));
     }
 }
 
-bool StereoAudioBuffers::outputHasNonZero() const {
+template<typename T>
+void BasicStereoAudioBuffers<T>::clearOutput() {
     for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        for (const auto& sample : outputData_[ch]) {
-            if (sample != 0.0f) return true;
-        }
+        std::fill_n(outputPtrs_[ch], blockSize_, T(0));
     }
-    return false;
 }
 
-bool StereoAudioBuffers::outputIsValid() const {
-    for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        for (const auto& sample : outputData_[ch]) {
-            if (std::isnan(sample) || std::isinf(sample)) return false;
-        }
-    }
-    return true;
+template<typename T>
+BufferStats BasicStereoAudioBuffers<T>::analyzeOutput() const {
+    return analyzeSamples(outputPtrs_, NUM_CHANNELS, blockSize_);
 }
 
-float StereoAudioBuffers::outputPeakAmplitude() const {
-    float peak = 0.0f;
-    for (uint32_t ch = 0; ch < NUM_CHANNELS; ++ch) {
-        for (const auto& sample : outputData_[ch]) {
-            peak = std::max(peak, std::abs(sample));
-        }
-    }
-    return peak;
-}
+template class BasicStereoAudioBuffers<float>;
+template class BasicStereoAudioBuffers<double>;
 
 //-----------------------------------------------------------------------------
 // AudioBuffers
 //-----------------------------------------------------------------------------
 
-AudioBuffers::AudioBuffers(uint32_t blockSize, uint32_t inputChannels, uint32_t outputChannels)
-    : blockSize_(blockSize), inputChannels_(inputChannels), outputChannels_(outputChannels) {
-
-    inputData_.resize(inputChannels);
-    inputPtrs_.resize(inputChannels);
-    for (uint32_t ch = 0; ch < inputChannels; ++ch) {
-        inputData_[ch].resize(blockSize, 0.0f);
-        inputPtrs_[ch] = inputData_[ch].data();
-    }
+template<typename T>
+BasicAudioBuffers<T>::BasicAudioBuffers(uint32_t blockSize, uint32_t inputChannels,
+                                        uint32_t outputChannels, BufferLayout layout)
+    : blockSize_(blockSize), inputChannels_(inputChannels), outputChannels_(outputChannels),
+      layout_(layout) {
 
-    outputData_.resize(outputChannels);
-    outputPtrs_.resize(outputChannels);
-    for (uint32_t ch = 0; ch < outputChannels; ++ch) {
-        outputData_[ch].resize(blockSize, 0.0f);
-        outputPtrs_[ch] = outputData_[ch].data();
+    // Inputs first, then outputs
+    uint32_t total = inputChannels + outputChannels;
+    std::vector<T*> ptrs(total);
+    if (layout == BufferLayout::Separate) {
+        separateData_.resize(total);
     }
+    allocateChannels(layout, blockSize, total, separateData_.data(), slab_, ptrs.data());
+    inputPtrs_.assign(ptrs.begin(), ptrs.begin() + inputChannels);
+    outputPtrs_.assign(ptrs.begin() + inputChannels, ptrs.end());
 
-    inputBuffer_.data32 = inputPtrs_.data();
-    inputBuffer_.data64 = nullptr;
+    setChannelPointers(inputBuffer_, inputPtrs_.data());
     inputBuffer_.channel_count = inputChannels;
     inputBuffer_.latency = 0;
     inputBuffer_.constant_mask = 0;
 
-    outputBuffer_.data32 = outputPtrs_.data();
-    outputBuffer_.data64 = nullptr;
+    setChannelPointers(outputBuffer_, outputPtrs_.data());
     outputBuffer_.channel_count = outputChannels;
     outputBuffer_.latency = 0;
     outputBuffer_.constant_mask = 0;
 }
 
-void AudioBuffers::clearInput() {
-    for (auto& ch : inputData_) {
-        std::fill(ch.begin(), ch.end(), 0.0f);
+template<typename T>
+void BasicAudioBuffers<T>::fillInputWithConstant(T value) {
+    for (T* ch : inputPtrs_) {
+        std::fill_n(ch, blockSize_, value);
     }
+    inputBuffer_.constant_mask = constantMask(inputChannels_);
 }
 
-void AudioBuffers::clearOutput() {
-    for (auto& ch : outputData_) {
-        std::fill(ch.begin(), ch.end(), 0.0f);
+template<typename T>
+void BasicAudioBuffers<T>::clearInput() {
+    for (T* ch : inputPtrs_) {
+        std::fill_n(ch, blockSize_, T(0));
     }
 }
 
-bool AudioBuffers::outputHasNonZero() const {
-    for (const auto& ch : outputData_) {
-        for (const auto& sample : ch) {
-            if (sample != 0.0f) return true;
-        }
+template<typename T>
+void BasicAudioBuffers<T>::clearOutput() {
+    for (T* ch : outputPtrs_) {
+        std::fill_n(ch, blockSize_, T(0));
     }
-    return false;
 }
 
-bool AudioBuffers::outputIsValid() const {
-    for (const auto& ch : outputData_) {
-        for (const auto& sample : ch) {
-            if (std::isnan(sample) || std::isinf(sample)) return false;
-        }
-    }
-    return true;
+template<typename T>
+BufferStats BasicAudioBuffers<T>::analyzeOutput() const {
+    return analyzeSamples(outputPtrs_.data(), outputChannels_, blockSize_);
 }
 
+template class BasicAudioBuffers<float>;
+template class BasicAudioBuffers<double>;
+
 } // namespace clap_trap
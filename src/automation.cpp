@@ -0,0 +1,83 @@
+/**
+ * clap-trap: Automation Implementation
+ */
+
+#include "clap-trap/automation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clap_trap {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double RAMP_HZ = 1.0;
+constexpr double LFO_HZ = 5.0;
+constexpr double WALK_STEP = 0.02;  // Largest random step, as a fraction of the range
+
+} // namespace
+
+AutomationGenerator::AutomationGenerator(std::vector<AutomationLane> lanes, double sampleRate,
+                                         uint32_t eventsPerBlock, uint64_t seed)
+    : lanes_(std::move(lanes))
+    , walk_(lanes_.size(), 0.5)
+    , sampleRate_(sampleRate)
+    , eventsPerBlock_(std::max(1u, eventsPerBlock))
+    , rng_(seed) {}
+
+uint32_t AutomationGenerator::eventsForBlock(uint32_t frames) const {
+    return std::min(eventsPerBlock_, frames) * static_cast<uint32_t>(lanes_.size());
+}
+
+double AutomationGenerator::position(size_t index, uint64_t sample) {
+    double seconds = static_cast<double>(sample) / sampleRate_;
+    switch (lanes_[index].shape) {
+        case AutomationShape::Ramp: {
+            double phase = seconds * RAMP_HZ - std::floor(seconds * RAMP_HZ);
+            return phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase;
+        }
+        case AutomationShape::Lfo:
+            return 0.5 + 0.5 * std::sin(2.0 * PI * LFO_HZ * seconds);
+        case AutomationShape::Random: {
+            std::uniform_real_distribution<double> step(-WALK_STEP, WALK_STEP);
+            double next = walk_[index] + step(rng_);
+            if (next < 0.0) next = -next;
+            if (next > 1.0) next = 2.0 - next;
+            walk_[index] = next;
+            return next;
+        }
+    }
+    return 0.5;
+}
+
+uint32_t AutomationGenerator::fillBlock(SimpleInputEvents& events, uint32_t frames) {
+    uint32_t perLane = std::min(eventsPerBlock_, frames);
+    uint32_t added = 0;
+
+    // Time-major, so every event is appended at the end of the sorted list
+    for (uint32_t k = 0; k < perLane; ++k) {
+        uint32_t offset = static_cast<uint32_t>(static_cast<uint64_t>(k) * frames / perLane);
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            const auto& lane = lanes_[i];
+            double range = lane.maxValue - lane.minValue;
+            double pos = position(i, sampleTime_ + offset);
+
+            bool ok;
+            if (lane.modulation) {
+                double amount = (pos - 0.5) * range;
+                if (lane.stepped) amount = std::round(amount);
+                ok = events.addParamMod(offset, lane.paramId, amount);
+            } else {
+                double value = lane.minValue + pos * range;
+                if (lane.stepped) value = std::round(value);
+                ok = events.addParamValue(offset, lane.paramId, value);
+            }
+            if (ok) added++;
+        }
+    }
+
+    sampleTime_ += frames;
+    return added;
+}
+
+} // namespace clap_trap
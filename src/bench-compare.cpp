@@ -0,0 +1,147 @@
+/**
+ * clap-trap: Benchmark Comparison Implementation
+ */
+
+#include "clap-trap/bench-compare.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace clap_trap {
+
+namespace {
+
+double medianOf(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    double upper = values[mid];
+    if (values.size() % 2 == 1) return upper;
+    double lower = *std::max_element(values.begin(), values.begin() + mid);
+    return (lower + upper) / 2.0;
+}
+
+} // namespace
+
+RankTestResult mannWhitneyU(const std::vector<HistogramBucket>& baseline,
+                            const std::vector<HistogramBucket>& current) {
+    // Merge both bucket lists by value; each bucket is one group of ties
+    struct Group {
+        uint64_t lower;
+        double a;  // baseline count
+        double b;  // current count
+    };
+    std::vector<Group> groups;
+    groups.reserve(baseline.size() + current.size());
+    for (const auto& bucket : baseline) groups.push_back({bucket.lowerNs, double(bucket.count), 0.0});
+    for (const auto& bucket : current) groups.push_back({bucket.lowerNs, 0.0, double(bucket.count)});
+    std::sort(groups.begin(), groups.end(), [](const Group& x, const Group& y) { return x.lower < y.lower; });
+
+    double n1 = 0.0, n2 = 0.0;
+    double rankSum = 0.0;   // Sum of current ranks
+    double tieTerm = 0.0;   // Sum of t^3 - t over tie groups
+    double rank = 0.0;      // Ranks used so far
+    for (size_t i = 0; i < groups.size();) {
+        double a = 0.0, b = 0.0;
+        uint64_t lower = groups[i].lower;
+        for (; i < groups.size() && groups[i].lower == lower; ++i) {
+            a += groups[i].a;
+            b += groups[i].b;
+        }
+        double t = a + b;
+        double midRank = rank + (t + 1.0) / 2.0;
+        rankSum += b * midRank;
+        tieTerm += t * t * t - t;
+        rank += t;
+        n1 += a;
+        n2 += b;
+    }
+
+    RankTestResult result;
+    if (n1 == 0.0 || n2 == 0.0) return result;
+
+    double n = n1 + n2;
+    result.u = rankSum - n2 * (n2 + 1.0) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+    if (variance <= 0.0) return result;
+
+    // Continuity corrected; large U means current ranks higher (slower)
+    result.z = (result.u - mean - 0.5) / std::sqrt(variance);
+    result.pValue = 0.5 * std::erfc(result.z / std::sqrt(2.0));
+    return result;
+}
+
+bool bootstrapChangeInterval(const std::vector<uint64_t>& baseline, const std::vector<uint64_t>& current,
+                             double confidence, double& low, double& high,
+                             uint32_t resamples, uint64_t seed) {
+    if (baseline.size() < 2 || current.size() < 2 || resamples == 0) return false;
+
+    std::mt19937_64 rng(seed);
+    auto resampleMedian = [&rng](const std::vector<uint64_t>& runs, std::vector<double>& scratch) {
+        std::uniform_int_distribution<size_t> pick(0, runs.size() - 1);
+        scratch.resize(runs.size());
+        for (auto& value : scratch) value = static_cast<double>(runs[pick(rng)]);
+        return medianOf(scratch);
+    };
+
+    std::vector<double> changes;
+    changes.reserve(resamples);
+    std::vector<double> scratch;
+    for (uint32_t r = 0; r < resamples; ++r) {
+        double base = resampleMedian(baseline, scratch);
+        double cur = resampleMedian(current, scratch);
+        if (base > 0.0) changes.push_back(cur / base - 1.0);
+    }
+    if (changes.empty()) return false;
+
+    std::sort(changes.begin(), changes.end());
+    double tail = (1.0 - confidence) / 2.0;
+    auto at = [&](double q) {
+        size_t index = static_cast<size_t>(q * static_cast<double>(changes.size() - 1) + 0.5);
+        return changes[std::min(index, changes.size() - 1)];
+    };
+    low = at(tail);
+    high = at(1.0 - tail);
+    return true;
+}
+
+bool isNoisyFirstRun(const std::vector<uint64_t>& runMedians, double tolerance, double* deviation) {
+    if (runMedians.size() < 3) return false;
+
+    std::vector<double> rest(runMedians.begin() + 1, runMedians.end());
+    double center = medianOf(rest);
+    if (center <= 0.0) return false;
+
+    std::vector<double> spread;
+    spread.reserve(rest.size());
+    for (double value : rest) spread.push_back(std::fabs(value - center));
+    double mad = medianOf(spread);
+
+    double offset = static_cast<double>(runMedians[0]) - center;
+    if (deviation) *deviation = offset / center;
+    return std::fabs(offset) > std::max(tolerance * center, 3.0 * mad);
+}
+
+TimingComparison compareTimings(const TimingStats& baseline, const TimingStats& current,
+                                double threshold, double alpha) {
+    TimingComparison result;
+    result.baselineMedianNs = static_cast<double>(baseline.p50Ns);
+    result.currentMedianNs = static_cast<double>(current.p50Ns);
+    if (result.baselineMedianNs > 0.0) {
+        result.change = result.currentMedianNs / result.baselineMedianNs - 1.0;
+    }
+
+    result.pValue = mannWhitneyU(baseline.histogram, current.histogram).pValue;
+    double fasterP = mannWhitneyU(current.histogram, baseline.histogram).pValue;
+    result.hasInterval = bootstrapChangeInterval(baseline.runMediansNs, current.runMediansNs, 0.95,
+                                                 result.changeLow, result.changeHigh);
+
+    bool slowerBeyondNoise = !result.hasInterval || result.changeLow > 0.0;
+    bool fasterBeyondNoise = !result.hasInterval || result.changeHigh < 0.0;
+    result.regressed = result.change > threshold && result.pValue < alpha && slowerBeyondNoise;
+    result.improved = result.change < -threshold && fasterP < alpha && fasterBeyondNoise;
+    return result;
+}
+
+} // namespace clap_trap
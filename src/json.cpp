@@ -0,0 +1,358 @@
+/**
+ * clap-trap: JSON Implementation
+ */
+
+#include "clap-trap/json.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace clap_trap {
+
+Json Json::array() {
+    Json value;
+    value.type_ = Type::Array;
+    return value;
+}
+
+Json Json::object() {
+    Json value;
+    value.type_ = Type::Object;
+    return value;
+}
+
+Json& Json::push(Json value) {
+    if (type_ != Type::Array) *this = array();
+    items_.push_back(std::move(value));
+    return items_.back();
+}
+
+Json& Json::set(std::string key, Json value) {
+    if (type_ != Type::Object) *this = object();
+    for (auto& member : members_) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return *this;
+        }
+    }
+    members_.emplace_back(std::move(key), std::move(value));
+    return *this;
+}
+
+const Json* Json::get(std::string_view key) const {
+    for (const auto& member : members_) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+Json* Json::get(std::string_view key) {
+    for (auto& member : members_) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Serialization
+//-----------------------------------------------------------------------------
+
+namespace {
+
+void writeString(std::string& out, const std::string& s) {
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+void writeNumber(std::string& out, double value) {
+    // JSON has no NaN or Inf
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    std::to_chars_result result;
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+        result = std::to_chars(buf, buf + sizeof(buf), static_cast<int64_t>(value));
+    } else {
+        result = std::to_chars(buf, buf + sizeof(buf), value);
+    }
+    out.append(buf, result.ptr);
+}
+
+void newline(std::string& out, int indent, int depth) {
+    if (indent < 0) return;
+    out += '\n';
+    out.append(static_cast<size_t>(indent * depth), ' ');
+}
+
+} // namespace
+
+void Json::dumpTo(std::string& out, int indent, int depth) const {
+    switch (type_) {
+        case Type::Null:   out += "null"; break;
+        case Type::Bool:   out += bool_ ? "true" : "false"; break;
+        case Type::Number: writeNumber(out, number_); break;
+        case Type::String: writeString(out, string_); break;
+        case Type::Array:
+            if (items_.empty()) {
+                out += "[]";
+                break;
+            }
+            out += '[';
+            for (size_t i = 0; i < items_.size(); ++i) {
+                if (i > 0) out += ',';
+                newline(out, indent, depth + 1);
+                items_[i].dumpTo(out, indent, depth + 1);
+            }
+            newline(out, indent, depth);
+            out += ']';
+            break;
+        case Type::Object:
+            if (members_.empty()) {
+                out += "{}";
+                break;
+            }
+            out += '{';
+            for (size_t i = 0; i < members_.size(); ++i) {
+                if (i > 0) out += ',';
+                newline(out, indent, depth + 1);
+                writeString(out, members_[i].first);
+                out += indent < 0 ? ":" : ": ";
+                members_[i].second.dumpTo(out, indent, depth + 1);
+            }
+            newline(out, indent, depth);
+            out += '}';
+            break;
+    }
+}
+
+std::string Json::dump(int indent) const {
+    std::string out;
+    dumpTo(out, indent, 0);
+    return out;
+}
+
+//-----------------------------------------------------------------------------
+// Parsing
+//-----------------------------------------------------------------------------
+
+namespace {
+
+class Parser {
+public:
+    explicit Parser(std::string_view text) : text_(text) {}
+
+    bool parseDocument(Json& out) {
+        if (!parseValue(out, 0)) return false;
+        skipSpace();
+        if (pos_ != text_.size()) return fail("Unexpected trailing characters");
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    static constexpr int MAX_DEPTH = 256;
+
+    bool fail(const char* message) {
+        if (error_.empty()) {
+            error_ = std::string(message) + " at offset " + std::to_string(pos_);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            pos_++;
+        }
+    }
+
+    bool consume(std::string_view literal) {
+        if (text_.substr(pos_, literal.size()) != literal) return false;
+        pos_ += literal.size();
+        return true;
+    }
+
+    bool parseValue(Json& out, int depth) {
+        if (depth > MAX_DEPTH) return fail("Nesting too deep");
+        skipSpace();
+        if (pos_ >= text_.size()) return fail("Unexpected end of input");
+
+        char c = text_[pos_];
+        if (c == '{') return parseObject(out, depth);
+        if (c == '[') return parseArray(out, depth);
+        if (c == '"') {
+            std::string s;
+            if (!parseString(s)) return false;
+            out = Json(std::move(s));
+            return true;
+        }
+        if (consume("true")) { out = Json(true); return true; }
+        if (consume("false")) { out = Json(false); return true; }
+        if (consume("null")) { out = Json(); return true; }
+        return parseNumber(out);
+    }
+
+    bool parseNumber(Json& out) {
+        size_t start = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-') pos_++;
+        while (pos_ < text_.size() && std::string_view("0123456789.eE+-").find(text_[pos_]) != std::string_view::npos) {
+            pos_++;
+        }
+        double value = 0.0;
+        auto result = std::from_chars(text_.data() + start, text_.data() + pos_, value);
+        if (start == pos_ || result.ec != std::errc() || result.ptr != text_.data() + pos_) {
+            pos_ = start;
+            return fail("Invalid value");
+        }
+        out = Json(value);
+        return true;
+    }
+
+    bool parseHex4(uint32_t& value) {
+        if (pos_ + 4 > text_.size()) return fail("Truncated \\u escape");
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+            else return fail("Invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        pos_++;  // Opening quote
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) break;
+            char e = text_[pos_++];
+            switch (e) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if (!parseHex4(cp)) return false;
+                    if (cp >= 0xD800 && cp < 0xDC00 && consume("\\u")) {
+                        uint32_t low = 0;
+                        if (!parseHex4(low)) return false;
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool parseArray(Json& out, int depth) {
+        pos_++;  // [
+        out = Json::array();
+        skipSpace();
+        if (consume("]")) return true;
+        while (true) {
+            Json item;
+            if (!parseValue(item, depth + 1)) return false;
+            out.push(std::move(item));
+            skipSpace();
+            if (consume("]")) return true;
+            if (!consume(",")) return fail("Expected ',' or ']'");
+        }
+    }
+
+    bool parseObject(Json& out, int depth) {
+        pos_++;  // {
+        out = Json::object();
+        skipSpace();
+        if (consume("}")) return true;
+        while (true) {
+            skipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') return fail("Expected member name");
+            std::string key;
+            if (!parseString(key)) return false;
+            skipSpace();
+            if (!consume(":")) return fail("Expected ':'");
+            Json value;
+            if (!parseValue(value, depth + 1)) return false;
+            out.set(std::move(key), std::move(value));
+            skipSpace();
+            if (consume("}")) return true;
+            if (!consume(",")) return fail("Expected ',' or '}'");
+        }
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+} // namespace
+
+Json Json::parse(std::string_view text, std::string* error) {
+    Parser parser(text);
+    Json result;
+    if (!parser.parseDocument(result)) {
+        if (error) *error = parser.error();
+        return Json();
+    }
+    if (error) error->clear();
+    return result;
+}
+
+} // namespace clap_trap
@@ -0,0 +1,62 @@
+/**
+ * clap-trap: Latency Histogram Implementation
+ */
+
+#include "clap-trap/latency-histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clap_trap {
+
+LatencyHistogram::LatencyHistogram() : counts_(BUCKET_COUNT, 0) {}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+    if (total_ == 0) return 0;
+
+    double clamped = std::clamp(percentile, 0.0, 100.0);
+    uint64_t rank = static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total_)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t cumulative = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        cumulative += counts_[i];
+        if (cumulative >= rank) {
+            return std::clamp(bucketUpperBound(i), min_, max_);
+        }
+    }
+    return max_;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(uint32_t index) {
+    if (index < SUB_BUCKET_COUNT) return index;
+    uint32_t group = index / SUB_BUCKET_COUNT;
+    uint32_t sub = index % SUB_BUCKET_COUNT;
+    uint32_t shift = group - 1;
+    return static_cast<uint64_t>(SUB_BUCKET_COUNT + sub) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(uint32_t index) {
+    if (index < SUB_BUCKET_COUNT) return index;
+    uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+    return bucketLowerBound(index) + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+} // namespace clap_trap
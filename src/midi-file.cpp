@@ -274,32 +274,29 @@ void MidiFile::computeTimes() {
         timeMap.push_back({tempo.tick, cumulativeSeconds, currentTempo});
     }
 
-    // Helper to convert tick to seconds
-    auto tickToSeconds = [&](uint32_t tick) -> double {
-        // Find the tempo region containing this tick
-        size_t idx = 0;
-        for (size_t i = 1; i < timeMap.size(); ++i) {
-            if (timeMap[i].tick > tick) break;
-            idx = i;
-        }
-
+    // Convert a tick within the tempo region starting at timeMap[idx]
+    auto regionToSeconds = [&](size_t idx, uint32_t tick) -> double {
         const auto& tp = timeMap[idx];
         uint32_t deltaTicks = tick - tp.tick;
         return tp.seconds + (deltaTicks * static_cast<double>(tp.microsecondsPerQuarter)) /
                            (ticksPerQuarter_ * 1000000.0);
     };
 
-    // Compute time for each event
+    // Events are sorted by tick, so walk them and the tempo map together
+    size_t region = 0;
+    uint32_t maxTick = 0;
     for (auto& event : events_) {
-        event.secondTime = tickToSeconds(event.tickTime);
+        while (region + 1 < timeMap.size() && timeMap[region + 1].tick <= event.tickTime) {
+            ++region;
+        }
+        event.secondTime = regionToSeconds(region, event.tickTime);
+        maxTick = std::max(maxTick, event.tickTime);
     }
 
     // Compute total duration from the maximum tick time
-    uint32_t maxTick = 0;
-    for (const auto& event : events_) {
-        maxTick = std::max(maxTick, event.tickTime);
-    }
-    durationSeconds_ = tickToSeconds(maxTick);
+    auto last = std::upper_bound(timeMap.begin(), timeMap.end(), maxTick,
+                                 [](uint32_t tick, const TimePoint& tp) { return tick < tp.tick; });
+    durationSeconds_ = regionToSeconds(static_cast<size_t>(last - timeMap.begin()) - 1, maxTick);
 
     // Update reported tempo to the initial tempo
     if (!tempoMap_.empty()) {
@@ -317,6 +314,44 @@ std::vector<MidiEvent> MidiFile::noteEvents() const {
     return notes;
 }
 
+//-----------------------------------------------------------------------------
+// MidiSchedule
+//-----------------------------------------------------------------------------
+
+MidiSchedule::MidiSchedule(const std::vector<MidiEvent>& events, uint32_t sampleRate, uint32_t blockSize)
+    : sampleRate_(sampleRate), blockSize_(std::max<uint32_t>(blockSize, 1)) {
+    events_.reserve(events.size());
+    for (const auto& event : events) {
+        uint64_t sample = static_cast<uint64_t>(event.secondTime * sampleRate_);
+        events_.push_back({sample, static_cast<uint32_t>(sample % blockSize_), event});
+    }
+
+    // MidiFile already returns events in order; anything else is sorted here
+    auto bySample = [](const Event& a, const Event& b) { return a.sampleTime < b.sampleTime; };
+    if (!std::is_sorted(events_.begin(), events_.end(), bySample)) {
+        std::stable_sort(events_.begin(), events_.end(), bySample);
+    }
+
+    // Block b owns events_[blockStarts_[b], blockStarts_[b + 1])
+    size_t blockCount = events_.empty() ? 0 : static_cast<size_t>(events_.back().sampleTime / blockSize_) + 1;
+    blockStarts_.resize(blockCount + 1);
+    size_t next = 0;
+    for (size_t b = 0; b < blockCount; ++b) {
+        blockStarts_[b] = static_cast<uint32_t>(next);
+        uint64_t blockEnd = static_cast<uint64_t>(b + 1) * blockSize_;
+        while (next < events_.size() && events_[next].sampleTime < blockEnd) {
+            ++next;
+        }
+    }
+    blockStarts_[blockCount] = static_cast<uint32_t>(next);
+}
+
+std::span<const MidiSchedule::Event> MidiSchedule::block(size_t index) const {
+    if (index >= blockCount()) return {};
+    return std::span<const Event>(events_.data() + blockStarts_[index],
+                                  blockStarts_[index + 1] - blockStarts_[index]);
+}
+
 // Write big-endian values
 static void writeBE32(std::vector<uint8_t>& data, uint32_t value) {
     data.push_back(static_cast<uint8_t>((value >> 24) & 0xFF));
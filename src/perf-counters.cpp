@@ -0,0 +1,294 @@
+/**
+ * clap-trap: Performance Counters Implementation
+ */
+
+#include "clap-trap/perf-counters.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#include <sys/resource.h>
+#endif
+
+namespace clap_trap {
+
+const char* PerfCounters::name(Counter counter) {
+    switch (counter) {
+        case Cycles:          return "cycles";
+        case Instructions:    return "instructions";
+        case BranchMisses:    return "branchMisses";
+        case L1DMisses:       return "l1dMisses";
+        case LlcMisses:       return "llcMisses";
+        case ContextSwitches: return "contextSwitches";
+        case COUNTER_COUNT:   break;
+    }
+    return "?";
+}
+
+double PerfCounters::Values::ipc() const {
+    if (!valid[Cycles] || !valid[Instructions] || value[Cycles] == 0) return 0.0;
+    return static_cast<double>(value[Instructions]) / static_cast<double>(value[Cycles]);
+}
+
+void PerfCounters::Values::add(const Values& other) {
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        if (!other.valid[c]) continue;
+        value[c] += other.value[c];
+        valid[c] = true;
+    }
+}
+
+PerfCounters::Values PerfCounters::Values::difference(const Values& end, const Values& begin) {
+    Values out;
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        if (!end.valid[c] || !begin.valid[c]) continue;
+        out.value[c] = end.value[c] >= begin.value[c] ? end.value[c] - begin.value[c] : 0;
+        out.valid[c] = true;
+    }
+    return out;
+}
+
+#if defined(__linux__)
+
+namespace {
+
+struct CounterSpec {
+    uint32_t type;
+    uint64_t config;
+    bool kernel;  // Count kernel time too (only context switches need it)
+};
+
+constexpr uint64_t cacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+constexpr CounterSpec COUNTER_SPECS[PerfCounters::COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, false},
+    {PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                     PERF_COUNT_HW_CACHE_RESULT_MISS), false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, false},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, true},
+};
+
+int openCounter(const CounterSpec& spec, int groupFd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.disabled = groupFd < 0 ? 1 : 0;  // Members follow the leader
+    attr.exclude_kernel = spec.kernel ? 0 : 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    // One group, so a single read() returns every counter
+    int firstErrno = 0;
+    int members = 0;
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        fds_[c] = openCounter(COUNTER_SPECS[c], leader_);
+        slot_[c] = -1;
+        if (fds_[c] < 0) {
+            if (firstErrno == 0) firstErrno = errno;
+            continue;
+        }
+        if (leader_ < 0) leader_ = fds_[c];
+        slot_[c] = members++;
+    }
+
+    if (!has(Cycles) && firstErrno != 0) {
+        error_ = std::string("perf_event_open failed: ") + strerror(firstErrno);
+        if (firstErrno == EACCES || firstErrno == EPERM) {
+            error_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool PerfCounters::available() const {
+    return leader_ >= 0;
+}
+
+bool PerfCounters::has(Counter counter) const {
+    return slot_[counter] >= 0;
+}
+
+void PerfCounters::start() {
+    if (leader_ < 0) return;
+    ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    running_ = true;
+}
+
+void PerfCounters::stop() {
+    if (leader_ < 0) return;
+    ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    running_ = false;
+}
+
+PerfCounters::Values PerfCounters::readRaw() const {
+    Values values;
+    if (leader_ < 0) return values;
+
+    // nr, time enabled, time running, then one value per member
+    uint64_t data[3 + COUNTER_COUNT] = {};
+    ssize_t bytes = ::read(leader_, data, sizeof(data));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || data[2] == 0) return values;
+
+    double scale = data[2] < data[1] ? static_cast<double>(data[1]) / static_cast<double>(data[2]) : 1.0;
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        if (slot_[c] < 0 || static_cast<uint64_t>(slot_[c]) >= data[0]) continue;
+        uint64_t raw = data[3 + slot_[c]];
+        values.value[c] = scale == 1.0 ? raw : static_cast<uint64_t>(static_cast<double>(raw) * scale);
+        values.valid[c] = true;
+    }
+    return values;
+}
+
+PerfCounters::Values PerfCounters::read() const {
+    return readRaw();
+}
+
+#elif defined(__APPLE__)
+
+namespace {
+
+// kperf is a private framework; counting needs root
+struct Kpc {
+    int (*forceAllCtrsSet)(int);
+    int (*setCounting)(uint32_t);
+    int (*setThreadCounting)(uint32_t);
+    uint32_t (*getCounterCount)(uint32_t);
+    int (*getThreadCounters)(uint32_t, uint32_t, uint64_t*);
+};
+
+constexpr uint32_t KPC_CLASS_FIXED_MASK = 1u << 0;
+constexpr uint32_t MAX_KPC_COUNTERS = 32;
+
+const Kpc* loadKpc() {
+    static Kpc kpc{};
+    static bool loaded = [] {
+        void* lib = dlopen("/System/Library/PrivateFrameworks/kperf.framework/kperf", RTLD_LAZY);
+        if (!lib) return false;
+        kpc.forceAllCtrsSet = reinterpret_cast<int (*)(int)>(dlsym(lib, "kpc_force_all_ctrs_set"));
+        kpc.setCounting = reinterpret_cast<int (*)(uint32_t)>(dlsym(lib, "kpc_set_counting"));
+        kpc.setThreadCounting = reinterpret_cast<int (*)(uint32_t)>(dlsym(lib, "kpc_set_thread_counting"));
+        kpc.getCounterCount = reinterpret_cast<uint32_t (*)(uint32_t)>(dlsym(lib, "kpc_get_counter_count"));
+        kpc.getThreadCounters = reinterpret_cast<int (*)(uint32_t, uint32_t, uint64_t*)>(
+            dlsym(lib, "kpc_get_thread_counters"));
+        return kpc.forceAllCtrsSet && kpc.setCounting && kpc.setThreadCounting &&
+               kpc.getCounterCount && kpc.getThreadCounters;
+    }();
+    return loaded ? &kpc : nullptr;
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        fds_[c] = -1;
+        slot_[c] = -1;
+    }
+
+    const Kpc* kpc = loadKpc();
+    if (!kpc) {
+        error_ = "kperf framework not available";
+    } else if (kpc->forceAllCtrsSet(1) != 0 || kpc->setCounting(KPC_CLASS_FIXED_MASK) != 0 ||
+               kpc->setThreadCounting(KPC_CLASS_FIXED_MASK) != 0) {
+        error_ = "kpc counters need root";
+    } else {
+        kpc_ = kpc->getCounterCount(KPC_CLASS_FIXED_MASK) >= 2;
+        if (!kpc_) error_ = "kpc has no fixed counters";
+    }
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const {
+    return true;  // Context switches come from getrusage()
+}
+
+bool PerfCounters::has(Counter counter) const {
+    if (counter == ContextSwitches) return true;
+    return kpc_ && (counter == Cycles || counter == Instructions);
+}
+
+PerfCounters::Values PerfCounters::readRaw() const {
+    Values values;
+    if (kpc_) {
+        uint64_t counts[MAX_KPC_COUNTERS] = {};
+        const Kpc* kpc = loadKpc();
+        uint32_t count = std::min(kpc->getCounterCount(KPC_CLASS_FIXED_MASK), MAX_KPC_COUNTERS);
+        if (kpc->getThreadCounters(0, count, counts) == 0) {
+#if defined(__aarch64__) || defined(__arm64__)
+            values.value[Cycles] = counts[0];
+            values.value[Instructions] = counts[1];
+#else
+            values.value[Instructions] = counts[0];
+            values.value[Cycles] = counts[1];
+#endif
+            values.valid[Cycles] = values.valid[Instructions] = true;
+        }
+    }
+
+    // Process-wide; macOS has no per-thread rusage
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        values.value[ContextSwitches] = static_cast<uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+        values.valid[ContextSwitches] = true;
+    }
+    return values;
+}
+
+void PerfCounters::start() {
+    base_ = readRaw();
+    running_ = true;
+}
+
+void PerfCounters::stop() {
+    final_ = Values::difference(readRaw(), base_);
+    running_ = false;
+}
+
+PerfCounters::Values PerfCounters::read() const {
+    return running_ ? Values::difference(readRaw(), base_) : final_;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("performance counters are not supported on this platform") {
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        fds_[c] = -1;
+        slot_[c] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const { return false; }
+bool PerfCounters::has(Counter) const { return false; }
+void PerfCounters::start() {}
+void PerfCounters::stop() {}
+PerfCounters::Values PerfCounters::readRaw() const { return {}; }
+PerfCounters::Values PerfCounters::read() const { return {}; }
+
+#endif
+
+} // namespace clap_trap
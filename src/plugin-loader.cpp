@@ -126,6 +126,14 @@ std::unique_ptr<PluginLoader> PluginLoader::create(const std::string &path) {
 }
 
 std::unique_ptr<PluginLoader> PluginLoader::load(const std::string &path) {
+  auto loader = open(path);
+  if (loader->entry_) {
+    loader->initEntry();
+  }
+  return loader;
+}
+
+std::unique_ptr<PluginLoader> PluginLoader::open(const std::string &path) {
   auto loader = std::unique_ptr<PluginLoader>(new PluginLoader());
   loader->path_ = path;
 
@@ -184,18 +192,30 @@ std::unique_ptr<PluginLoader> PluginLoader::load(const std::string &path) {
   // Verify CLAP version compatibility
   if (!clap_version_is_compatible(loader->entry_->clap_version)) {
     loader->error_ = "Incompatible CLAP version";
+    loader->entry_ = nullptr;
     return loader;
   }
 
+  return loader;
+}
+
+bool PluginLoader::initEntry() {
+  if (initialized_) {
+    return true;
+  }
+  if (!entry_) {
+    return false;
+  }
+
   // Initialize the plugin
-  if (!loader->entry_->init(path.c_str())) {
-    loader->error_ = "clap_entry->init() returned false";
-    loader->entry_ = nullptr;
-    return loader;
+  if (!entry_->init(path_.c_str())) {
+    error_ = "clap_entry->init() returned false";
+    entry_ = nullptr;
+    return false;
   }
 
-  loader->initialized_ = true;
-  return loader;
+  initialized_ = true;
+  return true;
 }
 
 #if CLAP_TRAP_HAS_WASM
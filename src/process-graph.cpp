@@ -0,0 +1,255 @@
+/**
+ * clap-trap: Process Graph Implementation
+ */
+
+#include "clap-trap/process-graph.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace clap_trap {
+
+std::unique_ptr<ProcessGraph> ProcessGraph::load(const std::vector<std::string>& paths) {
+    auto graph = std::unique_ptr<ProcessGraph>(new ProcessGraph());
+    if (paths.empty()) {
+        graph->error_ = "Empty plugin chain";
+        return graph;
+    }
+
+    for (const auto& path : paths) {
+        PluginLoader* loader = nullptr;
+        for (const auto& existing : graph->loaders_) {
+            if (existing->path() == path) loader = existing.get();
+        }
+        if (!loader) {
+            graph->loaders_.push_back(PluginLoader::create(path));
+            loader = graph->loaders_.back().get();
+        }
+
+        const clap_plugin_factory_t* factory = loader->factory();
+        if (!factory) {
+            graph->error_ = path + ": " + (loader->getError().empty() ? "No plugin factory" : loader->getError());
+            return graph;
+        }
+        const clap_plugin_descriptor_t* desc =
+            factory->get_plugin_count(factory) > 0 ? factory->get_plugin_descriptor(factory, 0) : nullptr;
+        if (!desc) {
+            graph->error_ = path + ": No plugins in factory";
+            return graph;
+        }
+
+        auto node = std::make_unique<Node>();
+        node->path = path;
+        node->descriptor = desc;
+        node->host = std::make_unique<TestHost>();
+        const clap_plugin_t* plugin = factory->create_plugin(factory, node->host->clapHost(), desc->id);
+        if (!plugin || !plugin->init(plugin)) {
+            if (plugin) plugin->destroy(plugin);
+            graph->error_ = path + ": create_plugin() or init() failed";
+            return graph;
+        }
+        node->plugin = plugin;
+        node->host->setPlugin(plugin);
+        node->host->pumpMainThread();
+        graph->nodes_.push_back(std::move(node));
+    }
+    return graph;
+}
+
+ProcessGraph::~ProcessGraph() {
+    if (processing_) {
+        TestHost::AudioThreadScope audio;
+        stopProcessing();
+    }
+    deactivate();
+    for (auto& node : nodes_) node->plugin->destroy(node->plugin);
+    nodes_.clear();
+}
+
+bool ProcessGraph::activate(uint32_t sampleRate, uint32_t blockSize, bool hugePages) {
+    deactivate();
+    if (blockSize == 0) {
+        error_ = "Block size must be at least 1";
+        return false;
+    }
+
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        Node& node = *nodes_[i];
+        const clap_plugin_t* plugin = node.plugin;
+        // Matched block sizes: every node gets exactly the blocks the graph runs
+        if (!plugin->activate(plugin, sampleRate, blockSize, blockSize)) {
+            for (size_t j = 0; j < i; ++j) {
+                nodes_[j]->plugin->deactivate(nodes_[j]->plugin);
+                nodes_[j]->host->setPluginActive(false);
+            }
+            error_ = node.path + ": activate() failed";
+            return false;
+        }
+        node.host->setPluginActive(true);
+
+        node.inputChannels = 0;
+        node.outputChannels = 2;  // Default stereo, as for a single plugin
+        const auto* ports = static_cast<const clap_plugin_audio_ports_t*>(
+            plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS));
+        if (ports) {
+            clap_audio_port_info_t info{};
+            if (ports->count(plugin, true) > 0 && ports->get(plugin, 0, true, &info)) {
+                node.inputChannels = info.channel_count;
+            }
+            info = {};
+            if (ports->count(plugin, false) > 0 && ports->get(plugin, 0, false, &info)) {
+                node.outputChannels = info.channel_count;
+            }
+        } else {
+            node.inputChannels = 2;
+        }
+
+        node.latency = 0;
+        if (const auto* ext = static_cast<const clap_plugin_latency_t*>(plugin->get_extension(plugin, CLAP_EXT_LATENCY))) {
+            node.latency = ext->get(plugin);
+        }
+        node.tail = 0;
+        if (const auto* ext = static_cast<const clap_plugin_tail_t*>(plugin->get_extension(plugin, CLAP_EXT_TAIL))) {
+            node.tail = ext->get(plugin);
+        }
+    }
+    sampleRate_ = sampleRate;
+    blockSize_ = blockSize;
+
+    // Both sides of the ping-pong in one slab, every channel cache-line aligned
+    maxChannels_ = 1;
+    for (const auto& node : nodes_) {
+        maxChannels_ = std::max({maxChannels_, node->inputChannels, node->outputChannels});
+    }
+    stride_ = paddedChannelStride(blockSize);
+    slab_.allocate(2 * maxChannels_ * stride_ * sizeof(float), hugePages);
+    float* base = static_cast<float*>(slab_.data());
+    for (uint32_t side = 0; side < 2; ++side) {
+        channels_[side].resize(maxChannels_);
+        for (uint32_t c = 0; c < maxChannels_; ++c) {
+            channels_[side][c] = base + (side * maxChannels_ + c) * stride_;
+        }
+    }
+
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        Node& node = *nodes_[i];
+        node.inputBuffer = {};
+        node.inputBuffer.data32 = const_cast<float**>(channels(i % 2));
+        node.inputBuffer.channel_count = node.inputChannels;
+        node.outputBuffer = {};
+        node.outputBuffer.data32 = const_cast<float**>(channels((i + 1) % 2));
+        node.outputBuffer.channel_count = node.outputChannels;
+
+        node.process = {};
+        node.process.frames_count = blockSize;
+        node.process.transport = nullptr;
+        node.process.audio_inputs = &node.inputBuffer;
+        node.process.audio_outputs = &node.outputBuffer;
+        node.process.audio_inputs_count = node.inputChannels > 0 ? 1 : 0;
+        node.process.audio_outputs_count = 1;
+        node.process.in_events = node.inEvents.get();
+        node.process.out_events = node.outEvents.get();
+    }
+    return true;
+}
+
+void ProcessGraph::deactivate() {
+    if (sampleRate_ == 0) return;
+    for (auto& node : nodes_) {
+        node->plugin->deactivate(node->plugin);
+        node->host->setPluginActive(false);
+    }
+    sampleRate_ = 0;
+}
+
+bool ProcessGraph::startProcessing() {
+    if (sampleRate_ == 0) {
+        error_ = "Graph is not active";
+        return false;
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (!nodes_[i]->plugin->start_processing(nodes_[i]->plugin)) {
+            for (size_t j = 0; j < i; ++j) nodes_[j]->plugin->stop_processing(nodes_[j]->plugin);
+            error_ = nodes_[i]->path + ": start_processing() failed";
+            return false;
+        }
+    }
+    processing_ = true;
+    return true;
+}
+
+void ProcessGraph::stopProcessing() {
+    if (!processing_) return;
+    for (auto& node : nodes_) node->plugin->stop_processing(node->plugin);
+    processing_ = false;
+}
+
+void ProcessGraph::process(uint32_t frames) {
+    frames = std::min(frames, blockSize_);
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        Node& node = *nodes_[i];
+
+        // Inputs the previous node has no output for would hold stale samples
+        uint32_t written = i == 0 ? node.inputChannels : nodes_[i - 1]->outputChannels;
+        for (uint32_t c = written; c < node.inputChannels; ++c) {
+            memset(node.inputBuffer.data32[c], 0, frames * sizeof(float));
+        }
+
+        node.process.frames_count = frames;
+        node.process.steady_time = static_cast<int64_t>(steadyTime_);
+        auto start = std::chrono::steady_clock::now();
+        node.lastStatus = node.plugin->process(node.plugin, &node.process);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        node.histogram.record(static_cast<uint64_t>(ns.count()));
+
+        // A failed block promises nothing about the outputs
+        if (node.lastStatus == CLAP_PROCESS_ERROR) {
+            for (uint32_t c = 0; c < node.outputChannels; ++c) {
+                memset(node.outputBuffer.data32[c], 0, frames * sizeof(float));
+            }
+        }
+    }
+    steadyTime_ += frames;
+}
+
+void ProcessGraph::reset() {
+    for (auto& node : nodes_) node->plugin->reset(node->plugin);
+}
+
+void ProcessGraph::pumpMainThread() {
+    for (auto& node : nodes_) node->host->pumpMainThread();
+}
+
+uint32_t ProcessGraph::inputChannels() const {
+    return nodes_.empty() ? 0 : nodes_.front()->inputChannels;
+}
+
+float* ProcessGraph::input(uint32_t channel) const {
+    return channels(0)[channel];
+}
+
+uint32_t ProcessGraph::outputChannels() const {
+    return nodes_.empty() ? 0 : nodes_.back()->outputChannels;
+}
+
+const float* ProcessGraph::output(uint32_t channel) const {
+    return channels(nodes_.size() % 2)[channel];
+}
+
+uint32_t ProcessGraph::latency() const {
+    uint64_t total = 0;
+    for (const auto& node : nodes_) total += node->latency;
+    return static_cast<uint32_t>(std::min<uint64_t>(total, UINT32_MAX));
+}
+
+uint32_t ProcessGraph::tail() const {
+    uint64_t total = 0;
+    for (const auto& node : nodes_) total += node->tail;  // UINT32_MAX (infinite) stays infinite
+    return static_cast<uint32_t>(std::min<uint64_t>(total, UINT32_MAX));
+}
+
+void ProcessGraph::resetStats() {
+    for (auto& node : nodes_) node->histogram.reset();
+}
+
+} // namespace clap_trap
@@ -0,0 +1,320 @@
+/**
+ * clap-trap: Results Report Implementation
+ */
+
+#include "clap-trap/report.h"
+#include <algorithm>
+#include <string_view>
+
+namespace clap_trap {
+
+TimingStats TimingStats::fromHistogram(std::string name, const LatencyHistogram& histogram) {
+    TimingStats stats;
+    stats.name = std::move(name);
+    stats.blocks = histogram.count();
+    stats.meanNs = histogram.mean();
+    stats.minNs = histogram.min();
+    stats.p50Ns = histogram.valueAtPercentile(50.0);
+    stats.p90Ns = histogram.valueAtPercentile(90.0);
+    stats.p99Ns = histogram.valueAtPercentile(99.0);
+    stats.p999Ns = histogram.valueAtPercentile(99.9);
+    stats.maxNs = histogram.max();
+
+    for (uint32_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        uint64_t count = histogram.countAt(i);
+        if (count == 0) continue;
+        stats.histogram.push_back({LatencyHistogram::bucketLowerBound(i),
+                                   LatencyHistogram::bucketUpperBound(i), count});
+    }
+    return stats;
+}
+
+namespace {
+
+void recordCheck(std::vector<CheckResult>& checks, std::string name, bool passed, std::string detail) {
+    for (auto& c : checks) {
+        if (c.name == name) {
+            c.passed = passed;
+            c.detail = std::move(detail);
+            return;
+        }
+    }
+    checks.push_back({std::move(name), passed, std::move(detail)});
+}
+
+} // namespace
+
+void PluginResult::check(std::string checkName, bool passed, std::string detail) {
+    recordCheck(checks, std::move(checkName), passed, std::move(detail));
+}
+
+bool PluginResult::passed() const {
+    return std::all_of(checks.begin(), checks.end(), [](const CheckResult& c) { return c.passed; });
+}
+
+void Report::check(std::string checkName, bool passed, std::string detail) {
+    recordCheck(checks, std::move(checkName), passed, std::move(detail));
+}
+
+PluginResult& Report::plugin(const std::string& id) {
+    for (auto& p : plugins) {
+        if (p.id == id) return p;
+    }
+    plugins.emplace_back();
+    plugins.back().id = id;
+    return plugins.back();
+}
+
+bool Report::passed() const {
+    bool fileOk = std::all_of(checks.begin(), checks.end(), [](const CheckResult& c) { return c.passed; });
+    return fileOk && std::all_of(plugins.begin(), plugins.end(),
+                                 [](const PluginResult& p) { return p.passed(); });
+}
+
+//-----------------------------------------------------------------------------
+// JSON
+//-----------------------------------------------------------------------------
+
+namespace {
+
+Json checksToJson(const std::vector<CheckResult>& checks) {
+    Json out = Json::array();
+    for (const auto& c : checks) {
+        Json check = Json::object();
+        check.set("name", c.name).set("passed", c.passed);
+        if (!c.detail.empty()) check.set("detail", c.detail);
+        out.push(std::move(check));
+    }
+    return out;
+}
+
+} // namespace
+
+Json toJson(const TimingStats& timing) {
+    Json histogram = Json::array();
+    for (const auto& bucket : timing.histogram) {
+        Json b = Json::object();
+        b.set("lowerNs", bucket.lowerNs).set("upperNs", bucket.upperNs).set("count", bucket.count);
+        histogram.push(std::move(b));
+    }
+
+    Json out = Json::object();
+    out.set("name", timing.name)
+       .set("blocks", timing.blocks)
+       .set("realtime", timing.realtime)
+       .set("meanNs", timing.meanNs)
+       .set("minNs", timing.minNs)
+       .set("p50Ns", timing.p50Ns)
+       .set("p90Ns", timing.p90Ns)
+       .set("p99Ns", timing.p99Ns)
+       .set("p999Ns", timing.p999Ns)
+       .set("maxNs", timing.maxNs)
+       .set("deadlineNs", timing.deadlineNs)
+       .set("deadlineMisses", timing.deadlineMisses)
+       .set("longestMissRun", timing.longestMissRun)
+       .set("histogram", std::move(histogram));
+    if (!timing.runMediansNs.empty()) {
+        Json runs = Json::array();
+        for (uint64_t median : timing.runMediansNs) runs.push(median);
+        out.set("runMediansNs", std::move(runs));
+    }
+    if (!timing.counters.isNull()) out.set("counters", timing.counters);
+    return out;
+}
+
+bool TimingStats::fromJson(const Json& json, TimingStats& out) {
+    if (!json.isObject()) return false;
+    auto real = [&](const char* key) {
+        const Json* value = json.get(key);
+        return value ? value->asNumber() : 0.0;
+    };
+    auto number = [&](const char* key) { return static_cast<uint64_t>(real(key)); };
+
+    const Json* name = json.get("name");
+    const Json* histogram = json.get("histogram");
+    if (!name || !name->isString() || !histogram || !histogram->isArray()) return false;
+
+    out = TimingStats();
+    out.name = name->asString();
+    out.blocks = number("blocks");
+    out.realtime = real("realtime");
+    out.meanNs = real("meanNs");
+    out.minNs = number("minNs");
+    out.p50Ns = number("p50Ns");
+    out.p90Ns = number("p90Ns");
+    out.p99Ns = number("p99Ns");
+    out.p999Ns = number("p999Ns");
+    out.maxNs = number("maxNs");
+    out.deadlineNs = number("deadlineNs");
+    out.deadlineMisses = number("deadlineMisses");
+    out.longestMissRun = number("longestMissRun");
+
+    for (const auto& bucket : histogram->items()) {
+        const Json* lower = bucket.get("lowerNs");
+        const Json* upper = bucket.get("upperNs");
+        const Json* count = bucket.get("count");
+        if (!lower || !upper || !count) return false;
+        out.histogram.push_back({static_cast<uint64_t>(lower->asNumber()),
+                                 static_cast<uint64_t>(upper->asNumber()),
+                                 static_cast<uint64_t>(count->asNumber())});
+    }
+    if (const Json* runs = json.get("runMediansNs")) {
+        for (const auto& run : runs->items()) {
+            out.runMediansNs.push_back(static_cast<uint64_t>(run.asNumber()));
+        }
+    }
+    if (const Json* counters = json.get("counters")) out.counters = *counters;
+    return true;
+}
+
+Json toJson(const PluginResult& p) {
+    Json timings = Json::array();
+    for (const auto& t : p.timings) timings.push(toJson(t));
+
+    Json plugin = Json::object();
+    plugin.set("id", p.id)
+          .set("name", p.name)
+          .set("vendor", p.vendor)
+          .set("version", p.version)
+          .set("passed", p.passed())
+          .set("checks", checksToJson(p.checks))
+          .set("timings", std::move(timings))
+          .set("details", p.details);  // Nested, so no detail can shadow a field above
+    return plugin;
+}
+
+bool PluginResult::fromJson(const Json& json, PluginResult& out) {
+    if (!json.isObject()) return false;
+    const Json* id = json.get("id");
+    if (!id || !id->isString()) return false;
+
+    out = PluginResult();
+    for (const auto& [key, value] : json.members()) {
+        if (key == "id" || key == "passed") {
+            continue;  // passed() is derived from the checks
+        } else if (key == "name") {
+            out.name = value.asString();
+        } else if (key == "vendor") {
+            out.vendor = value.asString();
+        } else if (key == "version") {
+            out.version = value.asString();
+        } else if (key == "checks") {
+            for (const auto& check : value.items()) {
+                const Json* name = check.get("name");
+                const Json* passed = check.get("passed");
+                if (!name || !passed) return false;
+                const Json* detail = check.get("detail");
+                out.checks.push_back({name->asString(), passed->asBool(), detail ? detail->asString() : ""});
+            }
+        } else if (key == "timings") {
+            for (const auto& timing : value.items()) {
+                if (!TimingStats::fromJson(timing, out.timings.emplace_back())) return false;
+            }
+        } else if (key == "details") {
+            if (value.isObject()) out.details = value;
+        }
+    }
+    out.id = id->asString();
+    return true;
+}
+
+Json toJson(const Report& report) {
+    Json host = Json::object();
+    host.set("sampleRate", report.host.sampleRate)
+        .set("bufferSize", report.host.bufferSize)
+        .set("blocks", report.host.blocks)
+        .set("precision", report.host.precision)
+        .set("bufferLayout", report.host.bufferLayout)
+        .set("instances", report.host.instances)
+        .set("threads", report.host.threads);
+
+    Json plugins = Json::array();
+    for (const auto& p : report.plugins) plugins.push(toJson(p));
+
+    Json out = Json::object();
+    out.set("command", report.command)
+       .set("plugin", report.pluginPath)
+       .set("passed", report.passed())
+       .set("host", std::move(host))
+       .set("checks", checksToJson(report.checks))
+       .set("plugins", std::move(plugins));
+    for (const auto& member : report.details.members()) {
+        out.set(member.first, member.second);
+    }
+    return out;
+}
+
+//-----------------------------------------------------------------------------
+// CSV
+//-----------------------------------------------------------------------------
+
+namespace {
+
+void appendField(std::string& out, const std::string& field) {
+    if (field.find_first_of(",\"\n\r") == std::string::npos) {
+        out += field;
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+std::string joinPath(const std::string& path, const std::string& key) {
+    return path.empty() ? key : path + "." + key;
+}
+
+void flatten(const Json& value, const std::string& plugin, const std::string& path, std::string& out);
+
+void flattenMembers(const Json& value, const std::string& plugin, const std::string& path,
+                    std::string_view skipKey, std::string& out) {
+    for (const auto& [key, child] : value.members()) {
+        if (key == skipKey) continue;
+
+        // Each plugin's values get their own plugin column
+        if (key == "plugins" && child.isArray()) {
+            for (const auto& entry : child.items()) {
+                const Json* id = entry.get("id");
+                flattenMembers(entry, id ? id->asString() : std::string(), std::string(), "id", out);
+            }
+            continue;
+        }
+        flatten(child, plugin, joinPath(path, key), out);
+    }
+}
+
+void flatten(const Json& value, const std::string& plugin, const std::string& path, std::string& out) {
+    if (value.isObject()) {
+        flattenMembers(value, plugin, path, {}, out);
+    } else if (value.isArray()) {
+        for (size_t i = 0; i < value.items().size(); ++i) {
+            const Json& item = value.items()[i];
+            const Json* name = item.get("name");
+            if (name && name->isString()) {
+                flattenMembers(item, plugin, joinPath(path, name->asString()), "name", out);
+            } else {
+                flatten(item, plugin, joinPath(path, std::to_string(i)), out);
+            }
+        }
+    } else {
+        appendField(out, plugin);
+        out += ',';
+        appendField(out, path);
+        out += ',';
+        appendField(out, value.isString() ? value.asString() : value.dump(-1));
+        out += '\n';
+    }
+}
+
+} // namespace
+
+std::string toCsv(const Json& report) {
+    std::string out = "plugin,metric,value\n";
+    flatten(report, std::string(), std::string(), out);
+    return out;
+}
+
+} // namespace clap_trap
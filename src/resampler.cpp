@@ -0,0 +1,222 @@
+/**
+ * clap-trap: Resampler Implementation
+ */
+
+#include "clap-trap/resampler.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace clap_trap {
+
+namespace {
+
+// Kaiser window shape: about 80 dB of stopband attenuation
+constexpr double KAISER_BETA = 8.0;
+
+// Cutoff as a fraction of the lower rate's Nyquist frequency. With the
+// default taps the passband is flat to about 0.84 of Nyquist and images
+// or aliases are down by 80 dB from Nyquist on.
+constexpr double CUTOFF = 0.92;
+
+constexpr uint32_t MAX_TAPS = 1024;
+
+// Input frames that pile up before the consumed part of the history is dropped
+constexpr size_t COMPACT_FRAMES = 4096;
+
+constexpr double PI = 3.14159265358979323846;
+
+// Zeroth-order modified Bessel function of the first kind, by its power series
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+float dotScalar(const float* a, const float* b, uint32_t count) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+#if defined(CLAP_TRAP_SIMD_X86)
+
+float dotSse2(const float* a, const float* b, uint32_t count) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + dotScalar(a + i, b + i, count - i);
+}
+
+CLAP_TRAP_TARGET("avx2")
+float dotAvx2(const float* a, const float* b, uint32_t count) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m256 sum256 = _mm256_add_ps(sum0, sum1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum256), _mm256_extractf128_ps(sum256, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + dotScalar(a + i, b + i, count - i);
+}
+
+#elif defined(CLAP_TRAP_SIMD_NEON)
+
+float dotNeon(const float* a, const float* b, uint32_t count) {
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(sum0, sum1)) + dotScalar(a + i, b + i, count - i);
+}
+
+#endif
+
+float dot(const float* a, const float* b, uint32_t count) {
+#if defined(CLAP_TRAP_SIMD_X86)
+    static const auto kernel = simd::hasAvx2() ? dotAvx2 : dotSse2;
+    return kernel(a, b, count);
+#elif defined(CLAP_TRAP_SIMD_NEON)
+    return dotNeon(a, b, count);
+#else
+    return dotScalar(a, b, count);
+#endif
+}
+
+} // namespace
+
+Resampler::Resampler(uint32_t inputRate, uint32_t outputRate, uint32_t channels, uint32_t taps)
+    : inputRate_(inputRate)
+    , outputRate_(outputRate)
+    , channels_(std::max(1u, channels)) {
+    uint64_t divisor = std::gcd(std::max(1u, inputRate), std::max(1u, outputRate));
+    up_ = std::max(1u, outputRate) / divisor;
+    down_ = std::max(1u, inputRate) / divisor;
+
+    // Converting down, the filter cuts below the input's Nyquist and needs
+    // proportionally more taps for the same transition band at the output
+    double ratio = std::min(1.0, static_cast<double>(up_) / static_cast<double>(down_));
+    double scaled = std::ceil(std::max(8u, taps) / ratio);
+    taps_ = std::min(MAX_TAPS, (static_cast<uint32_t>(scaled) + 7) & ~7u);
+    phases_ = static_cast<uint32_t>(std::min<uint64_t>(up_, MAX_PHASES));
+    interpolate_ = up_ > MAX_PHASES;
+
+    // Row r filters input offset r / phases_ of the way to the next frame;
+    // tap j reads frame (position - half + 1 + j). The extra last row is a
+    // whole frame on, for interpolating past the final phase.
+    const int32_t half = static_cast<int32_t>(taps_ / 2);
+    const double cutoff = 0.5 * CUTOFF * ratio;  // Cycles per input frame
+    const double windowScale = 1.0 / besselI0(KAISER_BETA);
+    coefficients_.resize(static_cast<size_t>(phases_ + 1) * taps_);
+    for (uint32_t r = 0; r <= phases_; ++r) {
+        float* row = coefficients_.data() + static_cast<size_t>(r) * taps_;
+        double offset = static_cast<double>(r) / phases_;
+        double sum = 0.0;
+        for (uint32_t j = 0; j < taps_; ++j) {
+            double x = offset + half - 1 - static_cast<int32_t>(j);
+            double arg = 2.0 * cutoff * x;
+            double sinc = std::abs(arg) < 1e-12 ? 1.0 : std::sin(PI * arg) / (PI * arg);
+            double edge = x / half;
+            double window = edge * edge < 1.0 ? besselI0(KAISER_BETA * std::sqrt(1.0 - edge * edge)) * windowScale : 0.0;
+            double value = 2.0 * cutoff * sinc * window;
+            row[j] = static_cast<float>(value);
+            sum += value;
+        }
+        // Unity gain at DC for every phase, so a constant stays constant
+        for (uint32_t j = 0; j < taps_; ++j) row[j] = static_cast<float>(row[j] / sum);
+    }
+
+    // Frames before the start read as silence
+    bufferStart_ = -(half - 1);
+    history_.assign(channels_, std::vector<float>(static_cast<size_t>(half - 1), 0.0f));
+}
+
+uint64_t Resampler::outputFramesFor(uint64_t inputFrames) const {
+    return (inputFrames * up_ + down_ - 1) / down_;
+}
+
+void Resampler::push(const float* interleaved, uint32_t frames) {
+    // Drop history no later output needs, once enough of it has piled up
+    int64_t firstNeeded = position_ - static_cast<int64_t>(taps_ / 2) + 1;
+    if (firstNeeded - bufferStart_ >= static_cast<int64_t>(COMPACT_FRAMES)) {
+        size_t drop = static_cast<size_t>(firstNeeded - bufferStart_);
+        for (auto& channel : history_) channel.erase(channel.begin(), channel.begin() + drop);
+        bufferStart_ += static_cast<int64_t>(drop);
+    }
+
+    for (uint32_t c = 0; c < channels_; ++c) {
+        auto& channel = history_[c];
+        size_t offset = channel.size();
+        channel.resize(offset + frames);
+        for (uint32_t f = 0; f < frames; ++f) {
+            channel[offset + f] = interleaved[static_cast<size_t>(f) * channels_ + c];
+        }
+    }
+}
+
+void Resampler::finish() {
+    if (finished_) return;
+    finished_ = true;
+    // Enough silence for the look-ahead of every output frame before the end
+    for (auto& channel : history_) channel.resize(channel.size() + taps_, 0.0f);
+}
+
+uint32_t Resampler::pull(float* interleaved, uint32_t frames) {
+    const int64_t half = static_cast<int64_t>(taps_ / 2);
+    const int64_t available = bufferStart_ + static_cast<int64_t>(history_[0].size());
+    uint32_t produced = 0;
+
+    while (produced < frames && position_ + half < available) {
+        size_t first = static_cast<size_t>(position_ - half + 1 - bufferStart_);
+        float* out = interleaved + static_cast<size_t>(produced) * channels_;
+
+        if (!interpolate_) {
+            const float* row = coefficients_.data() + phase_ * taps_;
+            for (uint32_t c = 0; c < channels_; ++c) {
+                out[c] = dot(history_[c].data() + first, row, taps_);
+            }
+        } else {
+            double exact = static_cast<double>(phase_) * phases_ / static_cast<double>(up_);
+            uint32_t r = std::min(phases_ - 1, static_cast<uint32_t>(exact));
+            float blend = static_cast<float>(exact - r);
+            const float* row = coefficients_.data() + static_cast<size_t>(r) * taps_;
+            for (uint32_t c = 0; c < channels_; ++c) {
+                const float* x = history_[c].data() + first;
+                float a = dot(x, row, taps_);
+                float b = dot(x, row + taps_, taps_);
+                out[c] = a + blend * (b - a);
+            }
+        }
+
+        phase_ += down_;
+        position_ += static_cast<int64_t>(phase_ / up_);
+        phase_ %= up_;
+        ++produced;
+    }
+    return produced;
+}
+
+} // namespace clap_trap
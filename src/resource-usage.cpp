@@ -0,0 +1,94 @@
+/**
+ * clap-trap: Resource Usage Implementation
+ */
+
+#include "clap-trap/resource-usage.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace clap_trap {
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+namespace {
+
+// Read a small /proc file with plain syscalls, so sampling doesn't allocate
+// or fault in stdio buffers; returns the length read, or 0
+size_t readProcFile(const char* path, char* text, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, text, size - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    text[n] = '\0';
+    return static_cast<size_t>(n);
+}
+
+} // namespace
+#endif
+
+ResourceUsage ResourceUsage::current(bool proportional) {
+    ResourceUsage usage;
+#if defined(_WIN32) || defined(__APPLE__)
+    (void)proportional;  // No PSS
+#endif
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.minorFaults = counters.PageFaultCount;
+        usage.residentBytes = static_cast<int64_t>(counters.WorkingSetSize);
+    }
+#else
+    struct rusage self{};
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        usage.minorFaults = static_cast<uint64_t>(self.ru_minflt);
+        usage.majorFaults = static_cast<uint64_t>(self.ru_majflt);
+    }
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+        KERN_SUCCESS) {
+        usage.residentBytes = static_cast<int64_t>(info.resident_size);
+    }
+#else
+    // ru_maxrss is only the peak; statm has the current size in pages (second field)
+    char text[1024];
+    if (readProcFile("/proc/self/statm", text, sizeof(text))) {
+        char* end = nullptr;
+        strtoull(text, &end, 10);
+        uint64_t pages = strtoull(end, nullptr, 10);
+        usage.residentBytes = static_cast<int64_t>(pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+    }
+    if (proportional && readProcFile("/proc/self/smaps_rollup", text, sizeof(text))) {
+        if (const char* pss = strstr(text, "\nPss:")) {
+            usage.proportionalBytes = static_cast<int64_t>(strtoull(pss + 5, nullptr, 10) * 1024);  // In kB
+        }
+    }
+#endif
+#endif
+    return usage;
+}
+
+ResourceUsage ResourceUsage::operator-(const ResourceUsage& begin) const {
+    ResourceUsage diff;
+    diff.minorFaults = minorFaults >= begin.minorFaults ? minorFaults - begin.minorFaults : 0;
+    diff.majorFaults = majorFaults >= begin.majorFaults ? majorFaults - begin.majorFaults : 0;
+    diff.residentBytes = residentBytes - begin.residentBytes;
+    diff.proportionalBytes = proportionalBytes - begin.proportionalBytes;
+    return diff;
+}
+
+} // namespace clap_trap
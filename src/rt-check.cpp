@@ -0,0 +1,50 @@
+/**
+ * clap-trap: Realtime Safety Check Implementation
+ *
+ * The parts of rt-check.h that need no hooks, plus fallbacks for everything
+ * else. The fallbacks are weak where the compiler allows it, so linking the
+ * clap-trap-rtcheck target (src/rt-hooks.cpp) replaces them.
+ */
+
+#include "clap-trap/rt-check.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CLAP_TRAP_RT_FALLBACK __attribute__((weak))
+#else
+#define CLAP_TRAP_RT_FALLBACK
+#endif
+
+namespace clap_trap {
+
+const char* rtViolationKindName(RtViolationKind kind) {
+    switch (kind) {
+        case RtViolationKind::Allocation: return "allocation";
+        case RtViolationKind::Lock:       return "lock";
+        case RtViolationKind::Syscall:    return "syscall";
+    }
+    return "?";
+}
+
+HeapCounts& HeapCounts::operator+=(const HeapCounts& other) {
+    allocations += other.allocations;
+    frees += other.frees;
+    allocatedBytes += other.allocatedBytes;
+    freedBytes += other.freedBytes;
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+// Fallbacks without the hooks
+//-----------------------------------------------------------------------------
+
+CLAP_TRAP_RT_FALLBACK bool rtCheckSupported() { return false; }
+CLAP_TRAP_RT_FALLBACK bool rtCheckEnable() { return false; }
+CLAP_TRAP_RT_FALLBACK RtRegion::RtRegion() {}
+CLAP_TRAP_RT_FALLBACK RtRegion::~RtRegion() {}
+CLAP_TRAP_RT_FALLBACK HeapCountScope::HeapCountScope(HeapCounts&) : previous_(nullptr) {}
+CLAP_TRAP_RT_FALLBACK HeapCountScope::~HeapCountScope() {}
+CLAP_TRAP_RT_FALLBACK std::vector<RtViolation> takeRtViolations() { return {}; }
+CLAP_TRAP_RT_FALLBACK uint64_t droppedRtViolations() { return 0; }
+CLAP_TRAP_RT_FALLBACK std::vector<std::string> symbolizeRtStack(const RtViolation&) { return {}; }
+
+} // namespace clap_trap
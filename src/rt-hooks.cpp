@@ -0,0 +1,416 @@
+/**
+ * clap-trap: Realtime Safety Check Hooks
+ *
+ * The interposed libc functions behind rt-check.h. Built as the separate
+ * clap-trap-rtcheck target so only binaries that link it on purpose get
+ * their allocator, locks and file calls replaced; the core library carries
+ * fallbacks that report the check as unsupported.
+ */
+
+// The hooks define libc functions, which fortified headers wrap inline
+#undef _FORTIFY_SOURCE
+
+#include "clap-trap/rt-check.h"
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define CLAP_TRAP_RT_HOOKS 1
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(CLAP_TRAP_RT_HOOKS)
+
+namespace clap_trap {
+
+namespace {
+
+constexpr uint32_t MAX_VIOLATIONS = 256;
+constexpr int SKIPPED_FRAMES = 2;  // recordViolation() and the hook itself
+
+struct ThreadState {
+    uint32_t depth;  // Open regions
+    bool inHook;     // Recording or resolving; calls made meanwhile are ours
+};
+
+// Initial-exec, so reading it from malloc can never allocate
+__attribute__((tls_model("initial-exec"))) thread_local ThreadState tState;
+__attribute__((tls_model("initial-exec"))) thread_local HeapCounts* tHeapCounts;
+
+RtViolation gViolations[MAX_VIOLATIONS];
+std::atomic<bool> gReady[MAX_VIOLATIONS];
+std::atomic<uint32_t> gNext{0};
+std::atomic<uint64_t> gDropped{0};
+
+inline bool watched() {
+    return tState.depth > 0 && !tState.inHook;
+}
+
+inline HeapCounts* heapCounts() {
+    return tState.inHook ? nullptr : tHeapCounts;
+}
+
+inline void countAllocation(HeapCounts* counts, void* block) {
+    if (!counts || !block) return;
+    counts->allocations++;
+    counts->allocatedBytes += malloc_usable_size(block);
+}
+
+inline void countFree(HeapCounts* counts, void* block) {
+    if (!counts || !block) return;
+    counts->frees++;
+    counts->freedBytes += malloc_usable_size(block);
+}
+
+__attribute__((noinline)) void recordViolation(RtViolationKind kind, const char* function, uint64_t size) {
+    tState.inHook = true;
+    void* frames[RT_MAX_FRAMES + SKIPPED_FRAMES];
+    int count = backtrace(frames, RT_MAX_FRAMES + SKIPPED_FRAMES);
+
+    uint32_t index = gNext.fetch_add(1, std::memory_order_relaxed);
+    if (index < MAX_VIOLATIONS) {
+        RtViolation& violation = gViolations[index];
+        violation.kind = kind;
+        violation.function = function;
+        violation.size = size;
+        violation.frameCount = count > SKIPPED_FRAMES ? static_cast<uint32_t>(count - SKIPPED_FRAMES) : 0;
+        for (uint32_t f = 0; f < violation.frameCount; ++f) {
+            violation.frames[f] = frames[f + SKIPPED_FRAMES];
+        }
+        gReady[index].store(true, std::memory_order_release);
+    } else {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    tState.inHook = false;
+}
+
+// Functions forwarded through dlsym(RTLD_NEXT); the malloc family uses glibc's
+// __libc_* entry points instead, since dlsym can itself allocate
+enum Forwarded {
+    FwdPosixMemalign, FwdAlignedAlloc, FwdMemalign,
+    FwdMutexLock, FwdRwlockRdlock, FwdRwlockWrlock, FwdSemWait,
+    FwdOpen, FwdOpen64, FwdFopen, FwdFopen64, FwdClose, FwdRead, FwdWrite,
+    FwdNanosleep, FwdUsleep, FwdMmap, FwdMunmap,
+    FORWARDED_COUNT
+};
+
+constexpr const char* FORWARDED_NAMES[FORWARDED_COUNT] = {
+    "posix_memalign", "aligned_alloc", "memalign",
+    "pthread_mutex_lock", "pthread_rwlock_rdlock", "pthread_rwlock_wrlock", "sem_wait",
+    "open", "open64", "fopen", "fopen64", "close", "read", "write",
+    "nanosleep", "usleep", "mmap", "munmap",
+};
+
+std::atomic<void*> gForwarded[FORWARDED_COUNT];
+
+template <typename Fn>
+Fn forwarded(Forwarded which) {
+    void* fn = gForwarded[which].load(std::memory_order_relaxed);
+    if (!fn) {
+        bool wasInHook = tState.inHook;
+        tState.inHook = true;
+        fn = dlsym(RTLD_NEXT, FORWARDED_NAMES[which]);
+        tState.inHook = wasInHook;
+        gForwarded[which].store(fn, std::memory_order_relaxed);
+    }
+    return reinterpret_cast<Fn>(fn);
+}
+
+// Base address of the module this file is linked into, i.e. the host
+const void* hostBase() {
+    static const void* base = [] {
+        Dl_info info{};
+        return dladdr(reinterpret_cast<void*>(&rtCheckEnable), &info) ? info.dli_fbase : nullptr;
+    }();
+    return base;
+}
+
+std::string demangle(const char* name) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status != 0 || !demangled) return name;
+    std::string out = demangled;
+    free(demangled);
+    return out;
+}
+
+} // namespace
+
+bool rtCheckSupported() {
+    return true;
+}
+
+bool rtCheckEnable() {
+    for (int f = 0; f < FORWARDED_COUNT; ++f) {
+        forwarded<void*>(static_cast<Forwarded>(f));
+    }
+    // The first backtrace() loads the unwinder
+    void* frames[4];
+    backtrace(frames, 4);
+    hostBase();
+    return true;
+}
+
+RtRegion::RtRegion() {
+    tState.depth++;
+}
+
+RtRegion::~RtRegion() {
+    tState.depth--;
+}
+
+HeapCountScope::HeapCountScope(HeapCounts& counts) : previous_(tHeapCounts) {
+    tHeapCounts = &counts;
+}
+
+HeapCountScope::~HeapCountScope() {
+    tHeapCounts = previous_;
+}
+
+std::vector<RtViolation> takeRtViolations() {
+    std::vector<RtViolation> out;
+    uint32_t count = std::min(gNext.load(std::memory_order_acquire), MAX_VIOLATIONS);
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (gReady[i].exchange(false, std::memory_order_acquire)) out.push_back(gViolations[i]);
+    }
+    gNext.store(0, std::memory_order_release);
+    return out;
+}
+
+uint64_t droppedRtViolations() {
+    return gDropped.exchange(0, std::memory_order_relaxed);
+}
+
+std::vector<std::string> symbolizeRtStack(const RtViolation& violation) {
+    struct Frame {
+        std::string text;
+        bool inHost;
+    };
+    std::vector<Frame> frames;
+    for (uint32_t f = 0; f < violation.frameCount; ++f) {
+        void* address = violation.frames[f];
+        char line[512];
+        Dl_info info{};
+        if (!dladdr(address, &info) || !info.dli_fname) {
+            snprintf(line, sizeof(line), "%p", address);
+            frames.push_back({line, false});
+            continue;
+        }
+
+        // The module offset is what addr2line wants; the symbol only covers exported functions
+        const char* module = strrchr(info.dli_fname, '/');
+        module = module ? module + 1 : info.dli_fname;
+        size_t moduleOffset = static_cast<const char*>(address) - static_cast<const char*>(info.dli_fbase);
+        if (info.dli_sname && info.dli_saddr) {
+            size_t symbolOffset = static_cast<const char*>(address) - static_cast<const char*>(info.dli_saddr);
+            snprintf(line, sizeof(line), "%s+0x%zx  %s+0x%zx", module, moduleOffset,
+                     demangle(info.dli_sname).c_str(), symbolOffset);
+        } else {
+            snprintf(line, sizeof(line), "%s+0x%zx", module, moduleOffset);
+        }
+        frames.push_back({line, info.dli_fbase == hostBase()});
+    }
+
+    // Below the plugin's frames, keep only the host frame that called it
+    size_t keep = frames.size();
+    bool seenPlugin = false;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        if (!frames[f].inHost) {
+            seenPlugin = true;
+        } else if (seenPlugin) {
+            keep = f + 1;
+            break;
+        }
+    }
+
+    std::vector<std::string> out;
+    out.reserve(keep);
+    for (size_t f = 0; f < keep; ++f) out.push_back(std::move(frames[f].text));
+    return out;
+}
+
+} // namespace clap_trap
+
+//-----------------------------------------------------------------------------
+// Interposed libc functions
+//-----------------------------------------------------------------------------
+
+using clap_trap::RtViolationKind;
+using clap_trap::countAllocation;
+using clap_trap::countFree;
+using clap_trap::heapCounts;
+using clap_trap::Forwarded;
+using clap_trap::forwarded;
+using clap_trap::recordViolation;
+using clap_trap::watched;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "malloc", size);
+    void* block = __libc_malloc(size);
+    countAllocation(heapCounts(), block);
+    return block;
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "calloc", count * size);
+    void* block = __libc_calloc(count, size);
+    countAllocation(heapCounts(), block);
+    return block;
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "realloc", size);
+    clap_trap::HeapCounts* counts = heapCounts();
+    size_t oldSize = counts && pointer ? malloc_usable_size(pointer) : 0;
+    void* block = __libc_realloc(pointer, size);
+    if (counts && (block || size == 0)) {
+        // Counted as freeing the old block and allocating the new one
+        if (pointer) {
+            counts->frees++;
+            counts->freedBytes += oldSize;
+        }
+        countAllocation(counts, block);
+    }
+    return block;
+}
+
+void free(void* pointer) noexcept {
+    if (pointer && watched()) recordViolation(RtViolationKind::Allocation, "free", 0);
+    countFree(heapCounts(), pointer);
+    __libc_free(pointer);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "posix_memalign", size);
+    int rc = forwarded<int (*)(void**, size_t, size_t)>(clap_trap::FwdPosixMemalign)(out, alignment, size);
+    if (rc == 0) countAllocation(heapCounts(), *out);
+    return rc;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "aligned_alloc", size);
+    void* block = forwarded<void* (*)(size_t, size_t)>(clap_trap::FwdAlignedAlloc)(alignment, size);
+    countAllocation(heapCounts(), block);
+    return block;
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Allocation, "memalign", size);
+    void* block = forwarded<void* (*)(size_t, size_t)>(clap_trap::FwdMemalign)(alignment, size);
+    countAllocation(heapCounts(), block);
+    return block;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Lock, "pthread_mutex_lock", 0);
+    return forwarded<int (*)(pthread_mutex_t*)>(clap_trap::FwdMutexLock)(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Lock, "pthread_rwlock_rdlock", 0);
+    return forwarded<int (*)(pthread_rwlock_t*)>(clap_trap::FwdRwlockRdlock)(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Lock, "pthread_rwlock_wrlock", 0);
+    return forwarded<int (*)(pthread_rwlock_t*)>(clap_trap::FwdRwlockWrlock)(lock);
+}
+
+int sem_wait(sem_t* semaphore) {
+    if (watched()) recordViolation(RtViolationKind::Lock, "sem_wait", 0);
+    return forwarded<int (*)(sem_t*)>(clap_trap::FwdSemWait)(semaphore);
+}
+
+static mode_t openMode(int flags, va_list args) {
+    bool needsMode = (flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE;
+    return needsMode ? static_cast<mode_t>(va_arg(args, int)) : 0;
+}
+
+int open(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    if (watched()) recordViolation(RtViolationKind::Syscall, "open", 0);
+    return forwarded<int (*)(const char*, int, ...)>(clap_trap::FwdOpen)(path, flags, mode);
+}
+
+int open64(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    if (watched()) recordViolation(RtViolationKind::Syscall, "open64", 0);
+    return forwarded<int (*)(const char*, int, ...)>(clap_trap::FwdOpen64)(path, flags, mode);
+}
+
+FILE* fopen(const char* path, const char* mode) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "fopen", 0);
+    return forwarded<FILE* (*)(const char*, const char*)>(clap_trap::FwdFopen)(path, mode);
+}
+
+FILE* fopen64(const char* path, const char* mode) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "fopen64", 0);
+    return forwarded<FILE* (*)(const char*, const char*)>(clap_trap::FwdFopen64)(path, mode);
+}
+
+int close(int fd) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "close", 0);
+    return forwarded<int (*)(int)>(clap_trap::FwdClose)(fd);
+}
+
+ssize_t read(int fd, void* buffer, size_t count) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "read", count);
+    return forwarded<ssize_t (*)(int, void*, size_t)>(clap_trap::FwdRead)(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "write", count);
+    return forwarded<ssize_t (*)(int, const void*, size_t)>(clap_trap::FwdWrite)(fd, buffer, count);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "nanosleep", 0);
+    return forwarded<int (*)(const struct timespec*, struct timespec*)>(clap_trap::FwdNanosleep)(duration, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "usleep", 0);
+    return forwarded<int (*)(useconds_t)>(clap_trap::FwdUsleep)(microseconds);
+}
+
+void* mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "mmap", length);
+    return forwarded<void* (*)(void*, size_t, int, int, int, off_t)>(clap_trap::FwdMmap)(
+        address, length, protection, flags, fd, offset);
+}
+
+int munmap(void* address, size_t length) noexcept {
+    if (watched()) recordViolation(RtViolationKind::Syscall, "munmap", length);
+    return forwarded<int (*)(void*, size_t)>(clap_trap::FwdMunmap)(address, length);
+}
+
+} // extern "C"
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * clap-trap: Scan Cache Implementation
+ */
+
+#include "clap-trap/scan-cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace clap_trap {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+bool hashFile(const fs::path& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    char buffer[1 << 16];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        std::streamsize n = file.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * FNV_PRIME;
+        }
+    }
+    return file.eof();
+}
+
+int64_t mtimeNs(const fs::path& path, std::error_code& ec) {
+    auto time = fs::last_write_time(path, ec);
+    if (ec) return 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// 64-bit values don't fit a JSON number exactly, so they are stored as text
+std::string toText(uint64_t value) {
+    return std::to_string(value);
+}
+
+uint64_t fromText(const Json* json) {
+    return json && json->isString() ? std::strtoull(json->asString().c_str(), nullptr, 10) : 0;
+}
+
+} // namespace
+
+bool FileSignature::matches(const FileSignature& current) const {
+    if (!exists || !current.exists || size != current.size) return false;
+    // A matching hash survives a reinstall that only touched the file
+    if (current.hash != 0) return hash == current.hash;
+    return mtimeNs == current.mtimeNs;
+}
+
+FileSignature fileSignature(const std::string& path, bool withHash) {
+    FileSignature sig;
+    std::error_code ec;
+    fs::file_status status = fs::status(path, ec);
+    if (ec || !fs::exists(status)) return sig;
+
+    if (fs::is_directory(status)) {
+        // Bundle: every file inside, in a stable order for the hash
+        std::vector<fs::path> files;
+        for (auto it = fs::recursive_directory_iterator(path, ec); !ec && it != fs::recursive_directory_iterator();
+             it.increment(ec)) {
+            if (it->is_regular_file(ec)) files.push_back(it->path());
+        }
+        if (ec) return sig;
+        std::sort(files.begin(), files.end());
+        uint64_t hash = FNV_OFFSET;
+        for (const auto& file : files) {
+            sig.size += fs::file_size(file, ec);
+            sig.mtimeNs = std::max(sig.mtimeNs, mtimeNs(file, ec));
+            if (ec || (withHash && !hashFile(file, hash))) return FileSignature{};
+        }
+        sig.mtimeNs = std::max(sig.mtimeNs, mtimeNs(path, ec));
+        if (withHash) sig.hash = hash;
+    } else {
+        sig.size = fs::file_size(path, ec);
+        sig.mtimeNs = mtimeNs(path, ec);
+        uint64_t hash = FNV_OFFSET;
+        if (ec || (withHash && !hashFile(path, hash))) return FileSignature{};
+        if (withHash) sig.hash = hash;
+    }
+    sig.exists = true;
+    return sig;
+}
+
+//-----------------------------------------------------------------------------
+// ScanCache
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<ScanCache> ScanCache::open(const std::string& file) {
+    auto cache = std::unique_ptr<ScanCache>(new ScanCache());
+    cache->file_ = file;
+
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return cache;  // Not created yet
+    std::stringstream text;
+    text << in.rdbuf();
+
+    std::string parseError;
+    Json json = Json::parse(text.str(), &parseError);
+    if (!parseError.empty() || !json.isObject()) {
+        cache->error_ = "Corrupt scan cache " + file + ": " + parseError;
+        return cache;
+    }
+    const Json* version = json.get("version");
+    if (!version || version->asNumber() != FORMAT_VERSION) return cache;  // Older format: rescan
+
+    const Json* entries = json.get("entries");
+    if (!entries) return cache;
+    for (const auto& item : entries->items()) {
+        const Json* path = item.get("path");
+        if (!path || !path->isString()) continue;
+        ScanEntry entry;
+        entry.path = path->asString();
+        entry.signature.exists = true;
+        entry.signature.size = fromText(item.get("size"));
+        entry.signature.mtimeNs = static_cast<int64_t>(fromText(item.get("mtimeNs")));
+        entry.signature.hash = fromText(item.get("hash"));
+        const Json* ok = item.get("ok");
+        entry.ok = ok && ok->asBool();
+        if (const Json* error = item.get("error")) entry.error = error->asString();
+        if (const Json* plugins = item.get("plugins"); plugins && plugins->isArray()) entry.plugins = *plugins;
+        cache->entries_[entry.path] = std::move(entry);
+    }
+    return cache;
+}
+
+std::string ScanCache::defaultPath() {
+    fs::path base;
+#if defined(_WIN32)
+    if (const char* local = std::getenv("LOCALAPPDATA")) base = fs::path(local) / "clap-trap";
+#elif defined(__APPLE__)
+    if (const char* home = std::getenv("HOME")) base = fs::path(home) / "Library" / "Caches" / "clap-trap";
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        base = fs::path(xdg) / "clap-trap";
+    } else if (const char* home = std::getenv("HOME")) {
+        base = fs::path(home) / ".cache" / "clap-trap";
+    }
+#endif
+    if (base.empty()) base = ".";
+    return (base / "scan-cache.json").string();
+}
+
+std::string ScanCache::normalize(const std::string& path) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    if (ec) return fs::path(path).lexically_normal().string();
+    fs::path canonical = fs::weakly_canonical(absolute, ec);
+    return (ec ? absolute.lexically_normal() : canonical).string();
+}
+
+const ScanEntry* ScanCache::lookup(const std::string& path, const FileSignature& current) const {
+    const ScanEntry* entry = find(path);
+    return entry && entry->signature.matches(current) ? entry : nullptr;
+}
+
+const ScanEntry* ScanCache::find(const std::string& path) const {
+    auto it = entries_.find(normalize(path));
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+void ScanCache::put(ScanEntry entry) {
+    entry.path = normalize(entry.path);
+    std::string path = entry.path;
+    entries_[path] = std::move(entry);
+}
+
+bool ScanCache::remove(const std::string& path) {
+    return entries_.erase(normalize(path)) > 0;
+}
+
+bool ScanCache::save() {
+    Json entries = Json::array();
+    for (const auto& [path, entry] : entries_) {
+        Json item = Json::object();
+        item.set("path", path)
+            .set("size", toText(entry.signature.size))
+            .set("mtimeNs", toText(static_cast<uint64_t>(entry.signature.mtimeNs)));
+        if (entry.signature.hash != 0) item.set("hash", toText(entry.signature.hash));
+        item.set("ok", entry.ok);
+        if (!entry.error.empty()) item.set("error", entry.error);
+        item.set("plugins", entry.plugins);
+        entries.push(std::move(item));
+    }
+    Json json = Json::object();
+    json.set("version", FORMAT_VERSION).set("entries", std::move(entries));
+
+    std::error_code ec;
+    fs::path target(file_);
+    if (target.has_parent_path()) fs::create_directories(target.parent_path(), ec);
+
+    std::string temp = file_ + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << json.dump(-1) << "\n";
+        if (!out.flush()) {
+            error_ = "Cannot write scan cache " + temp;
+            return false;
+        }
+    }
+    fs::rename(temp, target, ec);
+    if (ec) {
+        error_ = "Cannot replace scan cache " + file_ + ": " + ec.message();
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace clap_trap
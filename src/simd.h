@@ -0,0 +1,74 @@
+/**
+ * clap-trap: SIMD helpers (internal)
+ *
+ * Instruction set selection for the vectorized kernels. SSE2 is the x86-64
+ * baseline and NEON the AArch64 baseline; anything above that is compiled
+ * per function and picked at runtime.
+ */
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CLAP_TRAP_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CLAP_TRAP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Compile a single function for an instruction set above the baseline
+#if defined(CLAP_TRAP_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CLAP_TRAP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CLAP_TRAP_TARGET(isa)
+#endif
+
+namespace clap_trap {
+namespace simd {
+
+#if defined(CLAP_TRAP_SIMD_X86)
+
+inline bool hasSsse3() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const bool supported = [] {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+    }();
+    return supported;
+#else
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+#endif
+}
+
+inline bool hasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const bool supported = [] {
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#else
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#endif
+}
+
+#else
+
+inline bool hasSsse3() { return false; }
+inline bool hasAvx2() { return false; }
+
+#endif
+
+} // namespace simd
+} // namespace clap_trap
@@ -3,7 +3,9 @@
  */
 
 #include "clap-trap/test-host.h"
+#include <cstdio>
 #include <cstring>
+#include <utility>
 
 namespace clap_trap {
 
@@ -11,7 +13,31 @@ namespace clap_trap {
 // TestHost
 //-----------------------------------------------------------------------------
 
-TestHost::TestHost(const char* name, const char* vendor, const char* version) {
+namespace {
+
+thread_local bool tAudioThread = false;
+
+TestHost* hostOf(const clap_host_t* host) {
+    return static_cast<TestHost*>(host->host_data);
+}
+
+} // namespace
+
+const char* logSeverityName(clap_log_severity severity) {
+    switch (severity) {
+        case CLAP_LOG_DEBUG:              return "debug";
+        case CLAP_LOG_INFO:               return "info";
+        case CLAP_LOG_WARNING:            return "warning";
+        case CLAP_LOG_ERROR:              return "error";
+        case CLAP_LOG_FATAL:              return "fatal";
+        case CLAP_LOG_HOST_MISBEHAVING:   return "host misbehaving";
+        case CLAP_LOG_PLUGIN_MISBEHAVING: return "plugin misbehaving";
+        default:                          return "?";
+    }
+}
+
+TestHost::TestHost(const char* name, const char* vendor, const char* version)
+    : mainThread_(std::this_thread::get_id()) {
     host_.clap_version = CLAP_VERSION;
     host_.host_data = this;
     host_.name = name;
@@ -22,22 +48,143 @@ TestHost::TestHost(const char* name, const char* vendor, const char* version) {
     host_.request_restart = hostRequestRestart;
     host_.request_process = hostRequestProcess;
     host_.request_callback = hostRequestCallback;
+
+    paramsExt_.rescan = [](const clap_host_t* host, clap_param_rescan_flags flags) {
+        hostOf(host)->paramsRescanFlags_.fetch_or(flags);
+    };
+    paramsExt_.clear = [](const clap_host_t*, clap_id, clap_param_clear_flags) {};
+    paramsExt_.request_flush = [](const clap_host_t* host) {
+        hostOf(host)->paramsFlushRequested_ = true;
+    };
+    latencyExt_.changed = [](const clap_host_t* host) { hostOf(host)->latencyChanged_ = true; };
+    tailExt_.changed = [](const clap_host_t* host) { hostOf(host)->tailChanged_ = true; };
+    logExt_.log = [](const clap_host_t* host, clap_log_severity severity, const char* msg) {
+        auto* owner = hostOf(host);
+        if (tAudioThread) {
+            // No lock and no I/O on the audio thread: copy into the ring, or drop
+            AudioLogEntry entry;
+            entry.severity = severity;
+            size_t length = msg ? strnlen(msg, AUDIO_LOG_TEXT_BYTES - 1) : 0;
+            memcpy(entry.text, msg ? msg : "", length);
+            entry.text[length] = '\0';
+            bool queued = false;
+            if (!owner->audioLogBusy_.test_and_set(std::memory_order_acquire)) {
+                queued = owner->audioLog_.tryPush(entry);
+                owner->audioLogBusy_.clear(std::memory_order_release);
+            }
+            if (!queued) owner->audioLogDropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(owner->logMutex_);
+        owner->log_.push_back({severity, msg ? msg : ""});
+        if (owner->logEcho_) fprintf(stderr, "[plugin %s] %s\n", logSeverityName(severity), msg ? msg : "");
+    };
+    threadCheckExt_.is_main_thread = [](const clap_host_t* host) {
+        return !tAudioThread && std::this_thread::get_id() == hostOf(host)->mainThread_;
+    };
+    threadCheckExt_.is_audio_thread = [](const clap_host_t*) { return tAudioThread; };
 }
 
 void TestHost::resetRequests() {
     restartRequested_ = false;
     processRequested_ = false;
     callbackRequested_ = false;
+    paramsRescanFlags_ = 0;
+    paramsFlushRequested_ = false;
+    latencyChanged_ = false;
+    tailChanged_ = false;
+}
+
+void TestHost::drainAudioLog() {
+    AudioLogEntry entry;
+    std::lock_guard<std::mutex> lock(logMutex_);
+    while (audioLog_.tryPop(entry)) {
+        log_.push_back({entry.severity, entry.text});
+        if (logEcho_) fprintf(stderr, "[plugin %s] %s\n", logSeverityName(entry.severity), entry.text);
+    }
+}
+
+std::vector<LogMessage> TestHost::takeLogMessages() {
+    drainAudioLog();
+    std::lock_guard<std::mutex> lock(logMutex_);
+    return std::exchange(log_, {});
+}
+
+bool TestHost::pumpMainThread() {
+    drainAudioLog();
+    if (!plugin_) return false;
+
+    // The callback and flush must see the main thread, even inside an AudioThreadScope
+    bool wasAudio = tAudioThread;
+    tAudioThread = false;
+    bool ran = false;
+    if (callbackRequested_.exchange(false)) {
+        plugin_->on_main_thread(plugin_);
+        ran = true;
+    }
+    if (!pluginActive_ && paramsFlushRequested_.exchange(false)) {
+        const auto* params = static_cast<const clap_plugin_params_t*>(
+            plugin_->get_extension(plugin_, CLAP_EXT_PARAMS));
+        if (params && params->flush) {
+            EmptyInputEvents in;
+            DiscardOutputEvents out;
+            params->flush(plugin_, in.get(), out.get());
+            ran = true;
+        }
+    }
+    tAudioThread = wasAudio;
+    return ran;
+}
+
+TestHost::AudioThreadScope::AudioThreadScope() : previous_(tAudioThread) {
+    tAudioThread = true;
+}
+
+TestHost::AudioThreadScope::~AudioThreadScope() {
+    tAudioThread = previous_;
+}
+
+void TestHost::enableThreadPool(uint32_t workers, bool pinWorkers) {
+    threadPool_ = std::make_unique<ThreadPool>(workers, pinWorkers);
+    threadPoolExt_.request_exec = hostRequestExec;
+}
+
+void TestHost::setPlugin(const clap_plugin_t* plugin) {
+    plugin_ = plugin;
+    pluginThreadPool_ = nullptr;
+    if (plugin) {
+        pluginThreadPool_ = static_cast<const clap_plugin_thread_pool_t*>(
+            plugin->get_extension(plugin, CLAP_EXT_THREAD_POOL));
+    }
 }
 
 const void* TestHost::hostGetExtension(const clap_host_t* host, const char* id) {
     auto* self = static_cast<TestHost*>(host->host_data);
     if (self->extensionCallback_) {
-        return self->extensionCallback_(id);
+        if (const void* ext = self->extensionCallback_(id)) return ext;
+    }
+    if (strcmp(id, CLAP_EXT_PARAMS) == 0) return &self->paramsExt_;
+    if (strcmp(id, CLAP_EXT_LATENCY) == 0) return &self->latencyExt_;
+    if (strcmp(id, CLAP_EXT_TAIL) == 0) return &self->tailExt_;
+    if (strcmp(id, CLAP_EXT_LOG) == 0) return &self->logExt_;
+    if (strcmp(id, CLAP_EXT_THREAD_CHECK) == 0) return &self->threadCheckExt_;
+    if (self->threadPool_ && strcmp(id, CLAP_EXT_THREAD_POOL) == 0) {
+        return &self->threadPoolExt_;
     }
     return nullptr;
 }
 
+bool TestHost::hostRequestExec(const clap_host_t* host, uint32_t numTasks) {
+    auto* self = static_cast<TestHost*>(host->host_data);
+    if (!self->threadPool_ || !self->pluginThreadPool_ || !self->pluginThreadPool_->exec) return false;
+    return self->threadPool_->run(numTasks, [](void* context, uint32_t index) {
+        // Pool workers count as audio threads
+        AudioThreadScope audio;
+        auto* owner = static_cast<TestHost*>(context);
+        owner->pluginThreadPool_->exec(owner->plugin_, index);
+    }, self);
+}
+
 void TestHost::hostRequestRestart(const clap_host_t* host) {
     auto* self = static_cast<TestHost*>(host->host_data);
     self->restartRequested_ = true;
@@ -80,14 +227,9 @@ DiscardOutputEvents::DiscardOutputEvents() {
 // CaptureOutputEvents
 //-----------------------------------------------------------------------------
 
-CaptureOutputEvents::CaptureOutputEvents() {
-    events_.ctx = this;
-    events_.try_push = tryPush;
-}
-
-bool CaptureOutputEvents::tryPush(const clap_output_events_t* list, const clap_event_header_t* event) {
-    auto* self = static_cast<CaptureOutputEvents*>(list->ctx);
+namespace {
 
+CapturedEvent toCapturedEvent(const clap_event_header_t* event) {
     CapturedEvent captured{};
     captured.time = event->time;
     captured.type = event->type;
@@ -128,7 +270,19 @@ bool CaptureOutputEvents::tryPush(const clap_output_events_t* list, const clap_e
             break;
     }
 
-    self->captured_.push_back(captured);
+    return captured;
+}
+
+} // anonymous namespace
+
+CaptureOutputEvents::CaptureOutputEvents() {
+    events_.ctx = this;
+    events_.try_push = tryPush;
+}
+
+bool CaptureOutputEvents::tryPush(const clap_output_events_t* list, const clap_event_header_t* event) {
+    auto* self = static_cast<CaptureOutputEvents*>(list->ctx);
+    self->captured_.push_back(toCapturedEvent(event));
     return true;
 }
 
@@ -164,93 +318,241 @@ size_t CaptureOutputEvents::countParamValue() const {
     return count;
 }
 
+//-----------------------------------------------------------------------------
+// RingCaptureOutputEvents
+//-----------------------------------------------------------------------------
+
+RingCaptureOutputEvents::RingCaptureOutputEvents(size_t capacity) : ring_(capacity) {
+    events_.ctx = this;
+    events_.try_push = tryPush;
+}
+
+bool RingCaptureOutputEvents::tryPush(const clap_output_events_t* list, const clap_event_header_t* event) {
+    auto* self = static_cast<RingCaptureOutputEvents*>(list->ctx);
+    Entry entry{self->blockStart_ + event->time, toCapturedEvent(event)};
+    if (!self->ring_.tryPush(entry)) {
+        self->overflows_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    self->captured_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 // SimpleInputEvents
 //-----------------------------------------------------------------------------
 
-SimpleInputEvents::SimpleInputEvents() {
+namespace {
+
+// Keep every event 8-byte aligned inside the arena
+constexpr size_t EVENT_ALIGNMENT = 8;
+
+} // anonymous namespace
+
+SimpleInputEvents::SimpleInputEvents(size_t capacityBytes, uint32_t maxEvents)
+    : arena_(capacityBytes), order_(maxEvents) {
     events_.ctx = this;
     events_.size = size;
     events_.get = getEvent;
 }
 
-void SimpleInputEvents::addNoteOn(uint32_t time, int16_t port, int16_t channel,
-                                   int16_t key, int32_t noteId, double velocity) {
-    size_t offset = eventData_.size();
-    eventData_.resize(offset + sizeof(clap_event_note_t));
-
-    auto* event = reinterpret_cast<clap_event_note_t*>(eventData_.data() + offset);
-    event->header.size = sizeof(clap_event_note_t);
-    event->header.time = time;
-    event->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-    event->header.type = CLAP_EVENT_NOTE_ON;
-    event->header.flags = 0;
+void* SimpleInputEvents::allocate(uint32_t time, uint16_t type, uint32_t size, size_t extra) {
+    size_t bytes = (size + extra + EVENT_ALIGNMENT - 1) & ~(EVENT_ALIGNMENT - 1);
+    if (eventCount_ == order_.size() || bytes > arena_.size() - used_) {
+        dropped_++;
+        return nullptr;
+    }
+
+    uint32_t offset = static_cast<uint32_t>(used_);
+    used_ += bytes;
+
+    auto* header = reinterpret_cast<clap_event_header_t*>(arena_.data() + offset);
+    header->size = size;
+    header->time = time;
+    header->space_id = CLAP_CORE_EVENT_SPACE_ID;
+    header->type = type;
+    header->flags = 0;
+
+    // Events usually arrive in order, so search back from the end
+    uint32_t pos = eventCount_;
+    while (pos > 0) {
+        auto* prev = reinterpret_cast<const clap_event_header_t*>(arena_.data() + order_[pos - 1]);
+        if (prev->time <= time) break;
+        order_[pos] = order_[pos - 1];
+        --pos;
+    }
+    order_[pos] = offset;
+    eventCount_++;
+    return header;
+}
+
+bool SimpleInputEvents::addNoteOn(uint32_t time, int16_t port, int16_t channel,
+                                  int16_t key, int32_t noteId, double velocity) {
+    auto* event = static_cast<clap_event_note_t*>(
+        allocate(time, CLAP_EVENT_NOTE_ON, sizeof(clap_event_note_t)));
+    if (!event) return false;
     event->note_id = noteId;
     event->port_index = port;
     event->channel = channel;
     event->key = key;
     event->velocity = velocity;
-
-    eventOffsets_.push_back(offset);
+    return true;
 }
 
-void SimpleInputEvents::addNoteOff(uint32_t time, int16_t port, int16_t channel,
-                                    int16_t key, int32_t noteId, double velocity) {
-    size_t offset = eventData_.size();
-    eventData_.resize(offset + sizeof(clap_event_note_t));
-
-    auto* event = reinterpret_cast<clap_event_note_t*>(eventData_.data() + offset);
-    event->header.size = sizeof(clap_event_note_t);
-    event->header.time = time;
-    event->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-    event->header.type = CLAP_EVENT_NOTE_OFF;
-    event->header.flags = 0;
+bool SimpleInputEvents::addNoteOff(uint32_t time, int16_t port, int16_t channel,
+                                   int16_t key, int32_t noteId, double velocity) {
+    auto* event = static_cast<clap_event_note_t*>(
+        allocate(time, CLAP_EVENT_NOTE_OFF, sizeof(clap_event_note_t)));
+    if (!event) return false;
     event->note_id = noteId;
     event->port_index = port;
     event->channel = channel;
     event->key = key;
     event->velocity = velocity;
+    return true;
+}
 
-    eventOffsets_.push_back(offset);
+bool SimpleInputEvents::addNoteChoke(uint32_t time, int16_t port, int16_t channel,
+                                     int16_t key, int32_t noteId) {
+    auto* event = static_cast<clap_event_note_t*>(
+        allocate(time, CLAP_EVENT_NOTE_CHOKE, sizeof(clap_event_note_t)));
+    if (!event) return false;
+    event->note_id = noteId;
+    event->port_index = port;
+    event->channel = channel;
+    event->key = key;
+    event->velocity = 0.0;
+    return true;
 }
 
-void SimpleInputEvents::addParamValue(uint32_t time, clap_id paramId, double value) {
-    size_t offset = eventData_.size();
-    eventData_.resize(offset + sizeof(clap_event_param_value_t));
+bool SimpleInputEvents::addNoteExpression(uint32_t time, clap_note_expression expressionId,
+                                          int16_t port, int16_t channel, int16_t key,
+                                          int32_t noteId, double value) {
+    auto* event = static_cast<clap_event_note_expression_t*>(
+        allocate(time, CLAP_EVENT_NOTE_EXPRESSION, sizeof(clap_event_note_expression_t)));
+    if (!event) return false;
+    event->expression_id = expressionId;
+    event->note_id = noteId;
+    event->port_index = port;
+    event->channel = channel;
+    event->key = key;
+    event->value = value;
+    return true;
+}
 
-    auto* event = reinterpret_cast<clap_event_param_value_t*>(eventData_.data() + offset);
-    event->header.size = sizeof(clap_event_param_value_t);
-    event->header.time = time;
-    event->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-    event->header.type = CLAP_EVENT_PARAM_VALUE;
-    event->header.flags = 0;
+bool SimpleInputEvents::addParamValue(uint32_t time, clap_id paramId, double value,
+                                      int32_t noteId, int16_t port, int16_t channel, int16_t key) {
+    auto* event = static_cast<clap_event_param_value_t*>(
+        allocate(time, CLAP_EVENT_PARAM_VALUE, sizeof(clap_event_param_value_t)));
+    if (!event) return false;
     event->param_id = paramId;
     event->cookie = nullptr;
-    event->note_id = -1;
-    event->port_index = -1;
-    event->channel = -1;
-    event->key = -1;
+    event->note_id = noteId;
+    event->port_index = port;
+    event->channel = channel;
+    event->key = key;
     event->value = value;
+    return true;
+}
 
-    eventOffsets_.push_back(offset);
+bool SimpleInputEvents::addParamMod(uint32_t time, clap_id paramId, double amount,
+                                    int32_t noteId, int16_t port, int16_t channel, int16_t key) {
+    auto* event = static_cast<clap_event_param_mod_t*>(
+        allocate(time, CLAP_EVENT_PARAM_MOD, sizeof(clap_event_param_mod_t)));
+    if (!event) return false;
+    event->param_id = paramId;
+    event->cookie = nullptr;
+    event->note_id = noteId;
+    event->port_index = port;
+    event->channel = channel;
+    event->key = key;
+    event->amount = amount;
+    return true;
+}
+
+bool SimpleInputEvents::addParamGestureBegin(uint32_t time, clap_id paramId) {
+    auto* event = static_cast<clap_event_param_gesture_t*>(
+        allocate(time, CLAP_EVENT_PARAM_GESTURE_BEGIN, sizeof(clap_event_param_gesture_t)));
+    if (!event) return false;
+    event->param_id = paramId;
+    return true;
+}
+
+bool SimpleInputEvents::addParamGestureEnd(uint32_t time, clap_id paramId) {
+    auto* event = static_cast<clap_event_param_gesture_t*>(
+        allocate(time, CLAP_EVENT_PARAM_GESTURE_END, sizeof(clap_event_param_gesture_t)));
+    if (!event) return false;
+    event->param_id = paramId;
+    return true;
+}
+
+bool SimpleInputEvents::addTransport(uint32_t time, const clap_event_transport_t& transport) {
+    auto* event = static_cast<clap_event_transport_t*>(
+        allocate(time, CLAP_EVENT_TRANSPORT, sizeof(clap_event_transport_t)));
+    if (!event) return false;
+    clap_event_header_t header = event->header;
+    *event = transport;
+    event->header = header;
+    return true;
+}
+
+bool SimpleInputEvents::addMidi(uint32_t time, uint16_t port,
+                                uint8_t status, uint8_t data1, uint8_t data2) {
+    auto* event = static_cast<clap_event_midi_t*>(
+        allocate(time, CLAP_EVENT_MIDI, sizeof(clap_event_midi_t)));
+    if (!event) return false;
+    event->port_index = port;
+    event->data[0] = status;
+    event->data[1] = data1;
+    event->data[2] = data2;
+    return true;
+}
+
+bool SimpleInputEvents::addMidiSysex(uint32_t time, uint16_t port, const uint8_t* data, uint32_t size) {
+    // The payload lives right after the event, so it stays valid until clear()
+    auto* event = static_cast<clap_event_midi_sysex_t*>(
+        allocate(time, CLAP_EVENT_MIDI_SYSEX, sizeof(clap_event_midi_sysex_t), size));
+    if (!event) return false;
+    auto* payload = reinterpret_cast<uint8_t*>(event) + sizeof(clap_event_midi_sysex_t);
+    std::memcpy(payload, data, size);
+    event->port_index = port;
+    event->buffer = payload;
+    event->size = size;
+    return true;
+}
+
+bool SimpleInputEvents::addMidi2(uint32_t time, uint16_t port, const uint32_t data[4]) {
+    auto* event = static_cast<clap_event_midi2_t*>(
+        allocate(time, CLAP_EVENT_MIDI2, sizeof(clap_event_midi2_t)));
+    if (!event) return false;
+    event->port_index = port;
+    std::memcpy(event->data, data, sizeof(event->data));
+    return true;
+}
+
+bool SimpleInputEvents::add(const clap_event_header_t* event) {
+    if (event->size < sizeof(clap_event_header_t)) return false;
+    auto* copy = static_cast<clap_event_header_t*>(allocate(event->time, event->type, event->size));
+    if (!copy) return false;
+    std::memcpy(copy, event, event->size);
+    return true;
 }
 
 void SimpleInputEvents::clear() {
-    eventData_.clear();
-    eventOffsets_.clear();
+    used_ = 0;
+    eventCount_ = 0;
 }
 
 uint32_t SimpleInputEvents::size(const clap_input_events_t* list) {
     auto* self = static_cast<SimpleInputEvents*>(list->ctx);
-    return static_cast<uint32_t>(self->eventOffsets_.size());
+    return self->eventCount_;
 }
 
 const clap_event_header_t* SimpleInputEvents::getEvent(const clap_input_events_t* list, uint32_t index) {
     auto* self = static_cast<SimpleInputEvents*>(list->ctx);
-    if (index >= self->eventOffsets_.size()) return nullptr;
-    // Use offset to get pointer (safe after all events are added)
+    if (index >= self->eventCount_) return nullptr;
     return reinterpret_cast<const clap_event_header_t*>(
-        self->eventData_.data() + self->eventOffsets_[index]);
+        self->arena_.data() + self->order_[index]);
 }
 
 } // namespace clap_trap
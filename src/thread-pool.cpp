@@ -0,0 +1,160 @@
+/**
+ * clap-trap: Thread Pool Implementation
+ */
+
+#include "clap-trap/thread-pool.h"
+#include "clap-trap/threading.h"
+#include <chrono>
+
+namespace clap_trap {
+
+namespace {
+
+// A host requests work every block, so workers spin a little before sleeping
+constexpr int SPIN_ITERATIONS = 2000;
+
+constexpr uint64_t INDEX_MASK = ThreadPool::MAX_TASKS;
+
+uint64_t packRange(uint32_t generation, uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(generation & 0xffff) << 48) | (static_cast<uint64_t>(begin) << 24) | end;
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(uint32_t workers, bool pin)
+    : shares_(std::make_unique<Share[]>(workers + 1))
+    , counters_(std::make_unique<Counters[]>(workers + 1))
+    , participants_(workers + 1) {
+    workers_.reserve(workers);
+    for (uint32_t w = 0; w < workers; ++w) {
+        workers_.emplace_back([this, w, pin] { workerLoop(w + 1, pin); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop_.store(true);
+    generation_.fetch_add(1);
+    generation_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+bool ThreadPool::take(uint32_t share, uint32_t generation, bool fromBack, uint32_t& index) {
+    auto& range = shares_[share].range;
+    uint64_t tag = generation & 0xffff;
+    uint64_t value = range.load();
+    for (;;) {
+        // A share tagged with another generation belongs to an older or newer job
+        if ((value >> 48) != tag) return false;
+        uint32_t begin = static_cast<uint32_t>((value >> 24) & INDEX_MASK);
+        uint32_t end = static_cast<uint32_t>(value & INDEX_MASK);
+        if (begin >= end) return false;
+        uint64_t next = fromBack ? packRange(generation, begin, end - 1) : packRange(generation, begin + 1, end);
+        if (range.compare_exchange_weak(value, next)) {
+            index = fromBack ? end - 1 : begin;
+            return true;
+        }
+    }
+}
+
+void ThreadPool::work(uint32_t self, uint32_t generation, Job& job) {
+    Counters& counters = counters_[self];
+    auto execute = [&](uint32_t index, bool stolen) {
+        auto start = std::chrono::steady_clock::now();
+        job.task(job.context, index);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        // Single writer per counter set, so no read-modify-write needed
+        counters.tasks.store(counters.tasks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counters.taskNs.store(counters.taskNs.load(std::memory_order_relaxed) + static_cast<uint64_t>(ns.count()),
+                              std::memory_order_relaxed);
+        if (stolen) {
+            counters.stolen.store(counters.stolen.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        job.remaining.fetch_sub(1);
+    };
+
+    uint32_t index;
+    while (take(self, generation, false, index)) execute(index, false);
+    for (uint32_t k = 1; k < participants_; ++k) {
+        uint32_t victim = (self + k) % participants_;
+        while (take(victim, generation, true, index)) execute(index, true);
+    }
+}
+
+void ThreadPool::workerLoop(uint32_t index, bool pin) {
+    if (pin) pinCurrentThreadToCore(index % hardwareThreadCount());
+
+    uint32_t seen = 0;
+    for (;;) {
+        uint32_t generation = generation_.load();
+        for (int s = 0; s < SPIN_ITERATIONS && generation == seen; ++s) {
+            std::this_thread::yield();
+            generation = generation_.load();
+        }
+        if (generation == seen) {
+            generation_.wait(seen);
+            continue;
+        }
+        if (stop_.load()) return;
+        seen = generation;
+
+        // Checked again after registering, so the caller can't start the
+        // next job (and reuse this one's slot) while we are still in it
+        active_.fetch_add(1);
+        if (generation_.load() == generation) work(index, generation, jobs_[generation & 1]);
+        active_.fetch_sub(1);
+    }
+}
+
+bool ThreadPool::run(uint32_t count, Task task, void* context) {
+    if (count == 0) return true;
+    if (count > MAX_TASKS || busy_.exchange(true)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t generation = generation_.load() + 1;
+    Job& job = jobs_[generation & 1];
+    job.task = task;
+    job.context = context;
+    job.remaining.store(count);
+    for (uint32_t p = 0; p < participants_; ++p) {
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * p / participants_);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (p + 1) / participants_);
+        shares_[p].range.store(packRange(generation, begin, end));
+    }
+    generation_.store(generation);
+    if (!workers_.empty()) generation_.notify_all();
+
+    work(0, generation, job);
+    while (job.remaining.load() != 0 || active_.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    runs_.fetch_add(1, std::memory_order_relaxed);
+    busy_.store(false);
+    return true;
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    Stats stats;
+    stats.runs = runs_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    for (uint32_t p = 0; p < participants_; ++p) {
+        stats.tasks += counters_[p].tasks.load(std::memory_order_relaxed);
+        stats.stolen += counters_[p].stolen.load(std::memory_order_relaxed);
+        stats.taskNs += counters_[p].taskNs.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void ThreadPool::resetStats() {
+    runs_.store(0, std::memory_order_relaxed);
+    rejected_.store(0, std::memory_order_relaxed);
+    for (uint32_t p = 0; p < participants_; ++p) {
+        counters_[p].tasks.store(0, std::memory_order_relaxed);
+        counters_[p].stolen.store(0, std::memory_order_relaxed);
+        counters_[p].taskNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace clap_trap
@@ -0,0 +1,115 @@
+/**
+ * clap-trap: Threading helpers implementation
+ */
+
+#include "clap-trap/threading.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+namespace clap_trap {
+
+uint32_t hardwareThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+bool pinCurrentThreadToCore(uint32_t core) {
+#if defined(_WIN32)
+    if (core >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__APPLE__)
+    // macOS has no hard affinity; threads sharing a tag are kept apart from others
+    thread_affinity_policy_data_t policy = {static_cast<integer_t>(core + 1)};
+    thread_port_t thread = pthread_mach_thread_np(pthread_self());
+    return thread_policy_set(thread, THREAD_AFFINITY_POLICY,
+                             reinterpret_cast<thread_policy_t>(&policy),
+                             THREAD_AFFINITY_POLICY_COUNT) == KERN_SUCCESS;
+#else
+    if (core >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+bool setCurrentThreadRealtime(uint64_t periodNs, std::string& detail) {
+#if defined(_WIN32)
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        detail = "SetThreadPriority failed";
+        return false;
+    }
+    detail = "time-critical priority";
+    return true;
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    auto toTicks = [&](uint64_t ns) {
+        return static_cast<uint32_t>(ns * timebase.denom / timebase.numer);
+    };
+    thread_time_constraint_policy_data_t policy;
+    policy.period = toTicks(periodNs);
+    policy.computation = toTicks(periodNs / 2);
+    policy.constraint = toTicks(periodNs);
+    policy.preemptible = 1;
+    thread_port_t thread = pthread_mach_thread_np(pthread_self());
+    if (thread_policy_set(thread, THREAD_TIME_CONSTRAINT_POLICY, reinterpret_cast<thread_policy_t>(&policy),
+                          THREAD_TIME_CONSTRAINT_POLICY_COUNT) != KERN_SUCCESS) {
+        detail = "time-constraint policy refused";
+        return false;
+    }
+    detail = "time-constraint policy";
+    return true;
+#else
+    (void)periodNs;
+    // Below the kernel's own threads at the top of the range
+    constexpr int PRIORITY = 80;
+    sched_param param{};
+    param.sched_priority = std::min(PRIORITY, sched_get_priority_max(SCHED_FIFO));
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        detail = std::string("SCHED_FIFO refused: ") + strerror(error);
+        return false;
+    }
+    detail = "SCHED_FIFO priority " + std::to_string(param.sched_priority);
+    return true;
+#endif
+}
+
+void sleepUntil(std::chrono::steady_clock::time_point deadline) {
+#if defined(__linux__)
+    // libstdc++'s steady_clock is CLOCK_MONOTONIC; an absolute wait doesn't drift
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    timespec target;
+    target.tv_sec = static_cast<time_t>(ns / 1000000000);
+    target.tv_nsec = static_cast<long>(ns % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {}
+#elif defined(__APPLE__)
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero()) return;
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+    mach_wait_until(mach_absolute_time() + ns * timebase.denom / timebase.numer);
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+} // namespace clap_trap
@@ -2,23 +2,30 @@
  * clap-trap: Simple WAV file I/O
  *
  * Minimal implementation for reading/writing PCM WAV files.
- * Supports 16-bit and 32-bit float formats.
+ * Reads 16/24/32-bit PCM and 32-bit float; writes 16-bit PCM and 32-bit float.
  */
 
 #include "clap-trap/wav-file.h"
+#include "clap-trap/resampler.h"
+#include "simd.h"
+#include <algorithm>
 #include <cstring>
-#include <fstream>
 #include <cmath>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace clap_trap {
 
 namespace {
 
-struct RiffChunk {
-    char id[4];
-    uint32_t size;
-};
-
 struct WavFmtChunk {
     uint16_t audioFormat;
     uint16_t numChannels;
@@ -28,168 +35,574 @@ struct WavFmtChunk {
     uint16_t bitsPerSample;
 };
 
-template<typename T>
-T readLE(std::ifstream& file) {
-    T value;
-    file.read(reinterpret_cast<char*>(&value), sizeof(T));
-    return value;
-}
+// Validated format of a WAV file and where its sample data lives
+struct WavLayout {
+    WavFmtChunk fmt{};
+    uint64_t dataOffset = 0;
+    uint32_t dataSize = 0;
+};
+
+// Size of the canonical header written by WavWriter
+constexpr uint32_t WAV_HEADER_SIZE = 44;
+
+// Frames converted per write() chunk
+constexpr uint32_t WRITE_CHUNK_FRAMES = 4096;
+
+// Samples converted per step when deinterleaving from a mapping
+constexpr size_t CONVERT_CHUNK_SAMPLES = 4096;
+
+// File frames WavReader feeds its resampler per refill
+constexpr uint32_t RESAMPLE_CHUNK_FRAMES = 4096;
 
 template<typename T>
 void writeLE(std::ofstream& file, T value) {
     file.write(reinterpret_cast<const char*>(&value), sizeof(T));
 }
 
-} // anonymous namespace
+template<typename T>
+T loadLE(const uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
 
-//-----------------------------------------------------------------------------
-// WavFile
-//-----------------------------------------------------------------------------
+// Byte sources for parseWavHeader()
+struct StreamSource {
+    std::ifstream& file;
 
-std::unique_ptr<WavFile> WavFile::load(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        auto wav = std::make_unique<WavFile>();
-        wav->error_ = "Could not open file: " + path;
-        return wav;
+    bool read(void* dest, size_t size) {
+        file.read(static_cast<char*>(dest), static_cast<std::streamsize>(size));
+        return static_cast<bool>(file);
+    }
+    void skip(uint32_t size) { file.seekg(size, std::ios::cur); }
+    uint64_t position() { return static_cast<uint64_t>(file.tellg()); }
+};
+
+struct MemorySource {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+
+    bool read(void* dest, size_t count) {
+        if (count > size - pos) {
+            pos = size;
+            return false;
+        }
+        std::memcpy(dest, data + pos, count);
+        pos += count;
+        return true;
     }
+    void skip(uint32_t count) { pos += std::min<size_t>(count, size - pos); }
+    uint64_t position() { return pos; }
+};
 
-    // Read RIFF header
+// Parse the RIFF/WAVE chunks up to the start of the sample data
+template<typename Source>
+bool parseWavHeader(Source& src, WavLayout& layout, std::string& error) {
     char riffId[4];
-    file.read(riffId, 4);
-    if (std::memcmp(riffId, "RIFF", 4) != 0) {
-        auto wav = std::make_unique<WavFile>();
-        wav->error_ = "Not a RIFF file";
-        return wav;
+    if (!src.read(riffId, 4) || std::memcmp(riffId, "RIFF", 4) != 0) {
+        error = "Not a RIFF file";
+        return false;
     }
 
-    uint32_t fileSize = readLE<uint32_t>(file);
-    (void)fileSize;
+    uint32_t fileSize = 0;
+    src.read(&fileSize, 4);
 
     char waveId[4];
-    file.read(waveId, 4);
-    if (std::memcmp(waveId, "WAVE", 4) != 0) {
-        auto wav = std::make_unique<WavFile>();
-        wav->error_ = "Not a WAVE file";
-        return wav;
+    if (!src.read(waveId, 4) || std::memcmp(waveId, "WAVE", 4) != 0) {
+        error = "Not a WAVE file";
+        return false;
     }
 
-    auto wav = std::make_unique<WavFile>();
     bool foundFmt = false;
-    bool foundData = false;
-    WavFmtChunk fmt{};
+    WavFmtChunk& fmt = layout.fmt;
 
     // Read chunks
-    while (file && !foundData) {
+    for (;;) {
         char chunkId[4];
-        file.read(chunkId, 4);
-        if (!file) break;
-
-        uint32_t chunkSize = readLE<uint32_t>(file);
+        uint32_t chunkSize = 0;
+        if (!src.read(chunkId, 4) || !src.read(&chunkSize, 4)) break;
 
         if (std::memcmp(chunkId, "fmt ", 4) == 0) {
-            fmt.audioFormat = readLE<uint16_t>(file);
-            fmt.numChannels = readLE<uint16_t>(file);
-            fmt.sampleRate = readLE<uint32_t>(file);
-            fmt.byteRate = readLE<uint32_t>(file);
-            fmt.blockAlign = readLE<uint16_t>(file);
-            fmt.bitsPerSample = readLE<uint16_t>(file);
+            if (chunkSize < 16 || !src.read(&fmt, 16)) break;
 
             // Skip any extra format bytes
             if (chunkSize > 16) {
-                file.seekg(chunkSize - 16, std::ios::cur);
+                src.skip(chunkSize - 16);
             }
-
-            wav->sampleRate_ = fmt.sampleRate;
-            wav->channels_ = fmt.numChannels;
             foundFmt = true;
         }
         else if (std::memcmp(chunkId, "data", 4) == 0) {
             if (!foundFmt) {
-                wav->error_ = "Data chunk before fmt chunk";
-                return wav;
+                error = "Data chunk before fmt chunk";
+                return false;
             }
 
-            uint32_t numSamples = chunkSize / fmt.blockAlign;
-            wav->samples_.resize(numSamples * fmt.numChannels);
-
             if (fmt.audioFormat == 1) { // PCM
-                if (fmt.bitsPerSample == 16) {
-                    for (uint32_t i = 0; i < numSamples * fmt.numChannels; ++i) {
-                        int16_t sample = readLE<int16_t>(file);
-                        wav->samples_[i] = sample / 32768.0f;
-                    }
-                }
-                else if (fmt.bitsPerSample == 24) {
-                    for (uint32_t i = 0; i < numSamples * fmt.numChannels; ++i) {
-                        uint8_t bytes[3];
-                        file.read(reinterpret_cast<char*>(bytes), 3);
-                        int32_t sample = (bytes[0] << 8) | (bytes[1] << 16) | (bytes[2] << 24);
-                        sample >>= 8; // Sign extend
-                        wav->samples_[i] = sample / 8388608.0f;
-                    }
-                }
-                else if (fmt.bitsPerSample == 32) {
-                    for (uint32_t i = 0; i < numSamples * fmt.numChannels; ++i) {
-                        int32_t sample = readLE<int32_t>(file);
-                        wav->samples_[i] = sample / 2147483648.0f;
-                    }
-                }
-                else {
-                    wav->error_ = "Unsupported bit depth: " + std::to_string(fmt.bitsPerSample);
-                    return wav;
+                if (fmt.bitsPerSample != 16 && fmt.bitsPerSample != 24 && fmt.bitsPerSample != 32) {
+                    error = "Unsupported bit depth: " + std::to_string(fmt.bitsPerSample);
+                    return false;
                 }
             }
             else if (fmt.audioFormat == 3) { // IEEE float
-                if (fmt.bitsPerSample == 32) {
-                    for (uint32_t i = 0; i < numSamples * fmt.numChannels; ++i) {
-                        wav->samples_[i] = readLE<float>(file);
-                    }
-                }
-                else {
-                    wav->error_ = "Unsupported float bit depth: " + std::to_string(fmt.bitsPerSample);
-                    return wav;
+                if (fmt.bitsPerSample != 32) {
+                    error = "Unsupported float bit depth: " + std::to_string(fmt.bitsPerSample);
+                    return false;
                 }
             }
             else {
-                wav->error_ = "Unsupported audio format: " + std::to_string(fmt.audioFormat);
-                return wav;
+                error = "Unsupported audio format: " + std::to_string(fmt.audioFormat);
+                return false;
             }
 
-            foundData = true;
+            if (fmt.numChannels == 0 || fmt.blockAlign != fmt.numChannels * (fmt.bitsPerSample / 8)) {
+                error = "Invalid block alignment";
+                return false;
+            }
+
+            layout.dataOffset = src.position();
+            layout.dataSize = chunkSize;
+            return true;
         }
         else {
             // Skip unknown chunk
-            file.seekg(chunkSize, std::ios::cur);
+            src.skip(chunkSize);
         }
     }
 
-    if (!foundFmt || !foundData) {
-        wav->error_ = "Missing fmt or data chunk";
+    error = "Missing fmt or data chunk";
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// Sample conversion kernels
+//
+// The vector paths multiply by exact powers of two, so they produce the
+// same floats as the scalar tails.
+//-----------------------------------------------------------------------------
+
+void convertInt16(const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(CLAP_TRAP_SIMD_X86)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(CLAP_TRAP_SIMD_NEON)
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(src + i * 2));
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_n_f32(lo, 1.0f / 32768.0f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(hi, 1.0f / 32768.0f));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = loadLE<int16_t>(src + i * 2) / 32768.0f;
+    }
+}
+
+#if defined(CLAP_TRAP_SIMD_X86)
+CLAP_TRAP_TARGET("ssse3")
+size_t convertInt24Ssse3(const uint8_t* src, float* dst, size_t count) {
+    // Move each 3-byte sample into the top of a 32-bit lane; the value is then
+    // the sample scaled by 2^8, which the 2^-31 factor undoes exactly.
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    size_t i = 0;
+    // Each 16-byte load covers 4 samples plus 4 bytes of look-ahead
+    for (; i + 10 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(a, shuffle)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(b, shuffle)), scale));
+    }
+    return i;
+}
+#endif
+
+void convertInt24(const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(CLAP_TRAP_SIMD_X86)
+    if (simd::hasSsse3()) {
+        i = convertInt24Ssse3(src, dst, count);
+    }
+#elif defined(CLAP_TRAP_SIMD_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x3_t bytes = vld3_u8(src + i * 3);
+        uint16x8_t low = vorrq_u16(vmovl_u8(bytes.val[0]), vshll_n_u8(bytes.val[1], 8));
+        int16x8_t high = vmovl_s8(vreinterpret_s8_u8(bytes.val[2]));
+        int32x4_t a = vorrq_s32(vshll_n_s16(vget_low_s16(high), 16),
+                                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(low))));
+        int32x4_t b = vorrq_s32(vshll_n_s16(vget_high_s16(high), 16),
+                                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(low))));
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(a), 1.0f / 8388608.0f));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(b), 1.0f / 8388608.0f));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* b = src + i * 3;
+        int32_t sample = (b[0] << 8) | (b[1] << 16) | (b[2] << 24);
+        sample >>= 8; // Sign extend
+        dst[i] = sample / 8388608.0f;
+    }
+}
+
+void convertInt32(const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(CLAP_TRAP_SIMD_X86)
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+#elif defined(CLAP_TRAP_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        int32x4_t v = vreinterpretq_s32_u8(vld1q_u8(src + i * 4));
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(v), 1.0f / 2147483648.0f));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = loadLE<int32_t>(src + i * 4) / 2147483648.0f;
+    }
+}
+
+// Convert `count` raw little-endian samples to float
+void convertSamples(const uint8_t* src, float* dst, size_t count,
+                    uint16_t audioFormat, uint16_t bitsPerSample) {
+    if (audioFormat == 3) {
+        std::memcpy(dst, src, count * sizeof(float));
+    } else if (bitsPerSample == 16) {
+        convertInt16(src, dst, count);
+    } else if (bitsPerSample == 24) {
+        convertInt24(src, dst, count);
+    } else {
+        convertInt32(src, dst, count);
+    }
+}
+
+} // anonymous namespace
+
+//-----------------------------------------------------------------------------
+// WavFile
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<WavFile> WavFile::load(const std::string& path) {
+    auto wav = std::make_unique<WavFile>();
+
+    auto mapped = MappedWavFile::open(path);
+    if (mapped->hasError()) {
+        wav->error_ = mapped->getError();
         return wav;
     }
 
+    wav->sampleRate_ = mapped->sampleRate();
+    wav->channels_ = mapped->channels();
+    wav->samples_.resize(static_cast<size_t>(mapped->frameCount()) * mapped->channels());
+    mapped->readInterleaved(0, wav->samples_.data(), mapped->frameCount());
+
     return wav;
 }
 
 bool WavFile::save(const std::string& path, const std::vector<float>& samples,
                    uint32_t sampleRate, uint32_t channels, WavFormat format) {
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
+    auto writer = WavWriter::open(path, sampleRate, channels, format);
+    if (writer->hasError()) {
         return false;
     }
 
     uint32_t numFrames = static_cast<uint32_t>(samples.size() / channels);
+    if (!writer->write(samples.data(), numFrames)) {
+        return false;
+    }
+    return writer->close();
+}
+
+//-----------------------------------------------------------------------------
+// MappedWavFile
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<MappedWavFile> MappedWavFile::open(const std::string& path) {
+    auto wav = std::unique_ptr<MappedWavFile>(new MappedWavFile());
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        wav->error_ = "Could not open file: " + path;
+        return wav;
+    }
+    wav->fileHandle_ = file;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        wav->error_ = "Not a RIFF file";
+        return wav;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        wav->error_ = "Could not map file: " + path;
+        return wav;
+    }
+    wav->mappingHandle_ = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        wav->error_ = "Could not map file: " + path;
+        return wav;
+    }
+    wav->base_ = static_cast<const uint8_t*>(view);
+    wav->mappedSize_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        wav->error_ = "Could not open file: " + path;
+        return wav;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        wav->error_ = "Not a RIFF file";
+        return wav;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference
+    if (view == MAP_FAILED) {
+        wav->error_ = "Could not map file: " + path;
+        return wav;
+    }
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    wav->base_ = static_cast<const uint8_t*>(view);
+    wav->mappedSize_ = static_cast<size_t>(st.st_size);
+#endif
+
+    WavLayout layout;
+    MemorySource source{wav->base_, wav->mappedSize_};
+    if (!parseWavHeader(source, layout, wav->error_)) {
+        return wav;
+    }
+
+    wav->sampleRate_ = layout.fmt.sampleRate;
+    wav->channels_ = layout.fmt.numChannels;
+    wav->audioFormat_ = layout.fmt.audioFormat;
+    wav->bitsPerSample_ = layout.fmt.bitsPerSample;
+    wav->blockAlign_ = layout.fmt.blockAlign;
+    wav->samples_ = wav->base_ + layout.dataOffset;
+
+    // A truncated file only exposes the bytes that actually exist
+    uint64_t available = std::min<uint64_t>(layout.dataSize, wav->mappedSize_ - layout.dataOffset);
+    wav->frameCount_ = available / layout.fmt.blockAlign;
+    return wav;
+}
+
+MappedWavFile::~MappedWavFile() {
+#if defined(_WIN32)
+    if (base_) UnmapViewOfFile(base_);
+    if (mappingHandle_) CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    if (fileHandle_) CloseHandle(static_cast<HANDLE>(fileHandle_));
+#else
+    if (base_) munmap(const_cast<uint8_t*>(base_), mappedSize_);
+#endif
+}
+
+const float* MappedWavFile::floatData() const {
+    if (hasError() || audioFormat_ != 3) return nullptr;
+    if (reinterpret_cast<uintptr_t>(samples_) % alignof(float) != 0) return nullptr;
+    return reinterpret_cast<const float*>(samples_);
+}
+
+uint64_t MappedWavFile::readInterleaved(uint64_t startFrame, float* interleaved, uint64_t frames) const {
+    if (hasError() || startFrame >= frameCount_) return 0;
+    frames = std::min(frames, frameCount_ - startFrame);
+
+    convertSamples(samples_ + startFrame * blockAlign_, interleaved,
+                   static_cast<size_t>(frames * channels_), audioFormat_, bitsPerSample_);
+    return frames;
+}
+
+uint64_t MappedWavFile::readChannels(uint64_t startFrame, float* const* channelData, uint64_t frames) const {
+    if (hasError() || startFrame >= frameCount_) return 0;
+    frames = std::min(frames, frameCount_ - startFrame);
+
+    if (channels_ == 1) {
+        return readInterleaved(startFrame, channelData[0], frames);
+    }
+
+    // Convert a cache-sized run of interleaved samples, then scatter it
+    float scratch[CONVERT_CHUNK_SAMPLES];
+    uint64_t chunkFrames = std::max<uint64_t>(1, CONVERT_CHUNK_SAMPLES / channels_);
+    const float* direct = floatData();
+
+    for (uint64_t done = 0; done < frames;) {
+        uint64_t chunk = std::min(chunkFrames, frames - done);
+        const float* src;
+        if (direct) {
+            src = direct + (startFrame + done) * channels_;
+        } else {
+            convertSamples(samples_ + (startFrame + done) * blockAlign_, scratch,
+                           static_cast<size_t>(chunk * channels_), audioFormat_, bitsPerSample_);
+            src = scratch;
+        }
+
+        if (channels_ == 2) {
+            float* left = channelData[0] + done;
+            float* right = channelData[1] + done;
+            for (uint64_t f = 0; f < chunk; ++f) {
+                left[f] = src[f * 2];
+                right[f] = src[f * 2 + 1];
+            }
+        } else {
+            for (uint64_t f = 0; f < chunk; ++f) {
+                for (uint32_t c = 0; c < channels_; ++c) {
+                    channelData[c][done + f] = src[f * channels_ + c];
+                }
+            }
+        }
+        done += chunk;
+    }
+    return frames;
+}
+
+//-----------------------------------------------------------------------------
+// WavReader
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<WavReader> WavReader::open(const std::string& path) {
+    auto wav = std::unique_ptr<WavReader>(new WavReader());
+    auto& file = wav->file_;
+
+    file.open(path, std::ios::binary);
+    if (!file) {
+        wav->error_ = "Could not open file: " + path;
+        return wav;
+    }
+
+    WavLayout layout;
+    StreamSource source{file};
+    if (!parseWavHeader(source, layout, wav->error_)) {
+        return wav;
+    }
+
+    wav->sampleRate_ = layout.fmt.sampleRate;
+    wav->channels_ = layout.fmt.numChannels;
+    wav->audioFormat_ = layout.fmt.audioFormat;
+    wav->bitsPerSample_ = layout.fmt.bitsPerSample;
+    wav->blockAlign_ = layout.fmt.blockAlign;
+    wav->frameCount_ = layout.dataSize / layout.fmt.blockAlign;
+    wav->fileSampleRate_ = wav->sampleRate_;
+    wav->fileFrameCount_ = wav->frameCount_;
+    return wav;
+}
+
+WavReader::~WavReader() = default;
+
+bool WavReader::resampleTo(uint32_t sampleRate) {
+    if (hasError() || framesRead_ > 0 || sampleRate == 0) return false;
+    if (sampleRate == fileSampleRate_) {
+        resampler_.reset();
+    } else {
+        resampler_ = std::make_unique<Resampler>(fileSampleRate_, sampleRate, channels_);
+        fileChunk_.resize(static_cast<size_t>(RESAMPLE_CHUNK_FRAMES) * channels_);
+    }
+    sampleRate_ = sampleRate;
+    frameCount_ = resampler_ ? resampler_->outputFramesFor(fileFrameCount_) : fileFrameCount_;
+    return true;
+}
+
+uint32_t WavReader::readFile(float* interleaved, uint32_t frames) {
+    frames = static_cast<uint32_t>(std::min<uint64_t>(frames, fileFrameCount_ - fileFramesRead_));
+    if (frames == 0) return 0;
+
+    size_t bytes = static_cast<size_t>(frames) * blockAlign_;
+    if (raw_.size() < bytes) {
+        raw_.resize(bytes);
+    }
+
+    file_.read(reinterpret_cast<char*>(raw_.data()), static_cast<std::streamsize>(bytes));
+    if (file_.bad()) {
+        error_ = "Failed to read samples";
+        return 0;
+    }
+    frames = static_cast<uint32_t>(static_cast<size_t>(file_.gcount()) / blockAlign_);
+
+    convertSamples(raw_.data(), interleaved, static_cast<size_t>(frames) * channels_,
+                   audioFormat_, bitsPerSample_);
+
+    fileFramesRead_ += frames;
+    if (frames == 0) {
+        // Data chunk is shorter than its header claims
+        fileFrameCount_ = fileFramesRead_;
+    }
+    return frames;
+}
+
+uint32_t WavReader::read(float* interleaved, uint32_t frames) {
+    if (hasError()) return 0;
+
+    if (!resampler_) {
+        frames = readFile(interleaved, frames);
+        framesRead_ += frames;
+        frameCount_ = fileFrameCount_;
+        return frames;
+    }
+
+    // Refill the resampler from the file chunk by chunk, converting straight
+    // into the caller's buffer
+    frames = static_cast<uint32_t>(std::min<uint64_t>(frames, framesRemaining()));
+    uint32_t done = 0;
+    while (done < frames) {
+        uint32_t produced = resampler_->pull(interleaved + static_cast<size_t>(done) * channels_, frames - done);
+        done += produced;
+        if (done == frames || (produced == 0 && fileEnded_)) break;
+
+        uint32_t count = readFile(fileChunk_.data(), RESAMPLE_CHUNK_FRAMES);
+        if (count > 0) {
+            resampler_->push(fileChunk_.data(), count);
+        } else {
+            resampler_->finish();
+            fileEnded_ = true;
+            frameCount_ = std::max(framesRead_ + done, resampler_->outputFramesFor(fileFrameCount_));
+            frames = static_cast<uint32_t>(std::min<uint64_t>(frames, frameCount_ - framesRead_));
+        }
+    }
+
+    framesRead_ += done;
+    return done;
+}
+
+//-----------------------------------------------------------------------------
+// WavWriter
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<WavWriter> WavWriter::open(const std::string& path, uint32_t sampleRate,
+                                           uint32_t channels, WavFormat format) {
+    auto wav = std::unique_ptr<WavWriter>(new WavWriter());
+    wav->channels_ = channels;
+    wav->format_ = format;
+
+    auto& file = wav->file_;
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        wav->error_ = "Could not create file: " + path;
+        wav->closed_ = true;
+        return wav;
+    }
+
     uint16_t bitsPerSample = (format == WavFormat::Float32) ? 32 : 16;
     uint16_t audioFormat = (format == WavFormat::Float32) ? 3 : 1;
-    uint16_t blockAlign = channels * (bitsPerSample / 8);
+    uint16_t blockAlign = static_cast<uint16_t>(channels * (bitsPerSample / 8));
     uint32_t byteRate = sampleRate * blockAlign;
-    uint32_t dataSize = numFrames * blockAlign;
-    uint32_t fileSize = 36 + dataSize;
 
-    // RIFF header
+    // RIFF header (sizes are patched in close())
     file.write("RIFF", 4);
-    writeLE<uint32_t>(file, fileSize);
+    writeLE<uint32_t>(file, WAV_HEADER_SIZE - 8);
     file.write("WAVE", 4);
 
     // fmt chunk
@@ -204,23 +617,75 @@ bool WavFile::save(const std::string& path, const std::vector<float>& samples,
 
     // data chunk
     file.write("data", 4);
-    writeLE<uint32_t>(file, dataSize);
+    writeLE<uint32_t>(file, 0);
 
-    if (format == WavFormat::Float32) {
-        for (float sample : samples) {
-            writeLE<float>(file, sample);
-        }
+    if (!file) {
+        wav->error_ = "Failed to write WAV header";
+    }
+    return wav;
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::write(const float* interleaved, uint32_t frames) {
+    if (closed_ || hasError()) return false;
+
+    size_t bytesPerSample = (format_ == WavFormat::Float32) ? 4 : 2;
+    size_t dataBytes = (framesWritten_ + frames) * channels_ * bytesPerSample;
+    if (dataBytes > UINT32_MAX - WAV_HEADER_SIZE) {
+        error_ = "WAV file would exceed 4 GB";
+        return false;
+    }
+
+    if (format_ == WavFormat::Float32) {
+        file_.write(reinterpret_cast<const char*>(interleaved),
+                    static_cast<std::streamsize>(static_cast<size_t>(frames) * channels_ * sizeof(float)));
     }
     else {
-        for (float sample : samples) {
-            // Clamp and convert to 16-bit
-            float clamped = std::fmax(-1.0f, std::fmin(1.0f, sample));
-            int16_t intSample = static_cast<int16_t>(clamped * 32767.0f);
-            writeLE<int16_t>(file, intSample);
+        raw_.resize(static_cast<size_t>(WRITE_CHUNK_FRAMES) * channels_ * sizeof(int16_t));
+        for (uint32_t done = 0; done < frames;) {
+            uint32_t chunk = std::min(WRITE_CHUNK_FRAMES, frames - done);
+            size_t count = static_cast<size_t>(chunk) * channels_;
+            const float* src = interleaved + static_cast<size_t>(done) * channels_;
+            for (size_t i = 0; i < count; ++i) {
+                // Clamp and convert to 16-bit
+                float clamped = std::fmax(-1.0f, std::fmin(1.0f, src[i]));
+                int16_t intSample = static_cast<int16_t>(clamped * 32767.0f);
+                std::memcpy(raw_.data() + i * sizeof(int16_t), &intSample, sizeof(int16_t));
+            }
+            file_.write(reinterpret_cast<const char*>(raw_.data()),
+                        static_cast<std::streamsize>(count * sizeof(int16_t)));
+            done += chunk;
         }
     }
 
+    if (!file_) {
+        error_ = "Failed to write samples";
+        return false;
+    }
+    framesWritten_ += frames;
     return true;
 }
 
+bool WavWriter::close() {
+    if (closed_) return !hasError();
+    closed_ = true;
+
+    size_t bytesPerSample = (format_ == WavFormat::Float32) ? 4 : 2;
+    uint32_t dataSize = static_cast<uint32_t>(framesWritten_ * channels_ * bytesPerSample);
+
+    file_.seekp(4);
+    writeLE<uint32_t>(file_, WAV_HEADER_SIZE - 8 + dataSize);
+    file_.seekp(WAV_HEADER_SIZE - 4);
+    writeLE<uint32_t>(file_, dataSize);
+    file_.close();
+
+    if (file_.fail() && error_.empty()) {
+        error_ = "Failed to finalize WAV header";
+    }
+    return !hasError();
+}
+
 } // namespace clap_trap
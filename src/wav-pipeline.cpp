@@ -0,0 +1,183 @@
+/**
+ * clap-trap: WAV Pipeline Implementation
+ */
+
+#include "clap-trap/wav-pipeline.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clap_trap {
+
+//-----------------------------------------------------------------------------
+// WavReadAhead
+//-----------------------------------------------------------------------------
+
+WavReadAhead::WavReadAhead(std::unique_ptr<WavReader> reader, uint32_t chunkFrames, uint32_t depth)
+    : reader_(std::move(reader))
+    , sampleRate_(reader_->sampleRate())
+    , channels_(reader_->channels())
+    , frameCount_(reader_->frameCount())
+    , chunkFrames_(std::max<uint32_t>(1, chunkFrames))
+    , chunks_(std::max<uint32_t>(2, depth)) {
+    for (auto& chunk : chunks_) {
+        chunk.samples.resize(static_cast<size_t>(chunkFrames_) * channels_);
+    }
+    thread_ = std::thread([this] { readLoop(); });
+}
+
+WavReadAhead::~WavReadAhead() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+}
+
+void WavReadAhead::readLoop() {
+    for (uint64_t next = 0;; ++next) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return stop_ || next - consumed_ < chunks_.size(); });
+            if (stop_) return;
+        }
+
+        // The slot is free until filled_ moves past it, so no lock while reading
+        Chunk& chunk = chunks_[next % chunks_.size()];
+        chunk.frames = reader_->read(chunk.samples.data(), chunkFrames_);
+        if (chunk.frames == 0 && reader_->hasError()) {
+            error_ = reader_->getError();
+            failed_.store(true, std::memory_order_release);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            filled_ = next + 1;
+        }
+        changed_.notify_all();
+        if (chunk.frames == 0) return;  // End of file (or a read error) ends the stream
+    }
+}
+
+uint32_t WavReadAhead::read(float* interleaved, uint32_t frames) {
+    uint32_t done = 0;
+    while (done < frames && !ended_) {
+        uint64_t current = consumed_;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return filled_ > current; });
+        }
+
+        const Chunk& chunk = chunks_[current % chunks_.size()];
+        if (chunk.frames == 0) {
+            ended_ = true;
+            break;
+        }
+        uint32_t count = std::min(frames - done, chunk.frames - position_);
+        memcpy(interleaved + static_cast<size_t>(done) * channels_,
+               chunk.samples.data() + static_cast<size_t>(position_) * channels_,
+               static_cast<size_t>(count) * channels_ * sizeof(float));
+        done += count;
+        position_ += count;
+
+        if (position_ == chunk.frames) {
+            position_ = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                consumed_ = current + 1;
+            }
+            changed_.notify_all();
+        }
+    }
+    return done;
+}
+
+//-----------------------------------------------------------------------------
+// WavWriteBehind
+//-----------------------------------------------------------------------------
+
+WavWriteBehind::WavWriteBehind(std::unique_ptr<WavWriter> writer, uint32_t channels, uint32_t chunkFrames,
+                               uint32_t depth)
+    : writer_(std::move(writer))
+    , channels_(channels)
+    , chunkFrames_(std::max<uint32_t>(1, chunkFrames))
+    , chunks_(std::max<uint32_t>(2, depth)) {
+    for (auto& chunk : chunks_) {
+        chunk.samples.resize(static_cast<size_t>(chunkFrames_) * channels_);
+    }
+    thread_ = std::thread([this] { writeLoop(); });
+}
+
+WavWriteBehind::~WavWriteBehind() {
+    close();
+}
+
+void WavWriteBehind::writeLoop() {
+    for (uint64_t next = 0;; ++next) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return finish_ || submitted_ > next; });
+            if (submitted_ <= next) return;  // Finished and drained
+        }
+
+        const Chunk& chunk = chunks_[next % chunks_.size()];
+        bool ok = writer_->write(chunk.samples.data(), chunk.frames);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            written_ = next + 1;
+            if (!ok) failed_ = true;
+        }
+        changed_.notify_all();
+    }
+}
+
+void WavWriteBehind::submit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++submitted_;
+        if (failed_) ok_ = false;
+    }
+    changed_.notify_all();
+
+    // Wait for the next slot to drain before filling it
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [&] { return submitted_ - written_ < chunks_.size(); });
+    chunks_[submitted_ % chunks_.size()].frames = 0;
+}
+
+bool WavWriteBehind::write(const float* interleaved, uint32_t frames) {
+    if (closed_) return false;
+    framesQueued_ += frames;
+    uint32_t done = 0;
+    while (done < frames) {
+        Chunk& chunk = chunks_[submitted_ % chunks_.size()];
+        uint32_t count = std::min(frames - done, chunkFrames_ - chunk.frames);
+        memcpy(chunk.samples.data() + static_cast<size_t>(chunk.frames) * channels_,
+               interleaved + static_cast<size_t>(done) * channels_,
+               static_cast<size_t>(count) * channels_ * sizeof(float));
+        chunk.frames += count;
+        done += count;
+        if (chunk.frames == chunkFrames_) submit();
+    }
+    return ok_;
+}
+
+bool WavWriteBehind::close() {
+    if (closed_) return ok_;
+    closed_ = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (chunks_[submitted_ % chunks_.size()].frames > 0) ++submitted_;
+        finish_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+
+    if (failed_) ok_ = false;
+    if (!writer_->close()) ok_ = false;
+    return ok_;
+}
+
+} // namespace clap_trap
@@ -4,6 +4,14 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include "clap-trap/clap-trap.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
 
 using namespace clap_trap;
 
@@ -54,6 +62,153 @@ TEST_CASE("TestHost basic functionality", "[host]") {
     }
 }
 
+TEST_CASE("TestHost extensions", "[host]") {
+    TestHost host;
+    const auto* h = host.clapHost();
+
+    SECTION("Params, latency and tail notifications are recorded") {
+        auto* params = static_cast<const clap_host_params_t*>(h->get_extension(h, CLAP_EXT_PARAMS));
+        auto* latency = static_cast<const clap_host_latency_t*>(h->get_extension(h, CLAP_EXT_LATENCY));
+        auto* tail = static_cast<const clap_host_tail_t*>(h->get_extension(h, CLAP_EXT_TAIL));
+        REQUIRE(params != nullptr);
+        REQUIRE(latency != nullptr);
+        REQUIRE(tail != nullptr);
+
+        params->rescan(h, CLAP_PARAM_RESCAN_VALUES);
+        params->rescan(h, CLAP_PARAM_RESCAN_TEXT);
+        params->request_flush(h);
+        latency->changed(h);
+        tail->changed(h);
+        REQUIRE(host.paramsRescanFlags() == (CLAP_PARAM_RESCAN_VALUES | CLAP_PARAM_RESCAN_TEXT));
+        REQUIRE(host.paramsFlushRequested());
+        REQUIRE(host.latencyChanged());
+        REQUIRE(host.tailChanged());
+
+        host.resetRequests();
+        REQUIRE(host.paramsRescanFlags() == 0);
+        REQUIRE_FALSE(host.paramsFlushRequested());
+        REQUIRE_FALSE(host.latencyChanged());
+        REQUIRE_FALSE(host.tailChanged());
+    }
+
+    SECTION("Log messages are kept until taken") {
+        auto* log = static_cast<const clap_host_log_t*>(h->get_extension(h, CLAP_EXT_LOG));
+        REQUIRE(log != nullptr);
+        log->log(h, CLAP_LOG_INFO, "hello");
+        log->log(h, CLAP_LOG_WARNING, "careful");
+
+        auto messages = host.takeLogMessages();
+        REQUIRE(messages.size() == 2);
+        REQUIRE(messages[0].severity == CLAP_LOG_INFO);
+        REQUIRE(messages[1].text == "careful");
+        REQUIRE(std::string(logSeverityName(messages[1].severity)) == "warning");
+        REQUIRE(host.takeLogMessages().empty());
+    }
+
+    SECTION("Audio-thread log messages wait for the main thread") {
+        auto* log = static_cast<const clap_host_log_t*>(h->get_extension(h, CLAP_EXT_LOG));
+        {
+            TestHost::AudioThreadScope audio;
+            log->log(h, CLAP_LOG_ERROR, "from process()");
+            log->log(h, CLAP_LOG_INFO, std::string(1000, 'x').c_str());
+        }
+        auto messages = host.takeLogMessages();
+        REQUIRE(messages.size() == 2);
+        REQUIRE(messages[0].text == "from process()");
+        REQUIRE(messages[1].text.size() == TestHost::AUDIO_LOG_TEXT_BYTES - 1);
+
+        {
+            TestHost::AudioThreadScope audio;
+            for (size_t i = 0; i < TestHost::AUDIO_LOG_CAPACITY + 3; ++i) log->log(h, CLAP_LOG_DEBUG, "spam");
+        }
+        REQUIRE(host.droppedLogMessages() == 3);
+        REQUIRE(host.takeLogMessages().size() == TestHost::AUDIO_LOG_CAPACITY);
+    }
+
+    SECTION("pumpMainThread flushes parameters while the plugin is inactive") {
+        struct Flushes {
+            int calls = 0;
+            clap_plugin_params_t params{};
+        } flushes;
+        flushes.params.flush = [](const clap_plugin_t* p, const clap_input_events_t*, const clap_output_events_t*) {
+            static_cast<Flushes*>(p->plugin_data)->calls++;
+        };
+        clap_plugin_t plugin{};
+        plugin.plugin_data = &flushes;
+        plugin.get_extension = [](const clap_plugin_t* p, const char* id) -> const void* {
+            return strcmp(id, CLAP_EXT_PARAMS) == 0 ? &static_cast<Flushes*>(p->plugin_data)->params : nullptr;
+        };
+        host.setPlugin(&plugin);
+        auto* params = static_cast<const clap_host_params_t*>(h->get_extension(h, CLAP_EXT_PARAMS));
+
+        // Active: its next process() flushes, so the request stays pending
+        host.setPluginActive(true);
+        params->request_flush(h);
+        REQUIRE_FALSE(host.pumpMainThread());
+        REQUIRE(flushes.calls == 0);
+        REQUIRE(host.paramsFlushRequested());
+
+        host.setPluginActive(false);
+        REQUIRE(host.pumpMainThread());
+        REQUIRE(flushes.calls == 1);
+        REQUIRE_FALSE(host.paramsFlushRequested());
+        REQUIRE_FALSE(host.pumpMainThread());
+    }
+
+    SECTION("Thread check follows AudioThreadScope") {
+        auto* check = static_cast<const clap_host_thread_check_t*>(h->get_extension(h, CLAP_EXT_THREAD_CHECK));
+        REQUIRE(check != nullptr);
+        REQUIRE(check->is_main_thread(h));
+        REQUIRE_FALSE(check->is_audio_thread(h));
+        {
+            TestHost::AudioThreadScope audio;
+            REQUIRE_FALSE(check->is_main_thread(h));
+            REQUIRE(check->is_audio_thread(h));
+        }
+        REQUIRE(check->is_main_thread(h));
+
+        bool otherMain = true;
+        bool otherAudio = false;
+        std::thread other([&] {
+            otherMain = check->is_main_thread(h);
+            TestHost::AudioThreadScope audio;
+            otherAudio = check->is_audio_thread(h);
+        });
+        other.join();
+        REQUIRE_FALSE(otherMain);
+        REQUIRE(otherAudio);
+    }
+
+    SECTION("pumpMainThread runs requested callbacks on the main thread") {
+        struct Callbacks {
+            const clap_host_thread_check_t* check;
+            const clap_host_t* host;
+            int calls = 0;
+            bool onMain = false;
+        } callbacks{static_cast<const clap_host_thread_check_t*>(h->get_extension(h, CLAP_EXT_THREAD_CHECK)), h};
+        clap_plugin_t plugin{};
+        plugin.plugin_data = &callbacks;
+        plugin.on_main_thread = [](const clap_plugin_t* p) {
+            auto* c = static_cast<Callbacks*>(p->plugin_data);
+            c->calls++;
+            c->onMain = c->check->is_main_thread(c->host);
+        };
+        plugin.get_extension = [](const clap_plugin_t*, const char*) -> const void* { return nullptr; };
+
+        REQUIRE_FALSE(host.pumpMainThread());  // No plugin yet
+        host.setPlugin(&plugin);
+        REQUIRE_FALSE(host.pumpMainThread());  // Nothing requested
+
+        TestHost::AudioThreadScope audio;
+        h->request_callback(h);
+        REQUIRE(host.pumpMainThread());
+        REQUIRE(callbacks.calls == 1);
+        REQUIRE(callbacks.onMain);
+        REQUIRE_FALSE(host.callbackRequested());
+        REQUIRE_FALSE(host.pumpMainThread());
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Event list tests
 //-----------------------------------------------------------------------------
@@ -76,6 +231,69 @@ TEST_CASE("DiscardOutputEvents", "[events]") {
     REQUIRE(events.get()->try_push(events.get(), &note.header));
 }
 
+TEST_CASE("RingCaptureOutputEvents", "[events]") {
+    RingCaptureOutputEvents events(4);
+    const auto* list = events.get();
+
+    clap_event_note_t note{};
+    note.header.size = sizeof(note);
+    note.header.type = CLAP_EVENT_NOTE_ON;
+    note.header.time = 7;
+    note.key = 64;
+
+    events.beginBlock(1000);
+    for (int i = 0; i < 6; ++i) {
+        list->try_push(list, &note.header);
+    }
+    REQUIRE(events.capturedCount() == 4);
+    REQUIRE(events.overflowCount() == 2);
+
+    RingCaptureOutputEvents::Entry entry{};
+    REQUIRE(events.pop(entry));
+    REQUIRE(entry.sampleTime == 1007);
+    REQUIRE(entry.event.isNoteOn());
+    REQUIRE(entry.event.key == 64);
+}
+
+TEST_CASE("SpscRing", "[ring]") {
+    SECTION("Capacity rounds up to a power of two") {
+        SpscRing<int> ring(5);
+        REQUIRE(ring.capacity() == 8);
+        for (int i = 0; i < 8; ++i) REQUIRE(ring.tryPush(i));
+        REQUIRE_FALSE(ring.tryPush(8));
+
+        int value = -1;
+        REQUIRE(ring.tryPop(value));
+        REQUIRE(value == 0);
+        REQUIRE(ring.tryPush(8));
+        REQUIRE(ring.size() == 8);
+    }
+
+    SECTION("Values cross threads in order") {
+        SpscRing<uint32_t> ring(64);
+        constexpr uint32_t COUNT = 100000;
+        std::thread producer([&] {
+            for (uint32_t i = 0; i < COUNT; ++i) {
+                while (!ring.tryPush(i)) std::this_thread::yield();
+            }
+        });
+
+        bool inOrder = true;
+        for (uint32_t expected = 0; expected < COUNT;) {
+            uint32_t value;
+            if (ring.tryPop(value)) {
+                inOrder = inOrder && value == expected;
+                expected++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        REQUIRE(inOrder);
+        REQUIRE(ring.empty());
+    }
+}
+
 TEST_CASE("SimpleInputEvents", "[events]") {
     SimpleInputEvents events;
 
@@ -108,6 +326,127 @@ TEST_CASE("SimpleInputEvents", "[events]") {
         events.addNoteOn(0, 0, 0, 60, 1, 0.8);
         events.clear();
         REQUIRE(events.get()->size(events.get()) == 0);
+        REQUIRE(events.usedBytes() == 0);
+    }
+
+    SECTION("Events are kept sorted by time") {
+        events.addNoteOn(100, 0, 0, 60, 1, 0.8);
+        events.addParamValue(10, 1, 0.5);
+        events.addMidi(100, 0, 0xB0, 1, 64);
+        events.addParamMod(0, 2, 0.25);
+
+        const auto* list = events.get();
+        REQUIRE(list->size(list) == 4);
+        REQUIRE(list->get(list, 0)->type == CLAP_EVENT_PARAM_MOD);
+        REQUIRE(list->get(list, 1)->type == CLAP_EVENT_PARAM_VALUE);
+        // Equal times keep insertion order
+        REQUIRE(list->get(list, 2)->type == CLAP_EVENT_NOTE_ON);
+        REQUIRE(list->get(list, 3)->type == CLAP_EVENT_MIDI);
+    }
+
+    SECTION("SysEx payload is copied into the arena") {
+        uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+        REQUIRE(events.addMidiSysex(5, 0, sysex, sizeof(sysex)));
+        sysex[1] = 0;
+
+        const auto* event = reinterpret_cast<const clap_event_midi_sysex_t*>(
+            events.get()->get(events.get(), 0));
+        REQUIRE(event->size == sizeof(sysex));
+        REQUIRE(event->buffer[1] == 0x7E);
+        REQUIRE(reinterpret_cast<uintptr_t>(event) % 8 == 0);
+    }
+
+    SECTION("Full list drops events instead of growing") {
+        SimpleInputEvents small(1024, 4);
+        for (uint32_t i = 0; i < 6; ++i) {
+            small.addNoteOn(i, 0, 0, 60, -1, 1.0);
+        }
+        REQUIRE(small.count() == 4);
+        REQUIRE(small.droppedCount() == 2);
+        REQUIRE(small.capacityBytes() == 1024);
+
+        small.clear();
+        REQUIRE(small.addNoteOff(0, 0, 0, 60, -1, 0.0));
+        REQUIRE(small.count() == 1);
+    }
+}
+
+TEST_CASE("AutomationGenerator", "[events]") {
+    AutomationLane gain;
+    gain.paramId = 3;
+    gain.minValue = -24.0;
+    gain.maxValue = 24.0;
+    gain.shape = AutomationShape::Random;
+
+    AutomationLane mode;
+    mode.paramId = 7;
+    mode.minValue = 0.0;
+    mode.maxValue = 4.0;
+    mode.stepped = true;
+    mode.shape = AutomationShape::Ramp;
+
+    SimpleInputEvents events;
+
+    SECTION("Evenly spaced value events within range") {
+        AutomationGenerator automation({gain, mode}, 48000.0, 8);
+        REQUIRE(automation.eventsForBlock(256) == 16);
+
+        for (int block = 0; block < 400; ++block) {
+            events.clear();
+            REQUIRE(automation.fillBlock(events, 256) == 16);
+
+            const auto* list = events.get();
+            REQUIRE(list->size(list) == 16);
+            for (uint32_t i = 0; i < 16; ++i) {
+                const auto* event = reinterpret_cast<const clap_event_param_value_t*>(list->get(list, i));
+                REQUIRE(event->header.type == CLAP_EVENT_PARAM_VALUE);
+                REQUIRE(event->header.time == (i / 2) * 32);
+                REQUIRE(event->param_id == (i % 2 == 0 ? 3u : 7u));
+                REQUIRE(event->value >= (i % 2 == 0 ? -24.0 : 0.0));
+                REQUIRE(event->value <= (i % 2 == 0 ? 24.0 : 4.0));
+                if (i % 2 == 1) REQUIRE(event->value == std::round(event->value));
+            }
+        }
+    }
+
+    SECTION("At most one event per sample") {
+        AutomationGenerator automation({gain}, 48000.0, 1000);
+        REQUIRE(automation.fillBlock(events, 64) == 64);
+        const auto* list = events.get();
+        REQUIRE(list->get(list, 63)->time == 63);
+    }
+
+    SECTION("Modulation offsets are centred on zero") {
+        AutomationLane lfo = gain;
+        lfo.shape = AutomationShape::Lfo;
+        lfo.modulation = true;
+        AutomationGenerator automation({lfo}, 48000.0, 1);
+
+        double low = 0.0, high = 0.0;
+        for (int block = 0; block < 48000 / 256; ++block) {
+            events.clear();
+            automation.fillBlock(events, 256);
+            const auto* event = reinterpret_cast<const clap_event_param_mod_t*>(
+                events.get()->get(events.get(), 0));
+            REQUIRE(event->header.type == CLAP_EVENT_PARAM_MOD);
+            low = std::min(low, event->amount);
+            high = std::max(high, event->amount);
+        }
+        REQUIRE(low < -23.0);
+        REQUIRE(high > 23.0);
+    }
+
+    SECTION("Deterministic for a seed") {
+        AutomationGenerator a({gain}, 48000.0, 4, 42);
+        AutomationGenerator b({gain}, 48000.0, 4, 42);
+        SimpleInputEvents other;
+        a.fillBlock(events, 256);
+        b.fillBlock(other, 256);
+        for (uint32_t i = 0; i < 4; ++i) {
+            const auto* x = reinterpret_cast<const clap_event_param_value_t*>(events.get()->get(events.get(), i));
+            const auto* y = reinterpret_cast<const clap_event_param_value_t*>(other.get()->get(other.get(), i));
+            REQUIRE(x->value == y->value);
+        }
     }
 }
 
@@ -158,6 +497,17 @@ TEST_CASE("StereoAudioBuffers", "[buffers]") {
         }
         REQUIRE(allZero);
     }
+
+    SECTION("Constant fill sets constant_mask") {
+        buffers.fillInputWithConstant(0.25f);
+        REQUIRE(buffers.inputBuffer()->constant_mask == 0x3);
+        REQUIRE(buffers.inputData(0)[0] == 0.25f);
+        REQUIRE(buffers.inputData(1)[buffers.blockSize() - 1] == 0.25f);
+        REQUIRE(buffers.outputBuffer()->constant_mask == 0);
+
+        buffers.fillInputWithSine(440.0f, 48000.0f);
+        REQUIRE(buffers.inputBuffer()->constant_mask == 0);
+    }
 }
 
 TEST_CASE("AudioBuffers multi-channel", "[buffers]") {
@@ -168,6 +518,1024 @@ TEST_CASE("AudioBuffers multi-channel", "[buffers]") {
     REQUIRE(buffers.blockSize() == 128);
     REQUIRE(buffers.inputBuffer()->channel_count == 4);
     REQUIRE(buffers.outputBuffer()->channel_count == 6);
+
+    buffers.fillInputWithConstant(0.0f);
+    REQUIRE(buffers.inputBuffer()->constant_mask == 0xf);
+}
+
+TEST_CASE("Contiguous buffer layout", "[buffers]") {
+    SECTION("Channels share one aligned slab with padded strides") {
+        AudioBuffers buffers(100, 2, 3, BufferLayout::Contiguous);
+        size_t stride = paddedChannelStride(100);
+        REQUIRE(stride == 112);
+
+        const float* base = buffers.inputData(0);
+        REQUIRE(reinterpret_cast<uintptr_t>(base) % AlignedSlab::ALIGNMENT == 0);
+        REQUIRE(buffers.inputData(1) == base + stride);
+        REQUIRE(buffers.outputData(0) == base + 2 * stride);
+        REQUIRE(buffers.outputData(2) == base + 4 * stride);
+        REQUIRE(buffers.outputBuffer()->data32[2] == buffers.outputData(2));
+        REQUIRE_FALSE(buffers.outputHasNonZero());
+    }
+
+    SECTION("Strides avoid 4 KB multiples") {
+        REQUIRE(paddedChannelStride(1024) == 1040);
+        REQUIRE(paddedChannelStride(1) == 16);
+    }
+
+    SECTION("Huge page request always yields usable buffers") {
+        StereoAudioBuffers buffers(512, BufferLayout::ContiguousHugePages);
+        buffers.fillInputWithSine(440.0f, 48000.0f);
+        buffers.outputData(1)[511] = 0.5f;
+        REQUIRE(buffers.outputPeakAmplitude() == 0.5f);
+        buffers.clearOutput();
+        REQUIRE_FALSE(buffers.outputHasNonZero());
+    }
+}
+
+TEST_CASE("64-bit audio buffers", "[buffers]") {
+    SECTION("Channels are exposed through data64 only") {
+        StereoAudioBuffers64 buffers(64);
+        REQUIRE(buffers.inputBuffer()->data32 == nullptr);
+        REQUIRE(buffers.outputBuffer()->data64 != nullptr);
+        REQUIRE(buffers.outputBuffer()->data64[1] == buffers.outputData(1));
+
+        buffers.outputData(0)[63] = -0.75;
+        REQUIRE(buffers.outputPeakAmplitude() == 0.75f);
+        buffers.outputData(1)[0] = NAN;
+        REQUIRE_FALSE(buffers.outputIsValid());
+    }
+
+    SECTION("Contiguous strides are cache-line multiples of doubles") {
+        AudioBuffers64 buffers(100, 1, 1, BufferLayout::Contiguous);
+        REQUIRE(paddedChannelStride(100, sizeof(double)) == 104);
+        REQUIRE(buffers.outputData(0) == buffers.inputData(0) + 104);
+    }
+
+    SECTION("Precision negotiation follows the port flags") {
+        PrecisionSupport none;
+        REQUIRE(negotiatePrecision(none, SamplePrecision::Float64) == SamplePrecision::Float32);
+
+        PrecisionSupport supported{true, false};
+        REQUIRE(negotiatePrecision(supported, SamplePrecision::Float32) == SamplePrecision::Float32);
+        REQUIRE(negotiatePrecision(supported, SamplePrecision::Float64) == SamplePrecision::Float64);
+
+        REQUIRE(negotiatePrecision(supported, SamplePrecision::Auto) == SamplePrecision::Float32);
+
+        // The preference only decides when nothing was asked for
+        PrecisionSupport preferred{true, true};
+        REQUIRE(negotiatePrecision(preferred, SamplePrecision::Auto) == SamplePrecision::Float64);
+        REQUIRE(negotiatePrecision(preferred, SamplePrecision::Float32) == SamplePrecision::Float32);
+        REQUIRE(negotiatePrecision(none, SamplePrecision::Auto) == SamplePrecision::Float32);
+    }
+}
+
+TEST_CASE("Buffer analysis", "[buffers]") {
+    // Odd size so the vector kernels leave a scalar tail
+    AudioBuffers buffers(37, 0, 2);
+
+    SECTION("Silence") {
+        BufferStats stats = buffers.analyzeOutput();
+        REQUIRE_FALSE(stats.hasNonZero);
+        REQUIRE(stats.isValid());
+        REQUIRE(stats.peak == 0.0f);
+        REQUIRE(stats.rms == 0.0);
+        REQUIRE(stats.sampleCount == 74);
+    }
+
+    SECTION("Constant level gives exact peak, rms and dc") {
+        for (uint32_t ch = 0; ch < 2; ++ch) {
+            std::fill(buffers.outputData(ch), buffers.outputData(ch) + 37, -0.25f);
+        }
+        BufferStats stats = buffers.analyzeOutput();
+        REQUIRE(stats.hasNonZero);
+        REQUIRE(stats.peak == 0.25f);
+        REQUIRE(stats.dc == -0.25);
+        REQUIRE(std::abs(stats.rms - 0.25) < 1e-9);
+        REQUIRE(buffers.outputPeakAmplitude() == 0.25f);
+    }
+
+    SECTION("NaN, Inf and denormals are counted in the vector body and the tail") {
+        float* left = buffers.outputData(0);
+        float* right = buffers.outputData(1);
+        left[3] = NAN;
+        left[36] = NAN;
+        right[10] = INFINITY;
+        right[35] = -INFINITY;
+        left[5] = 1e-40f;
+        right[36] = -1e-40f;
+        left[20] = 0.5f;
+
+        BufferStats stats = buffers.analyzeOutput();
+        REQUIRE(stats.nanCount == 2);
+        REQUIRE(stats.infCount == 2);
+        REQUIRE(stats.denormalCount == 2);
+        REQUIRE(stats.peak == INFINITY);
+        REQUIRE_FALSE(stats.isValid());
+        REQUIRE_FALSE(buffers.outputIsValid());
+        REQUIRE(buffers.outputHasNonZero());
+    }
+
+    SECTION("NaN alone counts as non-zero but not as peak") {
+        buffers.outputData(1)[0] = NAN;
+        BufferStats stats = buffers.analyzeOutput();
+        REQUIRE(stats.hasNonZero);
+        REQUIRE(stats.peak == 0.0f);
+        REQUIRE(stats.nanCount == 1);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// WAV file tests
+//-----------------------------------------------------------------------------
+
+TEST_CASE("WAV streaming round-trip", "[wav]") {
+    std::string path = (std::filesystem::temp_directory_path() / "clap-trap-test.wav").string();
+
+    std::vector<float> samples(3000 * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = std::sin(static_cast<float>(i) * 0.01f) * 0.5f;
+    }
+
+    SECTION("Float32 written in chunks reads back exactly") {
+        auto writer = WavWriter::open(path, 44100, 2, WavFormat::Float32);
+        REQUIRE_FALSE(writer->hasError());
+        REQUIRE(writer->write(samples.data(), 1000));
+        REQUIRE(writer->write(samples.data() + 2000, 2000));
+        REQUIRE(writer->close());
+        REQUIRE(writer->framesWritten() == 3000);
+
+        auto reader = WavReader::open(path);
+        REQUIRE_FALSE(reader->hasError());
+        REQUIRE(reader->sampleRate() == 44100);
+        REQUIRE(reader->channels() == 2);
+        REQUIRE(reader->frameCount() == 3000);
+
+        std::vector<float> block(512 * 2);
+        std::vector<float> readBack;
+        while (uint32_t frames = reader->read(block.data(), 512)) {
+            readBack.insert(readBack.end(), block.begin(), block.begin() + frames * 2);
+        }
+        REQUIRE(readBack == samples);
+        REQUIRE(reader->framesRemaining() == 0);
+    }
+
+    SECTION("Int16 round-trip through WavFile") {
+        REQUIRE(WavFile::save(path, samples, 48000, 2, WavFormat::Int16));
+
+        auto wav = WavFile::load(path);
+        REQUIRE_FALSE(wav->hasError());
+        REQUIRE(wav->frameCount() == 3000);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            REQUIRE(std::abs(wav->samples()[i] - samples[i]) < 1.0f / 16384.0f);
+        }
+    }
+
+    SECTION("Missing file reports an error") {
+        auto reader = WavReader::open("/nonexistent/path/file.wav");
+        REQUIRE(reader->hasError());
+        float sample = 0.0f;
+        REQUIRE(reader->read(&sample, 1) == 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("WAV pipeline", "[wav]") {
+    std::string inPath = (std::filesystem::temp_directory_path() / "clap-trap-pipeline-in.wav").string();
+    std::string outPath = (std::filesystem::temp_directory_path() / "clap-trap-pipeline-out.wav").string();
+
+    std::vector<float> samples(5000 * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = std::sin(static_cast<float>(i) * 0.01f) * 0.5f;
+    }
+    REQUIRE(WavFile::save(inPath, samples, 44100, 2, WavFormat::Float32));
+
+    SECTION("Odd block sizes across small chunks read and write back exactly") {
+        // Chunks of 300 frames with only two in flight keep both threads waiting on each other
+        WavReadAhead input(WavReader::open(inPath), 300, 2);
+        REQUIRE(input.sampleRate() == 44100);
+        REQUIRE(input.channels() == 2);
+        REQUIRE(input.frameCount() == 5000);
+
+        WavWriteBehind output(WavWriter::open(outPath, 44100, 2, WavFormat::Float32), 2, 300, 2);
+        std::vector<float> block(257 * 2);
+        while (uint32_t frames = input.read(block.data(), 257)) {
+            REQUIRE(output.write(block.data(), frames));
+        }
+        REQUIRE(input.read(block.data(), 257) == 0);
+        REQUIRE_FALSE(input.hasError());
+        REQUIRE(output.framesQueued() == 5000);
+        REQUIRE(output.close());
+
+        auto wav = WavFile::load(outPath);
+        REQUIRE_FALSE(wav->hasError());
+        REQUIRE(wav->samples() == samples);
+    }
+
+    SECTION("A data chunk shorter than its header ends the stream without an error") {
+        std::filesystem::resize_file(inPath, std::filesystem::file_size(inPath) - 1000 * 2 * sizeof(float));
+        WavReadAhead input(WavReader::open(inPath), 300, 2);
+        std::vector<float> block(512 * 2);
+        uint64_t total = 0;
+        while (uint32_t frames = input.read(block.data(), 512)) total += frames;
+        CHECK(total == 4000);
+        CHECK_FALSE(input.hasError());
+    }
+
+    SECTION("Stopping before the end of the input") {
+        WavReadAhead input(WavReader::open(inPath), 256, 2);
+        float frame[2];
+        REQUIRE(input.read(frame, 1) == 1);
+        REQUIRE(frame[0] == samples[0]);
+    }
+
+    SECTION("Destructor flushes a partial chunk") {
+        {
+            WavWriteBehind output(WavWriter::open(outPath, 44100, 2, WavFormat::Float32), 2);
+            REQUIRE(output.write(samples.data(), 100));
+        }
+        auto wav = WavFile::load(outPath);
+        REQUIRE(wav->frameCount() == 100);
+    }
+
+    std::filesystem::remove(inPath);
+    std::filesystem::remove(outPath);
+}
+
+TEST_CASE("Resampler", "[wav]") {
+    constexpr double PI = 3.14159265358979323846;
+
+    // Convert a 1 kHz stereo sine pushed in odd-sized chunks and compare it
+    // with the ideal sine at the output rate, away from the edges
+    auto checkSine = [&](uint32_t inputRate, uint32_t outputRate) {
+        const uint32_t inputFrames = inputRate / 4;
+        std::vector<float> input(inputFrames * 2);
+        for (uint32_t f = 0; f < inputFrames; ++f) {
+            input[f * 2] = 0.5f * static_cast<float>(std::sin(2.0 * PI * 1000.0 * f / inputRate));
+            input[f * 2 + 1] = -input[f * 2];
+        }
+
+        Resampler resampler(inputRate, outputRate, 2);
+        uint64_t expected = resampler.outputFramesFor(inputFrames);
+        std::vector<float> output;
+        std::vector<float> block(333 * 2);
+        for (uint32_t pushed = 0; pushed < inputFrames; pushed += 777) {
+            resampler.push(input.data() + pushed * 2, std::min(777u, inputFrames - pushed));
+            while (uint32_t frames = resampler.pull(block.data(), 333)) {
+                output.insert(output.end(), block.begin(), block.begin() + frames * 2);
+            }
+        }
+        resampler.finish();
+        while (uint32_t frames = resampler.pull(block.data(), 333)) {
+            output.insert(output.end(), block.begin(), block.begin() + frames * 2);
+        }
+        REQUIRE(output.size() / 2 >= expected);
+
+        float maxError = 0.0f;
+        for (uint64_t f = resampler.taps(); f + resampler.taps() < expected; ++f) {
+            float ideal = 0.5f * static_cast<float>(std::sin(2.0 * PI * 1000.0 * f / outputRate));
+            maxError = std::max(maxError, std::abs(output[f * 2] - ideal));
+            maxError = std::max(maxError, std::abs(output[f * 2 + 1] + ideal));
+        }
+        REQUIRE(maxError < 1e-3f);
+    };
+
+    SECTION("Converting up keeps a sine in place") {
+        checkSine(44100, 96000);
+    }
+
+    SECTION("Converting down keeps a sine in place") {
+        checkSine(48000, 44100);
+    }
+
+    SECTION("Ratios beyond the phase table interpolate between phases") {
+        checkSine(44100, 48001);
+    }
+
+    SECTION("Output length follows the exact ratio") {
+        Resampler resampler(44100, 48000, 1);
+        REQUIRE(resampler.outputFramesFor(44100) == 48000);
+        REQUIRE(resampler.outputFramesFor(1) == 2);
+        REQUIRE(resampler.outputFramesFor(0) == 0);
+    }
+
+    SECTION("WavReader converts as it streams") {
+        std::string path = (std::filesystem::temp_directory_path() / "clap-trap-resample.wav").string();
+        std::vector<float> samples(10000 * 2, 0.25f);
+        REQUIRE(WavFile::save(path, samples, 44100, 2, WavFormat::Float32));
+
+        auto reader = WavReader::open(path);
+        REQUIRE(reader->resampleTo(96000));
+        REQUIRE(reader->sampleRate() == 96000);
+        REQUIRE(reader->fileSampleRate() == 44100);
+        REQUIRE(reader->frameCount() == 21769);
+
+        std::vector<float> block(1000 * 2);
+        uint64_t total = 0;
+        float middle = 0.0f;
+        while (uint32_t frames = reader->read(block.data(), 1000)) {
+            if (total == 10000) middle = block[0];
+            total += frames;
+        }
+        REQUIRE(total == 21769);
+        REQUIRE(reader->framesRemaining() == 0);
+        REQUIRE(std::abs(middle - 0.25f) < 1e-4f);
+        REQUIRE_FALSE(reader->resampleTo(48000));
+
+        // The file's own rate reads the samples unchanged
+        reader = WavReader::open(path);
+        REQUIRE(reader->resampleTo(44100));
+        REQUIRE(reader->frameCount() == 10000);
+        REQUIRE(reader->read(block.data(), 1) == 1);
+        REQUIRE(block[0] == 0.25f);
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("MappedWavFile", "[wav]") {
+    std::string path = (std::filesystem::temp_directory_path() / "clap-trap-mapped.wav").string();
+
+    std::vector<float> samples(1000 * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = std::sin(static_cast<float>(i) * 0.02f) * 0.5f;
+    }
+
+    SECTION("Float32 data is exposed without a copy") {
+        REQUIRE(WavFile::save(path, samples, 48000, 2, WavFormat::Float32));
+
+        auto mapped = MappedWavFile::open(path);
+        REQUIRE_FALSE(mapped->hasError());
+        REQUIRE(mapped->isFloat());
+        REQUIRE(mapped->frameCount() == 1000);
+        REQUIRE(mapped->floatData() != nullptr);
+        REQUIRE(std::vector<float>(mapped->floatData(), mapped->floatData() + samples.size()) == samples);
+
+        std::vector<float> left(1000), right(1000);
+        float* channels[2] = {left.data(), right.data()};
+        REQUIRE(mapped->readChannels(0, channels, 2000) == 1000);
+        REQUIRE(left[10] == samples[20]);
+        REQUIRE(right[999] == samples[1999]);
+    }
+
+    SECTION("PCM conversion matches the scalar formula") {
+        // 24-bit and 32-bit files written by hand, with an odd sample count
+        // so the vector loops leave a scalar tail
+        for (uint16_t bits : {uint16_t(24), uint16_t(32)}) {
+            const uint32_t count = 37;
+            const uint32_t bytes = bits / 8;
+            std::vector<uint8_t> data(count * bytes);
+            std::vector<float> expected(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                int32_t value = static_cast<int32_t>(i * 2654435761u) >> (32 - bits);
+                std::memcpy(&data[i * bytes], &value, bytes);
+                expected[i] = static_cast<float>(value) / static_cast<float>(1u << (bits - 1));
+            }
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            uint32_t dataSize = static_cast<uint32_t>(data.size());
+            uint32_t riffSize = 36 + dataSize, fmtSize = 16, sampleRate = 44100, byteRate = 44100 * bytes;
+            uint16_t audioFormat = 1, channels = 1, blockAlign = static_cast<uint16_t>(bytes);
+            out.write("RIFF", 4);
+            out.write(reinterpret_cast<const char*>(&riffSize), 4);
+            out.write("WAVEfmt ", 8);
+            out.write(reinterpret_cast<const char*>(&fmtSize), 4);
+            out.write(reinterpret_cast<const char*>(&audioFormat), 2);
+            out.write(reinterpret_cast<const char*>(&channels), 2);
+            out.write(reinterpret_cast<const char*>(&sampleRate), 4);
+            out.write(reinterpret_cast<const char*>(&byteRate), 4);
+            out.write(reinterpret_cast<const char*>(&blockAlign), 2);
+            out.write(reinterpret_cast<const char*>(&bits), 2);
+            out.write("data", 4);
+            out.write(reinterpret_cast<const char*>(&dataSize), 4);
+            out.write(reinterpret_cast<const char*>(data.data()), dataSize);
+            out.close();
+
+            auto mapped = MappedWavFile::open(path);
+            REQUIRE_FALSE(mapped->hasError());
+            REQUIRE(mapped->bitsPerSample() == bits);
+            REQUIRE(mapped->floatData() == nullptr);
+
+            std::vector<float> converted(count);
+            REQUIRE(mapped->readInterleaved(0, converted.data(), count) == count);
+            REQUIRE(converted == expected);
+        }
+    }
+
+    SECTION("Missing file reports an error") {
+        auto mapped = MappedWavFile::open("/nonexistent/path/file.wav");
+        REQUIRE(mapped->hasError());
+        REQUIRE(mapped->floatData() == nullptr);
+    }
+
+    std::filesystem::remove(path);
+}
+
+//-----------------------------------------------------------------------------
+// MIDI tests
+//-----------------------------------------------------------------------------
+
+TEST_CASE("MIDI tempo changes", "[midi]") {
+    // Format 0, 480 ticks per quarter: 120 BPM, then 240 BPM from tick 480
+    const uint8_t track[] = {
+        0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,  // tempo 500000
+        0x00, 0x90, 60, 100,                        // note-on @ 0.0s
+        0x83, 0x60, 0xFF, 0x51, 0x03, 0x03, 0xD0, 0x90,  // tempo 250000 @ tick 480
+        0x83, 0x60, 0x80, 60, 0,                    // note-off @ 0.75s
+        0x83, 0x60, 0x90, 62, 100,                  // note-on @ 1.0s
+        0x00, 0xFF, 0x2F, 0x00
+    };
+    const uint8_t header[] = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0x01, 0xE0,
+                              'M', 'T', 'r', 'k', 0, 0, 0, static_cast<uint8_t>(sizeof(track))};
+
+    auto path = (std::filesystem::temp_directory_path() / "clap-trap-tempo-test.mid").string();
+    {
+        std::ofstream f(path, std::ios::binary);
+        f.write(reinterpret_cast<const char*>(header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(track), sizeof(track));
+    }
+
+    auto midi = MidiFile::load(path.c_str());
+    REQUIRE(midi);
+    REQUIRE_FALSE(midi->hasError());
+
+    auto notes = midi->noteEvents();
+    REQUIRE(notes.size() == 3);
+    CHECK(std::abs(notes[0].secondTime - 0.0) < 1e-9);
+    CHECK(std::abs(notes[1].secondTime - 0.75) < 1e-9);
+    CHECK(std::abs(notes[2].secondTime - 1.0) < 1e-9);
+    CHECK(std::abs(midi->durationSeconds() - 1.0) < 1e-9);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("MidiSchedule", "[midi]") {
+    auto note = [](double seconds, uint8_t key) {
+        MidiEvent e{};
+        e.secondTime = seconds;
+        e.type = 0x90;
+        e.data1 = key;
+        e.data2 = 100;
+        return e;
+    };
+
+    // 1000 Hz, 100-sample blocks: block N covers [N/10 s, (N+1)/10 s)
+    std::vector<MidiEvent> events = {note(0.0, 60), note(0.05, 61), note(0.25, 62),
+                                     note(0.299, 63), note(0.1, 64)};
+    MidiSchedule schedule(events, 1000, 100);
+
+    CHECK(schedule.eventCount() == 5);
+    REQUIRE(schedule.blockCount() == 3);
+
+    auto b0 = schedule.block(0);
+    REQUIRE(b0.size() == 2);
+    CHECK(b0[0].offset == 0);
+    CHECK(b0[1].offset == 50);
+    CHECK(b0[1].midi.data1 == 61);
+
+    auto b1 = schedule.block(1);
+    REQUIRE(b1.size() == 1);
+    CHECK(b1[0].offset == 0);
+    CHECK(b1[0].midi.data1 == 64);
+    CHECK(b1[0].sampleTime == 100);
+
+    auto b2 = schedule.block(2);
+    REQUIRE(b2.size() == 2);
+    CHECK(b2[0].offset == 50);
+    CHECK(b2[1].offset == 99);
+
+    CHECK(schedule.block(3).empty());
+    CHECK(MidiSchedule({}, 48000, 256).blockCount() == 0);
+}
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram tests
+//-----------------------------------------------------------------------------
+
+TEST_CASE("LatencyHistogram", "[histogram]") {
+    LatencyHistogram hist;
+
+    SECTION("Empty by default") {
+        REQUIRE(hist.count() == 0);
+        REQUIRE(hist.min() == 0);
+        REQUIRE(hist.max() == 0);
+        REQUIRE(hist.valueAtPercentile(50.0) == 0);
+    }
+
+    SECTION("Small values are exact") {
+        for (uint64_t v = 1; v <= 10; ++v) hist.record(v);
+        REQUIRE(hist.count() == 10);
+        REQUIRE(hist.min() == 1);
+        REQUIRE(hist.max() == 10);
+        REQUIRE(hist.valueAtPercentile(50.0) == 5);
+        REQUIRE(hist.valueAtPercentile(100.0) == 10);
+        REQUIRE(hist.mean() == 5.5);
+    }
+
+    SECTION("Large values stay within bucket precision") {
+        for (uint64_t v = 1; v <= 100000; ++v) hist.record(v * 1000);
+        uint64_t p99 = hist.valueAtPercentile(99.0);
+        double error = std::abs(static_cast<double>(p99) - 99000000.0) / 99000000.0;
+        REQUIRE(error < 1.0 / LatencyHistogram::SUB_BUCKET_COUNT);
+        REQUIRE(hist.valueAtPercentile(100.0) == 100000000);
+    }
+
+    SECTION("Bucket bounds cover every value") {
+        for (uint64_t v : {uint64_t(0), uint64_t(63), uint64_t(64), uint64_t(65), uint64_t(1000), uint64_t(123456789), UINT64_MAX}) {
+            uint32_t idx = LatencyHistogram::bucketIndex(v);
+            REQUIRE(idx < LatencyHistogram::BUCKET_COUNT);
+            REQUIRE(LatencyHistogram::bucketLowerBound(idx) <= v);
+            REQUIRE(LatencyHistogram::bucketUpperBound(idx) >= v);
+        }
+    }
+
+    SECTION("Merge and reset") {
+        LatencyHistogram other;
+        hist.record(100);
+        other.record(200);
+        hist.merge(other);
+        REQUIRE(hist.count() == 2);
+        REQUIRE(hist.max() == 200);
+
+        hist.reset();
+        REQUIRE(hist.count() == 0);
+        REQUIRE(hist.countAt(LatencyHistogram::bucketIndex(100)) == 0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Report tests
+//-----------------------------------------------------------------------------
+
+TEST_CASE("Json", "[report]") {
+    SECTION("dump keeps insertion order") {
+        Json doc = Json::object();
+        doc.set("b", 1).set("a", "x").set("list", Json::array());
+        doc.get("list")->push(true);
+        doc.get("list")->push(nullptr);
+        doc.get("list")->push(0.5);
+        CHECK(doc.dump(-1) == R"({"b":1,"a":"x","list":[true,null,0.5]})");
+    }
+
+    SECTION("set replaces existing members") {
+        Json doc = Json::object();
+        doc.set("k", 1).set("k", 2);
+        CHECK(doc.size() == 1);
+        CHECK(doc.get("k")->asNumber() == 2.0);
+    }
+
+    SECTION("round-trip") {
+        Json doc = Json::object();
+        doc.set("name", "quote \" and \\ and \n")
+           .set("count", uint64_t(1234567890123))
+           .set("ratio", 0.1)
+           .set("nan", std::nan(""));
+        std::string error;
+        Json parsed = Json::parse(doc.dump(), &error);
+        REQUIRE(error.empty());
+        CHECK(parsed.get("name")->asString() == "quote \" and \\ and \n");
+        CHECK(parsed.get("count")->asNumber() == 1234567890123.0);
+        CHECK(parsed.get("ratio")->asNumber() == 0.1);
+        CHECK(parsed.get("nan")->isNull());
+    }
+
+    SECTION("unicode escapes") {
+        Json parsed = Json::parse(R"(["\u00e9\ud83d\ude00"])");
+        REQUIRE(parsed.isArray());
+        CHECK(parsed.items()[0].asString() == "\xC3\xA9\xF0\x9F\x98\x80");
+    }
+
+    SECTION("parse errors") {
+        std::string error;
+        CHECK(Json::parse("{\"a\": }", &error).isNull());
+        CHECK_FALSE(error.empty());
+        CHECK(Json::parse("[1, 2] x", &error).isNull());
+        CHECK(Json::parse("\"open", &error).isNull());
+    }
+}
+
+TEST_CASE("Report", "[report]") {
+    Report report;
+    report.command = "bench";
+    report.pluginPath = "test.clap";
+    report.check("load", true);
+
+    PluginResult& result = report.plugin("com.example.gain");
+    result.name = "Gain";
+    result.check("setup", true);
+
+    LatencyHistogram hist;
+    for (uint64_t v = 1; v <= 100; ++v) hist.record(v * 1000);
+    TimingStats timing = TimingStats::fromHistogram("float32", hist);
+    CHECK(timing.blocks == 100);
+    CHECK(timing.maxNs == 100000);
+    uint64_t bucketed = 0;
+    for (const auto& b : timing.histogram) bucketed += b.count;
+    CHECK(bucketed == 100);
+    result.timings.push_back(timing);
+
+    CHECK(&report.plugin("com.example.gain") == &result);
+    CHECK(report.passed());
+
+    result.check("setup", false, "activate() failed");
+    CHECK(result.checks.size() == 1);
+    CHECK_FALSE(report.passed());
+
+    Json json = toJson(report);
+    CHECK(json.get("command")->asString() == "bench");
+    CHECK_FALSE(json.get("passed")->asBool(true));
+    const Json& plugin = json.get("plugins")->items()[0];
+    CHECK(plugin.get("id")->asString() == "com.example.gain");
+    CHECK(plugin.get("timings")->items()[0].get("p50Ns")->isNumber());
+
+    result.details.set("latency", 64);
+    result.details.set("checks", "not the checks");
+    CHECK(toJson(result).get("checks")->isArray());
+    PluginResult restored;
+    REQUIRE(PluginResult::fromJson(toJson(result), restored));
+    CHECK(restored.id == "com.example.gain");
+    CHECK(restored.name == "Gain");
+    CHECK(restored.checks.size() == 1);
+    CHECK(restored.checks[0].detail == "activate() failed");
+    CHECK(restored.timings.size() == 1);
+    CHECK(restored.details.get("latency")->asNumber() == 64);
+    CHECK(restored.details.get("checks")->asString() == "not the checks");
+    CHECK(restored.details.get("passed") == nullptr);
+    CHECK_FALSE(PluginResult::fromJson(Json::object(), restored));
+
+    std::string csv = toCsv(json);
+    CHECK(csv.rfind("plugin,metric,value\n", 0) == 0);
+    CHECK(csv.find("\n,command,bench\n") != std::string::npos);
+    CHECK(csv.find("\ncom.example.gain,checks.setup.detail,activate() failed\n") != std::string::npos);
+    CHECK(csv.find("\ncom.example.gain,timings.float32.maxNs,100000\n") != std::string::npos);
+}
+
+TEST_CASE("Benchmark comparison", "[report]") {
+    auto timing = [](uint64_t base, uint64_t spread, std::vector<uint64_t> runs) {
+        LatencyHistogram hist;
+        for (uint64_t i = 0; i < 5000; ++i) hist.record(base + (i * 7919) % spread);
+        TimingStats t = TimingStats::fromHistogram("float32", hist);
+        t.runMediansNs = std::move(runs);
+        return t;
+    };
+
+    TimingStats baseline = timing(10000, 2000, {11000, 11020, 10990, 11010, 10980});
+    TimingStats same = timing(10000, 2000, {11010, 10990, 11000, 11030, 10970});
+    TimingStats slower = timing(12000, 2000, {13000, 13020, 12990, 13010, 12980});
+
+    SECTION("Mann-Whitney U") {
+        CHECK(mannWhitneyU(baseline.histogram, same.histogram).pValue > 0.1);
+        CHECK(mannWhitneyU(baseline.histogram, slower.histogram).pValue < 1e-6);
+        CHECK(mannWhitneyU(slower.histogram, baseline.histogram).pValue > 0.99);
+        CHECK(mannWhitneyU({}, slower.histogram).pValue == 1.0);
+    }
+
+    SECTION("bootstrap interval") {
+        double low = 0, high = 0;
+        REQUIRE(bootstrapChangeInterval(baseline.runMediansNs, slower.runMediansNs, 0.95, low, high));
+        CHECK(low > 0.15);
+        CHECK(high < 0.2);
+        CHECK_FALSE(bootstrapChangeInterval({1000}, {1000, 1001}, 0.95, low, high));
+    }
+
+    SECTION("noisy first run") {
+        double deviation = 0;
+        CHECK(isNoisyFirstRun({15000, 11000, 11020, 10990, 11010}, 0.05, &deviation));
+        CHECK(deviation > 0.3);
+        CHECK_FALSE(isNoisyFirstRun({11050, 11000, 11020, 10990, 11010}, 0.05));
+        CHECK_FALSE(isNoisyFirstRun({15000, 11000}, 0.05));
+    }
+
+    SECTION("regression decision") {
+        CHECK_FALSE(compareTimings(baseline, same, 0.05).regressed);
+        TimingComparison cmp = compareTimings(baseline, slower, 0.05);
+        CHECK(cmp.regressed);
+        CHECK(cmp.change > 0.15);
+        CHECK_FALSE(compareTimings(baseline, slower, 0.25).regressed);
+        CHECK(compareTimings(slower, baseline, 0.05).improved);
+    }
+
+    SECTION("timing round-trips through JSON") {
+        TimingStats parsed;
+        REQUIRE(TimingStats::fromJson(Json::parse(toJson(slower).dump()), parsed));
+        CHECK(parsed.p50Ns == slower.p50Ns);
+        CHECK(parsed.histogram.size() == slower.histogram.size());
+        CHECK(parsed.runMediansNs == slower.runMediansNs);
+        CHECK_FALSE(TimingStats::fromJson(Json::object(), parsed));
+    }
+}
+
+TEST_CASE("PerfCounters", "[perf]") {
+    SECTION("Values arithmetic") {
+        PerfCounters::Values begin, end;
+        begin.value[PerfCounters::Cycles] = 1000;
+        end.value[PerfCounters::Cycles] = 3000;
+        end.value[PerfCounters::Instructions] = 9000;
+        begin.valid[PerfCounters::Cycles] = end.valid[PerfCounters::Cycles] = true;
+        end.valid[PerfCounters::Instructions] = true;
+
+        PerfCounters::Values delta = PerfCounters::Values::difference(end, begin);
+        REQUIRE(delta.valid[PerfCounters::Cycles]);
+        REQUIRE(delta.value[PerfCounters::Cycles] == 2000);
+        REQUIRE_FALSE(delta.valid[PerfCounters::Instructions]);
+        REQUIRE(delta.ipc() == 0.0);
+
+        PerfCounters::Values total;
+        total.add(end);
+        total.add(end);
+        REQUIRE(total.value[PerfCounters::Instructions] == 18000);
+        REQUIRE(total.ipc() == 3.0);
+    }
+
+    SECTION("Counting a scope") {
+        PerfCounters counters;
+        if (!counters.has(PerfCounters::Instructions)) {
+            // Not permitted or not supported here (e.g. in a container or VM)
+            REQUIRE_FALSE(counters.getError().empty());
+            return;
+        }
+
+        PerfCounters::Values total;
+        counters.start();
+        for (int r = 0; r < 2; ++r) {
+            PerfCounters::Scope scope(counters, total);
+            volatile double x = 0.0;
+            for (int i = 0; i < 100000; ++i) x = x + i * 0.5;
+        }
+        counters.stop();
+
+        REQUIRE(total.valid[PerfCounters::Instructions]);
+        REQUIRE(total.value[PerfCounters::Instructions] > 200000);
+        REQUIRE(total.value[PerfCounters::Instructions] <= counters.read().value[PerfCounters::Instructions]);
+    }
+
+    REQUIRE(std::string(PerfCounters::name(PerfCounters::BranchMisses)) == "branchMisses");
+}
+
+TEST_CASE("RtCheck", "[rt]") {
+    if (!rtCheckSupported()) {
+        REQUIRE_FALSE(rtCheckEnable());
+        return;
+    }
+    REQUIRE(rtCheckEnable());
+    takeRtViolations();
+
+    // Through a volatile pointer so the compiler can't drop the pair
+    void* (*volatile allocate)(size_t) = malloc;
+    void (*volatile release)(void*) = free;
+
+    SECTION("Calls outside a region pass") {
+        release(allocate(32));
+        REQUIRE(takeRtViolations().empty());
+    }
+
+    SECTION("Allocations and locks inside a region are recorded") {
+        std::mutex mutex;
+        {
+            RtRegion region;
+            release(allocate(48));
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        auto violations = takeRtViolations();
+        REQUIRE(violations.size() == 3);
+        REQUIRE(std::string(violations[0].function) == "malloc");
+        REQUIRE(violations[0].kind == RtViolationKind::Allocation);
+        REQUIRE(violations[0].size == 48);
+        REQUIRE(std::string(violations[1].function) == "free");
+        REQUIRE(violations[2].kind == RtViolationKind::Lock);
+        REQUIRE(violations[0].frameCount > 0);
+        REQUIRE_FALSE(symbolizeRtStack(violations[0]).empty());
+        REQUIRE(droppedRtViolations() == 0);
+    }
+
+    SECTION("Regions are per thread") {
+        std::thread other([&] {
+            RtRegion region;
+            release(allocate(16));
+        });
+        release(allocate(16));
+        other.join();
+        REQUIRE(takeRtViolations().size() == 2);
+    }
+
+    SECTION("Heap calls are counted per scope") {
+        void* (*volatile reallocate)(void*, size_t) = realloc;
+        HeapCounts outer;
+        HeapCounts inner;
+        {
+            HeapCountScope scope(outer);
+            void* block = allocate(100);
+            {
+                HeapCountScope nested(inner);
+                release(allocate(16));
+            }
+            block = reallocate(block, 4000);
+            release(block);
+        }
+        release(allocate(64));  // Not counted
+
+        REQUIRE(inner.allocations == 1);
+        REQUIRE(inner.frees == 1);
+        REQUIRE(inner.netBytes() == 0);
+        REQUIRE(outer.allocations == 2);
+        REQUIRE(outer.frees == 2);
+        REQUIRE(outer.allocatedBytes >= 4100);
+        REQUIRE(outer.netBytes() == 0);
+        REQUIRE(takeRtViolations().empty());
+    }
+}
+
+TEST_CASE("ThreadPool", "[threading]") {
+    struct Hits {
+        std::vector<std::atomic<uint32_t>> counts;
+        explicit Hits(size_t n) : counts(n) {}
+    };
+    auto countHit = [](void* context, uint32_t index) {
+        static_cast<Hits*>(context)->counts[index].fetch_add(1);
+    };
+
+    SECTION("Every task runs exactly once") {
+        ThreadPool pool(3);
+        for (uint32_t count : {1u, 2u, 7u, 64u, 1000u}) {
+            Hits hits(count);
+            REQUIRE(pool.run(count, countHit, &hits));
+            for (const auto& hit : hits.counts) REQUIRE(hit.load() == 1);
+        }
+        ThreadPool::Stats stats = pool.stats();
+        REQUIRE(stats.runs == 5);
+        REQUIRE(stats.tasks == 1 + 2 + 7 + 64 + 1000);
+        pool.resetStats();
+        REQUIRE(pool.stats().tasks == 0);
+    }
+
+    SECTION("Without workers the caller runs everything") {
+        ThreadPool pool(0);
+        Hits hits(10);
+        REQUIRE(pool.run(10, countHit, &hits));
+        for (const auto& hit : hits.counts) REQUIRE(hit.load() == 1);
+        REQUIRE(pool.stats().stolen == 0);
+    }
+
+    SECTION("Nested runs are rejected") {
+        ThreadPool pool(2);
+        struct Nested {
+            ThreadPool* pool;
+            std::atomic<uint32_t> accepted{0};
+        } nested{&pool};
+        REQUIRE(pool.run(4, [](void* context, uint32_t) {
+            auto* n = static_cast<Nested*>(context);
+            if (n->pool->run(1, [](void*, uint32_t) {}, nullptr)) n->accepted++;
+        }, &nested));
+        REQUIRE(nested.accepted == 0);
+        REQUIRE(pool.stats().rejected == 4);
+    }
+}
+
+TEST_CASE("TestHost thread pool extension", "[host]") {
+    TestHost host;
+    const clap_host_t* clap = host.clapHost();
+    REQUIRE(clap->get_extension(clap, CLAP_EXT_THREAD_POOL) == nullptr);
+
+    host.enableThreadPool(2);
+    auto* ext = static_cast<const clap_host_thread_pool_t*>(clap->get_extension(clap, CLAP_EXT_THREAD_POOL));
+    REQUIRE(ext != nullptr);
+    // No plugin bound, so there is nothing to run the tasks on
+    REQUIRE_FALSE(ext->request_exec(clap, 4));
+}
+
+TEST_CASE("Thread affinity", "[threading]") {
+    REQUIRE(hardwareThreadCount() >= 1);
+    REQUIRE(hardwareThreadCount() == std::max(1u, std::thread::hardware_concurrency()));
+
+    // On a thread of its own, so the test runner keeps its affinity
+    bool pinned = false;
+    std::thread([&] { pinned = pinCurrentThreadToCore(0); }).join();
+#if defined(__linux__)
+    REQUIRE(pinned);
+#else
+    (void)pinned;
+#endif
+
+#if !defined(__APPLE__)
+    // macOS only takes an affinity tag, which any number is
+    bool rejected = true;
+    std::thread([&] { rejected = !pinCurrentThreadToCore(1u << 20); }).join();
+    REQUIRE(rejected);
+#endif
+}
+
+TEST_CASE("sleepUntil", "[threading]") {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 1; i <= 3; ++i) {
+        auto deadline = start + std::chrono::milliseconds(2 * i);
+        sleepUntil(deadline);
+        REQUIRE(std::chrono::steady_clock::now() >= deadline);
+    }
+
+    // A deadline in the past returns at once
+    auto before = std::chrono::steady_clock::now();
+    sleepUntil(start);
+    REQUIRE(std::chrono::steady_clock::now() - before < std::chrono::seconds(1));
+}
+
+TEST_CASE("ResourceUsage", "[perf]") {
+    ResourceUsage before = ResourceUsage::current();
+#if defined(__linux__) || defined(__APPLE__)
+    REQUIRE(before.residentBytes > 0);
+#endif
+
+    // Touching fresh pages faults them in and grows the resident set
+    constexpr size_t bytes = 16u << 20;
+    std::unique_ptr<char[]> block(new char[bytes]);
+    for (size_t i = 0; i < bytes; i += 4096) block[i] = static_cast<char>(i);
+    ResourceUsage cost = ResourceUsage::current() - before;
+#if defined(__linux__) || defined(__APPLE__)
+    REQUIRE(cost.minorFaults + cost.majorFaults > 0);
+    REQUIRE(cost.residentBytes > 0);
+#endif
+    REQUIRE(block[4096] == static_cast<char>(4096));
+
+#if defined(__linux__)
+    ResourceUsage withPss = ResourceUsage::current(true);
+    if (withPss.proportionalBytes > 0) REQUIRE(withPss.proportionalBytes <= withPss.residentBytes);
+#endif
+}
+
+TEST_CASE("ScanCache", "[cache]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "clap-trap-scan-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string plugin = (dir / "fake.clap").string();
+    std::string file = (dir / "cache" / "scan-cache.json").string();
+    auto writePlugin = [&](const char* contents) {
+        std::ofstream out(plugin, std::ios::binary | std::ios::trunc);
+        out << contents;
+    };
+    writePlugin("first");
+
+    FileSignature signature = fileSignature(plugin, true);
+    REQUIRE(signature.exists);
+    CHECK(signature.size == 5);
+    CHECK(signature.hash != 0);
+    CHECK_FALSE(fileSignature((dir / "missing.clap").string()).exists);
+
+    {
+        auto cache = ScanCache::open(file);
+        REQUIRE_FALSE(cache->hasError());
+        CHECK(cache->entries().empty());
+
+        ScanEntry entry;
+        entry.path = plugin;
+        entry.signature = signature;
+        entry.ok = true;
+        entry.plugins.push(Json::object().set("id", "com.example.fake"));
+        cache->put(entry);
+        REQUIRE(cache->save());
+    }
+
+    auto cache = ScanCache::open(file);
+    REQUIRE_FALSE(cache->hasError());
+    const ScanEntry* entry = cache->lookup(plugin, fileSignature(plugin));
+    REQUIRE(entry != nullptr);
+    CHECK(entry->ok);
+    CHECK(entry->signature.mtimeNs == signature.mtimeNs);
+    CHECK(entry->signature.hash == signature.hash);
+    CHECK(entry->plugins.items()[0].get("id")->asString() == "com.example.fake");
+
+    SECTION("Changed size invalidates") {
+        writePlugin("second!");
+        CHECK(cache->lookup(plugin, fileSignature(plugin)) == nullptr);
+        CHECK(cache->find(plugin) != nullptr);
+    }
+    SECTION("Changed mtime invalidates unless the hash matches") {
+        fs::last_write_time(plugin, fs::last_write_time(plugin) + std::chrono::seconds(10));
+        CHECK(cache->lookup(plugin, fileSignature(plugin)) == nullptr);
+        CHECK(cache->lookup(plugin, fileSignature(plugin, true)) != nullptr);
+    }
+    SECTION("Same size, different contents") {
+        writePlugin("other");
+        fs::last_write_time(plugin, fs::last_write_time(plugin) + std::chrono::seconds(10));
+        CHECK(cache->lookup(plugin, fileSignature(plugin, true)) == nullptr);
+    }
+    SECTION("Relative and absolute paths share an entry") {
+        fs::path cwd = fs::current_path();
+        fs::current_path(dir);
+        CHECK(cache->find("fake.clap") == entry);
+        CHECK(cache->find("./cache/../fake.clap") == entry);
+        CHECK(cache->remove("fake.clap"));
+        CHECK(cache->find(plugin) == nullptr);
+        fs::current_path(cwd);
+    }
+    SECTION("Corrupt file starts empty") {
+        std::ofstream(file, std::ios::trunc) << "{\"version\": 1, \"entries\": [";
+        auto corrupt = ScanCache::open(file);
+        CHECK(corrupt->hasError());
+        CHECK(corrupt->entries().empty());
+    }
+
+    fs::remove_all(dir);
 }
 
 //-----------------------------------------------------------------------------
@@ -180,4 +1548,24 @@ TEST_CASE("PluginLoader error handling", "[loader]") {
         REQUIRE(loader->entry() == nullptr);
         REQUIRE_FALSE(loader->getError().empty());
     }
+    SECTION("Non-existent file, opened without init") {
+        auto loader = PluginLoader::open("/nonexistent/path/plugin.clap");
+        REQUIRE(loader->entry() == nullptr);
+        REQUIRE_FALSE(loader->getError().empty());
+        REQUIRE_FALSE(loader->initEntry());
+    }
+}
+
+TEST_CASE("ProcessGraph error handling", "[loader]") {
+    SECTION("Empty chain") {
+        auto graph = ProcessGraph::load({});
+        REQUIRE(graph->hasError());
+        REQUIRE(graph->nodeCount() == 0);
+    }
+    SECTION("Missing plugin names the failing file") {
+        auto graph = ProcessGraph::load({"/nonexistent/path/eq.clap", "/nonexistent/path/verb.clap"});
+        REQUIRE(graph->hasError());
+        REQUIRE(graph->getError().find("eq.clap") != std::string::npos);
+        REQUIRE(graph->nodeCount() == 0);
+    }
 }